@@ -363,14 +363,16 @@ void setBrightnessLED(uint8_t brightness, MsgType mt) {
   }
 }
 
-String buildState() {
-  char brightness[4];
-  sprintf(brightness, "%03d", ledBrightness);
-  return String('#') + String(ledState) + String('#') + String(brightness) + String('#') + String(ledState);
+void buildState(char *state, int size) {
+  // Monta o estado sem String intermediária
+  LF_LoRaLine line(state, size);
+  line.addInt(ledState).addInt(ledBrightness, 3).addInt(ledState);
 }
 
 void sendState(MsgType mt) {
 
-  LF_LoRa.sendState(buildState(), mt);
+  char state[32];
+  buildState(state, sizeof(state));
+  LF_LoRa.sendState(state, mt);
 
 }
@@ -132,13 +132,6 @@ float fFrequencia = -100.0;
 
 // Mensagens
 uint8_t lastModoOp = LORA_OP_MODE_LOOP;
-String sState;
-String sTensao;
-String sPotencia;
-String sCorrente;
-String sEnergia;
-String sFrequencia;
-String sInterruptor;
 
 // ######### Rotinas
 void setup_lora() {
@@ -454,53 +447,17 @@ void resetEnergy(MsgType mt) {
   sendState(mt);
 }
 
-void leTensao() {
-  char msg[16];
-  int tensaoAjustada = fTensao * 10 + 0.5;
-  sprintf(msg, "%04d",tensaoAjustada);
-  sTensao = String(msg);
-}
-
-void lePotencia() {
-  char msg[16];
-  int potenciaAjustada = fPotencia * 10 + 0.5;
-  sprintf(msg, "%06d",potenciaAjustada);
-  sPotencia = String(msg);
-}
-
-void leCorrente() {
-  char msg[16];
+void buildState(char *state, int size) {
+  // Tensão, potência, corrente, energia, frequência e interruptor, com
+  // largura fixa e sem String intermediária
   if (fCorrente >= 100.0) fCorrente = 99.999;
-  int correnteAjustada = fCorrente * 1000 + 0.5;
-  sprintf(msg, "%06d",correnteAjustada);
-  sCorrente = String(msg);
-}
-
-void leEnergia() {
-  char msg[16];
-  int energiaAjustada = fEnergia*1000;
-  sprintf(msg, "%06d",energiaAjustada);
-  sEnergia = String(msg);
-}
-
-void leFrequencia() {
-  char msg[16];
-  int frequenciaAjustada = fFrequencia * 10 + 0.5;
-  sprintf(msg, "%06d",frequenciaAjustada);
-  sFrequencia = String(msg);
-}
-
-void leInterruptor() {
-  sInterruptor = String(digitalRead(LED_PIN));
-}
-
-void buildState() {
-  sState = String('#') + sTensao;
-  sState = sState + String('#') + sPotencia;
-  sState = sState + String('#') + sCorrente;
-  sState = sState + String('#') + sEnergia;
-  sState = sState + String('#') + sFrequencia;
-  sState = sState + String('#') + sInterruptor;
+  LF_LoRaLine line(state, size);
+  line.addInt(fTensao * 10 + 0.5, 4);
+  line.addInt(fPotencia * 10 + 0.5, 6);
+  line.addInt(fCorrente * 1000 + 0.5, 6);
+  line.addInt(fEnergia * 1000, 6);
+  line.addInt(fFrequencia * 10 + 0.5, 6);
+  line.addInt(digitalRead(LED_PIN));
 }
 
 void sendState(MsgType mt) {
@@ -512,15 +469,10 @@ void sendState(MsgType mt) {
   if (fEnergia < 0) return;
   if (fFrequencia < 0) return;
 
-  leTensao();
-  lePotencia();
-  leCorrente();
-  leEnergia();
-  leFrequencia();
-  leInterruptor();
-  buildState();
+  char state[64];
+  buildState(state, sizeof(state));
 
-  LF_LoRa.sendState(sState, mt);
+  LF_LoRa.sendState(state, mt);
 
 }
 
@@ -292,18 +292,16 @@ void setColor(uint8_t r, uint8_t g, uint8_t b, MsgType mt) {
 }
 
 
-String buildState() {
-  char br[4];
-  sprintf(br, "%03d", ledBrightness);
-  char r[4];
-  sprintf(r, "%03d", ledRed);
-  char g[4];
-  sprintf(g, "%03d", ledGreen);
-  char b[4];
-  sprintf(b, "%03d", ledBlue);
-  return String('#') + String(ledState) + String('#') + String(br) + String('#') + String(r) + String('#') + String(g) + String('#') + String(b) + String('#') + String(ledState);
+void buildState(char *state, int size) {
+  // Monta o estado sem String intermediária
+  LF_LoRaLine line(state, size);
+  line.addInt(ledState).addInt(ledBrightness, 3);
+  line.addInt(ledRed, 3).addInt(ledGreen, 3).addInt(ledBlue, 3);
+  line.addInt(ledState);
 }
 
 void sendState(MsgType mt) {
-  LF_LoRa.sendState(buildState(), mt);
+  char state[48];
+  buildState(state, sizeof(state));
+  LF_LoRa.sendState(state, mt);
 }
@@ -45,10 +45,20 @@
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
 
-#define CMD_GET_USB_MODEL      "!000"
-#define CMD_SET_SYNCH_FREQ     "!001"
+#define CMD_GET_USB_MODEL      "000"
+#define CMD_SET_SYNCH_FREQ     "001"
 #define USB_MODEL              "USB Adapter Ver 1.0"
 
+// Rede com repetidores: aprende a quantos saltos está cada escravo e limita
+// a retransmissão da descida a essa distância
+#define USE_REPEATERS          false
+
+// Comandos do adaptador: "!000" e "!001SSSFFFFF" (synch word e frequência, como 915E6)
+static constexpr LF_LoRaCmdSpec usbCmds[] = {
+  {CMD_GET_USB_MODEL,  0, 0, 0x00, true, {0, 0, 0, 0}},
+  {CMD_SET_SYNCH_FREQ, 2, 2, 0x01, true, {3, 5, 5, 5}},
+};
+
 //########## Para LoRa
 // Pinos do lora (comunicação spi)
 #define LORA_RST_PIN    14
@@ -94,6 +104,11 @@ void setup_lora() {
   // Definindo a palavra de sincronismo
   LoRa.setSyncWord(synch_word);
 
+  // Aprendendo a quantos saltos está cada escravo, para limitar os repetidores
+  if (USE_REPEATERS) {
+    LF_LoRa.setMasterRoutes(true);
+  }
+
   // Entrando no modo "receive"
   LoRa.receive();
 
@@ -163,7 +178,7 @@ void loop_lora() {
     }
 
     // Criando buffer para receber a mensagem processada
-    char msg_data[LF_LORA_MAX_PACKET_SIZE];
+    char msg_data[LF_LORA_MAX_PACKET_SIZE + 1];
 
     if (LF_LoRa.loraDecode(LoraData.c_str(), LoraData.length(), msg_data)) {
       if (msg_data[0] == '!') {
@@ -171,7 +186,7 @@ void loop_lora() {
         Serial.println(msg_data);
       } else {
         // Não começa com !, envia a mensagem para LoRa2MQTT com #RSSI no início
-        char msg[LF_LORA_MAX_PACKET_SIZE];
+        char msg[LF_LORA_MAX_PACKET_SIZE + 6];
         sprintf(msg, "#%04d%s",LoRa.packetRssi(),msg_data);
         Serial.println(msg);
       }
@@ -194,17 +209,21 @@ void loop_serial() {
       enviaParaLoRa(sLoRaMsg);
     } else if (sSerialMsg.charAt(0) == '!') {
       // Mensagem com ! no início. É de configuração
-      if (sSerialMsg.equals(CMD_GET_USB_MODEL)) {
-        Serial.print("!");Serial.println(USB_MODEL);
-        return;
-      }
-      if (sSerialMsg.substring(0,4).equals(CMD_SET_SYNCH_FREQ)) {
-        synch_word = sSerialMsg.substring(4,7).toInt();
-        frequency = (int)sSerialMsg.substring(7,12).toFloat();
-        LoRa.setSyncWord(synch_word);
-        LoRa.setFrequency(frequency);
-        displayStatus();
-        return;
+      LF_LoRaCmd cmd;
+      if (cmd.parse(sSerialMsg.c_str(), sSerialMsg.length()) && (cmd.count() == 2) &&
+          (cmd.match(usbCmds, sizeof(usbCmds) / sizeof(usbCmds[0]), 1) != nullptr)) {
+        if (cmd.token(1).equals(CMD_GET_USB_MODEL)) {
+          Serial.print("!");Serial.println(USB_MODEL);
+          return;
+        }
+        if (cmd.token(1).sub(0,3).equals(CMD_SET_SYNCH_FREQ)) {
+          synch_word = cmd.arg(0).toInt();
+          frequency = (long)cmd.arg(1).toFloat();
+          LoRa.setSyncWord(synch_word);
+          LoRa.setFrequency(frequency);
+          displayStatus();
+          return;
+        }
       }
       // Enviando a mensagem completa para para o módulo LoRa
       enviaParaLoRa(sSerialMsg);
@@ -231,13 +250,13 @@ void enviaParaLoRa(String sMsg) {
   LoRa.beginPacket();
 
   // Criando buffer para colocar dados LoRa
-  char lora_data[LF_LORA_MAX_PACKET_SIZE];
+  char lora_data[LF_LORA_MAX_PACKET_SIZE + 1];
 
   // Codificando pacote LoRa
-  LF_LoRa.loraEncode(sMsg.c_str(), sMsg.length(), lora_data);
+  int len = LF_LoRa.loraEncode(sMsg.c_str(), sMsg.length(), lora_data);
 
   // Enviando LoRa
-  LoRa.print(lora_data);
+  LoRa.write((const uint8_t *)lora_data, len);
 
   LoRa.endPacket();
 
@@ -0,0 +1,6 @@
+#!/bin/sh
+# Compila a ferramenta de replay no Linux, com os mocks de extras/test/mock.
+# Uso: extras/replay/build.sh [saída]
+cd "$(dirname "$0")" || exit 1
+SRC=../../src
+g++ -std=gnu++17 -O2 -Wall -I ../test/mock -I $SRC -o "${1:-lf_lora_replay}" lf_lora_replay.cpp $SRC/*.cpp ../test/mock/mock.cpp
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// AEAD no Linux: bloco AES, CMAC e quadros cifrados contra os abertos.
+// Uso: extras/test/run.sh bench_aead
+
+#define private public
+#include <LF_LoRa.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#define ROUNDS  200000
+#define BATCH   1000     // Quadros cifrados de antemão para a decodificação
+#define PAYLOAD 48       // Bytes de dados, uma linha de estado típica
+
+static volatile uint32_t sink = 0;
+
+/* -------------------------------------------------------------------------- */
+template <typename F>
+static double nsPerOp(F f) {
+  auto t0 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < ROUNDS; i++) {
+    f(i);
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(t1 - t0).count() / ROUNDS;
+} /* nsPerOp */
+
+/* -------------------------------------------------------------------------- */
+static void report(const char *name, double aead, double plain) {
+  if (plain == 0) {
+    printf("%-14s %8.1f ns\n", name, aead);
+    return;
+  }
+  printf("%-14s %8.1f ns %8.1f ns %+8.1f ns\n", name, aead, plain, aead - plain);
+} /* report */
+
+/* -------------------------------------------------------------------------- */
+// Decodifica quadros novos: cifro um lote fora da medida, decodifico medindo
+static double decodeNs(LF_LoRaClass &tx, LF_LoRaClass &rx, const char *msg) {
+  std::vector<std::string> frames(BATCH);
+  char out[LF_LORA_MAX_PACKET_SIZE + 1];
+  double ns = 0;
+  uint32_t ok = 0;
+  if (rx._aeadNodesLen > 0) {
+    // O encode acima adiantou o contador além do que os 16 bits cobrem
+    rx._aeadNodes[0].rx.reset(tx._aeadNodes[0].txCounter);
+  }
+  for (uint32_t done = 0; done < ROUNDS; done += BATCH) {
+    for (uint32_t i = 0; i < BATCH; i++) {
+      int len = tx.loraAddHeaderId(msg, PAYLOAD, 5, (done + i) & 0x7F, out);
+      frames[i].assign(out, len);
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < BATCH; i++) {
+      ok += rx.loraDecode(frames[i].c_str(), frames[i].size(), out);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    ns += std::chrono::duration<double, std::nano>(t1 - t0).count();
+  }
+  if (ok != ROUNDS) {
+    printf("decode: %u de %u quadros recusados\n", ROUNDS - ok, ROUNDS);
+  }
+  return ns / ROUNDS;
+} /* decodeNs */
+
+/* -------------------------------------------------------------------------- */
+int main() {
+
+  static const uint8_t key[LF_LORA_AES_BLOCK] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+  uint8_t block[LF_LORA_AES_BLOCK] = {0};
+  uint8_t data[PAYLOAD] = {0};
+  uint8_t tag[LF_LORA_AEAD_TAG_LEN];
+  char msg[PAYLOAD + 1];
+  memset(msg, 'x', PAYLOAD);
+  msg[0] = '#';
+  msg[PAYLOAD] = 0;
+  char out[LF_LORA_MAX_PACKET_SIZE + 1];
+
+  LF_LoRaAead aead;
+  aead.setKey(key);
+  report("AES bloco", nsPerOp([&](uint32_t i) { block[0] = i; aead.encryptBlock(block, block); sink += block[0]; }), 0);
+  report("CTR 48 B", nsPerOp([&](uint32_t i) { block[9] = i; aead.crypt(block, data, PAYLOAD); sink += data[0]; }), 0);
+  report("CMAC 48 B", nsPerOp([&](uint32_t i) { block[9] = i; aead.mac(block, data, PAYLOAD, tag); sink += tag[0]; }), 0);
+  printf("\n%-14s %11s %11s %11s\n", "quadro", "AEAD", "aberto", "custo");
+
+  // Master e escravo com a mesma chave de sessão, e o par sem AEAD
+  LF_LoRaClass *tx = new LF_LoRaClass();
+  LF_LoRaClass *rx = new LF_LoRaClass();
+  LF_LoRaClass *plainTx = new LF_LoRaClass();
+  LF_LoRaClass *plainRx = new LF_LoRaClass();
+  for (LF_LoRaClass *n : {tx, rx, plainTx, plainRx}) {
+    n->_netId = 1;
+    n->_masterAddr = 0;
+  }
+  rx->_myAddr = 5;
+  plainRx->_myAddr = 5;
+  tx->aeadKeyApply(key);
+  rx->aeadKeyApply(key);
+  tx->aeadNodeSet(5, key);
+  rx->aeadNodeSet(5, key);
+
+  report("encode",
+    nsPerOp([&](uint32_t i) { sink += tx->loraAddHeaderId(msg, PAYLOAD, 5, i & 0x7F, out); }),
+    nsPerOp([&](uint32_t i) { sink += plainTx->loraAddHeaderId(msg, PAYLOAD, 5, i & 0x7F, out); }));
+  report("decode", decodeNs(*tx, *rx, msg), decodeNs(*plainTx, *plainRx, msg));
+
+  for (LF_LoRaClass *n : {tx, rx, plainTx, plainRx}) {
+    n->clearRegRecs();
+    delete n;
+  }
+  return 0;
+
+} /* main */
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// LF_LoRaFmt contra snprintf/strtol/strtof no Linux.
+// Uso: extras/test/run.sh bench_fmt
+
+#include <LF_LoRa_Fmt.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#define ROUNDS 2000000
+
+static volatile uint32_t sink = 0;
+
+/* -------------------------------------------------------------------------- */
+template <typename F>
+static double nsPerOp(F f) {
+  auto t0 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < ROUNDS; i++) {
+    f(i);
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(t1 - t0).count() / ROUNDS;
+} /* nsPerOp */
+
+/* -------------------------------------------------------------------------- */
+static void report(const char *name, double lib, double ref) {
+  printf("%-14s %8.1f ns %8.1f ns %6.1fx\n", name, lib, ref, ref / lib);
+} /* report */
+
+/* -------------------------------------------------------------------------- */
+int main() {
+
+  char buf[64];
+  static const char *hex[] = {"1A2B", "00FF", "BEEF", "0001"};
+  static const char *dec[] = {"-123", "4567", "89", "100000"};
+  static const char *flt[] = {"220.1", "0.45", "915E6", "3.14159"};
+
+  printf("%-14s %11s %11s %7s\n", "", "LF_LoRaFmt", "libc", "ganho");
+
+  report("fmtInt",
+    nsPerOp([&](uint32_t i) { sink += LF_LoRaFmt::fmtInt(buf, sizeof(buf), (int32_t)i - 1000000, 6); }),
+    nsPerOp([&](uint32_t i) { sink += snprintf(buf, sizeof(buf), "%06ld", (long)i - 1000000); }));
+
+  report("fmtHex",
+    nsPerOp([&](uint32_t i) { sink += LF_LoRaFmt::fmtHex(buf, sizeof(buf), i, 8); }),
+    nsPerOp([&](uint32_t i) { sink += snprintf(buf, sizeof(buf), "%08lX", (unsigned long)i); }));
+
+  report("fmtFixed",
+    nsPerOp([&](uint32_t i) { sink += LF_LoRaFmt::fmtFixed(buf, sizeof(buf), (int32_t)i, 3); }),
+    nsPerOp([&](uint32_t i) { sink += snprintf(buf, sizeof(buf), "%.3f", i / 1000.0); }));
+
+  report("parseInt",
+    nsPerOp([&](uint32_t i) { int32_t v; LF_LoRaFmt::parseInt(dec[i & 3], strlen(dec[i & 3]), v); sink += v; }),
+    nsPerOp([&](uint32_t i) { sink += strtol(dec[i & 3], nullptr, 10); }));
+
+  report("parseHex",
+    nsPerOp([&](uint32_t i) { uint32_t v; LF_LoRaFmt::parseHex(hex[i & 3], 4, v); sink += v; }),
+    nsPerOp([&](uint32_t i) { sink += strtol(hex[i & 3], nullptr, 16); }));
+
+  report("parseFloat",
+    nsPerOp([&](uint32_t i) { float v; LF_LoRaFmt::parseFloat(flt[i & 3], strlen(flt[i & 3]), v); sink += (uint32_t)v; }),
+    nsPerOp([&](uint32_t i) { sink += (uint32_t)strtof(flt[i & 3], nullptr); }));
+
+  // Linha de estado inteira
+  report("LF_LoRaLine",
+    nsPerOp([&](uint32_t i) {
+      LF_LoRaLine line(buf, sizeof(buf));
+      line.addFixed(2201, 1).addInt(i & 0xFFF, 6).addFixed(457, 3).addInt(1);
+      sink += line.length();
+    }),
+    nsPerOp([&](uint32_t i) {
+      sink += snprintf(buf, sizeof(buf), "#%.1f#%06u#%.3f#%d", 220.1, i & 0xFFF, 0.457, 1);
+    }));
+
+  return 0;
+
+} /* main */
@@ -0,0 +1,109 @@
+#pragma once
+// Mocks mínimos do core ESP32 do Arduino para os testes no Linux
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <functional>
+#include <stdlib.h>
+#include <string.h>
+#define INPUT 0
+#define INPUT_PULLUP 2
+#define OUTPUT 1
+#define HIGH 1
+#define LOW 0
+#define DEC 10
+#define HEX 16
+#define CHANGE 3
+#define IRAM_ATTR
+#define F(x) x
+class String {
+ public:
+  std::string s;
+  String() {}
+  String(const char* c) : s(c ? c : "") {}
+  String(const std::string& c) : s(c) {}
+  String(char c) : s(1, c) {}
+  String(int v, int base = 10) { char b[40]; snprintf(b, 40, base == 16 ? "%x" : "%d", v); s = b; }
+  String(unsigned v, int base = 10) { char b[40]; snprintf(b, 40, base == 16 ? "%x" : "%u", v); s = b; }
+  String(long v, int base = 10) { char b[40]; snprintf(b, 40, "%ld", v); s = b; }
+  String(unsigned long v, int base = 10) { char b[40]; snprintf(b, 40, "%lu", v); s = b; }
+  String(long long v, int base = 10) { char b[40]; snprintf(b, 40, "%lld", v); s = b; }
+  String(unsigned long long v, int base = 10) { char b[40]; snprintf(b, 40, "%llu", v); s = b; }
+  String(float v, int d = 2) { char b[40]; snprintf(b, 40, "%.*f", d, v); s = b; }
+  String(double v, int d = 2) { char b[40]; snprintf(b, 40, "%.*f", d, v); s = b; }
+  const char* c_str() const { return s.c_str(); }
+  unsigned length() const { return s.size(); }
+  String substring(unsigned a) const { return a >= s.size() ? String() : String(s.substr(a)); }
+  String substring(unsigned a, unsigned b) const { if (a >= s.size()) return String(); return String(s.substr(a, b - a)); }
+  bool equals(const String& o) const { return s == o.s; }
+  bool operator==(const String& o) const { return s == o.s; }
+  bool operator==(const char* o) const { return s == o; }
+  String& operator+=(const String& o) { s += o.s; return *this; }
+  String& operator+=(char c) { s += c; return *this; }
+  String& operator+=(const char* c) { s += c; return *this; }
+  friend String operator+(const String& a, const String& b) { return String(a.s + b.s); }
+  friend String operator+(const String& a, const char* b) { return String(a.s + b); }
+  friend String operator+(const char* a, const String& b) { return String(a + b.s); }
+  friend String operator+(const String& a, char b) { return String(a.s + b); }
+  int lastIndexOf(char c) const { auto p = s.rfind(c); return p == std::string::npos ? -1 : (int)p; }
+  int indexOf(char c, unsigned from = 0) const { auto p = s.find(c, from); return p == std::string::npos ? -1 : (int)p; }
+  void remove(unsigned i, unsigned n) { s.erase(i, n); }
+  void toUpperCase() { for (auto& c : s) c = toupper(c); }
+  long toInt() const { return atol(s.c_str()); }
+  float toFloat() const { return atof(s.c_str()); }
+  char charAt(unsigned i) const { return i < s.size() ? s[i] : 0; }
+  char operator[](unsigned i) const { return s[i]; }
+  bool reserve(unsigned n) { s.reserve(n); return true; }
+};
+class Print {
+ public:
+  virtual size_t write(uint8_t) { return 1; }
+  virtual size_t write(const uint8_t* b, size_t n) { return n; }
+  size_t write(const char* b, size_t n) { return write((const uint8_t*)b, n); }
+  template <class T> size_t print(T) { return 0; }
+  template <class T> size_t print(T, int) { return 0; }
+  template <class T> size_t println(T) { return 0; }
+  template <class T> size_t println(T, int) { return 0; }
+  size_t println() { return 0; }
+};
+// Guarda tudo o que é escrito, para conferir a saída
+class CapturePrint : public Print {
+ public:
+  using Print::write;
+  size_t write(uint8_t b) override { data += (char)b; return 1; }
+  size_t write(const uint8_t* b, size_t n) override { data.append((const char*)b, n); return n; }
+  std::string data;
+};
+class Stream : public Print {
+ public:
+  virtual int available() { return 0; }
+  virtual int read() { return -1; }
+  String readString() { return String(); }
+  void begin(long) {}
+};
+extern Stream Serial;
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long);
+void delayMicroseconds(unsigned int);
+long random(long);
+long random(long, long);
+void pinMode(uint8_t, uint8_t);
+int digitalRead(uint8_t);
+void digitalWrite(uint8_t, uint8_t);
+void yield();
+int digitalPinToInterrupt(int);
+void attachInterrupt(int, void (*)(void), int);
+void attachInterruptArg(uint8_t, void (*)(void*), void*, int);
+void detachInterrupt(uint8_t);
+void noInterrupts();
+void interrupts();
+#ifdef ESP32
+typedef int BaseType_t;
+typedef void* TaskHandle_t;
+#define pdPASS 1
+BaseType_t xTaskCreatePinnedToCore(void (*)(void*), const char*, uint32_t, void*, int, TaskHandle_t*, int);
+void vTaskDelay(int);
+void vTaskDelete(TaskHandle_t);
+uint32_t esp_random();
+#endif
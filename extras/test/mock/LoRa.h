@@ -0,0 +1,32 @@
+#pragma once
+#include <Arduino.h>
+#include <string>
+#include <vector>
+class LoRaClass : public Stream {
+ public:
+  int begin(long f) { frequency = f; return 1; } void end() {}
+  int beginPacket(int = 0) { packet.clear(); return 1; }
+  int endPacket(bool = false) { sent.push_back(packet); sentTime.push_back(millis()); return 1; }
+  using Stream::write;
+  size_t write(uint8_t b) override { packet += (char)b; return 1; }
+  size_t write(const uint8_t* b, size_t n) override { packet.append((const char*)b, n); return n; }
+  int parsePacket(int = 0) { int n = rxLen; rxLen = 0; return n; } int packetRssi() { return 0; } float packetSnr() { return 0; } long packetFrequencyError() { return 0; }
+  int rssi() { return 0; }
+  int available() { return rxPos < rx.size() ? rx.size() - rxPos : 0; }
+  int read() { if (rxPos >= rx.size()) return -1; reads++; return (uint8_t)rx[rxPos++]; } int peek() { return -1; }
+  // Entrega um quadro: o próximo parsePacket devolve o tamanho e read() os bytes
+  void deliver(const std::string& f) { rx = f; rxPos = 0; rxLen = f.size(); }
+  void receive(int = 0) {} void idle() {} void sleep() {}
+  void setTxPower(int, int = 0) {} void setFrequency(long f) { frequency = f; } void setSpreadingFactor(int) {} void setSignalBandwidth(long) {} void setCodingRate4(int) {} void setPreambleLength(long) {} void setSyncWord(int) {} void enableCrc() {} void disableCrc() {}
+  void setPins(int, int, int) {} void setSPI(SPIClass&) {}
+  uint8_t random() { return 0; }
+  long frequency = 0;   // Última frequência sintonizada
+  int rxLen = 0;        // Tamanho do próximo pacote que parsePacket entrega
+  std::string packet;   // Quadros enviados e o millis() de cada um
+  std::vector<std::string> sent;
+  std::vector<unsigned long> sentTime;
+  std::string rx;       // Quadro recebido, lido por read()
+  size_t rxPos = 0;
+  int reads = 0;        // Bytes lidos por read(), para conferir o descarte cedo
+};
+extern LoRaClass LoRa;
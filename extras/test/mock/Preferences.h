@@ -0,0 +1,23 @@
+#pragma once
+#include <Arduino.h>
+#include <map>
+#include <vector>
+// Preferences em RAM, sobrevive a um novo inic() como a NVS da placa
+class Preferences {
+ public:
+  static std::map<std::string, std::vector<uint8_t>> &store() { static std::map<std::string, std::vector<uint8_t>> m; return m; }
+  bool begin(const char *ns, bool = false) { _ns = ns; return true; }
+  void end() {}
+  std::vector<uint8_t> *find(const char *k) { auto it = store().find(_ns + "/" + k); return it == store().end() ? nullptr : &it->second; }
+  size_t getBytes(const char *k, void *b, size_t n) { auto v = find(k); if (!v || v->size() > n) return 0; memcpy(b, v->data(), v->size()); return v->size(); }
+  size_t putBytes(const char *k, const void *b, size_t n) { store()[_ns + "/" + k].assign((const uint8_t *)b, (const uint8_t *)b + n); return n; }
+  uint32_t getUInt(const char *k, uint32_t d = 0) { uint32_t v = d; getBytes(k, &v, 4); return v; }
+  size_t putUInt(const char *k, uint32_t v) { return putBytes(k, &v, 4); }
+  size_t getBytesLength(const char *k) { auto v = find(k); return v ? v->size() : 0; }
+  bool isKey(const char *k) { return find(k) != nullptr; }
+  bool remove(const char *k) { return store().erase(_ns + "/" + k) > 0; }
+  String getString(const char *k, String d = String()) { auto v = find(k); return v ? String(std::string(v->begin(), v->end())) : d; }
+  size_t putString(const char *k, String s) { return putBytes(k, s.c_str(), s.length()); }
+ private:
+  std::string _ns;
+};
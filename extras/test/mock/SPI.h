@@ -0,0 +1,7 @@
+#pragma once
+#include <Arduino.h>
+#define MSBFIRST 1
+#define SPI_MODE0 0
+struct SPISettings { SPISettings() {} SPISettings(uint32_t, uint8_t, uint8_t) {} };
+struct SPIClass { void begin(int=-1, int=-1, int=-1, int=-1) {} void beginTransaction(SPISettings) {} void endTransaction() {} uint8_t transfer(uint8_t) { return 0; } void transferBytes(const uint8_t*, uint8_t*, uint32_t) {} void writeBytes(const uint8_t*, uint32_t) {} };
+extern SPIClass SPI;
@@ -0,0 +1,5 @@
+#pragma once
+#include <Arduino.h>
+#define WIFI_OFF 0
+struct WiFiClass { void softAP(const char*, const char*) {} String softAPmacAddress() { return String(); } void disconnect(bool) {} void mode(int) {} };
+extern WiFiClass WiFi;
@@ -0,0 +1,4 @@
+#pragma once
+#include <stdint.h>
+typedef enum { ESP_MAC_WIFI_STA, ESP_MAC_WIFI_SOFTAP } esp_mac_type_t;
+int esp_read_mac(uint8_t*, esp_mac_type_t);
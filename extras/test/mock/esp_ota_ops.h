@@ -0,0 +1,9 @@
+#pragma once
+#include "esp_partition.h"
+typedef uint32_t esp_ota_handle_t;
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t*);
+esp_err_t esp_ota_begin(const esp_partition_t*, size_t, esp_ota_handle_t*);
+esp_err_t esp_ota_write_with_offset(esp_ota_handle_t, const void*, size_t, uint32_t);
+esp_err_t esp_ota_end(esp_ota_handle_t);
+esp_err_t esp_ota_abort(esp_ota_handle_t);
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t*);
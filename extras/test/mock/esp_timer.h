@@ -0,0 +1,13 @@
+#pragma once
+#include <stdint.h>
+typedef struct esp_timer* esp_timer_handle_t;
+typedef int esp_err_t;
+#define ESP_OK 0
+typedef enum { ESP_TIMER_TASK } esp_timer_dispatch_t;
+typedef struct { void (*callback)(void*); void* arg; esp_timer_dispatch_t dispatch_method; const char* name; bool skip_unhandled_events; } esp_timer_create_args_t;
+inline esp_err_t esp_timer_create(const esp_timer_create_args_t*, esp_timer_handle_t* h) { *h = nullptr; return ESP_OK; }
+inline esp_err_t esp_timer_start_periodic(esp_timer_handle_t, uint64_t) { return ESP_OK; }
+inline esp_err_t esp_timer_start_once(esp_timer_handle_t, uint64_t) { return ESP_OK; }
+inline esp_err_t esp_timer_stop(esp_timer_handle_t) { return ESP_OK; }
+inline esp_err_t esp_timer_delete(esp_timer_handle_t) { return ESP_OK; }
+inline int64_t esp_timer_get_time() { return 0; }
@@ -0,0 +1,7 @@
+#pragma once
+#include <stdint.h>
+typedef struct { int x; } mbedtls_aes_context;
+#define MBEDTLS_AES_ENCRYPT 1
+void mbedtls_aes_init(mbedtls_aes_context*); void mbedtls_aes_free(mbedtls_aes_context*);
+int mbedtls_aes_setkey_enc(mbedtls_aes_context*, const unsigned char*, unsigned);
+int mbedtls_aes_crypt_ecb(mbedtls_aes_context*, int, const unsigned char*, unsigned char*);
@@ -0,0 +1,26 @@
+#include <Arduino.h>
+#include <WiFi.h>
+#include <SPI.h>
+#include <LoRa.h>
+#include <atomic>
+Stream Serial; WiFiClass WiFi; SPIClass SPI; LoRaClass LoRa;
+// Relógio manual, atômico para os testes com a tarefa do rádio
+std::atomic<unsigned long> g_millis{0};
+unsigned long millis() { return g_millis; }
+unsigned long micros() { return g_millis * 1000; }
+void delay(unsigned long d) { g_millis += d; }
+void delayMicroseconds(unsigned int) {}
+long random(long m) { return m ? rand() % m : 0; }
+long random(long a, long b) { return b > a ? a + rand() % (b - a) : a; }
+void pinMode(uint8_t, uint8_t) {}
+// Nível dos pinos, os testes mudam direto
+int g_pins[64] = {};
+int digitalRead(uint8_t p) { return g_pins[p]; }
+void digitalWrite(uint8_t, uint8_t) {}
+void yield() {}
+int digitalPinToInterrupt(int p) { return p; }
+void attachInterrupt(int, void (*)(void), int) {}
+void attachInterruptArg(uint8_t, void (*)(void*), void*, int) {}
+void detachInterrupt(uint8_t) {}
+void noInterrupts() {}
+void interrupts() {}
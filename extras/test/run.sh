@@ -0,0 +1,31 @@
+#!/bin/sh
+# Testes da biblioteca no Linux, com mocks do core do Arduino em mock/.
+# Uso: extras/test/run.sh [teste ...]
+#   sem argumentos roda todos os test_*.cpp (ASan + UBSan)
+#   test_*_tsan.cpp são compilados com o ThreadSanitizer
+#   bench_*.cpp só rodam quando pedidos, compilados com -O2 e sem sanitizer
+cd "$(dirname "$0")" || exit 1
+SRC=../../src
+OUT=${TMPDIR:-/tmp}/lf_lora_test
+mkdir -p "$OUT"
+
+tests=$*
+if [ -z "$tests" ]; then
+  tests=$(ls test_*.cpp | sed 's/\.cpp$//')
+fi
+
+rc=0
+for t in $tests; do
+  t=${t%.cpp}
+  case $t in
+    *_tsan) flags="-O1 -g -fsanitize=thread" ;;
+    bench_*) flags="-O2" ;;
+    *) flags="-O1 -g -fsanitize=address,undefined -fno-sanitize-recover=all" ;;
+  esac
+  if ! g++ -std=gnu++17 -Wall $flags -I mock -I $SRC -o "$OUT/$t" "$t.cpp" $SRC/*.cpp mock/mock.cpp -lpthread; then
+    rc=1
+    continue
+  fi
+  "$OUT/$t" || rc=1
+done
+exit $rc
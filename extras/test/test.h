@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef	LF_LORA_TEST_H
+#define	LF_LORA_TEST_H
+
+#include <stdio.h>
+#include <atomic>
+
+// Verificação mínima para os testes no Linux, sem framework
+static int testFails = 0;
+
+#define CHECK(c) do { \
+  if (!(c)) { \
+    printf("%s:%d: falhou: %s\n", __FILE__, __LINE__, #c); \
+    testFails++; \
+  } \
+} while (0)
+
+#define TEST_END() (printf("%s: %s\n", __FILE__, testFails ? "FALHOU" : "ok"), testFails ? 1 : 0)
+
+// Relógio manual do mock (millis())
+extern std::atomic<unsigned long> g_millis;
+
+// Nível dos pinos do mock (digitalRead())
+extern int g_pins[64];
+
+#endif
@@ -0,0 +1,361 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// AEAD: AES e CMAC contra os vetores da FIPS-197 e da RFC 4493, chaves de
+// sessão no pareamento (100/101), quadros cifrados de ida e volta, quadros
+// adulterados e a janela contra repetição
+
+#define private public
+#include <LF_LoRa.h>
+#include "test.h"
+
+#include <string.h>
+#include <string>
+
+#define SLOT_LEN 200
+
+static const uint8_t devKey[LF_LORA_AES_BLOCK] = {
+  0x10, 0x21, 0x32, 0x43, 0x54, 0x65, 0x76, 0x87, 0x98, 0xA9, 0xBA, 0xCB, 0xDC, 0xED, 0xFE, 0x0F
+};
+static LF_LoRaClass *master = nullptr;
+
+/* -------------------------------------------------------------------------- */
+static void testAes() {
+
+  // FIPS-197, apêndice C.1
+  static const uint8_t key[16] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F
+  };
+  static const uint8_t pt[16] = {
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF
+  };
+  static const uint8_t ct[16] = {
+    0x69, 0xC4, 0xE0, 0xD8, 0x6A, 0x7B, 0x04, 0x30, 0xD8, 0xCD, 0xB7, 0x80, 0x70, 0xB4, 0xC5, 0x5A
+  };
+  LF_LoRaAead aead;
+  aead.setKey(key);
+  uint8_t out[16];
+  aead.encryptBlock(pt, out);
+  CHECK(memcmp(out, ct, 16) == 0);
+
+} /* testAes */
+
+/* -------------------------------------------------------------------------- */
+static void testCmac() {
+
+  // RFC 4493, seção 4. mac() toma o primeiro bloco como nonce e devolve a
+  // tag truncada em LF_LORA_AEAD_TAG_LEN bytes
+  static const uint8_t key[16] = {
+    0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6, 0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C
+  };
+  static const uint8_t k1[16] = {
+    0xFB, 0xEE, 0xD6, 0x18, 0x35, 0x71, 0x33, 0x66, 0x7C, 0x85, 0xE0, 0x8F, 0x72, 0x36, 0xA8, 0xDE
+  };
+  static const uint8_t k2[16] = {
+    0xF7, 0xDD, 0xAC, 0x30, 0x6A, 0xE2, 0x66, 0xCC, 0xF9, 0x0B, 0xC1, 0x1E, 0xE4, 0x6D, 0x51, 0x3B
+  };
+  static const uint8_t msg[64] = {
+    0x6B, 0xC1, 0xBE, 0xE2, 0x2E, 0x40, 0x9F, 0x96, 0xE9, 0x3D, 0x7E, 0x11, 0x73, 0x93, 0x17, 0x2A,
+    0xAE, 0x2D, 0x8A, 0x57, 0x1E, 0x03, 0xAC, 0x9C, 0x9E, 0xB7, 0x6F, 0xAC, 0x45, 0xAF, 0x8E, 0x51,
+    0x30, 0xC8, 0x1C, 0x46, 0xA3, 0x5C, 0xE4, 0x11, 0xE5, 0xFB, 0xC1, 0x19, 0x1A, 0x0A, 0x52, 0xEF,
+    0xF6, 0x9F, 0x24, 0x45, 0xDF, 0x4F, 0x9B, 0x17, 0xAD, 0x2B, 0x41, 0x7B, 0xE6, 0x6C, 0x37, 0x10
+  };
+  static const struct {
+    int len;
+    uint8_t tag[4];
+  } vectors[] = {
+    {16, {0x07, 0x0A, 0x16, 0xB4}},
+    {40, {0xDF, 0xA6, 0x67, 0x47}},
+    {64, {0x51, 0xF0, 0xBE, 0xBF}},
+  };
+  LF_LoRaAead aead;
+  aead.setKey(key);
+  CHECK(memcmp(aead._k1, k1, 16) == 0);
+  CHECK(memcmp(aead._k2, k2, 16) == 0);
+  for (const auto &v : vectors) {
+    uint8_t tag[LF_LORA_AEAD_TAG_LEN];
+    aead.mac(msg, msg + 16, v.len - 16, tag);
+    CHECK(memcmp(tag, v.tag, LF_LORA_AEAD_TAG_LEN) == 0);
+  }
+
+} /* testCmac */
+
+/* -------------------------------------------------------------------------- */
+static void testWindow() {
+
+  LF_LoRaAeadWindow w;
+  w.reset(0);
+  CHECK(w.check(1));
+  CHECK(!w.check(1));
+  // Fora de ordem dentro de LF_LORA_AEAD_WINDOW quadros
+  CHECK(w.check(5));
+  CHECK(w.check(3));
+  CHECK(w.check(2));
+  CHECK(!w.check(3));
+  CHECK(w.check(4));
+  CHECK(w.last() == 5);
+  CHECK(w.check(40));
+  CHECK(!w.check(40 - LF_LORA_AEAD_WINDOW));
+  CHECK(w.check(40 - LF_LORA_AEAD_WINDOW + 1));
+  CHECK(!w.check(5));
+  CHECK(!w.check(0));
+
+  // Contador inteiro a partir dos 16 bits baixos, nos dois sentidos da volta
+  w.reset(0xFFF0);
+  CHECK(w.expand(0xFFF1) == 0xFFF1);
+  CHECK(w.expand(0x0005) == 0x10005);
+  CHECK(w.check(0x10005));
+  CHECK(w.expand(0xFFF8) == 0xFFF8);
+  CHECK(w.check(0xFFF8));
+  CHECK(w.expand(0x8004) == 0x18004);
+
+} /* testWindow */
+
+/* -------------------------------------------------------------------------- */
+// Avança o relógio até o próximo envio do pareamento
+static bool waitSend(unsigned long limit) {
+  LF_LoRaClass &L = LF_LoRa;
+  size_t n = LoRa.sent.size();
+  for (unsigned long t = 0; t <= limit; t++) {
+    L._wheel.advance(lfLoRaMillis64());
+    L.pairingSendLoop();
+    if (LoRa.sent.size() > n) return true;
+    g_millis += 1;
+  }
+  return false;
+} /* waitSend */
+
+/* -------------------------------------------------------------------------- */
+static void testPairing() {
+
+  LF_LoRaClass &L = LF_LoRa;
+  L._sMac = "000000C0FFEE";
+  L._sLast6Mac = "C0FFEE";
+  L.setOpMode(LORA_OP_MODE_PAIRING);
+
+  // Chamada do master: contribuição nova para a rodada
+  char out[LF_LORA_MAX_PACKET_SIZE + 1];
+  const char *call = "!000000!FFFFFF!100!016!0200";
+  int len = master->loraEncode(call, strlen(call), out);
+  CHECK(master->_aeadPairTokenOk);
+  L.execMsgModePairing(out + 1, len - 1);
+
+  // Apresentação com a contribuição do escravo, o master guarda
+  CHECK(waitSend(16 * SLOT_LEN));
+  char token[9];
+  LF_LoRaFmt::fmtHex(token, sizeof(token), L._aeadPairTokens[0], 8);
+  std::string present = LoRa.sent.back();
+  CHECK(present == std::string("!FFFFFF!C0FFEE!100!000000C0FFEE!TEST!N") + token);
+  CHECK(master->loraDecode(present.c_str(), present.size(), out));
+  CHECK(master->_aeadPairRecs[0].token == L._aeadPairTokens[0]);
+  L._pairPending = false;
+
+  // Configuração em lote: só o escravo que se apresentou ganha chave
+  const char *cfg = "!FFFFFF!FFFFFF!101!001!000!AAAAAA007!C0FFEE005";
+  len = master->loraEncode(cfg, strlen(cfg), out);
+  LF_LoRaFmt::fmtHex(token, sizeof(token), master->_aeadPairToken, 8);
+  CHECK(std::string(out, len) == std::string(cfg) + "!N" + token);
+  CHECK(master->_aeadNodesLen == 1);
+  CHECK(master->_aeadNodes[0].addr == 5);
+  CHECK(Preferences::store().count("LoRa/aead") == 1);
+
+  L._stepNegotiation = LORA_STEP_NEG_CFG;
+  L._pairSlotLen = SLOT_LEN;
+  L.execMsgModePairing(out + 1, len - 1);
+  CHECK(L._pairOk && L._aeadPairKeyed[0]);
+  CHECK(waitSend(10 * SLOT_LEN));
+  CHECK(waitSend(10 * SLOT_LEN));
+  CHECK(L._opMode == LORA_OP_MODE_LOOP);
+
+  // Os dois lados com a mesma chave de sessão, que não é a do dispositivo
+  CHECK(L._aeadNodesLen == 1);
+  CHECK(L._aeadNodes[0].addr == 5);
+  CHECK(memcmp(L._aeadNodes[0].key, master->_aeadNodes[0].key, LF_LORA_AES_BLOCK) == 0);
+  CHECK(memcmp(L._aeadNodes[0].key, devKey, LF_LORA_AES_BLOCK) != 0);
+
+} /* testPairing */
+
+/* -------------------------------------------------------------------------- */
+static void testRoundTrip() {
+
+  LF_LoRaClass &L = LF_LoRa;
+  char out[LF_LORA_MAX_PACKET_SIZE + 1];
+  char dec[LF_LORA_MAX_PACKET_SIZE + 1];
+
+  // Descida: cabeçalho aberto, contador de 16 bits e tag de 4 bytes
+  int len = master->loraAddHeaderId("#on", 3, 5, 0x10, out);
+  CHECK(len == LF_LORA_HEADER_SIZE + 3 + LF_LORA_AEAD_OVERHEAD);
+  CHECK(LF_LORA_AEAD_OVERHEAD <= 6);
+  CHECK(memcmp(out + LF_LORA_HEADER_SIZE + LF_LORA_AEAD_CTR_LEN, "#on", 3) != 0);
+  CHECK(L.loraDecode(out, len, dec));
+  CHECK(strcmp(dec + LF_LORA_HEADER_SIZE, "#on") == 0);
+  // O mesmo quadro de novo é repetição
+  CHECK(!L.loraDecode(out, len, dec) && L._aeadReplay);
+
+  // Subida
+  len = L.loraAddHeaderId("#t=1", 4, 0, 0x81, out);
+  CHECK(master->loraDecode(out, len, dec));
+  CHECK(strcmp(dec + LF_LORA_HEADER_SIZE, "#t=1") == 0);
+
+  // Fora de ordem dentro da janela
+  std::string f[3];
+  for (int i = 0; i < 3; i++) {
+    len = master->loraAddHeaderId("#x", 2, 5, 0x20 + i, out);
+    f[i] = std::string(out, len);
+  }
+  CHECK(L.loraDecode(f[2].c_str(), f[2].size(), dec));
+  CHECK(L.loraDecode(f[0].c_str(), f[0].size(), dec));
+  CHECK(L.loraDecode(f[1].c_str(), f[1].size(), dec));
+  CHECK(!L.loraDecode(f[0].c_str(), f[0].size(), dec) && L._aeadReplay);
+
+  // Mais antigo que a janela
+  len = master->loraAddHeaderId("#x", 2, 5, 0x30, out);
+  std::string old(out, len);
+  for (int i = 0; i < LF_LORA_AEAD_WINDOW; i++) {
+    len = master->loraAddHeaderId("#x", 2, 5, 0x31, out);
+  }
+  CHECK(L.loraDecode(out, len, dec));
+  CHECK(!L.loraDecode(old.c_str(), old.size(), dec) && L._aeadReplay);
+
+  // O repetidor muda o contador de saltos, fora do nonce
+  len = master->loraAddHeaderId("#h", 2, 5, 0x40, out);
+  out[LORA_HOPS_POS] = '3';
+  CHECK(L.loraDecode(out, len, dec));
+
+} /* testRoundTrip */
+
+/* -------------------------------------------------------------------------- */
+static void testTamper() {
+
+  LF_LoRaClass &L = LF_LoRa;
+  char out[LF_LORA_MAX_PACKET_SIZE + 1];
+  char dec[LF_LORA_MAX_PACKET_SIZE + 1];
+  int len = master->loraAddHeaderId("#temp=22", 8, 5, 0x50, out);
+  std::string frame(out, len);
+
+  // Qualquer byte da tag, dos dados cifrados, do contador ou do cabeçalho
+  static const int positions[] = {len - 1, len - LF_LORA_AEAD_TAG_LEN, LF_LORA_HEADER_SIZE + LF_LORA_AEAD_CTR_LEN,
+                                  LF_LORA_HEADER_SIZE, 7};
+  for (int pos : positions) {
+    std::string bad = frame;
+    bad[pos] ^= (pos < LF_LORA_HEADER_SIZE) ? 0x01 : 0x40;
+    CHECK(!L.loraDecode(bad.c_str(), bad.size(), dec));
+    CHECK(!L._aeadReplay);
+  }
+  // A cópia certa ainda passa: o quadro adulterado não gastou o contador
+  CHECK(L.loraDecode(frame.c_str(), frame.size(), dec));
+
+} /* testTamper */
+
+/* -------------------------------------------------------------------------- */
+static void testGroupAndForeign() {
+
+  LF_LoRaClass &L = LF_LoRa;
+  char out[LF_LORA_MAX_PACKET_SIZE + 1];
+  char dec[LF_LORA_MAX_PACKET_SIZE + 1];
+  static const uint8_t groupKey[LF_LORA_AES_BLOCK] = {9, 9, 9, 9, 8, 8, 8, 8, 7, 7, 7, 7, 6, 6, 6, 6};
+
+  // Sem a chave de grupo não há como cifrar para o grupo
+  CHECK(master->loraAddHeaderId("#G", 2, 0xF1, 0x60, out) == 0);
+  master->setAeadGroupKey(groupKey);
+  L.setAeadGroupKey(groupKey);
+
+  // Grupo leva o contador inteiro
+  int len = master->loraAddHeaderId("#G", 2, 0xF1, 0x60, out);
+  CHECK(len == LF_LORA_HEADER_SIZE + 2 + LF_LORA_AEAD_OVERHEAD_GROUP);
+  CHECK(L.loraDecode(out, len, dec));
+  CHECK(strcmp(dec + LF_LORA_HEADER_SIZE, "#G") == 0);
+  // Só o master fala com o grupo
+  CHECK(L.loraAddHeaderId("#G", 2, 0xF1, 0x61, out) == 0);
+
+  // Quadro para outro escravo: sem a chave, o cabeçalho aberto basta para
+  // classificar (e repetir)
+  static const uint8_t other[LF_LORA_AES_BLOCK] = {7};
+  master->aeadNodeSet(7, other);
+  len = master->loraAddHeaderId("#on", 3, 7, 0x70, out);
+  uint8_t de, para;
+  CHECK(L.loraCheckMsgIni(out, len, de, para, dec) == LORA_MSG_CHECK_NOT_ME);
+  CHECK(L._aeadForeign && (para == 7));
+  CHECK(L.loraCheckMsgIni(out, len, de, para, dec) == LORA_MSG_CHECK_ALREADY_REC);
+
+  master->setAeadGroupKey(nullptr);
+  L.setAeadGroupKey(nullptr);
+
+} /* testGroupAndForeign */
+
+/* -------------------------------------------------------------------------- */
+static void testPersist() {
+
+  LF_LoRaClass &L = LF_LoRa;
+  char out[LF_LORA_MAX_PACKET_SIZE + 1];
+  char dec[LF_LORA_MAX_PACKET_SIZE + 1];
+
+  // Escravo reiniciado: chave de sessão do CfgRec, contador pulado adiante
+  uint8_t key[LF_LORA_AES_BLOCK];
+  memcpy(key, L._aeadNodes[0].key, sizeof(key));
+  uint32_t tx = L._aeadNodes[0].txCounter;
+  L._aeadNodesLen = 0;
+  L.inic();
+  CHECK((L._aeadNodesLen == 1) && (L._aeadNodes[0].addr == 5));
+  CHECK(memcmp(L._aeadNodes[0].key, key, sizeof(key)) == 0);
+  CHECK(L._aeadNodes[0].txCounter > tx);
+  int len = L.loraAddHeaderId("#t=2", 4, 0, 0x82, out);
+  CHECK(master->loraDecode(out, len, dec));
+
+  // Master reiniciado: chaves dos escravos do registro "aead"
+  std::map<std::string, std::vector<uint8_t>> prefs = Preferences::store();
+  Preferences::store().clear();
+  master->aeadSave();
+  LF_LoRaClass *m2 = new LF_LoRaClass();
+  m2->_netId = 1;
+  m2->setOnAeadDeviceKey([](const char *, uint8_t *) { return false; });
+  CHECK(m2->_aeadNodesLen == master->_aeadNodesLen);
+  CHECK(memcmp(m2->_aeadNodes[0].key, key, sizeof(key)) == 0);
+  CHECK(m2->_aeadNodes[0].txCounter == master->_aeadNodes[0].txCounter + LORA_NONCE_SAVE_STEP);
+  len = m2->loraAddHeaderId("#on", 3, 5, 0x11, out);
+  CHECK(L.loraDecode(out, len, dec));
+  m2->clearRegRecs();
+  delete m2;
+  Preferences::store() = prefs;
+
+} /* testPersist */
+
+/* -------------------------------------------------------------------------- */
+int main() {
+
+  testAes();
+  testCmac();
+  testWindow();
+
+  // Escravo (instância global) com a chave do dispositivo, master que a
+  // conhece pelo MAC
+  LF_LoRaClass &L = LF_LoRa;
+  L.slaveCfg("TEST");
+  L.inic();
+  L.setAeadKey(devKey);
+  master = new LF_LoRaClass();
+  master->_netId = 1;
+  master->setOnAeadDeviceKey([](const char *mac, uint8_t *key) {
+    if (strcmp(mac, "000000C0FFEE") != 0) return false;
+    memcpy(key, devKey, LF_LORA_AES_BLOCK);
+    return true;
+  });
+
+  testPairing();
+  testRoundTrip();
+  testTamper();
+  testGroupAndForeign();
+  testPersist();
+
+  master->clearRegRecs();
+  delete master;
+  return TEST_END();
+
+} /* main */
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// Analisador do canal (LF_LoRaAnalyzer): duplicadas e reenvios, troca do
+// remetente mais silencioso, histograma de RSSI e o resumo
+
+#include "LF_LoRa_Analyzer.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <string>
+
+/* -------------------------------------------------------------------------- */
+// Quadro só com o cabeçalho "NNDDPPIILLLL" e dados de enchimento
+static std::string frame(uint8_t net, uint8_t de, uint8_t para, uint8_t id, int len = 20) {
+  char h[13];
+  snprintf(h, sizeof(h), "%02X%02X%02X%02X%04X", net, de, para, id, len);
+  return std::string(h) + std::string(len - 12, 'x');
+} /* frame */
+
+/* -------------------------------------------------------------------------- */
+static bool hear(LF_LoRaAnalyzer &a, const std::string &f, int rssi, uint32_t airtime, uint32_t now) {
+  return a.frame(f.c_str(), f.size(), rssi, airtime, now);
+} /* hear */
+
+/* -------------------------------------------------------------------------- */
+static void testDupRetx() {
+
+  LF_LoRaAnalyzer a;
+  a.reset(0);
+
+  // Telemetria repetida pelo repetidor: duplicada, não reenvio
+  hear(a, frame(1, 5, 0, 10), -80, 50, 100);
+  hear(a, frame(1, 5, 0, 10), -90, 50, 150);
+  LF_LoRaSenderStats *s = a.sender(0);
+  CHECK((s->dups == 1) && (s->retx == 0) && !s->confPending);
+
+  // Confirmação (ID > 191) sem ack, depois outra: o escravo reenviou
+  hear(a, frame(1, 5, 0, 200), -80, 50, 200);
+  CHECK(s->confPending && (s->retx == 0));
+  hear(a, frame(1, 5, 0, 201), -80, 50, 300);
+  CHECK(s->retx == 1);
+
+  // Ack do master com o mesmo ID: não conta como confirmação dele
+  hear(a, frame(1, 0, 5, 201), -70, 40, 350);
+  CHECK(!s->confPending);
+  LF_LoRaSenderStats *m = a.sender(1);
+  CHECK((m->de == 0) && !m->confPending && (m->retx == 0));
+
+  // Confirmação nova depois do ack não é reenvio
+  hear(a, frame(1, 5, 0, 202), -80, 50, 400);
+  CHECK(s->retx == 1);
+  // A cópia do repetidor da mesma confirmação é duplicada
+  hear(a, frame(1, 5, 0, 202), -95, 50, 420);
+  CHECK((s->dups == 2) && (s->retx == 1));
+
+  // O mesmo escravo em outra rede é outro remetente
+  hear(a, frame(2, 5, 0, 202), -80, 50, 500);
+  CHECK(a.senderCount() == 3);
+
+  // Cabeçalho inválido só ocupa o canal
+  CHECK(!a.frame("ZZ0500C80014", 12, -80, 30, 600));
+  CHECK(!a.frame("0105", 4, -80, 30, 600));
+  CHECK(a.invalid() == 2);
+  CHECK(a.frames() == 10);
+  CHECK(a.airtime() == 50 * 7 + 40 + 2 * 30);
+
+} /* testDupRetx */
+
+/* -------------------------------------------------------------------------- */
+static void testEviction() {
+
+  LF_LoRaAnalyzer a;
+  a.reset(0);
+
+  // Tabela cheia, o remetente 7 com menos tempo no ar
+  for (int i = 0; i < LF_LORA_ANALYZER_SENDERS; i++) {
+    uint32_t airtime = (i == 7) ? 10 : 100 + i;
+    hear(a, frame(1, i, 0, 1), -80, airtime, 1000);
+  }
+  CHECK(a.senderCount() == LF_LORA_ANALYZER_SENDERS);
+
+  // O novo toma o lugar do mais silencioso
+  hear(a, frame(1, 0x40, 0, 1), -80, 500, 2000);
+  CHECK(a.senderCount() == LF_LORA_ANALYZER_SENDERS);
+  bool found7 = false;
+  bool found40 = false;
+  for (int i = 0; i < LF_LORA_ANALYZER_SENDERS; i++) {
+    found7 |= (a.sender(i)->de == 7);
+    found40 |= (a.sender(i)->de == 0x40);
+  }
+  CHECK(!found7 && found40);
+
+  // Empate no tempo no ar: sai quem está calado há mais tempo
+  LF_LoRaAnalyzer b;
+  b.reset(0);
+  for (int i = 0; i < LF_LORA_ANALYZER_SENDERS; i++) {
+    hear(b, frame(1, i, 0, 1), -80, 100, (i == 3) ? 10 : 1000 + i);
+  }
+  hear(b, frame(1, 0x41, 0, 1), -80, 100, 5000);
+  for (int i = 0; i < LF_LORA_ANALYZER_SENDERS; i++) {
+    CHECK(b.sender(i)->de != 3);
+  }
+
+  // O resumo conta a troca
+  CapturePrint out;
+  a.summary(out, 10000);
+  CHECK(out.data.compare(0, 4, "#AN#") == 0);
+  CHECK(out.data.find("#16#1\n") != std::string::npos);
+
+} /* testEviction */
+
+/* -------------------------------------------------------------------------- */
+static void testRssiBins() {
+
+  LF_LoRaAnalyzer a;
+  a.reset(0);
+
+  // Faixas de LF_LORA_ANALYZER_RSSI_STEP dB a partir de -130 dBm, os
+  // extremos caem na primeira e na última
+  static const int rssi[] = {-140, -130, -121, -120, -111, -70, -61, -60, -20};
+  static const uint16_t bins[LF_LORA_ANALYZER_RSSI_BINS] = {3, 2, 0, 0, 0, 0, 2, 2};
+  for (uint8_t i = 0; i < sizeof(rssi) / sizeof(rssi[0]); i++) {
+    hear(a, frame(1, 5, 0, i), rssi[i], 10, 100 * i);
+  }
+  LF_LoRaSenderStats *s = a.sender(0);
+  for (uint8_t b = 0; b < LF_LORA_ANALYZER_RSSI_BINS; b++) {
+    CHECK(s->rssiHist[b] == bins[b]);
+  }
+  CHECK((s->rssiMin == -140) && (s->rssiMax == -20));
+
+} /* testRssiBins */
+
+/* -------------------------------------------------------------------------- */
+static void testSummary() {
+
+  LF_LoRaAnalyzer a;
+  a.reset(0);
+  hear(a, frame(1, 5, 0, 10, 20), -100, 50, 1000);
+  hear(a, frame(1, 0, 5, 10, 16), -60, 40, 2000);
+  hear(a, frame(1, 5, 0, 11, 20), -80, 50, 3000);
+
+  // Totais, depois os remetentes do que mais ocupa o canal para o menos
+  CapturePrint out;
+  size_t n = a.summary(out, 10000);
+  CHECK(n == out.data.size());
+  CHECK(out.data ==
+        "#AN#10#3#140#14#0#2#0\n"
+        "#AS#01#05#2#40#100#10#-90#-100#-80#0#0#2000#2000#2000#0#0#0#1#0#1#0#0\n"
+        "#AS#01#00#1#16#40#4#-60#-60#-60#0#0#0#0#0#0#0#0#0#0#0#0#1\n");
+
+  // Depois do reset só a linha dos totais
+  a.reset(10000);
+  out.data.clear();
+  a.summary(out, 12000);
+  CHECK(out.data == "#AN#2#0#0#0#0#0#0\n");
+
+} /* testSummary */
+
+/* -------------------------------------------------------------------------- */
+int main() {
+  testDupRetx();
+  testEviction();
+  testRssiBins();
+  testSummary();
+  return TEST_END();
+} /* main */
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// Gestos do botão a partir de bordas roteirizadas, e o caminho da interrupção
+
+#define private public
+#include <LF_LoRa.h>
+#include "test.h"
+
+#include <vector>
+
+#define BTN_PIN 4
+
+struct Edge {
+  bool pressed;
+  unsigned long time;
+};
+
+/* -------------------------------------------------------------------------- */
+static uint8_t run(const std::vector<Edge> &edges, unsigned long end) {
+
+  // Último evento do LF_LoRaButton avaliado a cada ms
+  LF_LoRaButton b;
+  uint8_t last = BTN_EVT_NONE;
+  size_t i = 0;
+  for (unsigned long t = 0; t < end; t++) {
+    while ((i < edges.size()) && (edges[i].time == t)) {
+      b.edge(edges[i].pressed, t);
+      i++;
+    }
+    uint8_t evt = b.update(t);
+    if (evt != BTN_EVT_NONE) last = evt;
+  }
+  return last;
+
+} /* run */
+
+/* -------------------------------------------------------------------------- */
+static void testGestures() {
+
+  // Clique com repique nas duas bordas
+  CHECK(run({{1, 100}, {0, 102}, {1, 104}, {0, 200}, {1, 203}, {0, 205}}, 2000) == BTN_EVT_CLICK);
+  CHECK(run({{1, 100}, {0, 200}, {1, 300}, {0, 400}}, 2000) == BTN_EVT_DBL_CLICK);
+  CHECK(run({{1, 100}, {0, 1600}}, 3000) == BTN_EVT_LONG);
+  // Apertado além de BTN_LONG_TIME não gera nada
+  CHECK(run({{1, 100}, {0, 3500}}, 5000) == BTN_EVT_NONE);
+  // Pulso menor que o debounce é ignorado
+  CHECK(run({{1, 100}, {0, 105}}, 2000) == BTN_EVT_NONE);
+
+  std::vector<Edge> cfg;
+  for (unsigned long k = 0; k < BTN_CFG_CLICKS; k++) {
+    cfg.push_back({1, 100 + k * 200});
+    cfg.push_back({0, 200 + k * 200});
+  }
+  CHECK(run(cfg, 3000) == BTN_EVT_CFG);
+
+} /* testGestures */
+
+/* -------------------------------------------------------------------------- */
+static void testDeadline() {
+
+  // Prazo até o fim da sequência de cliques, parado não tem prazo
+  LF_LoRaButton b;
+  CHECK(b.nextDeadline(0) == BTN_NO_DEADLINE);
+  b.edge(true, 100);
+  CHECK(b.nextDeadline(110) == BTN_DEBOUNCE_TIME - 10);
+  b.edge(false, 200);
+  CHECK(b.update(220) == BTN_EVT_NONE);
+  CHECK(b.nextDeadline(220) == BTN_OFF_TIME - 20);
+  CHECK(b.update(200 + BTN_OFF_TIME) == BTN_EVT_CLICK);
+  CHECK(b.idle());
+  CHECK(b.nextDeadline(200 + BTN_OFF_TIME) == BTN_NO_DEADLINE);
+
+} /* testDeadline */
+
+/* -------------------------------------------------------------------------- */
+static void isrEdge(bool pressed) {
+  // Nível no pino e interrupção de borda
+  g_pins[BTN_PIN] = pressed;
+  LF_LoRaClass::btnIsr(&LF_LoRa);
+} /* isrEdge */
+
+/* -------------------------------------------------------------------------- */
+static void testIsr() {
+
+  LF_LoRaClass &L = LF_LoRa;
+  L.btnCfg(BTN_PIN, false);
+  // Sem ESP32 a interrupção não existe, o teste chama o btnIsr direto
+  CHECK(!L.setBtnIrqEnable(true));
+  L._btnIrqEnabled = true;
+
+  // A interrupção só enfileira, nada muda até o loop
+  g_millis = 1000;
+  isrEdge(true);
+  g_millis += 2;
+  isrEdge(false);
+  g_millis += 2;
+  isrEdge(true);
+  CHECK(!L._btnEdgeQueue.empty());
+  CHECK(L.timeToNextDeadline() == 0);
+  CHECK(L._btn._counter == 0);
+
+  g_millis += 100;
+  isrEdge(false);
+  // Loop atrasado: as bordas valem pelo momento da interrupção
+  g_millis += 300;
+  L.loopBtnLed();
+  CHECK(L._btnEdgeQueue.empty());
+  CHECK(!L.isBtnClickActive());
+  g_millis += 200;
+  L.loopBtnLed();
+  CHECK(L.isBtnClickActive());
+
+  // Fila cheia perde bordas, o loop corrige pelo nível atual
+  for (int i = 0; i < 2 * BTN_EDGE_QUEUE_LEN; i++) {
+    g_millis += 1;
+    isrEdge(i % 2 == 0);
+  }
+  g_pins[BTN_PIN] = 1;
+  L.loopBtnLed();
+  CHECK(L._lastBtnState);
+  g_millis += 100;
+  isrEdge(false);
+  g_millis += BTN_OFF_TIME + 10;
+  L.loopBtnLed();
+  L.loopBtnLed();
+  CHECK(L.isBtnClickActive());
+  CHECK(L._btn.idle());
+
+  L._btnIrqEnabled = false;
+
+} /* testIsr */
+
+/* -------------------------------------------------------------------------- */
+static void testLed() {
+
+  // LED do pareamento pisca no loopBtnLed, fora da interrupção
+  static bool led = false;
+  static int toggles = 0;
+  LF_LoRaClass &L = LF_LoRa;
+  L.onLedCheck = []() { return led; };
+  L.onLedTurnOnPairing = []() { led = true; toggles++; };
+  L.onLedTurnOffPairing = []() { led = false; toggles++; };
+
+  L._opMode = LORA_OP_MODE_PAIRING;
+  L._lastModoOp = LORA_OP_MODE_PAIRING;
+  for (int i = 0; i < 10; i++) {
+    g_millis += LED_CICLE_TIME / 5;
+    L.loopBtnLed();
+  }
+  CHECK((toggles >= 2) && (toggles <= 3));
+
+  L._opMode = LORA_OP_MODE_LOOP;
+  L.loopBtnLed();
+  CHECK(!led);
+
+} /* testLed */
+
+/* -------------------------------------------------------------------------- */
+int main() {
+
+  testGestures();
+  testDeadline();
+
+  LF_LoRaClass &L = LF_LoRa;
+  L.slaveCfg("TEST");
+  L.inic();
+  L._netId = 1;
+  L.setMyAddr(5);
+  L.setMasterAddr(0);
+  L.setOpMode(LORA_OP_MODE_LOOP);
+
+  testIsr();
+  testLed();
+
+  return TEST_END();
+
+} /* main */
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// Captura de quadros e replay sem efeitos no nó
+
+#define private public
+#include <LF_LoRa.h>
+#include "test.h"
+
+#include <string>
+
+static int execCount = 0;
+static LF_LoRaClass *sender = nullptr; // Com AEAD, tem a chave de todos os pares
+
+/* -------------------------------------------------------------------------- */
+static int frame(const char *msg, uint8_t de, uint8_t para, uint8_t id, char *out) {
+  LF_LoRaClass &S = (sender != nullptr) ? *sender : LF_LoRa;
+  return S.loraAddHeaderDe(msg, strlen(msg), de, para, id, out);
+} /* frame */
+
+/* -------------------------------------------------------------------------- */
+static void feed() {
+
+  char out[LF_LORA_MAX_PACKET_SIZE + 1];
+  int n;
+
+  n = frame("#on", 0x00, 0x05, 0x10, out);
+  CHECK(LF_LoRa.loraMsgProcess(out, n));            // OK
+  CHECK(!LF_LoRa.loraMsgProcess(out, n));           // ALREADY_REC
+  n = frame("#on", 0x00, 0x07, 0x11, out);
+  LF_LoRa.loraMsgProcess(out, n);                   // NOT_ME
+  n = frame("#on", 0x09, 0x05, 0x12, out);
+  LF_LoRa.loraMsgProcess(out, n);                   // NOT_MASTER
+  LF_LoRa.loraMsgProcess("ZZ0005120011#on", 15);    // ERROR
+
+} /* feed */
+
+/* -------------------------------------------------------------------------- */
+static void testReplay(bool aead) {
+
+  LF_LoRaClass &L = LF_LoRa;
+  static const uint8_t key[LF_LORA_AES_BLOCK] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+  L.setAeadKey(aead ? key : nullptr);
+  L.clearRegRecs();
+  L._aeadNodesLen = 0;
+  if (aead) {
+    // O nó só tem a chave de sessão dele, os quadros para 7 e de 9 chegam
+    // sem chave e são classificados pelo cabeçalho aberto
+    L.aeadNodeSet(0x05, key);
+    sender = new LF_LoRaClass();
+    sender->_netId = 0x01;
+    sender->_masterAddr = 0x00;
+    sender->aeadKeyApply(key);
+    sender->aeadNodeSet(0x05, key);
+    sender->aeadNodeSet(0x07, key);
+    sender->aeadNodeSet(0x09, key);
+  }
+  L.setCaptureEnable(true);
+
+  execCount = 0;
+  feed();
+  CHECK(execCount == 1);
+  CHECK(L.captureCount() == 5);
+
+  // Guarda o que captureDump escreve
+  CapturePrint trace;
+  L.captureDump(trace);
+
+  // Estado do nó antes do replay
+  int regRecsLen = L._regRecsLen;
+  RegRec regRecs[8];
+  memcpy(regRecs, L._regRecs, regRecsLen * sizeof(RegRec));
+  AeadNodeRec aeadNodes[LORA_AEAD_NODES];
+  memcpy(aeadNodes, L._aeadNodes, sizeof(aeadNodes));
+  uint8_t aeadNodesLen = L._aeadNodesLen;
+  uint8_t fwdRecsLen = L._fwdRecsLen;
+  std::map<std::string, std::vector<uint8_t>> prefs = Preferences::store();
+
+  for (int pass = 0; pass < 2; pass++) {
+    CaptureStats stats;
+    CHECK(L.captureReplay((const uint8_t *)trace.data.data(), trace.data.size(), &stats) == 5);
+    CHECK(stats.frames == 5);
+    CHECK(stats.mismatches == 0);
+    CHECK(stats.verdicts[LORA_MSG_CHECK_OK] == 1);
+    CHECK(stats.verdicts[LORA_MSG_CHECK_ALREADY_REC] == 1);
+    CHECK(stats.verdicts[LORA_MSG_CHECK_NOT_ME] == 1);
+    CHECK(stats.verdicts[LORA_MSG_CHECK_NOT_MASTER] == 1);
+    CHECK(stats.verdicts[LORA_MSG_CHECK_ERROR] == 1);
+  }
+
+  // Nada executado, capturado, enviado ou gravado
+  CHECK(execCount == 1);
+  CHECK(L.captureCount() == 5);
+  CHECK(L._regRecsLen == regRecsLen);
+  CHECK(memcmp(L._regRecs, regRecs, regRecsLen * sizeof(RegRec)) == 0);
+  CHECK(L._aeadNodesLen == aeadNodesLen);
+  CHECK(memcmp(L._aeadNodes, aeadNodes, sizeof(aeadNodes)) == 0);
+  CHECK(Preferences::store() == prefs);
+  CHECK(L._fwdRecsLen == fwdRecsLen);
+
+  // Trace inválido
+  CHECK(L.captureReplay((const uint8_t *)"LFCQ\x01", 5) == 0);
+
+  L.setCaptureEnable(false);
+  if (sender != nullptr) {
+    sender->clearRegRecs();
+    delete sender;
+    sender = nullptr;
+  }
+
+} /* testReplay */
+
+/* -------------------------------------------------------------------------- */
+int main() {
+
+  LF_LoRaClass &L = LF_LoRa;
+  L.slaveCfg("TEST");
+  L.setOnExecMsgModeLoop([](String, MsgType) { execCount++; });
+  L.inic();
+  L._netId = 0x01;
+  L.setMyAddr(0x05);
+  L.setMasterAddr(0x00);
+  L.setOpMode(LORA_OP_MODE_LOOP);
+  L.setRepeaterEnable(true);
+
+  testReplay(false);
+  testReplay(true);
+  return TEST_END();
+
+} /* main */
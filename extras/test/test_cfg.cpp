@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// Configuração na memória não volátil: chaves antigas, registro CfgRec e
+// IDs de sequência pulados adiante no início
+
+#define private public
+#include <LF_LoRa.h>
+#include "test.h"
+
+/* -------------------------------------------------------------------------- */
+static void testLegacyKeys() {
+
+  LF_LoRaClass &L = LF_LoRa;
+
+  // Placa pareada com o firmware antigo: só as chaves soltas, sem IDs
+  Preferences p;
+  p.begin("LoRa");
+  p.putUInt("opMode", LORA_OP_MODE_LOOP);
+  p.putUInt("netId", 7);
+  p.putUInt("masterAddr", 1);
+  p.putUInt("myAddr", 9);
+  p.end();
+
+  L.inic();
+  CHECK((L._opMode == LORA_OP_MODE_LOOP) && (L._netId == 7) && (L._masterAddr == 1) && (L._myAddr == 9));
+  // IDs pulados adiante do início fixo do firmware antigo
+  CHECK(L._lastSendIdTele == 128 + LORA_ID_SAVE_STEP);
+  CHECK(L._lastSendIdConf == 192 + LORA_ID_SAVE_STEP);
+
+  // O primeiro envio grava o registro novo
+  CHECK(Preferences::store().count("LoRa/cfg") == 0);
+  uint8_t id = L.getNextIdTeleToSend();
+  CHECK(id == 128 + LORA_ID_SAVE_STEP + 1);
+  CHECK(Preferences::store().count("LoRa/cfg") == 1);
+
+  // Reiniciando, vale o registro, pulado adiante de novo
+  L._lastSendIdTele = 128;
+  L._savedIdTele = 128;
+  L.inic();
+  CHECK(L._myAddr == 9);
+  CHECK(L._lastSendIdTele == id + LORA_ID_SAVE_STEP);
+
+} /* testLegacyKeys */
+
+/* -------------------------------------------------------------------------- */
+int main() {
+
+  LF_LoRaClass &L = LF_LoRa;
+  L.slaveCfg("TEST");
+
+  testLegacyKeys();
+
+  return TEST_END();
+
+} /* main */
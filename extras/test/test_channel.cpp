@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// Plano de canais: canal atribuído, varredura do gateway e vazão agregada
+
+#define private public
+#include <LF_LoRa.h>
+#include "test.h"
+
+#include <algorithm>
+#include <math.h>
+#include <vector>
+
+static const long plan[4] = {915000000, 915200000, 915400000, 915600000};
+
+/* -------------------------------------------------------------------------- */
+static void testHopping() {
+
+  LF_LoRaClass &L = LF_LoRa;
+  L._channel = 1;
+  L.setOpMode(LORA_OP_MODE_LOOP);
+  CHECK(L.currentFrequency() == plan[1]);
+  CHECK(LoRa.frequency == plan[1]);
+
+  // O gateway varre o plano sem perder o canal atribuído
+  L.setChannelHopping(100);
+  long seen[4] = {};
+  for (int i = 0; i < 4; i++) {
+    g_millis += 101;
+    L.loopLora();
+    seen[L._hopIndex] = LoRa.frequency;
+    CHECK(L.channel() == 1);
+  }
+  for (int i = 0; i < 4; i++) {
+    CHECK(seen[i] == plan[i]);
+  }
+
+  // Gravado continua o atribuído
+  L.saveCfg();
+  CfgRec cfg;
+  Preferences pref;
+  pref.begin("LoRa", true);
+  CHECK(pref.getBytes("cfg", &cfg, sizeof(cfg)) == sizeof(cfg));
+  pref.end();
+  CHECK(cfg.channel == 1);
+
+  // Sem varredura, volta para o canal atribuído
+  L.setChannelHopping(0);
+  CHECK(LoRa.frequency == plan[1]);
+
+} /* testHopping */
+
+/* -------------------------------------------------------------------------- */
+static uint32_t aloha(uint8_t channels, uint8_t nodesPerChannel, uint32_t airtime, uint32_t duration) {
+
+  // ALOHA puro: cada nó envia em média a cada interval ms (exponencial) no
+  // seu canal, o gateway multicanal recebe o quadro que não se sobrepõe a
+  // outro no mesmo canal. Carga de 0,5 por canal.
+  uint32_t interval = 2 * nodesPerChannel * airtime;
+  std::vector<std::pair<uint32_t, uint8_t>> txs;
+  srand(1);
+  for (uint16_t node = 0; node < channels * nodesPerChannel; node++) {
+    double t = 0;
+    while (true) {
+      t += -log((rand() + 1.0) / (RAND_MAX + 2.0)) * interval;
+      if (t >= duration) break;
+      txs.push_back({(uint32_t)t, node % channels});
+    }
+  }
+  std::sort(txs.begin(), txs.end());
+
+  uint32_t ok = 0;
+  for (size_t i = 0; i < txs.size(); i++) {
+    bool hit = false;
+    for (size_t j = i; (j-- > 0) && (txs[i].first - txs[j].first < airtime);) {
+      if (txs[j].second == txs[i].second) hit = true;
+    }
+    for (size_t j = i + 1; (j < txs.size()) && (txs[j].first - txs[i].first < airtime); j++) {
+      if (txs[j].second == txs[i].second) hit = true;
+    }
+    if (!hit) ok++;
+  }
+  return ok;
+
+} /* aloha */
+
+/* -------------------------------------------------------------------------- */
+static void testThroughput() {
+
+  // Quadro de telemetria típico: cabeçalho + 32 bytes
+  uint32_t airtime = LF_LoRa.loraAirtime(LF_LORA_HEADER_SIZE + 32);
+  CHECK(airtime > 0);
+
+  uint32_t duration = 3600000;
+  uint32_t one = aloha(1, 16, airtime, duration);
+  printf("canais  quadros/h  por canal\n");
+  for (uint8_t channels = 1; channels <= 4; channels *= 2) {
+    uint32_t ok = aloha(channels, 16, airtime, duration);
+    printf("%6u %10u %10u\n", channels, ok, ok / channels);
+    // Mesma carga por canal: a vazão agregada cresce com o número de canais
+    CHECK(ok > one * channels * 8 / 10);
+    CHECK(ok < one * channels * 12 / 10);
+  }
+
+} /* testThroughput */
+
+/* -------------------------------------------------------------------------- */
+int main() {
+
+  LF_LoRaClass &L = LF_LoRa;
+  L.slaveCfg("TEST");
+  L.setChannelPlan(plan, 4);
+  L.inic();
+  L.loopLora();
+  CHECK(L.radioReady());
+
+  testHopping();
+  testThroughput();
+  return TEST_END();
+
+} /* main */
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// Fuzz do LF_LoRaCmd e do pareamento: entradas aleatórias e mutações de
+// comandos válidos, em buffers do tamanho exato (sem '\0') para o ASan
+// pegar qualquer leitura fora
+
+#define private public
+#include <LF_LoRa.h>
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#define ROUNDS 200000
+
+// Mesmas tabelas do LF_LoRa.cpp e do exemplo LF_LoRa_USB_Adapter_01
+static constexpr LF_LoRaCmdSpec pairingCmds[] = {
+  {"100", 0, 2, 0x03, false, {3, 4, 4, 4}},
+  {"101", 3, LF_LORA_CMD_ANY, 0x03, false, {3, 3, 0, 0}},
+};
+static constexpr LF_LoRaCmdSpec usbCmds[] = {
+  {"000", 0, 0, 0x00, true, {0, 0, 0, 0}},
+  {"001", 2, 2, 0x01, true, {3, 5, 5, 5}},
+};
+
+static const char *seeds[] = {
+  "000000!FFFFFF!100",
+  "000000!FFFFFF!100!016!0200",
+  "A1B2C3!FFFFFF!101!001!000!005",
+  "A1B2C3!FFFFFF!101!001!000!005!003!G0A0B",
+  "FFFFFF!FFFFFF!101!001!000!A1B2C3005003G0A!D4E5F6006",
+  "!000",
+  "!001018915E6",
+  "!001052433.1",
+};
+
+/* -------------------------------------------------------------------------- */
+static std::vector<char> input() {
+
+  // Metade aleatória, metade mutação de uma semente
+  std::vector<char> in;
+  if (rand() % 2) {
+    int len = rand() % 80;
+    static const char alpha[] = "!0123456789ABCDEFabcdefG.Ee-+#\0\xff";
+    for (int i = 0; i < len; i++) {
+      in.push_back((rand() % 4) ? alpha[rand() % (sizeof(alpha) - 1)] : (char)rand());
+    }
+    return in;
+  }
+  const char *s = seeds[rand() % (sizeof(seeds) / sizeof(seeds[0]))];
+  in.assign(s, s + strlen(s));
+  for (int m = rand() % 4; m >= 0; m--) {
+    int pos = in.empty() ? 0 : rand() % (in.size() + 1);
+    switch (rand() % 4) {
+      case 0: if (pos < (int)in.size()) in[pos] = (char)rand(); break;
+      case 1: in.insert(in.begin() + pos, (rand() % 2) ? '!' : (char)('0' + rand() % 10)); break;
+      case 2: if (pos < (int)in.size()) in.erase(in.begin() + pos); break;
+      case 3: in.resize(pos); break;
+    }
+  }
+  return in;
+
+} /* input */
+
+/* -------------------------------------------------------------------------- */
+static bool inside(const LF_LoRaToken &t, const char *buf, int len) {
+  return (t.len == 0) || ((t.ptr >= buf) && (t.ptr + t.len <= buf + len));
+} /* inside */
+
+/* -------------------------------------------------------------------------- */
+static void useToken(const LF_LoRaToken &t) {
+  // Todos os acessos do token, o resultado não importa
+  volatile uint32_t sink = 0;
+  sink = sink + t.toInt();
+  sink = sink + (t.toFloat() > 0);
+  sink = sink + t.isDigits() + t.isHex() + t.equals("100") + t.equalsIgnoreCase("FFFFFF");
+  LF_LoRaToken s = t.sub(rand() % 8, rand() % 8);
+  sink = sink + s.len + s.toInt();
+} /* useToken */
+
+/* -------------------------------------------------------------------------- */
+static void fuzzCmd(const std::vector<char> &in) {
+
+  int len = in.size();
+  char *buf = new char[len > 0 ? len : 1];
+  if (len > 0) memcpy(buf, in.data(), len);
+
+  LF_LoRaCmd cmd;
+  if (cmd.parse(buf, len)) {
+    CHECK(cmd.count() >= 1);
+    CHECK(cmd.count() <= LF_LORA_CMD_MAX_TOKENS);
+    for (uint8_t i = 0; i < cmd.count(); i++) {
+      CHECK(inside(cmd.token(i), buf, len));
+      useToken(cmd.token(i));
+    }
+    const LF_LoRaCmdSpec *tables[2] = {pairingCmds, usbCmds};
+    for (int k = 0; k < 2; k++) {
+      for (uint8_t idx = 0; idx < 4; idx++) {
+        if (cmd.match(tables[k], 2, idx) == nullptr) {
+          CHECK(cmd.argCount() == 0);
+          continue;
+        }
+        for (uint8_t a = 0; a <= cmd.argCount(); a++) {
+          CHECK(inside(cmd.arg(a), buf, len));
+          useToken(cmd.arg(a));
+        }
+      }
+    }
+  }
+
+  delete[] buf;
+
+} /* fuzzCmd */
+
+/* -------------------------------------------------------------------------- */
+static void fuzzPairing(const std::vector<char> &in) {
+
+  // Pareamento recebendo o comando, em qualquer passo da negociação
+  LF_LoRaClass &L = LF_LoRa;
+  int len = in.size();
+  char *buf = new char[len > 0 ? len : 1];
+  if (len > 0) memcpy(buf, in.data(), len);
+
+  L.setOpMode(LORA_OP_MODE_PAIRING);
+  L._stepNegotiation = (rand() % 2) ? LORA_STEP_NEG_INIC : LORA_STEP_NEG_CFG;
+  L.execMsgModePairing(buf, len);
+  // Endereço de grupo nunca vira endereço de nó
+  CHECK(L._pairMyAddr < LORA_ADDR_GROUP_FIRST);
+  CHECK(L._myAddr < LORA_ADDR_GROUP_FIRST);
+  CHECK(L._endpoints[0].pairAddr < LORA_ADDR_GROUP_FIRST);
+
+  delete[] buf;
+
+} /* fuzzPairing */
+
+/* -------------------------------------------------------------------------- */
+int main() {
+
+  LF_LoRaClass &L = LF_LoRa;
+  L.slaveCfg("TEST");
+  L.addEndpoint("SUB", nullptr);
+  L.inic();
+
+  srand(42);
+  for (int r = 0; r < ROUNDS; r++) {
+    std::vector<char> in = input();
+    fuzzCmd(in);
+    if ((r % 8) == 0) fuzzPairing(in);
+  }
+
+  return TEST_END();
+
+} /* main */
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// Telemetria em delta contra o último estado confirmado
+
+#define private public
+#include <LF_LoRa.h>
+#include "test.h"
+
+/* -------------------------------------------------------------------------- */
+static void ack() {
+  // Confirmação do master para a mensagem enviada
+  LF_LoRa._internalMsgStatus = INT_STATUS_EMPTY;
+  LF_LoRa._internalLastMsgStatus = INT_STATUS_EMPTY;
+  LF_LoRa.deltaAck();
+} /* ack */
+
+/* -------------------------------------------------------------------------- */
+static void send() {
+  g_millis += 10;
+  LF_LoRa.loopLora();
+} /* send */
+
+/* -------------------------------------------------------------------------- */
+static void testSaved() {
+
+  LF_LoRaClass &L = LF_LoRa;
+  L.setDeltaEnable(true);
+
+  // Primeiro estado vai completo, com confirmação, e vira a base
+  L.sendState("#220.1#100#0.45#OFF", MSG_TYPE_TELEMETRY);
+  CHECK(L._internalMsgStatus == INT_STATUS_CONFIRM);
+  send();
+  CHECK(L._internalSentMsg == "#220.1#100#0.45#OFF");
+  ack();
+  CHECK(L._deltaBaseOk);
+  CHECK(L.deltaBytesSaved() == 0);
+
+  // Delta substituído antes de ir para o ar não conta
+  L.sendState("#220.1#101#0.45#OFF", MSG_TYPE_TELEMETRY);
+  CHECK(L._internalMsg.charAt(0) == LORA_DELTA_CHAR);
+  L.sendState("#220.1#102#0.45#OFF", MSG_TYPE_TELEMETRY);
+  CHECK(L.deltaBytesSaved() == 0);
+  send();
+  String sDelta = L._internalSentMsg;
+  CHECK(sDelta.charAt(0) == LORA_DELTA_CHAR);
+  CHECK(L.deltaBytesSaved() == strlen("#220.1#102#0.45#OFF") - sDelta.length());
+  CHECK(L._deltaCount == 1);
+
+  // O master reconstrói o estado
+  String sOut;
+  CHECK(L.deltaApply(sDelta, "#220.1#100#0.45#OFF", L._deltaBaseId, sOut));
+  CHECK(sOut == "#220.1#102#0.45#OFF");
+
+} /* testSaved */
+
+/* -------------------------------------------------------------------------- */
+int main() {
+
+  LF_LoRaClass &L = LF_LoRa;
+  L.slaveCfg("TEST");
+  L.inic();
+  L._netId = 0x01;
+  L.setMyAddr(0x05);
+  L.setMasterAddr(0x00);
+  L.setOpMode(LORA_OP_MODE_LOOP);
+  L.loopLora();
+
+  testSaved();
+  return TEST_END();
+
+} /* main */
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// Descarte cedo: quadro de outra rede, para outro nó ou já recebido sai
+// depois de ler só o cabeçalho do rádio
+
+#define private public
+#include <LF_LoRa.h>
+#include "test.h"
+
+#include <string.h>
+#include <string>
+
+static int execCount = 0;
+
+/* -------------------------------------------------------------------------- */
+static std::string frame(uint8_t net, uint8_t de, uint8_t para, uint8_t id, const char *msg) {
+  LF_LoRaClass &L = LF_LoRa;
+  char out[LF_LORA_MAX_PACKET_SIZE + 1];
+  uint8_t myNet = L._netId;
+  L._netId = net;
+  int len = L.loraAddHeaderDe(msg, strlen(msg), de, para, id, out);
+  L._netId = myNet;
+  return std::string(out, len);
+} /* frame */
+
+/* -------------------------------------------------------------------------- */
+// Entrega o quadro ao rádio e roda a recepção, devolve os bytes lidos
+static int receive(const std::string &f, bool &ok) {
+  LoRa.reads = 0;
+  LoRa.deliver(f);
+  ok = LF_LoRa.loraMsgReceiveLoop();
+  return LoRa.reads;
+} /* receive */
+
+/* -------------------------------------------------------------------------- */
+static void testDrop() {
+
+  LF_LoRaClass &L = LF_LoRa;
+  bool ok;
+  uint32_t drops = L.earlyDropCount();
+  std::string payload(100, 'x');
+  payload[0] = '#';
+
+  // Outra rede
+  CHECK(receive(frame(0x02, 0x00, 0x05, 0x10, payload.c_str()), ok) == LF_LORA_HEADER_SIZE);
+  CHECK(!ok && (L.earlyDropCount() == ++drops));
+
+  // Para outro nó
+  CHECK(receive(frame(0x01, 0x00, 0x07, 0x11, payload.c_str()), ok) == LF_LORA_HEADER_SIZE);
+  CHECK(!ok && (L.earlyDropCount() == ++drops));
+
+  // Para mim: caminho completo, lido inteiro e executado
+  std::string mine = frame(0x01, 0x00, 0x05, 0x12, payload.c_str());
+  CHECK(receive(mine, ok) == (int)mine.size());
+  CHECK(ok && (execCount == 1));
+  CHECK(L.earlyDropCount() == drops);
+
+  // A mesma de novo: já recebida
+  CHECK(receive(mine, ok) == LF_LORA_HEADER_SIZE);
+  CHECK(!ok && (L.earlyDropCount() == ++drops));
+  CHECK(execCount == 1);
+
+  // Difusão passa pelo caminho completo
+  std::string bcast = frame(0x01, 0x00, 0xFF, 0x13, "#all");
+  CHECK(receive(bcast, ok) == (int)bcast.size());
+  CHECK(L.earlyDropCount() == drops);
+
+  // O repetidor precisa ver o quadro para outro nó inteiro
+  L.setRepeaterEnable(true);
+  std::string other = frame(0x01, 0x00, 0x07, 0x14, payload.c_str());
+  CHECK(receive(other, ok) == (int)other.size());
+  CHECK(!ok && (L.earlyDropCount() == drops));
+  L.setRepeaterEnable(false);
+
+} /* testDrop */
+
+/* -------------------------------------------------------------------------- */
+int main() {
+
+  LF_LoRaClass &L = LF_LoRa;
+  L.slaveCfg("TEST");
+  L.setOnExecMsgModeLoop([](String, MsgType) { execCount++; });
+  L.inic();
+  L._netId = 0x01;
+  L.setMyAddr(0x05);
+  L.setMasterAddr(0x00);
+  L.setOpMode(LORA_OP_MODE_LOOP);
+
+  testDrop();
+
+  return TEST_END();
+
+} /* main */
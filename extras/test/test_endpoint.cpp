@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// Endpoints lógicos: pareamento sem bloquear o loop e um escalonador de
+// envio para o principal e todos os endpoints
+
+#define private public
+#include <LF_LoRa.h>
+#include "test.h"
+
+#define EPS 3
+
+/* -------------------------------------------------------------------------- */
+static void loopFor(unsigned long ms) {
+  for (unsigned long i = 0; i < ms; i++) {
+    g_millis++;
+    LF_LoRa.loopLora();
+  }
+} /* loopFor */
+
+/* -------------------------------------------------------------------------- */
+static void testPairing() {
+
+  LF_LoRaClass &L = LF_LoRa;
+  L.setOpMode(LORA_OP_MODE_PAIRING);
+
+  // Apresentação do principal e dos endpoints sai pelo loop, sem delay()
+  unsigned long start = g_millis;
+  size_t sent = LoRa.sent.size();
+  L.execMsgModePairing("000000!FFFFFF!100", 17);
+  CHECK(g_millis == start);
+  CHECK(LoRa.sent.size() == sent);
+  CHECK(L._pairPending);
+  CHECK(L.timeToNextDeadline() > 0);
+  for (uint8_t ep = 0; ep < EPS; ep++) {
+    CHECK(L._endpoints[ep].pairPending);
+  }
+
+  // Endpoint com a apresentação vencida acorda o loop
+  L._wheel.advance(lfLoRaMillis64() + 2000);
+  L._wheel.cancel(L._tmrPair);
+  L._pairPending = false;
+  CHECK(L.timeToNextDeadline() == 0);
+  L.pairingSendLoop();
+  L.pairingSendLoop();
+  L.pairingSendLoop();
+  CHECK(LoRa.sent.size() == sent + EPS);
+  CHECK(L.timeToNextDeadline() != 0);
+
+  // Configuração em lote para o principal e os endpoints
+  String b = "FFFFFF!FFFFFF!101!001!000!" + L._sLast6Mac + "005";
+  for (uint8_t ep = 0; ep < EPS; ep++) {
+    b += "!" + L._endpoints[ep].sLast6Mac + "00" + String(6 + ep);
+  }
+  L.execMsgModePairing(b.c_str(), b.length());
+  CHECK(g_millis == start);
+  loopFor(5000);
+  CHECK(L.opMode() == LORA_OP_MODE_LOOP);
+  CHECK(L.myAddr() == 5);
+  for (uint8_t ep = 1; ep <= EPS; ep++) {
+    CHECK(L.endpointAddr(ep) == 5 + ep);
+  }
+
+} /* testPairing */
+
+/* -------------------------------------------------------------------------- */
+static void testScheduler() {
+
+  LF_LoRaClass &L = LF_LoRa;
+
+  // Principal e todos os endpoints com telemetria ao mesmo tempo
+  size_t first = LoRa.sent.size();
+  L.sendState("#0", MSG_TYPE_TELEMETRY);
+  for (uint8_t ep = 1; ep <= EPS; ep++) {
+    L.sendState(ep, "#" + String(ep), MSG_TYPE_TELEMETRY);
+  }
+  CHECK(L.timeToNextDeadline() == 0);
+
+  loopFor(L._msgSendIntervalBase);
+  CHECK(LoRa.sent.size() - first == EPS + 1);
+
+  // Nunca emendados: espaçados por ao menos metade da fração do intervalo
+  unsigned long gap = L._msgSendIntervalBase / (EPS + 1);
+  for (size_t i = first + 1; i < LoRa.sent.size(); i++) {
+    CHECK(LoRa.sentTime[i] - LoRa.sentTime[i - 1] >= gap / 2);
+  }
+
+  // Mensagem de endpoint esperando pelo escalonador não acorda o loop, o
+  // prazo do escalonador acorda. Sem prazo armado, sai já
+  L.sendState(1, "#9", MSG_TYPE_TELEMETRY);
+  L._wheel.add(L._tmrEpTx, 300);
+  uint32_t next = L.timeToNextDeadline();
+  CHECK((next > 0) && (next <= 300));
+  L._wheel.cancel(L._tmrEpTx);
+  L._wheel.cancel(L._endpoints[0].sendTimer);
+  CHECK(L.timeToNextDeadline() == 0);
+
+} /* testScheduler */
+
+/* -------------------------------------------------------------------------- */
+int main() {
+
+  LF_LoRaClass &L = LF_LoRa;
+  L.slaveCfg("MAIN");
+  for (uint8_t ep = 0; ep < EPS; ep++) {
+    L.addEndpoint("SUB", nullptr);
+  }
+  L.inic();
+
+  testPairing();
+  testScheduler();
+
+  return TEST_END();
+
+} /* main */
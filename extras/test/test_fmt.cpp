@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// Formatação e leitura de números, conferidas com snprintf/strtol/strtof
+
+#include <LF_LoRa_Fmt.h>
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* -------------------------------------------------------------------------- */
+static void testFmt() {
+
+  char a[32], b[32];
+  int32_t ints[] = {0, 7, -7, 123456, -2147483647 - 1, 2147483647};
+  for (int32_t v : ints) {
+    LF_LoRaFmt::fmtInt(a, sizeof(a), v);
+    snprintf(b, sizeof(b), "%ld", (long)v);
+    CHECK(strcmp(a, b) == 0);
+    LF_LoRaFmt::fmtInt(a, sizeof(a), v, 6);
+    snprintf(b, sizeof(b), "%06ld", (long)v);
+    CHECK(strcmp(a, b) == 0);
+  }
+  LF_LoRaFmt::fmtHex(a, sizeof(a), 0xBEEF, 8);
+  CHECK(strcmp(a, "0000BEEF") == 0);
+  LF_LoRaFmt::fmtFixed(a, sizeof(a), -4512, 3);
+  CHECK(strcmp(a, "-4.512") == 0);
+  LF_LoRaFmt::fmtFixed(a, sizeof(a), 5, 2);
+  CHECK(strcmp(a, "0.05") == 0);
+
+  // Não coube: 0 e buffer vazio
+  CHECK(LF_LoRaFmt::fmtInt(a, 4, 12345) == 0);
+  CHECK(a[0] == 0);
+
+} /* testFmt */
+
+/* -------------------------------------------------------------------------- */
+static void testParse() {
+
+  int32_t i;
+  uint32_t h;
+  CHECK(LF_LoRaFmt::parseInt("-123#", 5, i) == 4 && i == -123);
+  CHECK(LF_LoRaFmt::parseHex("1aF", 3, h) == 3 && h == 0x1AF);
+  CHECK(LF_LoRaFmt::parseFixed("2.345", 5, 2, i) == 5 && i == 234);
+  CHECK(LF_LoRaFmt::parseInt("#", 1, i) == 0);
+
+} /* testParse */
+
+/* -------------------------------------------------------------------------- */
+static void testParseFloat() {
+
+  // Mesmo float que o strtof, inclusive com muitas casas e expoente
+  const char *in[] = {"0", "1", "-2.5", "220.1", "0.45", "3.14159265358979",
+                      "0.000123456", "915E6", "433.175e6", "1e-5", "-7.0E+3",
+                      "123456789012345678901234", "0.1234567890123456789",
+                      "99999.99", "1.17549435e-38", "3.4e38"};
+  for (const char *s : in) {
+    float v;
+    int n = LF_LoRaFmt::parseFloat(s, strlen(s), v);
+    CHECK(n == (int)strlen(s));
+    float ref = strtof(s, nullptr);
+    // Uma divisão no fim: no máximo 1 ulp do correto
+    CHECK(fabsf(v - ref) <= fabsf(ref) * 1.2e-7f);
+  }
+
+  // 0.1 somado casa a casa desviava do strtof
+  float v;
+  LF_LoRaFmt::parseFloat("0.3", 3, v);
+  CHECK(v == 0.3f);
+  LF_LoRaFmt::parseFloat("1234.5678", 9, v);
+  CHECK(v == 1234.5678f);
+
+  CHECK(LF_LoRaFmt::parseFloat("-", 1, v) == 0);
+  CHECK(LF_LoRaFmt::parseFloat(".", 1, v) == 0);
+  CHECK(LF_LoRaFmt::parseFloat("12#3", 4, v) == 2 && v == 12);
+  // Expoente inválido não é consumido
+  CHECK(LF_LoRaFmt::parseFloat("5E", 2, v) == 1 && v == 5);
+
+} /* testParseFloat */
+
+/* -------------------------------------------------------------------------- */
+static void testLine() {
+
+  char buf[16];
+  LF_LoRaLine line(buf, sizeof(buf));
+  line.addInt(1).addInt(7, 3).addFixed(45, 2);
+  CHECK(strcmp(line.c_str(), "#1#007#0.45") == 0);
+  CHECK(!line.overflow());
+  line.addStr("toolong");
+  CHECK(line.overflow());
+
+} /* testLine */
+
+/* -------------------------------------------------------------------------- */
+int main() {
+
+  testFmt();
+  testParse();
+  testParseFloat();
+  testLine();
+
+  return TEST_END();
+
+} /* main */
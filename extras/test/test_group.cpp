@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// Grupos: resposta no slot do endereço sem segurar a fila e endereços de
+// grupo recusados no pareamento
+
+#define private public
+#include <LF_LoRa.h>
+#include "test.h"
+
+/* -------------------------------------------------------------------------- */
+static void testStaggerNotBlocking() {
+
+  LF_LoRaClass &L = LF_LoRa;
+
+  // Resposta a grupo esperando o slot, resposta comum chega depois
+  L._groupRxOn = true;
+  L._groupRxId = 200;
+  L._wheel.add(L._tmrGroupResp, 1000);
+  L.fiFoPushMsg("#G1", 200, 0, true);
+  L.fiFoPushMsg("#G2", 200, 0, true);
+  L.fiFoPushMsg("#U", 201, 0, false);
+  CHECK(L.nextSendLen() == 2);
+
+  // A comum sai já, as de grupo continuam na ordem
+  size_t sent = LoRa.sent.size();
+  CHECK(L.fiFoSendMsg());
+  CHECK(LoRa.sent.size() == sent + 1);
+  CHECK(LoRa.sent.back().find("#U") != std::string::npos);
+  CHECK(!L.fiFoSendMsg());
+  CHECK(L._fiFoMsgMsg[L._fiFoFirst] == "#G1");
+
+  // No slot saem as de grupo
+  L._wheel.cancel(L._tmrGroupResp);
+  CHECK(L.fiFoSendMsg());
+  CHECK(LoRa.sent.back().find("#G1") != std::string::npos);
+  CHECK(L.fiFoSendMsg());
+  CHECK(LoRa.sent.back().find("#G2") != std::string::npos);
+  CHECK(L._fiFoFirst == L._fiFoLast);
+  L._groupRxOn = false;
+
+} /* testStaggerNotBlocking */
+
+/* -------------------------------------------------------------------------- */
+static void testTaskGroupFlag() {
+
+  LF_LoRaClass &L = LF_LoRa;
+
+  // No modo tarefa a marca de grupo vai com a mensagem, não depende de
+  // _groupRxOn quando a aplicação responde
+  L._taskMode = true;
+  L._groupRxOn = true;
+  L._lastIdRec = 210;
+  L.taskRxPush("#CMD", true);
+  L._groupRxOn = false;
+  L.taskRxDrain();
+  L.sendState("#R", MSG_TYPE_RESPONSE);
+  L._wheel.add(L._tmrGroupResp, 1000);
+  L.taskTxDrain();
+  L._taskMode = false;
+  CHECK(L._fiFoFirst != L._fiFoLast);
+  CHECK(L._fiFoGroup[L._fiFoFirst]);
+  CHECK(L.nextSendLen() == -1);
+  L._wheel.cancel(L._tmrGroupResp);
+  CHECK(L.fiFoSendMsg());
+
+} /* testTaskGroupFlag */
+
+/* -------------------------------------------------------------------------- */
+static void testPairGroupAddr() {
+
+  LF_LoRaClass &L = LF_LoRa;
+
+  // Endereço de grupo para o principal ou para o endpoint é recusado
+  L.setOpMode(LORA_OP_MODE_PAIRING);
+  L._stepNegotiation = LORA_STEP_NEG_CFG;
+  L._pairOk = false;
+  String b = "FFFFFF!FFFFFF!101!001!000!" + L._sLast6Mac + "240";
+  L.execMsgModePairing(b.c_str(), b.length());
+  CHECK(!L._pairOk);
+  b = "FFFFFF!FFFFFF!101!001!000!" + L._sLast6Mac + "005!" + L._endpoints[0].sLast6Mac + "254";
+  L.execMsgModePairing(b.c_str(), b.length());
+  CHECK(!L._pairOk);
+  CHECK(!L._endpoints[0].pairOk);
+
+  // Endereços comuns passam
+  b = "FFFFFF!FFFFFF!101!001!000!" + L._sLast6Mac + "005!" + L._endpoints[0].sLast6Mac + "006";
+  L.execMsgModePairing(b.c_str(), b.length());
+  CHECK(L._pairOk && (L._pairMyAddr == 5));
+  CHECK(L._endpoints[0].pairOk && (L._endpoints[0].pairAddr == 6));
+  L.setOpMode(LORA_OP_MODE_LOOP);
+
+} /* testPairGroupAddr */
+
+/* -------------------------------------------------------------------------- */
+int main() {
+
+  LF_LoRaClass &L = LF_LoRa;
+  L.slaveCfg("TEST");
+  L.addEndpoint("SUB", nullptr);
+  L.inic();
+  L._netId = 1;
+  L.setMyAddr(5);
+  L.setMasterAddr(0);
+  L.setOpMode(LORA_OP_MODE_LOOP);
+
+  testStaggerNotBlocking();
+  testTaskGroupFlag();
+  testPairGroupAddr();
+
+  return TEST_END();
+
+} /* main */
@@ -0,0 +1,369 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// Recepção da imagem (LF_LoRaOtaRx) e rodadas de reparo com perdas
+
+#define private public
+#include "LF_LoRa_Ota.h"
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <set>
+#include <string>
+#include <vector>
+
+// Imagem em RAM, conta os begin/end para conferir o ciclo da gravação
+class MemImage : public LF_LoRaOtaImage {
+
+public:
+
+  bool begin(char, uint32_t size) {
+    begins++;
+    open = true;
+    memset(data, 0, sizeof(data));
+    return size <= sizeof(data);
+  }
+  bool write(uint32_t offset, const uint8_t *buf, int len) {
+    if (!open) return false;
+    memcpy(data + offset, buf, len);
+    // Simula uma gravação que corrompe o primeiro byte uma vez
+    if ((offset == 0) && (corrupt > 0)) {
+      data[0] ^= 0xFF;
+      corrupt--;
+    }
+    return true;
+  }
+  bool read(uint32_t offset, uint8_t *buf, int len) {
+    memcpy(buf, data + offset, len);
+    return true;
+  }
+  bool end(bool ok) {
+    ends++;
+    if (!ok) aborts++;
+    open = false;
+    return ok;
+  }
+
+  uint8_t data[1024] = {};
+  int begins = 0;
+  int ends = 0;
+  int aborts = 0;
+  int corrupt = 0;
+  bool open = false;
+
+};
+
+static uint8_t g_image[300];
+
+/* -------------------------------------------------------------------------- */
+// Passa os quadros de uma rodada do master para o escravo 5, na consulta
+// devolve a resposta dele e fecha a janela
+static void sendAll(LF_LoRaOtaTx &tx, LF_LoRaOtaRx &rx) {
+  char buf[256];
+  int n;
+  while ((n = tx.next(buf, sizeof(buf))) > 0) {
+    if (buf[1] != LF_LORA_OTA_QUERY) {
+      rx.frame(buf, n);
+      continue;
+    }
+    uint16_t slotLen;
+    if (rx.slot(buf, n, 5, slotLen) < 0) break;
+    char rep[LF_LORA_OTA_REPORT_LEN];
+    n = rx.report(rep, sizeof(rep));
+    tx.report(5, rep, n);
+    tx.endWindow();
+    break;
+  }
+} /* sendAll */
+
+/* -------------------------------------------------------------------------- */
+static void testRetryAfterMismatch() {
+
+  MemImage src;
+  memcpy(src.data, g_image, sizeof(g_image));
+  MemImage dst;
+  dst.corrupt = 1;
+  LF_LoRaOtaRx rx;
+  rx.setImage(&dst);
+  LF_LoRaOtaTx tx;
+  uint8_t nodes[] = {5};
+  CHECK(tx.begin(1, LF_LORA_OTA_KIND_FW, sizeof(g_image), &src, nodes, 1, 100));
+
+  sendAll(tx, rx);
+  // Hash errado: a gravação é descartada e reaberta antes de pedir tudo de novo
+  CHECK(rx.status() == LF_LORA_OTA_RECEIVING);
+  CHECK(rx.received() == 0);
+  CHECK(dst.aborts == 1);
+  CHECK(dst.begins == 2);
+  CHECK(dst.open);
+
+  sendAll(tx, rx);
+  CHECK(rx.status() == LF_LORA_OTA_VERIFIED);
+  CHECK(memcmp(dst.data, g_image, sizeof(g_image)) == 0);
+
+} /* testRetryAfterMismatch */
+
+/* -------------------------------------------------------------------------- */
+static void testMasterReboot() {
+
+  MemImage src;
+  memcpy(src.data, g_image, sizeof(g_image));
+  MemImage dst;
+  LF_LoRaOtaRx rx;
+  rx.setImage(&dst);
+  uint8_t nodes[] = {5};
+
+  LF_LoRaOtaTx tx;
+  CHECK(tx.begin(1, LF_LORA_OTA_KIND_FW, 200, &src, nodes, 1, 100));
+  sendAll(tx, rx);
+  CHECK(rx.status() == LF_LORA_OTA_VERIFIED);
+
+  // START repetido da mesma imagem não reinicia a recepção
+  char buf[256];
+  LF_LoRaOtaTx again;
+  CHECK(again.begin(1, LF_LORA_OTA_KIND_FW, 200, &src, nodes, 1, 100));
+  int n = again.next(buf, sizeof(buf));
+  CHECK(rx.frame(buf, n));
+  CHECK(rx.status() == LF_LORA_OTA_VERIFIED);
+  CHECK(dst.begins == 1);
+
+  // Master reiniciado: mesma sessão, imagem nova
+  src.data[0] ^= 0x55;
+  LF_LoRaOtaTx reboot;
+  CHECK(reboot.begin(1, LF_LORA_OTA_KIND_FW, sizeof(g_image), &src, nodes, 1, 100));
+  sendAll(reboot, rx);
+  CHECK(dst.begins == 2);
+  CHECK(rx.status() == LF_LORA_OTA_VERIFIED);
+  CHECK(memcmp(dst.data, src.data, sizeof(g_image)) == 0);
+
+} /* testMasterReboot */
+
+/* -------------------------------------------------------------------------- */
+// Escravos no mesmo rádio simulado, cada um com a sua imagem
+struct Slave {
+  uint8_t addr;
+  MemImage dst;
+  LF_LoRaOtaRx rx;
+  std::vector<std::string> reports;   // $M enviados, em ordem
+};
+
+/* -------------------------------------------------------------------------- */
+// Uma rodada: perde os $K ao acaso (loss em %, independente por escravo
+// ou a mesma perda para todos), o resto chega. Devolve os blocos enviados.
+static uint32_t sendLossy(LF_LoRaOtaTx &tx, std::vector<Slave *> &slaves, int loss, bool shared) {
+  char buf[256];
+  int n;
+  uint32_t sent = tx.blocksSent();
+  while ((n = tx.next(buf, sizeof(buf))) > 0) {
+    if (buf[1] == LF_LORA_OTA_BLOCK) {
+      bool lostAll = shared && (rand() % 100 < loss);
+      for (Slave *s : slaves) {
+        bool lost = shared ? lostAll : (rand() % 100 < loss);
+        if (!lost) s->rx.frame(buf, n);
+      }
+      continue;
+    }
+    if (buf[1] != LF_LORA_OTA_QUERY) {
+      for (Slave *s : slaves) s->rx.frame(buf, n);
+      continue;
+    }
+    // Cada escravo consultado responde no seu slot
+    for (Slave *s : slaves) {
+      uint16_t slotLen;
+      if (s->rx.slot(buf, n, s->addr, slotLen) < 0) continue;
+      char rep[LF_LORA_OTA_REPORT_LEN];
+      int len = s->rx.report(rep, sizeof(rep));
+      s->reports.push_back(std::string(rep, len));
+      tx.report(s->addr, rep, len);
+    }
+    tx.endWindow();
+    break;
+  }
+  return tx.blocksSent() - sent;
+} /* sendLossy */
+
+/* -------------------------------------------------------------------------- */
+// Buracos de um $M: o primeiro absoluto, os seguintes pela distância
+static std::vector<uint16_t> holes(const std::string &rep) {
+  std::vector<uint16_t> out;
+  uint32_t v = 0;
+  for (size_t p = 4; p < rep.size(); p++) {
+    char c = rep[p];
+    if ((c >= 'G') && (c <= 'V')) {
+      v = (v << 4) | (c - 'G');
+      continue;
+    }
+    v = (v << 4) | ((c <= '9') ? c - '0' : c - 'A' + 10);
+    out.push_back(out.empty() ? v : out.back() + v + 1);
+    v = 0;
+  }
+  return out;
+} /* holes */
+
+/* -------------------------------------------------------------------------- */
+// Blocos que o escravo ainda não tem
+static std::set<uint16_t> missing(Slave &s, uint16_t blocks) {
+  std::set<uint16_t> out;
+  for (uint16_t i = 0; i < blocks; i++) {
+    if (!(s.rx._bitmap[i >> 3] & (1 << (i & 7)))) out.insert(i);
+  }
+  return out;
+} /* missing */
+
+/* -------------------------------------------------------------------------- */
+static void testLossyUnion() {
+
+  // Blocos de 4 bytes: 256 blocos para 1 KB, muitos buracos por rodada
+  static uint8_t image[1024];
+  for (size_t i = 0; i < sizeof(image); i++) image[i] = i * 13 + 1;
+  MemImage src;
+  memcpy(src.data, image, sizeof(image));
+  const uint16_t blocks = sizeof(image) / 4;
+
+  Slave a, b, c;
+  a.addr = 5;
+  b.addr = 6;
+  c.addr = 7;
+  std::vector<Slave *> slaves = {&a, &b, &c};
+  for (Slave *s : slaves) s->rx.setImage(&s->dst);
+  uint8_t nodes[] = {5, 6, 7};
+  LF_LoRaOtaTx tx;
+  CHECK(tx.begin(2, LF_LORA_OTA_KIND_CFG, sizeof(image), &src, nodes, 3, 100, 4));
+
+  // Primeira passada com 20% de perda em cada escravo
+  srand(7);
+  CHECK(sendLossy(tx, slaves, 20, false) == blocks);
+  std::set<uint16_t> all;
+  for (Slave *s : slaves) {
+    std::set<uint16_t> m = missing(*s, blocks);
+    CHECK(!m.empty());
+    // O $M lista exatamente os buracos, cabem numa resposta
+    std::vector<uint16_t> h = holes(s->reports.back());
+    CHECK(std::set<uint16_t>(h.begin(), h.end()) == m);
+    all.insert(m.begin(), m.end());
+  }
+
+  // O reparo manda a união dos buracos, uma vez cada, sem perdas agora
+  CHECK(sendLossy(tx, slaves, 0, false) == all.size());
+  for (Slave *s : slaves) {
+    CHECK(s->rx.status() == LF_LORA_OTA_VERIFIED);
+    CHECK(memcmp(s->dst.data, image, sizeof(image)) == 0);
+  }
+  // Completos respondem vazio e o master encerra
+  sendLossy(tx, slaves, 0, false);
+  for (Slave *s : slaves) CHECK(s->reports.back().size() == 4);
+  char buf[256];
+  while (tx.next(buf, sizeof(buf)) > 0) {}
+  CHECK(tx.status() == LF_LORA_OTA_DONE);
+  CHECK(tx.nodesOk() == 3);
+
+} /* testLossyUnion */
+
+/* -------------------------------------------------------------------------- */
+// Mesma perda para todos (interferência no master): o reparo depende dos
+// buracos, não de quantos escravos há
+static uint32_t repairShared(int count) {
+  static uint8_t image[1024];
+  for (size_t i = 0; i < sizeof(image); i++) image[i] = i * 5 + 9;
+  MemImage src;
+  memcpy(src.data, image, sizeof(image));
+  std::vector<Slave> pool(count);
+  std::vector<Slave *> slaves;
+  uint8_t nodes[16];
+  for (int i = 0; i < count; i++) {
+    pool[i].addr = 10 + i;
+    pool[i].rx.setImage(&pool[i].dst);
+    slaves.push_back(&pool[i]);
+    nodes[i] = 10 + i;
+  }
+  LF_LoRaOtaTx tx;
+  CHECK(tx.begin(3, LF_LORA_OTA_KIND_CFG, sizeof(image), &src, nodes, count, 100, 4));
+  srand(11);
+  uint32_t repair = 0;
+  sendLossy(tx, slaves, 20, true);
+  for (int round = 0; round < LF_LORA_OTA_MAX_ROUNDS; round++) {
+    bool done = true;
+    for (Slave *s : slaves) done &= (s->rx.status() == LF_LORA_OTA_VERIFIED);
+    if (done) break;
+    repair += sendLossy(tx, slaves, 20, true);
+  }
+  for (Slave *s : slaves) CHECK(s->rx.status() == LF_LORA_OTA_VERIFIED);
+  return repair;
+} /* repairShared */
+
+/* -------------------------------------------------------------------------- */
+static void testRepairScale() {
+
+  uint32_t two = repairShared(2);
+  uint32_t eight = repairShared(8);
+  printf("reparo: %u blocos para 2 escravos, %u para 8\n", two, eight);
+  CHECK(two > 0);
+  CHECK(eight == two);
+
+} /* testRepairScale */
+
+/* -------------------------------------------------------------------------- */
+static void testReportContinuation() {
+
+  // Perda alta: os buracos não cabem num $M, a resposta seguinte
+  // continua de onde a anterior parou
+  static uint8_t image[1024];
+  for (size_t i = 0; i < sizeof(image); i++) image[i] = i * 3 + 2;
+  MemImage src;
+  memcpy(src.data, image, sizeof(image));
+  const uint16_t blocks = sizeof(image) / 4;
+
+  Slave a, b;
+  a.addr = 5;
+  b.addr = 6;
+  std::vector<Slave *> slaves = {&a, &b};
+  for (Slave *s : slaves) s->rx.setImage(&s->dst);
+  uint8_t nodes[] = {5, 6};
+  LF_LoRaOtaTx tx;
+  CHECK(tx.begin(4, LF_LORA_OTA_KIND_CFG, sizeof(image), &src, nodes, 2, 100, 4));
+
+  srand(3);
+  sendLossy(tx, slaves, 90, false);
+  std::set<uint16_t> m = missing(a, blocks);
+  std::vector<uint16_t> first = holes(a.reports.back());
+  CHECK(a.reports.back().size() < LF_LORA_OTA_REPORT_LEN);
+  CHECK(first.size() < m.size());
+  // Os primeiros buracos, em ordem
+  std::vector<uint16_t> prefix(m.begin(), m.end());
+  prefix.resize(first.size());
+  CHECK(first == prefix);
+
+  // Reparo perfeito só do que foi pedido: a próxima resposta começa depois
+  sendLossy(tx, slaves, 0, false);
+  std::vector<uint16_t> next = holes(a.reports.back());
+  CHECK(!next.empty() && (next.front() > first.back()));
+
+  for (int round = 0; round < LF_LORA_OTA_MAX_ROUNDS; round++) {
+    if ((a.rx.status() == LF_LORA_OTA_VERIFIED) && (b.rx.status() == LF_LORA_OTA_VERIFIED)) break;
+    sendLossy(tx, slaves, 0, false);
+  }
+  CHECK(a.rx.status() == LF_LORA_OTA_VERIFIED);
+  CHECK(b.rx.status() == LF_LORA_OTA_VERIFIED);
+  CHECK(memcmp(a.dst.data, image, sizeof(image)) == 0);
+  CHECK(memcmp(b.dst.data, image, sizeof(image)) == 0);
+
+} /* testReportContinuation */
+
+/* -------------------------------------------------------------------------- */
+int main() {
+  for (size_t i = 0; i < sizeof(g_image); i++) g_image[i] = i * 7 + 3;
+  testRetryAfterMismatch();
+  testMasterReboot();
+  testLossyUnion();
+  testRepairScale();
+  testReportContinuation();
+  return TEST_END();
+} /* main */
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// Pareamento: slot da apresentação (100) pelo MAC, novo slot na rodada
+// seguinte e a configuração em lote (101)
+
+#define private public
+#include <LF_LoRa.h>
+#include "test.h"
+
+#include <stdlib.h>
+
+#define SLOTS    16     // Como no comando abaixo
+#define SLOT_LEN 200
+
+/* -------------------------------------------------------------------------- */
+// Avança o relógio até o próximo envio do pareamento, devolve o tempo gasto
+static long waitSend(unsigned long limit) {
+  LF_LoRaClass &L = LF_LoRa;
+  size_t n = LoRa.sent.size();
+  for (unsigned long t = 0; t <= limit; t++) {
+    L._wheel.advance(lfLoRaMillis64());
+    L.pairingSendLoop();
+    if (LoRa.sent.size() > n) return t;
+    g_millis += 1;
+  }
+  return -1;
+} /* waitSend */
+
+/* -------------------------------------------------------------------------- */
+// Slot em que o nó com este MAC se apresenta na rodada round
+static int slotOf(uint32_t mac, int round) {
+  LF_LoRaClass &L = LF_LoRa;
+  char sMac[13];
+  snprintf(sMac, sizeof(sMac), "000000%06X", mac);
+  L._sMac = sMac;
+  L._sLast6Mac = L._sMac.substring(6);
+  L.setOpMode(LORA_OP_MODE_PAIRING);
+  // Formato do master: !SSS!TTTT
+  String cmd = "000000!FFFFFF!100!016!0200";
+  for (int r = 0; r < round; r++) {
+    L.execMsgModePairing(cmd.c_str(), cmd.length());
+  }
+  long t = waitSend(SLOTS * SLOT_LEN);
+  CHECK(t >= 0);
+  CHECK(LoRa.sent.back() == "!FFFFFF!" + std::string(L._sLast6Mac.c_str()) + "!100!" + sMac + "!TEST");
+  // Retardo dentro do slot menor que um quarto dele
+  CHECK(t % SLOT_LEN <= SLOT_LEN / 4);
+  L._pairPending = false;
+  return t / SLOT_LEN;
+} /* slotOf */
+
+/* -------------------------------------------------------------------------- */
+static void testSlots() {
+
+  // MACs sequenciais (mesmo lote de fábrica) se espalham pelos slots
+  static const int nodes = 160;
+  int count[SLOTS] = {};
+  int slot1[nodes];
+  for (int i = 0; i < nodes; i++) {
+    slot1[i] = slotOf(0xA1B200 + i, 1);
+    count[slot1[i]]++;
+  }
+  for (int s = 0; s < SLOTS; s++) {
+    CHECK((count[s] >= 3) && (count[s] <= 20));
+  }
+
+  // A mesma rodada dá o mesmo slot, a seguinte sorteia de novo: pares que
+  // colidiram na primeira quase sempre se separam
+  CHECK(slotOf(0xA1B200, 1) == slot1[0]);
+  int slot2[nodes];
+  for (int i = 0; i < nodes; i++) {
+    slot2[i] = slotOf(0xA1B200 + i, 2);
+  }
+  int pairs = 0;
+  int again = 0;
+  int moved = 0;
+  for (int i = 0; i < nodes; i++) {
+    if (slot2[i] != slot1[i]) moved++;
+    for (int j = i + 1; j < nodes; j++) {
+      if (slot1[i] != slot1[j]) continue;
+      pairs++;
+      if (slot2[i] == slot2[j]) again++;
+    }
+  }
+  printf("slots: %d pares colididos na rodada 1, %d de novo na 2, %d de %d mudaram\n", pairs, again, moved, nodes);
+  CHECK(pairs > 0);
+  CHECK(again * 4 < pairs);
+  CHECK(moved > nodes / 2);
+
+} /* testSlots */
+
+/* -------------------------------------------------------------------------- */
+static void testBatch() {
+
+  LF_LoRaClass &L = LF_LoRa;
+  L._sMac = "000000C0FFEE";
+  L._sLast6Mac = "C0FFEE";
+  String mac = L._sLast6Mac;
+
+  // Lote só com MACs de outros nós: nada muda
+  L.setOpMode(LORA_OP_MODE_PAIRING);
+  L._stepNegotiation = LORA_STEP_NEG_CFG;
+  L._pairSlotLen = SLOT_LEN;
+  String b = "FFFFFF!FFFFFF!101!001!000!AAAAAA007!BBBBBB009";
+  L.execMsgModePairing(b.c_str(), b.length());
+  CHECK(!L._pairOk && !L._pairPending);
+  // Assinatura antiga, com String
+  L.execMsgModePairing(b);
+  CHECK(!L._pairOk && !L._pairPending);
+
+  // Endereço de grupo ou difusão recusado, mesmo no meio de outros nós
+  b = "FFFFFF!FFFFFF!101!001!000!AAAAAA007!" + mac + "240!BBBBBB009";
+  L.execMsgModePairing(b.c_str(), b.length());
+  CHECK(!L._pairOk);
+  b = "FFFFFF!FFFFFF!101!001!000!" + mac + "255";
+  L.execMsgModePairing(b.c_str(), b.length());
+  CHECK(!L._pairOk);
+  // Endereço que não é número
+  b = "FFFFFF!FFFFFF!101!001!000!" + mac + "0x5";
+  L.execMsgModePairing(b.c_str(), b.length());
+  CHECK(!L._pairOk);
+
+  // Lote misturado: meu MAC em segundo, com canal e grupo. Respondo no
+  // segundo slot e de novo depois do lote inteiro
+  b = "FFFFFF!FFFFFF!101!001!000!AAAAAA007!" + mac + "005003G241!BBBBBB009";
+  L.execMsgModePairing(b.c_str(), b.length());
+  CHECK(L._pairOk && (L._pairMyAddr == 5) && (L._pairNetId == 1) && (L._pairMasterAddr == 0));
+  CHECK(L._pairChannel == 3);
+  CHECK(L._pairGroups[0][0] == 241);
+  long t = waitSend(10 * SLOT_LEN);
+  CHECK(t == SLOT_LEN);
+  CHECK(LoRa.sent.back() == "!FFFFFF!C0FFEE!101!001!000!005!003");
+  CHECK(L._opMode == LORA_OP_MODE_PAIRING);
+  t = waitSend(10 * SLOT_LEN);
+  CHECK(t == 3 * SLOT_LEN);
+
+  // Depois da segunda cópia a configuração vale
+  CHECK(L._opMode == LORA_OP_MODE_LOOP);
+  CHECK((L._myAddr == 5) && (L._netId == 1) && (L._channel == 3));
+  CHECK(L._groups[0][0] == 241);
+
+} /* testBatch */
+
+/* -------------------------------------------------------------------------- */
+int main() {
+
+  LF_LoRaClass &L = LF_LoRa;
+  L.slaveCfg("TEST");
+  L.inic();
+  L._netId = 1;
+  L.setMyAddr(5);
+  L.setMasterAddr(0);
+  L.setOpMode(LORA_OP_MODE_LOOP);
+
+  srand(1);
+  testSlots();
+  testBatch();
+
+  return TEST_END();
+
+} /* main */
@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// Repetidor: vários nós no mesmo rádio simulado, com alcance direto, um e
+// dois saltos. Mede a entrega de ponta a ponta e o tempo no ar por salto.
+// Sem colisões: o que se mede é o alcance e o custo de ar, não a disputa
+// do canal.
+
+#define private public
+#include <LF_LoRa.h>
+#include "test.h"
+
+#include <set>
+#include <vector>
+
+#define SIM_NODES 5   // Master, escravo e até três repetidores
+#define SIM_MSGS  20
+
+// Quem ouve quem
+struct Topology {
+  const char *name;
+  bool link[SIM_NODES][SIM_NODES];
+  uint8_t hops;     // Distância esperada do escravo
+};
+
+struct Sim {
+
+  LF_LoRaClass *nodes[SIM_NODES];
+  const Topology *topo;
+  uint32_t airtime = 0;              // Todo o tempo no ar, originais e retransmissões
+  std::set<int> upRx;                // IDs das subidas entregues ao master
+  int downRx = 0;                    // Descidas entregues ao escravo
+  std::vector<std::string> downSent; // Descidas como o master mandou
+
+  /* ------------------------------------------------------------------------ */
+  // Nó 0 é o master (endereço 0), nó 1 o escravo 5, os demais repetidores
+  explicit Sim(const Topology &t) : topo(&t) {
+    static const uint8_t addrs[SIM_NODES] = {0, 5, 10, 11, 12};
+    for (int i = 0; i < SIM_NODES; i++) {
+      LF_LoRaClass *n = new LF_LoRaClass();
+      n->slaveCfg("TEST");
+      n->inic();
+      n->_netId = 1;
+      n->_myAddr = addrs[i];
+      n->setMasterAddr(0);
+      n->setOpMode(LORA_OP_MODE_LOOP);
+      if (i >= 2) n->setRepeaterEnable(true);
+      nodes[i] = n;
+    }
+    nodes[0]->setMasterRoutes(true);
+  }
+
+  ~Sim() {
+    // A classe é feita para a instância global, solto os registros aqui
+    for (int i = 0; i < SIM_NODES; i++) {
+      nodes[i]->clearRegRecs();
+      delete nodes[i];
+    }
+  }
+
+  /* ------------------------------------------------------------------------ */
+  // Quadro no ar: cada vizinho recebe, o master como o adaptador USB
+  void transmit(int from, const std::string &f) {
+    airtime += nodes[0]->loraAirtime(f.size());
+    for (int j = 0; j < SIM_NODES; j++) {
+      if (!topo->link[from][j]) continue;
+      if (j == 0) {
+        char out[LF_LORA_MAX_PACKET_SIZE + 1];
+        if (nodes[0]->loraDecode(f.c_str(), f.size(), out) && (hexByte(out + 2) == 5)) {
+          upRx.insert(hexByte(out + 6));
+        }
+        continue;
+      }
+      LoRa.deliver(f);
+      if (nodes[j]->loraMsgReceiveLoop() && (j == 1)) downRx++;
+    }
+  }
+
+  /* ------------------------------------------------------------------------ */
+  // Avança o relógio até os repetidores esvaziarem a fila
+  void run() {
+    for (int step = 0; step < 1000; step++) {
+      for (int i = 0; i < SIM_NODES; i++) {
+        size_t n = LoRa.sent.size();
+        nodes[i]->repeaterSendLoop();
+        for (size_t k = n; k < LoRa.sent.size(); k++) {
+          transmit(i, LoRa.sent[k]);
+        }
+      }
+      bool pending = false;
+      for (int i = 0; i < SIM_NODES; i++) {
+        pending |= nodes[i]->_fwdRecsLen > 0;
+      }
+      if (!pending) return;
+      g_millis += 10;
+    }
+  }
+
+  /* ------------------------------------------------------------------------ */
+  void uplink() {
+    char out[LF_LORA_MAX_PACKET_SIZE + 1];
+    int len = nodes[1]->loraAddHeader("#t=1", 4, 0, out);
+    transmit(1, std::string(out, len));
+    run();
+  }
+
+  /* ------------------------------------------------------------------------ */
+  void downlink() {
+    char out[LF_LORA_MAX_PACKET_SIZE + 1];
+    int len = nodes[0]->loraAddHeader("#CMD", 4, 5, out);
+    downSent.push_back(std::string(out, len));
+    transmit(0, downSent.back());
+    run();
+  }
+
+  static uint8_t hexByte(const char *s) {
+    uint32_t v = 0;
+    LF_LoRaFmt::parseHex(s, 2, v);
+    return v;
+  }
+
+};
+
+/* -------------------------------------------------------------------------- */
+static void runTopology(const Topology &t) {
+
+  Sim sim(t);
+  for (int k = 0; k < SIM_MSGS; k++) {
+    sim.uplink();
+    g_millis += 1000;
+  }
+  CHECK((int)sim.upRx.size() == SIM_MSGS);
+
+  // O master aprendeu a distância, o escravo ouvido direto fica sem marca
+  CHECK(sim.nodes[0]->routeKnown(5));
+  for (int k = 0; k < SIM_MSGS; k++) {
+    sim.downlink();
+    g_millis += 1000;
+  }
+  CHECK(sim.downRx == SIM_MSGS);
+  for (const std::string &f : sim.downSent) {
+    char stamp = (t.hops == 0) ? '0' : '0' + (LORA_HOP_MAX - t.hops);
+    CHECK(f[LORA_HOPS_POS] == stamp);
+  }
+
+  // Cada repetidor no caminho retransmite cada quadro uma vez só
+  uint32_t fwd = 0;
+  for (int i = 2; i < SIM_NODES; i++) {
+    CHECK(sim.nodes[i]->repeaterFwdCount() <= 2 * SIM_MSGS);
+    fwd += sim.nodes[i]->repeaterFwdCount();
+  }
+  CHECK(fwd == (uint32_t)t.hops * 2 * SIM_MSGS);
+
+  uint32_t direct = sim.nodes[0]->loraAirtime(sim.downSent[0].size());
+  printf("%-8s entrega %3d%% / %3d%%  ar %4u ms/msg  (%u ms direto, +%u ms por salto)\n", t.name,
+         (int)sim.upRx.size() * 100 / SIM_MSGS, sim.downRx * 100 / SIM_MSGS,
+         sim.airtime / (2 * SIM_MSGS), direct,
+         t.hops ? (sim.airtime / (2 * SIM_MSGS) - direct) / t.hops : 0);
+
+} /* runTopology */
+
+/* -------------------------------------------------------------------------- */
+static void testGating() {
+
+  // Repetidor 12 ouve o master mas não o escravo: não aprende rota e não
+  // retransmite a descida
+  static const Topology t = {"gating", {
+    {0, 0, 1, 0, 1},
+    {0, 0, 1, 0, 0},
+    {1, 1, 0, 0, 0},
+    {0, 0, 0, 0, 0},
+    {1, 0, 0, 0, 0},
+  }, 1};
+  Sim sim(t);
+  sim.uplink();
+  sim.downlink();
+  CHECK(sim.upRx.size() == 1);
+  CHECK(sim.downRx == 1);
+  CHECK(sim.nodes[2]->repeaterFwdCount() == 2);
+  CHECK(!sim.nodes[4]->routeKnown(5));
+  CHECK(sim.nodes[4]->repeaterFwdCount() == 0);
+
+} /* testGating */
+
+/* -------------------------------------------------------------------------- */
+static void testShortestRoute() {
+
+  // Escravo ouvido direto e pelo repetidor: o master fica com a rota direta
+  // e a descida sai sem marca de saltos, como o firmware antigo espera
+  static const Topology t = {"atalho", {
+    {0, 1, 1, 0, 0},
+    {1, 0, 1, 0, 0},
+    {1, 1, 0, 0, 0},
+    {0, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0},
+  }, 0};
+  Sim sim(t);
+  sim.uplink();
+  CHECK(sim.upRx.size() == 1);
+  CHECK(sim.nodes[0]->_routeRecsLen == 1);
+  CHECK(sim.nodes[0]->_routeRecs[0].hops == 0);
+  sim.downlink();
+  CHECK(sim.downSent[0][LORA_HOPS_POS] == '0');
+  // A cópia do repetidor chega repetida e não conta de novo
+  CHECK(sim.downRx == 1);
+
+} /* testShortestRoute */
+
+/* -------------------------------------------------------------------------- */
+int main() {
+
+  srand(1);
+  g_millis = 1000;
+
+  // Master, escravo 5 e repetidores 10, 11 e 12 (links simétricos)
+  static const Topology direct = {"direto", {
+    {0, 1, 0, 0, 0},
+    {1, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0},
+  }, 0};
+  static const Topology oneHop = {"1 salto", {
+    {0, 0, 1, 0, 0},
+    {0, 0, 1, 0, 0},
+    {1, 1, 0, 0, 0},
+    {0, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0},
+  }, 1};
+  static const Topology twoHops = {"2 saltos", {
+    {0, 0, 1, 0, 0},
+    {0, 0, 0, 1, 0},
+    {1, 0, 0, 1, 0},
+    {0, 1, 1, 0, 0},
+    {0, 0, 0, 0, 0},
+  }, 2};
+
+  runTopology(direct);
+  runTopology(oneHop);
+  runTopology(twoHops);
+  testGating();
+  testShortestRoute();
+
+  return TEST_END();
+
+} /* main */
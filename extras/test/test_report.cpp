@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// Envio por mudança (LF_LoRaReport)
+
+#include "LF_LoRa_Report.h"
+#include "test.h"
+
+/* -------------------------------------------------------------------------- */
+static void testMinInterval() {
+
+  LF_LoRaReport r;
+  int a = r.addField("a", 1, 1.0, LF_LORA_REPORT_DB_ABS, 10000);
+  int b = r.addField("b", 1, 1.0, LF_LORA_REPORT_DB_ABS, 0);
+
+  r.setValue(a, 10, 0);
+  r.setValue(b, 10, 0);
+  CHECK(r.due(0));
+  r.sent(0);
+
+  // b dispara sozinho, não renova o intervalo de a
+  r.setValue(b, 20, 9000);
+  CHECK(r.due(9000));
+  r.sent(9000);
+
+  // a mudou: ainda dentro do seu intervalo, depois dele vai
+  r.setValue(a, 20, 9500);
+  CHECK(!r.due(9500));
+  CHECK(r.due(10000));
+  r.sent(10000);
+
+  // E a partir de agora conta deste envio
+  r.setValue(a, 30, 12000);
+  CHECK(!r.due(12000));
+  CHECK(!r.due(19999));
+  CHECK(r.due(20000));
+
+} /* testMinInterval */
+
+/* -------------------------------------------------------------------------- */
+static void testState() {
+
+  LF_LoRaReport r;
+  r.addField("v", 1, 1.0);
+  r.addField("p", 0, 1.0);
+  r.addField("f", 2, 0.1);
+  r.setValue("v", 220.14f, 0);
+  r.setValue("p", 100, 0);
+  r.setValue("f", -0.456f, 0);
+
+  CHECK(r.state() == "#220.1#100#-0.46");
+
+  char buf[32];
+  CHECK(r.state(buf, sizeof(buf)) == 16);
+  CHECK(strcmp(buf, "#220.1#100#-0.46") == 0);
+
+  // Não coube, linha vazia
+  CHECK(r.state(buf, 10) == 0);
+  CHECK(buf[0] == 0);
+
+} /* testState */
+
+/* -------------------------------------------------------------------------- */
+int main() {
+  testMinInterval();
+  testState();
+  return TEST_END();
+} /* main */
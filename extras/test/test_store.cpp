@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// Guarda local (LF_LoRaStore): quadro em lote do escravo lido no master,
+// fila cheia, master perdido, sondagens e a subida quando ele volta
+
+#define private public
+#include <LF_LoRa.h>
+#include "test.h"
+
+#include <string.h>
+
+/* -------------------------------------------------------------------------- */
+static void testUnpack() {
+
+  LF_LoRaStore st;
+  CHECK(st.push(1000, "#t=1", 4));
+  CHECK(st.push(1500, "#t=22", 5));
+  CHECK(st.push(1800, "#t=333", 6));
+
+  // Escravo monta o lote
+  char frame[LORA_STORE_FRAME + 1];
+  uint32_t endSeq;
+  int len = st.pack(frame, sizeof(frame), 2000, endSeq);
+  CHECK(len > 0);
+
+  // Master percorre os registros
+  static const char *msgs[] = {"#t=1", "#t=22", "#t=333"};
+  static const uint32_t ages[] = {1000, 500, 200};
+  int pos = 0, msgPos, msgLen, n = 0;
+  uint32_t age;
+  while ((pos = LF_LoRaStore::unpack(frame, len, pos, age, msgPos, msgLen)) != -1) {
+    CHECK(n < 3);
+    if (n >= 3) break;
+    CHECK(age == ages[n]);
+    CHECK((msgLen == (int)strlen(msgs[n])) && (memcmp(frame + msgPos, msgs[n], msgLen) == 0));
+    n++;
+  }
+  CHECK(n == 3);
+
+  // Registro novo no meio tempo: a confirmação do lote não o tira da fila
+  CHECK(st.push(2100, "#t=4", 4));
+  st.ack(endSeq);
+  CHECK(st.count() == 1);
+
+  // Quadro inválido
+  CHECK(LF_LoRaStore::unpack("#t=1", 4, 0, age, msgPos, msgLen) == -1);
+  CHECK(LF_LoRaStore::unpack("&0000", 5, 0, age, msgPos, msgLen) == -1);
+
+} /* testUnpack */
+
+/* -------------------------------------------------------------------------- */
+static void testDefaultOff() {
+
+  // Sem habilitar, master perdido não guarda nada
+  LF_LoRaClass &L = LF_LoRa;
+  CHECK(!L._storeEnabled);
+  L._masterLost = true;
+  L.sendState("#t=1", MSG_TYPE_CONFIRM);
+  CHECK(L._store.empty());
+  L._masterLost = false;
+
+} /* testDefaultOff */
+
+/* -------------------------------------------------------------------------- */
+static void testDropOldest() {
+
+  // Registros de 100 bytes: 19 cabem em LF_LORA_STORE_SIZE, o 20º
+  // descarta o mais antigo
+  LF_LoRaStore st;
+  char msg[101];
+  int fit = LF_LORA_STORE_SIZE / (100 + LF_LORA_STORE_REC_HEAD);
+  for (int i = 0; i <= fit; i++) {
+    memset(msg, 'a' + i, 100);
+    msg[0] = '#';
+    CHECK(st.push(1000 + i, msg, 100));
+  }
+  CHECK(st.count() == fit);
+  CHECK(st.dropped() == 1);
+
+  // O lote começa pelo segundo registro
+  char frame[LORA_STORE_FRAME + 1];
+  uint32_t endSeq;
+  int len = st.pack(frame, sizeof(frame), 5000, endSeq);
+  uint32_t age;
+  int msgPos, msgLen;
+  CHECK(LF_LoRaStore::unpack(frame, len, 0, age, msgPos, msgLen) != -1);
+  CHECK((msgLen == 100) && (frame[msgPos + 1] == 'b'));
+  CHECK(age == 5000 - 1001);
+
+  // Maior que LF_LORA_STORE_MSG_MAX não entra e não conta como descarte
+  char big[LF_LORA_STORE_MSG_MAX + 1];
+  memset(big, 'x', sizeof(big));
+  CHECK(!st.push(6000, big, sizeof(big)));
+  CHECK(st.dropped() == 1);
+
+} /* testDropOldest */
+
+/* -------------------------------------------------------------------------- */
+// Avança o relógio em passos até o próximo envio, devolve o tempo gasto
+static long waitSend(unsigned long limit, unsigned long step) {
+  LF_LoRaClass &L = LF_LoRa;
+  size_t n = LoRa.sent.size();
+  for (unsigned long t = 0; t <= limit; t += step) {
+    L._wheel.advance(lfLoRaMillis64());
+    L.fiFoSendMsg() || L.internalSendMsg() || L.storeSendMsg();
+    if (LoRa.sent.size() > n) return t;
+    g_millis += step;
+  }
+  return -1;
+} /* waitSend */
+
+/* -------------------------------------------------------------------------- */
+static void testLostMaster() {
+
+  LF_LoRaClass &L = LF_LoRa;
+  L.setStoreEnable(true);
+  L._msgSendIntervalBase = 1000;
+  srand(5);
+
+  // Confirmação sem resposta: reenvia até LORA_STORE_MISS falhas seguidas
+  L.sendState("#t=1", MSG_TYPE_CONFIRM);
+  size_t sent = LoRa.sent.size();
+  for (int i = 0; i < LORA_STORE_MISS; i++) {
+    CHECK(!L.masterLost());
+    CHECK(waitSend(5000, 10) >= 0);
+  }
+  CHECK(LoRa.sent.size() == sent + LORA_STORE_MISS);
+  g_millis += 2000;
+  L._wheel.advance(lfLoRaMillis64());
+  CHECK(!L.internalSendMsg());
+  CHECK(L.masterLost());
+  unsigned long lostTime = L._storeLostTime;
+  CHECK(lostTime != 0);
+  // A mensagem pendente e as novas vão para a fila
+  CHECK(L._store.count() == 1);
+  L.sendState("#t=2", MSG_TYPE_TELEMETRY);
+  L.sendState("#t=3", MSG_TYPE_CONFIRM);
+  CHECK(L._store.count() == 3);
+  CHECK(L._internalMsgStatus == INT_STATUS_EMPTY);
+
+  // Sondagens com o lote, intervalo dobrando até LORA_STORE_PROBE_MAX
+  unsigned long backoff = L._msgSendIntervalBase;
+  CHECK(L._storeBackoff == backoff);
+  CHECK(waitSend(backoff * 2, 10) >= 0);
+  CHECK(LoRa.sent.back().find("&") != std::string::npos);
+  int probes = 0;
+  while (backoff < LORA_STORE_PROBE_MAX) {
+    unsigned long next = (backoff * 2 > LORA_STORE_PROBE_MAX) ? LORA_STORE_PROBE_MAX : backoff * 2;
+    CHECK(L._storeBackoff == next);
+    long t = waitSend(2 * LORA_STORE_PROBE_MAX, 10);
+    // Sorteado entre o intervalo e uma vez e meia ele
+    CHECK((t >= (long)backoff) && (t < (long)(backoff + backoff / 2 + 10)));
+    backoff = next;
+    probes++;
+  }
+  CHECK(probes > 5);
+  long t = waitSend(2 * LORA_STORE_PROBE_MAX, 10);
+  CHECK((t >= LORA_STORE_PROBE_MAX) && (t < LORA_STORE_PROBE_MAX * 3 / 2 + 10));
+  CHECK(L._storeBackoff == LORA_STORE_PROBE_MAX);
+  CHECK(L.masterLost());
+
+  // Master de volta: confirma o ID da última sondagem, o lote inteiro sai
+  // da fila e o tempo de recuperação vale desde a perda
+  char out[LF_LORA_MAX_PACKET_SIZE + 1];
+  int n = L.loraAddHeaderDe("OK", 2, 0x00, 0x05, L._storeId, out);
+  L.loraMsgProcess(out, n);
+  CHECK(!L.masterLost());
+  CHECK(L._store.empty());
+  CHECK(!L._storeWaitAck && (L._storeMiss == 0));
+  CHECK(L.storeRecoveryTime() == g_millis - lostTime);
+  CHECK(L._storeLostTime == 0);
+  CHECK(!L._wheel.pending(L._tmrStore));
+
+  // Depois da volta, mensagens seguem o caminho normal
+  L.sendState("#t=4", MSG_TYPE_TELEMETRY);
+  CHECK(L._store.empty());
+  CHECK(L._internalMsgStatus == INT_STATUS_TELEMETRY);
+
+  L.setStoreEnable(false);
+
+} /* testLostMaster */
+
+/* -------------------------------------------------------------------------- */
+int main() {
+
+  LF_LoRaClass &L = LF_LoRa;
+  L.slaveCfg("TEST");
+  L.inic();
+  L._netId = 1;
+  L.setMyAddr(5);
+  L.setMasterAddr(0);
+  L.setOpMode(LORA_OP_MODE_LOOP);
+
+  testUnpack();
+  testDefaultOff();
+  testDropOldest();
+  testLostMaster();
+
+  return TEST_END();
+
+} /* main */
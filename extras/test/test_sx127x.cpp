@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// Driver SX127x contra um rádio simulado no nível dos registradores
+
+#include "test.h"
+#include "LF_LoRa_SX127x.h"
+
+#include <vector>
+
+// SPI que simula o banco de registradores e a FIFO do SX127x
+class MockSpi : public LF_SX127xSpi {
+
+public:
+
+  uint8_t regs[128] = {};
+  uint8_t fifo[256] = {};
+  std::vector<uint8_t> writes;   // Registradores escritos, em ordem
+  int selects = 0;
+
+  void select(bool active) {
+    if (active) {
+      _first = true;
+      selects++;
+    }
+  }
+
+  uint8_t transfer(uint8_t data) {
+    if (_first) {
+      _first = false;
+      _write = (data & 0x80) != 0;
+      _addr = data & 0x7F;
+      return 0;
+    }
+    uint8_t ret = 0;
+    if (_addr == SX127X_REG_FIFO) {
+      // A FIFO não avança o endereço, avança o ponteiro
+      uint8_t &ptr = regs[SX127X_REG_FIFO_ADDR_PTR];
+      if (_write) {
+        fifo[ptr] = data;
+      } else {
+        ret = fifo[ptr];
+      }
+      ptr++;
+    } else {
+      if (_write) {
+        regWrite(_addr, data);
+      } else {
+        ret = regs[_addr];
+      }
+      _addr++;
+    }
+    return ret;
+  }
+
+private:
+
+  void regWrite(uint8_t addr, uint8_t data) {
+    writes.push_back(addr);
+    if (addr == SX127X_REG_IRQ_FLAGS) {
+      // Escrever 1 limpa a flag
+      regs[addr] &= ~data;
+      return;
+    }
+    regs[addr] = data;
+    // TX termina na hora
+    if ((addr == SX127X_REG_OP_MODE) && ((data & 0x07) == SX127X_MODE_TX)) {
+      regs[SX127X_REG_IRQ_FLAGS] |= SX127X_IRQ_TX_DONE;
+    }
+  }
+
+  bool _first = false;
+  bool _write = false;
+  uint8_t _addr = 0;
+
+};
+
+/* -------------------------------------------------------------------------- */
+static void testBegin() {
+
+  MockSpi spi;
+  LF_SX127x radio;
+  radio.cfg(&spi, -1);
+
+  // Outro chip no barramento
+  CHECK(!radio.begin(915E6));
+
+  spi.regs[SX127X_REG_VERSION] = SX127X_VERSION;
+  CHECK(radio.begin(915E6));
+  CHECK(spi.regs[SX127X_REG_OP_MODE] == (SX127X_MODE_LONG_RANGE | SX127X_MODE_STDBY));
+
+  // Modo LoRa ligado em sleep antes de qualquer outra configuração
+  CHECK(spi.writes.size() > 1);
+  CHECK(spi.writes[0] == SX127X_REG_OP_MODE);
+
+  // 915 MHz => FRF 0xE4C000
+  CHECK(spi.regs[SX127X_REG_FRF_MSB] == 0xE4);
+  CHECK(spi.regs[SX127X_REG_FRF_MID] == 0xC0);
+  CHECK(spi.regs[SX127X_REG_FRF_LSB] == 0x00);
+  CHECK((spi.regs[SX127X_REG_LNA] & 0x03) == 0x03);
+
+} /* testBegin */
+
+/* -------------------------------------------------------------------------- */
+static void testBurst() {
+
+  MockSpi spi;
+  LF_SX127x radio;
+  radio.cfg(&spi, -1);
+
+  // Os três bytes do FRF numa única transação
+  int selects = spi.selects;
+  radio.setFrequency(433E6);
+  CHECK(spi.selects == selects + 1);
+  CHECK(spi.regs[SX127X_REG_FRF_MSB] == 0x6C);
+  CHECK(spi.regs[SX127X_REG_FRF_MID] == 0x40);
+  CHECK(spi.regs[SX127X_REG_FRF_LSB] == 0x00);
+
+  selects = spi.selects;
+  radio.setPreambleLength(0x0108);
+  CHECK(spi.selects == selects + 1);
+  CHECK(spi.regs[SX127X_REG_PREAMBLE_MSB] == 0x01);
+  CHECK(spi.regs[SX127X_REG_PREAMBLE_LSB] == 0x08);
+
+} /* testBurst */
+
+/* -------------------------------------------------------------------------- */
+static void testModem() {
+
+  MockSpi spi;
+  LF_SX127x radio;
+  radio.cfg(&spi, -1);
+
+  radio.setSignalBandwidth(125E3);
+  CHECK((spi.regs[SX127X_REG_MODEM_CONFIG_1] >> 4) == 7);
+  radio.setCodingRate4(5);
+  CHECK((spi.regs[SX127X_REG_MODEM_CONFIG_1] & 0x0E) == (1 << 1));
+
+  // SF12 em 125 kHz: símbolo de 32 ms, liga o Low Data Rate Optimize
+  radio.setSpreadingFactor(12);
+  CHECK((spi.regs[SX127X_REG_MODEM_CONFIG_2] >> 4) == 12);
+  CHECK(spi.regs[SX127X_REG_MODEM_CONFIG_3] & 0x08);
+  CHECK(spi.regs[SX127X_REG_DETECTION_OPTIMIZE] == 0xC3);
+
+  radio.setSpreadingFactor(7);
+  CHECK((spi.regs[SX127X_REG_MODEM_CONFIG_2] >> 4) == 7);
+  CHECK(!(spi.regs[SX127X_REG_MODEM_CONFIG_3] & 0x08));
+
+  radio.setSpreadingFactor(6);
+  CHECK(spi.regs[SX127X_REG_DETECTION_OPTIMIZE] == 0xC5);
+  CHECK(spi.regs[SX127X_REG_DETECTION_THRESHOLD] == 0x0C);
+
+  radio.setCrc(true);
+  CHECK(spi.regs[SX127X_REG_MODEM_CONFIG_2] & 0x04);
+  radio.setCrc(false);
+  CHECK(!(spi.regs[SX127X_REG_MODEM_CONFIG_2] & 0x04));
+
+  radio.setTxPower(20);
+  CHECK(spi.regs[SX127X_REG_PA_DAC] == 0x87);
+  CHECK(spi.regs[SX127X_REG_PA_CONFIG] == (0x80 | 15));
+  radio.setTxPower(10);
+  CHECK(spi.regs[SX127X_REG_PA_DAC] == 0x84);
+  CHECK(spi.regs[SX127X_REG_PA_CONFIG] == (0x80 | 8));
+
+} /* testModem */
+
+/* -------------------------------------------------------------------------- */
+static void testRssi() {
+
+  MockSpi spi;
+  LF_SX127x radio;
+  radio.cfg(&spi, -1);
+
+  spi.regs[SX127X_REG_PKT_RSSI_VALUE] = 100;
+
+  // Porta LF até 525 MHz, porta HF acima
+  radio.setFrequency(433E6);
+  CHECK(radio.packetRssi() == -64);
+  radio.setFrequency(470E6);
+  CHECK(radio.packetRssi() == -64);
+  radio.setFrequency(525E6);
+  CHECK(radio.packetRssi() == -57);
+  radio.setFrequency(868E6);
+  CHECK(radio.packetRssi() == -57);
+  radio.setFrequency(915E6);
+  CHECK(radio.packetRssi() == -57);
+
+  spi.regs[SX127X_REG_PKT_SNR_VALUE] = 0xF8;
+  CHECK(radio.packetSnr() == -2.0f);
+
+} /* testRssi */
+
+/* -------------------------------------------------------------------------- */
+static void testSend() {
+
+  MockSpi spi;
+  LF_SX127x radio;
+  radio.cfg(&spi, -1);
+
+  const uint8_t msg[5] = {'h', 'e', 'l', 'l', 'o'};
+  CHECK(radio.send(msg, 5));
+  CHECK(memcmp(spi.fifo, msg, 5) == 0);
+  CHECK(spi.regs[SX127X_REG_PAYLOAD_LENGTH] == 5);
+  CHECK((spi.regs[SX127X_REG_OP_MODE] & 0x07) == SX127X_MODE_TX);
+  CHECK(!(spi.regs[SX127X_REG_IRQ_FLAGS] & SX127X_IRQ_TX_DONE));
+
+} /* testSend */
+
+/* -------------------------------------------------------------------------- */
+static void testReceive() {
+
+  MockSpi spi;
+  LF_SX127x radio;
+  radio.cfg(&spi, -1);
+
+  radio.receive();
+  CHECK(spi.regs[SX127X_REG_DIO_MAPPING_1] == 0x00);
+  CHECK((spi.regs[SX127X_REG_OP_MODE] & 0x07) == SX127X_MODE_RX_CONTINUOUS);
+
+  // Nada recebido
+  CHECK(radio.parsePacket() == 0);
+
+  // Pacote no meio da FIFO
+  memcpy(spi.fifo + 0x20, "world", 5);
+  spi.regs[SX127X_REG_FIFO_RX_CURRENT_ADDR] = 0x20;
+  spi.regs[SX127X_REG_RX_NB_BYTES] = 5;
+  spi.regs[SX127X_REG_IRQ_FLAGS] = SX127X_IRQ_RX_DONE | SX127X_IRQ_VALID_HEADER;
+  CHECK(radio.parsePacket() == 5);
+  CHECK(spi.regs[SX127X_REG_IRQ_FLAGS] == 0);
+  uint8_t buf[5];
+  CHECK(radio.readFifo(buf, 5) == 5);
+  CHECK(memcmp(buf, "world", 5) == 0);
+
+  // CRC errado, descarta e limpa as flags
+  spi.regs[SX127X_REG_IRQ_FLAGS] = SX127X_IRQ_RX_DONE | SX127X_IRQ_PAYLOAD_CRC_ERROR;
+  CHECK(radio.parsePacket() == 0);
+  CHECK(spi.regs[SX127X_REG_IRQ_FLAGS] == 0);
+
+} /* testReceive */
+
+/* -------------------------------------------------------------------------- */
+static void testBurstFrame() {
+
+  MockSpi spi;
+  LF_SX127x radio;
+  radio.cfg(&spi, -1);
+
+  // Quadro de 255 bytes: a FIFO inteira numa só transação, nos dois
+  // sentidos. Um envio curto gasta as mesmas transações que o longo
+  uint8_t msg[255];
+  for (int i = 0; i < 255; i++) {
+    msg[i] = i ^ 0x5A;
+  }
+  int selects = spi.selects;
+  CHECK(radio.send(msg, 5));
+  int shortSend = spi.selects - selects;
+  selects = spi.selects;
+  CHECK(radio.send(msg, 255));
+  CHECK(spi.selects - selects == shortSend);
+  CHECK(memcmp(spi.fifo, msg, 255) == 0);
+  CHECK(spi.regs[SX127X_REG_PAYLOAD_LENGTH] == 255);
+
+  uint8_t buf[255];
+  spi.regs[SX127X_REG_FIFO_ADDR_PTR] = 0;
+  selects = spi.selects;
+  CHECK(radio.readFifo(buf, 255) == 255);
+  CHECK(spi.selects == selects + 1);
+  CHECK(memcmp(buf, msg, 255) == 0);
+
+} /* testBurstFrame */
+
+/* -------------------------------------------------------------------------- */
+int main() {
+  testBegin();
+  testBurst();
+  testModem();
+  testRssi();
+  testSend();
+  testReceive();
+  testBurstFrame();
+  return TEST_END();
+} /* main */
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// Modo tarefa: a aplicação configura e envia enquanto a tarefa do rádio
+// roda (std::thread no Linux). Compilado com o ThreadSanitizer.
+
+#define private public
+#include <LF_LoRa.h>
+#include "test.h"
+
+#include <thread>
+
+static const uint8_t key[LF_LORA_AES_BLOCK] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+
+/* -------------------------------------------------------------------------- */
+static void testSetters() {
+
+  LF_LoRaClass &L = LF_LoRa;
+  CHECK(L.beginTask());
+
+  for (int i = 0; i < 2000; i++) {
+    L.setRepeaterEnable(i & 1);
+    L.setAeadKey((i % 3) ? key : nullptr);
+    L.setAeadGroupKey((i % 5) ? key : nullptr);
+    L.setSyncWord(0x12 + (i & 1));
+    L.setChannelHopping((i % 4) ? 0 : 100);
+    L.setMasterRoutes(i & 2);
+    L.setTdmaEnable(i & 1);
+    L.setStoreEnable(i & 2);
+    L.setDeltaEnable(i & 1, 5 + (i & 3));
+    L.setChannel(i % 3);
+    L.setGroupResponse(i & 1, 100 + i);
+    L.setAnalyzerEnable(i & 4, 1000, nullptr);
+    L.setOtaImage(nullptr);
+    L.sendState("#t=1", MSG_TYPE_TELEMETRY);
+    L.loopLora();
+    L.opMode();
+    g_millis += 5;
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+  }
+
+  // Última configuração pedida vale, na ordem
+  L.setRepeaterEnable(true);
+  L.setAeadKey(key);
+  L.setAeadGroupKey(key);
+  L.setSyncWord(0x34);
+  L.setChannelHopping(0);
+  L.setMasterRoutes(false);
+  L.setTdmaEnable(true);
+  L.setStoreEnable(false);
+  L.setDeltaEnable(true, 7);
+  L.setChannel(2);
+  L.setGroupResponse(1, 250);
+  L.setAnalyzerEnable(true, 2000, nullptr);
+  L.endTask();
+
+  CHECK(!L.taskMode());
+  CHECK(L._repeaterEnabled);
+  CHECK(L._aeadEnabled);
+  CHECK(L._aeadGroupOk);
+  CHECK(L._syncWord == 0x34);
+  CHECK(L._hopDwell == 0);
+  CHECK(!L._wheel.pending(L._tmrHop));
+  CHECK(!L._masterRoutes);
+  CHECK(L._tdmaEnabled);
+  CHECK(!L._storeEnabled);
+  CHECK(!L._wheel.pending(L._tmrStore));
+  CHECK(L._deltaEnabled && (L._deltaFullEvery == 7));
+  CHECK(L._channel == 2);
+  CHECK((L._groupResp == 1) && (L._groupRespSlot == 250));
+  CHECK(L._analyzerEnabled && (L._analyzerPeriod == 2000));
+  CHECK(L._wheel.pending(L._tmrAnalyzer));
+  L.setAnalyzerEnable(false, 0, nullptr);
+  L.setTdmaEnable(false);
+  L.setDeltaEnable(false, 0);
+
+} /* testSetters */
+
+/* -------------------------------------------------------------------------- */
+static void testSendMode() {
+
+  LF_LoRaClass &L = LF_LoRa;
+
+  // Fora do loop a tarefa do rádio descarta o envio
+  L._internalMsgStatus = INT_STATUS_EMPTY;
+  L.setOpMode(LORA_OP_MODE_PAIRING);
+  CHECK(L.beginTask());
+  L.sendState("#t=2", MSG_TYPE_TELEMETRY);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  L.endTask();
+  CHECK(L._internalMsgStatus == INT_STATUS_EMPTY);
+
+  // Enfileirado e não pego pela tarefa: aplicado no endTask
+  L.setOpMode(LORA_OP_MODE_LOOP);
+  L._taskMode = true;
+  L.setSyncWord(0x56);
+  L.sendState("#t=3", MSG_TYPE_TELEMETRY);
+  L._taskMode = false;
+  L.taskTxDrain();
+  CHECK(L._syncWord == 0x56);
+  CHECK(L._internalMsgStatus != INT_STATUS_EMPTY);
+
+} /* testSendMode */
+
+/* -------------------------------------------------------------------------- */
+static void testTimeSnap() {
+
+  // Relógio da rede lido pela aplicação enquanto a tarefa do rádio grava
+  LF_LoRaTimeSync s;
+  LF_LoRaTimeSnap snap;
+  std::atomic<bool> run{true};
+  std::thread reader([&]() {
+    while (run) {
+      // Desvio sempre de 1000 a 1099 ms (0 antes da primeira gravação),
+      // nunca uma mistura de duas gravações
+      uint32_t off = snap.now(0);
+      CHECK((off == 0) || ((off >= 1000) && (off < 1100)));
+    }
+  });
+  for (uint32_t k = 0; k < 20000; k++) {
+    uint32_t off = 1000 + k % 100;
+    s.reset();
+    s.sample(0, off);
+    snap.store(s);
+  }
+  run = false;
+  reader.join();
+
+} /* testTimeSnap */
+
+/* -------------------------------------------------------------------------- */
+int main() {
+
+  LF_LoRaClass &L = LF_LoRa;
+  static const long plan[3] = {915000000, 915200000, 915400000};
+  L.slaveCfg("TEST");
+  L.inic();
+  L._netId = 0x01;
+  L.setMyAddr(0x05);
+  L.setMasterAddr(0x00);
+  L.setOpMode(LORA_OP_MODE_LOOP);
+  L.setChannelPlan(plan, 3);
+
+  testSetters();
+  testSendMode();
+  testTimeSnap();
+  return TEST_END();
+
+} /* main */
@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// TDMA: escravos saturados seguindo o beacon (tdmaBeacon/tdmaCanSend), cada
+// um com o seu cristal, contra ALOHA com a mesma carga. Mede a utilização
+// do canal (tempo no ar entregue sem colisão / tempo total).
+
+#define private public
+#include <LF_LoRa.h>
+#include "test.h"
+
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+#define SIM_SLAVES     20   // Escravos com slot
+#define SIM_FREE        2   // Escravos sem slot, na contenção
+#define SIM_CONTENTION  1   // Slots de contenção
+#define SIM_PAYLOAD   200   // Bytes de cada envio, sem o cabeçalho
+#define SIM_FRAMES     30   // Superframes simulados
+
+struct Tx {
+  double start;
+  double end;
+  int node;
+};
+
+struct Node {
+  LF_LoRaClass *lora;
+  double ppm;       // Deriva do cristal em relação ao master
+  double base;      // millis() do escravo quando o master estava em 0
+  double busy = 0;  // Fim do envio em andamento (tempo real)
+};
+
+static uint32_t g_airtime;   // Tempo no ar de um envio (ms)
+static uint32_t g_beaconAir; // Tempo no ar do beacon (ms)
+
+/* -------------------------------------------------------------------------- */
+// millis() do escravo no tempo real t
+static void setLocal(const Node &n, double t) {
+  g_millis = (unsigned long)llround(n.base + t * (1 + n.ppm * 1e-6));
+} /* setLocal */
+
+/* -------------------------------------------------------------------------- */
+// Envios que não se sobrepõem a nenhum outro
+static std::vector<bool> delivered(const std::vector<Tx> &txs) {
+  std::vector<size_t> order(txs.size());
+  for (size_t i = 0; i < order.size(); i++) order[i] = i;
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return txs[a].start < txs[b].start; });
+  std::vector<bool> ok(txs.size(), true);
+  for (size_t i = 0; i < order.size(); i++) {
+    const Tx &a = txs[order[i]];
+    for (size_t j = i + 1; (j < order.size()) && (txs[order[j]].start < a.end); j++) {
+      ok[order[i]] = false;
+      ok[order[j]] = false;
+    }
+  }
+  return ok;
+} /* delivered */
+
+/* -------------------------------------------------------------------------- */
+static double utilization(const std::vector<Tx> &txs, double total) {
+  std::vector<bool> ok = delivered(txs);
+  double air = 0;
+  for (size_t i = 0; i < txs.size(); i++) {
+    if (ok[i]) air += txs[i].end - txs[i].start;
+  }
+  return air / total;
+} /* utilization */
+
+/* -------------------------------------------------------------------------- */
+// Superframe que cabe os slots com a guarda no pior caso: um beacon perdido,
+// deriva de LORA_TDMA_DRIFT_PPM por dois superframes
+static void layout(uint16_t &slotLen, uint16_t &superframe) {
+  uint32_t period = 0;
+  for (int k = 0; k < 4; k++) {
+    uint32_t guard = LORA_TDMA_GUARD_MIN + (2 * period * LORA_TDMA_DRIFT_PPM + 999999) / 1000000;
+    slotLen = g_airtime + 2 * guard + 1;
+    period = (SIM_SLAVES + SIM_CONTENTION) * slotLen + g_beaconAir;
+  }
+  superframe = period;
+} /* layout */
+
+/* -------------------------------------------------------------------------- */
+// Roda SIM_FRAMES superframes. maxPpm: deriva máxima dos escravos; os
+// beacons se perdem ao acaso, nunca dois seguidos para o mesmo escravo.
+// Devolve os envios e quantos saíram do slot (ou da contenção) no tempo real.
+static std::vector<Tx> runTdma(double maxPpm, int &outside, uint16_t &superframe) {
+
+  uint16_t slotLen;
+  layout(slotLen, superframe);
+
+  // Beacon montado pelo master (instância global), sem o cabeçalho
+  uint8_t addrs[SIM_SLAVES];
+  for (int i = 0; i < SIM_SLAVES; i++) {
+    addrs[i] = 10 + i;
+  }
+  LF_LoRa.sendTdmaBeacon(superframe, slotLen, SIM_CONTENTION, addrs, SIM_SLAVES);
+  String beacon = LoRa.sent.back().substr(LF_LORA_HEADER_SIZE);
+
+  Node nodes[SIM_SLAVES + SIM_FREE];
+  for (int i = 0; i < SIM_SLAVES + SIM_FREE; i++) {
+    nodes[i].lora = new LF_LoRaClass();
+    nodes[i].lora->_myAddr = 10 + i;
+    nodes[i].lora->tdmaApply(true);
+    nodes[i].ppm = maxPpm * (2.0 * rand() / RAND_MAX - 1);
+    nodes[i].base = rand() % 100000;
+  }
+
+  std::vector<Tx> txs;
+  outside = 0;
+  bool lost[SIM_SLAVES + SIM_FREE] = {};
+  for (int k = 0; k < SIM_FRAMES; k++) {
+    // Superframe conta da recepção do beacon
+    double rx = (double)k * superframe + g_beaconAir;
+    for (int i = 0; i < SIM_SLAVES + SIM_FREE; i++) {
+      lost[i] = (k > 0) && !lost[i] && (rand() % 5 == 0);
+      if (lost[i]) continue;
+      setLocal(nodes[i], rx);
+      nodes[i].lora->_lastRxTime = g_millis;
+      CHECK(nodes[i].lora->tdmaBeacon(beacon));
+    }
+    for (double t = rx; t < rx + superframe - g_beaconAir; t += 1) {
+      for (int i = 0; i < SIM_SLAVES + SIM_FREE; i++) {
+        Node &n = nodes[i];
+        if (t < n.busy) continue;
+        setLocal(n, t);
+        if (!n.lora->tdmaActive() || !n.lora->tdmaCanSend(SIM_PAYLOAD + LF_LORA_HEADER_SIZE)) continue;
+        n.lora->_tdmaLastCycle = n.lora->_tdmaCycle;
+        n.busy = t + g_airtime;
+        txs.push_back({t, n.busy, i});
+        // Dentro do slot (ou da contenção) no tempo do master
+        double first = (i < SIM_SLAVES) ? i : SIM_SLAVES;
+        double last = (i < SIM_SLAVES) ? i + 1 : SIM_SLAVES + SIM_CONTENTION;
+        if ((t < rx + first * slotLen) || (n.busy > rx + last * slotLen)) outside++;
+      }
+    }
+  }
+
+  for (int i = 0; i < SIM_SLAVES + SIM_FREE; i++) {
+    delete nodes[i].lora;
+  }
+  return txs;
+
+} /* runTdma */
+
+/* -------------------------------------------------------------------------- */
+// ALOHA puro: cada escravo envia uma vez por período, em momento sorteado
+static double aloha(int nodes, double period) {
+  std::vector<Tx> txs;
+  for (int k = 0; k < SIM_FRAMES * 20; k++) {
+    for (int i = 0; i < nodes; i++) {
+      double t = k * period + period * rand() / RAND_MAX;
+      txs.push_back({t, t + g_airtime, i});
+    }
+  }
+  return utilization(txs, SIM_FRAMES * 20 * period);
+} /* aloha */
+
+/* -------------------------------------------------------------------------- */
+static void testUtilization() {
+
+  int outside;
+  uint16_t superframe;
+  std::vector<Tx> txs = runTdma(LORA_TDMA_DRIFT_PPM, outside, superframe);
+  double total = (double)SIM_FRAMES * superframe;
+
+  // Slots atribuídos nunca colidem nem saem do lugar
+  std::vector<bool> ok = delivered(txs);
+  int sent[SIM_SLAVES + SIM_FREE] = {};
+  for (size_t i = 0; i < txs.size(); i++) {
+    sent[txs[i].node]++;
+    if (txs[i].node < SIM_SLAVES) CHECK(ok[i]);
+  }
+  CHECK(outside == 0);
+  for (int i = 0; i < SIM_SLAVES; i++) {
+    CHECK(sent[i] == SIM_FRAMES);
+  }
+  // Quem não tem slot usa a contenção
+  for (int i = SIM_SLAVES; i < SIM_SLAVES + SIM_FREE; i++) {
+    CHECK(sent[i] > 0);
+  }
+
+  // Máximo teórico: um envio em cada slot, o resto é beacon e guarda
+  double max = (double)(SIM_SLAVES + SIM_CONTENTION) * g_airtime / superframe;
+  double tdma = utilization(txs, total);
+  double load = (double)(SIM_SLAVES + SIM_FREE) * g_airtime / superframe;
+  double same = aloha(SIM_SLAVES + SIM_FREE, superframe);
+  // Melhor caso do ALOHA, carga de meio quadro por tempo de quadro
+  double best = aloha(SIM_SLAVES + SIM_FREE, 2.0 * (SIM_SLAVES + SIM_FREE) * g_airtime);
+
+  printf("envio %u ms, superframe %u ms, carga %.2f\n", g_airtime, superframe, load);
+  printf("TDMA             %5.1f%% (máximo %5.1f%%)\n", tdma * 100, max * 100);
+  printf("ALOHA mesma carga %5.1f%%\n", same * 100);
+  printf("ALOHA carga 0.5   %5.1f%%\n", best * 100);
+  CHECK(max > 0.8);
+  CHECK(tdma >= 0.9 * max);
+  CHECK(same < 0.2);
+  CHECK(fabs(best - 0.5 * exp(-1.0)) < 0.03);
+
+} /* testUtilization */
+
+/* -------------------------------------------------------------------------- */
+static void testDriftBudget() {
+
+  // Deriva bem acima de LORA_TDMA_DRIFT_PPM: a guarda não cobre e o envio
+  // sai do slot. Mostra que é a guarda que segura os casos acima.
+  int outside;
+  uint16_t superframe;
+  runTdma(20 * LORA_TDMA_DRIFT_PPM, outside, superframe);
+  CHECK(outside > 0);
+
+} /* testDriftBudget */
+
+/* -------------------------------------------------------------------------- */
+static void testBeaconLost() {
+
+  // Sem beacon por LORA_TDMA_BEACON_LOST superframes volta ao ALOHA
+  LF_LoRaClass *n = new LF_LoRaClass();
+  n->_myAddr = 10;
+  n->tdmaApply(true);
+  g_millis = 5000;
+  n->_lastRxTime = g_millis;
+  CHECK(n->tdmaBeacon("$B03E80064000A"));
+  CHECK(n->tdmaActive() && (n->tdmaSlot() == 0));
+  g_millis += 1000UL * LORA_TDMA_BEACON_LOST;
+  CHECK(!n->tdmaCanSend(50));
+  g_millis += 1;
+  CHECK(n->tdmaCanSend(50));
+  CHECK(!n->tdmaActive());
+  delete n;
+
+} /* testBeaconLost */
+
+/* -------------------------------------------------------------------------- */
+int main() {
+
+  LF_LoRaClass &L = LF_LoRa;
+  L.slaveCfg("TEST");
+  L.inic();
+  L._netId = 1;
+  L.setMyAddr(5);
+  L.setMasterAddr(0);
+  L.setOpMode(LORA_OP_MODE_LOOP);
+
+  srand(1);
+  g_airtime = L.loraAirtime(SIM_PAYLOAD + LF_LORA_HEADER_SIZE);
+  g_beaconAir = L.loraAirtime(12 + 2 * SIM_SLAVES + LF_LORA_HEADER_SIZE);
+
+  testUtilization();
+  testDriftBudget();
+  testBeaconLost();
+
+  return TEST_END();
+
+} /* main */
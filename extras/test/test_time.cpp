@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// Relógio da rede (LF_LoRaTimeSync): desvio e deriva do cristal, volta do
+// millis(), master reiniciado e o momento da recepção vindo do DIO0
+
+#define private public
+#include <LF_LoRa.h>
+#include "test.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+/* -------------------------------------------------------------------------- */
+static void testDrift() {
+
+  // Beacons a cada 30 s com atraso aleatório, perto da volta do millis()
+  static const double ppms[] = {-80, 40, 150};
+  for (double ppm : ppms) {
+    LF_LoRaTimeSync s;
+    srand(1);
+    double t0 = 4294000000.0;
+    double worst = 0;
+    for (int k = 0; k < 200; k++) {
+      double real = k * 30000.0 + (rand() % 1000);
+      uint32_t local = (uint32_t)fmod(t0 + real, 4294967296.0);
+      uint32_t master = (uint32_t)fmod(123456.0 + real * (1 + ppm * 1e-6) + (rand() % 3 - 1), 4294967296.0);
+      s.sample(local, master);
+      // Previsão 15 s depois do beacon
+      double r2 = real + 15000;
+      uint32_t l2 = (uint32_t)fmod(t0 + r2, 4294967296.0);
+      uint32_t m2 = (uint32_t)fmod(123456.0 + r2 * (1 + ppm * 1e-6), 4294967296.0);
+      double e = fabs((double)(int32_t)(s.now(l2) - m2));
+      if (k >= LF_LORA_TIME_SAMPLES) worst = fmax(worst, e);
+    }
+    CHECK(fabs(s.driftPpm() - ppm) < 5);
+    CHECK(worst <= 3);
+    CHECK(s.accuracy() < 2);
+    CHECK(s.resetCount() == 0);
+  }
+
+} /* testDrift */
+
+/* -------------------------------------------------------------------------- */
+static void testReset() {
+
+  // Salto maior que LF_LORA_TIME_RESET: master reiniciou, começo de novo
+  LF_LoRaTimeSync s;
+  s.sample(1000, 5000);
+  s.sample(31000, 35000);
+  CHECK(s.now(32000) == 36000);
+  s.sample(61000, 200);
+  CHECK(s.resetCount() == 1);
+  CHECK(s.sampleCount() == 1);
+  CHECK(s.now(62000) == 1200);
+
+} /* testReset */
+
+/* -------------------------------------------------------------------------- */
+static void testSnapshot() {
+
+  // A cópia lida pela aplicação dá o mesmo tempo que o ajuste
+  LF_LoRaTimeSync s;
+  LF_LoRaTimeSnap snap;
+  CHECK(!snap.synced());
+  CHECK(snap.now(1234) == 1234);
+  for (uint32_t k = 0; k < 10; k++) {
+    s.sample(k * 30000, 500000 + k * 30003);
+    snap.store(s);
+  }
+  CHECK(snap.synced());
+  for (uint32_t t = 270000; t < 400000; t += 7000) {
+    CHECK(snap.now(t) == s.now(t));
+  }
+
+} /* testSnapshot */
+
+/* -------------------------------------------------------------------------- */
+static void testRxDoneStamp() {
+
+  LF_LoRaClass &L = LF_LoRa;
+
+  // Pacote achado pelo loop 50 ms depois do RxDone
+  g_millis = 1000;
+  L.rxDoneIsr(&L);
+  g_millis = 1050;
+  LoRa.rxLen = 20;
+  CHECK(L.radioParsePacket() == 20);
+  CHECK(L._lastRxTime == 1000);
+
+  // Marca sem pacote (erro de CRC) não vale para o próximo
+  g_millis = 2000;
+  L.rxDoneIsr(&L);
+  CHECK(L.radioParsePacket() == 0);
+  g_millis = 2100;
+  LoRa.rxLen = 20;
+  CHECK(L.radioParsePacket() == 20);
+  CHECK(L._lastRxTime == 2100);
+
+  // TxDone no envio também não
+  g_millis = 3000;
+  L.rxDoneIsr(&L);
+  L.loraSendRaw("x", 1);
+  g_millis = 3100;
+  LoRa.rxLen = 20;
+  CHECK(L.radioParsePacket() == 20);
+  CHECK(L._lastRxTime == 3100);
+
+} /* testRxDoneStamp */
+
+/* -------------------------------------------------------------------------- */
+int main() {
+
+  LF_LoRaClass &L = LF_LoRa;
+  L.slaveCfg("TEST");
+  L.inic();
+  L._netId = 1;
+  L.setMyAddr(5);
+  L.setMasterAddr(0);
+  L.setOpMode(LORA_OP_MODE_LOOP);
+
+  testDrift();
+  testReset();
+  testSnapshot();
+  testRxDoneStamp();
+
+  return TEST_END();
+
+} /* main */
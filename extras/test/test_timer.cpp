@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+// Roda de timers: prazos exatos, volta dos contadores e prazos além do último nível
+
+#define private public
+#include <LF_LoRa_Timer.h>
+#include "test.h"
+
+#include <stdlib.h>
+#include <vector>
+
+static uint64_t now = 0;
+static int fired = 0;
+static int late = 0;
+
+/* -------------------------------------------------------------------------- */
+static void cb(void *arg, uint8_t id) {
+  // Todo timer vence exatamente no prazo
+  LF_LoRaTimer *t = (LF_LoRaTimer *)arg;
+  fired++;
+  if (t->expire != now) late++;
+} /* cb */
+
+/* -------------------------------------------------------------------------- */
+static void testRandom(uint64_t base) {
+
+  // Inserções, trocas e cancelamentos aleatórios, andando pelo nextDeadline
+  LF_LoRaTimerWheel w;
+  w.begin(base);
+  now = base;
+  fired = 0;
+  late = 0;
+  srand(1);
+  std::vector<LF_LoRaTimer> ts(500);
+  for (size_t i = 0; i < ts.size(); i++) {
+    ts[i].cb = cb;
+    ts[i].arg = &ts[i];
+  }
+
+  for (int step = 0; step < 20000; step++) {
+    LF_LoRaTimer &t = ts[rand() % ts.size()];
+    int r = rand() % 10;
+    uint32_t d = (r < 5) ? rand() % 100 : (r < 8) ? rand() % 5000 : rand() % 300000;
+    if (rand() % 7 == 0) {
+      w.cancel(t);
+    } else {
+      w.add(t, d);
+    }
+    uint32_t next = w.nextDeadline();
+    uint64_t target = now + 1 + rand() % 200;
+    if ((next != LF_LORA_WHEEL_NONE) && (now + next < target)) {
+      now += next;
+      w.advance(now);
+    } else {
+      while (now < target) {
+        now++;
+        w.advance(now);
+      }
+    }
+  }
+
+  // Só pelo nextDeadline até esvaziar
+  int guard = 0;
+  while ((w.count() > 0) && (guard++ < 100000)) {
+    uint32_t next = w.nextDeadline();
+    CHECK(next > 0);
+    if (next == 0) break;
+    now += next;
+    w.advance(now);
+  }
+  CHECK(w.count() == 0);
+  CHECK(fired > 0);
+  CHECK(late == 0);
+
+} /* testRandom */
+
+/* -------------------------------------------------------------------------- */
+static void testFar() {
+
+  // Timer além de 64^4 ms fica numa posição do último nível que não segue
+  // o prazo, não pode esconder um timer do mesmo nível que vence antes
+  const uint32_t level3 = 1UL << (LF_LORA_WHEEL_BITS * 3);
+  const uint32_t max = 1UL << (LF_LORA_WHEEL_BITS * 4);
+  LF_LoRaTimerWheel w;
+  w.begin(0);
+  now = 0;
+  fired = 0;
+  late = 0;
+
+  LF_LoRaTimer far;
+  far.cb = cb;
+  far.arg = &far;
+  w.add(far, max + 5000000);
+  CHECK(w.nextDeadline() == max + 5000000);
+
+  now = 10 * (uint64_t)level3;
+  w.advance(now);
+  LF_LoRaTimer near;
+  near.cb = cb;
+  near.arg = &near;
+  w.add(near, 60 * level3);
+  CHECK(w.nextDeadline() == 60 * level3);
+
+  // Venço os dois só pelo nextDeadline
+  while (w.count() > 0) {
+    now += w.nextDeadline();
+    w.advance(now);
+    if (fired == 1) CHECK(!near.active && far.active);
+  }
+  CHECK(fired == 2);
+  CHECK(late == 0);
+  CHECK(w._farCount == 0);
+
+  // Cancelado continua contando certo
+  w.add(far, 0xFFFFFFF0);
+  CHECK(w._farCount == 1);
+  w.cancel(far);
+  CHECK(w._farCount == 0);
+  CHECK(w.nextDeadline() == LF_LORA_WHEEL_NONE);
+
+} /* testFar */
+
+/* -------------------------------------------------------------------------- */
+static void testMillis64() {
+
+  // millis() de 32 bits dando a volta
+  g_millis = 0xFFFFFFF0UL;
+  uint64_t a = lfLoRaMillis64();
+  g_millis = 0x100000010ULL;
+  uint64_t b = lfLoRaMillis64();
+  CHECK(b - a == 0x20);
+  CHECK(b > 0xFFFFFFFFULL);
+
+} /* testMillis64 */
+
+/* -------------------------------------------------------------------------- */
+int main() {
+
+  testRandom(0);
+  // Volta dos 32 bits e base grande
+  testRandom(0xFFFFFF00ULL);
+  testRandom(0xFFFFFFFF0000ULL);
+  testFar();
+  testMillis64();
+
+  return TEST_END();
+
+} /* main */
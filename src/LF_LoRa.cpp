@@ -21,11 +21,65 @@
 #include <SPI.h>
 #include <LoRa.h>
 
+// MAC sem precisar ligar o WiFi
+#if defined(ESP32)
+#include <esp_mac.h>
+#endif
+
 // ## Variáveis fora da Classe
 
 // Gerais
 //bool vIsDebugEnabled; // Para funcionar em serverSSDP, não pode ser variável da classe...
 
+// Argumentos dos comandos da tarefa do rádio com mais de um valor
+struct TaskCmdGroupResp {
+  uint8_t mode;
+  uint16_t slot;
+};
+
+struct TaskCmdAnalyzer {
+  bool enable;
+  uint32_t period;
+  Print *out;
+};
+
+struct TaskCmdOtaSend {
+  uint8_t para;
+  char kind;
+  uint32_t size;
+  LF_LoRaOtaImage *image;
+  uint8_t nodesLen;
+  uint8_t nodes[LF_LORA_OTA_MAX_NODES];
+};
+
+// Converte 2 caracteres HEX em byte
+static uint8_t hexByte(const char *s) {
+  uint32_t v = 0;
+  LF_LoRaFmt::parseHex(s, 2, v);
+  return v;
+} /* hexByte */
+
+// Comandos de pareamento "!PARA!DE!CMD!...", validados sem alocação
+static constexpr LF_LoRaCmdSpec pairingCmds[] = {
+  {"100", 0, 2, 0x03, false, {3, 4, 4, 4}},               // [!SSS!TTTT] slots e duração
+  {"101", 3, LF_LORA_CMD_ANY, 0x03, false, {3, 3, 0, 0}}, // !NNN!MMM!EEE[!CCC] ou lote
+};
+
+// Lê o próximo campo "#NNvalor" de uma mensagem delta
+static bool deltaNext(const String &s, int &pos, int &index, String &value) {
+  if (pos >= (int)s.length()) return false;
+  int end = s.indexOf('#', pos + 1);
+  if (end == -1) end = s.length();
+  if ((s.charAt(pos) != '#') || (end - pos < 3)) {
+    index = -2;
+    return false;
+  }
+  index = s.substring(pos+1,pos+3).toInt();
+  value = s.substring(pos+3,end);
+  pos = end;
+  return true;
+} /* deltaNext */
+
 // LF_LoRaClass Class Methods
 /* -------------------------------------------------------------------------- */
 LF_LoRaClass::LF_LoRaClass()
@@ -48,6 +102,16 @@ void LF_LoRaClass::hardwareCfg(uint8_t rstPin, uint8_t ssPin, uint8_t sckPin, ui
   // Configuração do módulo transceptor LoRa
   LoRa.setPins(_loraSsPin, _loraRstPin, _loraDi00Pin);
 
+  // Configuração do driver nativo, usado se habilitado por setNativeDriver
+  _nativeSpi.cfg(&SPI, _loraSsPin);
+  _native.cfg(&_nativeSpi, _loraRstPin);
+
+#if defined(ESP32)
+  // DIO0 sobe no RxDone: o momento da recepção vem da interrupção, não de
+  // quando o loop encontrou o pacote
+  attachInterruptArg(digitalPinToInterrupt(_loraDi00Pin), &LF_LoRaClass::rxDoneIsr, this, RISING);
+#endif
+
 } /* hardwareCfg */
 
 /* -------------------------------------------------------------------------- */
@@ -72,16 +136,31 @@ void LF_LoRaClass::btnCfg(uint8_t btn_pin, bool btn_inverted) {
 /* -------------------------------------------------------------------------- */
 void LF_LoRaClass::inic() {
 
-  // Habilito o WiFi para pegar o MAC
-  WiFi.softAP("AP_TEMP", "12345678"); // Configura o ESP32 como AP
-  _sMac = WiFi.softAPmacAddress();
-  while (_sMac.lastIndexOf(':') >= 0) {
-    _sMac.remove(_sMac.lastIndexOf(':'), 1);
-  }
+  // Marco o início para medir o tempo até o primeiro envio
+  _inicTime = micros();
+
+  // Prazos contam a partir de agora
+  _wheel.begin(lfLoRaMillis64());
+  _uiWheel.begin(lfLoRaMillis64());
+
+  // Pego o MAC do AP direto do eFuse, sem ligar o WiFi
+  uint8_t mac[6];
+  char sMac[13];
+#if defined(ESP32)
+  esp_read_mac(mac, ESP_MAC_WIFI_SOFTAP);
+#else
+  memset(mac, 0, sizeof(mac));
+#endif
+  sprintf(sMac, "%02X%02X%02X%02X%02X%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+  _sMac = String(sMac);
   _sLast6Mac = _sMac.substring(6);
-  // Desligo o WiFi para economizar energia
-  WiFi.disconnect(true);
-  WiFi.mode(WIFI_OFF);
+  // MAC virtual dos endpoints, varia o segundo dígito do final do MAC
+  uint32_t mac24 = strtoul(_sLast6Mac.c_str(), NULL, 16);
+  for (uint8_t ep = 0; ep < _endpointsLen; ep++) {
+    char sEpMac[7];
+    sprintf(sEpMac, "%06lX", (unsigned long)((mac24 + ((uint32_t)(ep + 1) << 20)) & 0xFFFFFF));
+    _endpoints[ep].sLast6Mac = String(sEpMac);
+  }
 
   // Abro Preferences com o namespace "LoRa". Cada módulo, biblioteca, etc
   // deve usar um namespace para previnir colisões de nome de chave. Irá abrir o
@@ -89,35 +168,56 @@ void LF_LoRaClass::inic() {
   // se o segundo parâmetro for true, abrirá no modo Read Only.
   // Nota: O namespace é limitado a 15 caracteres.
   pref.begin("LoRa", true);
-  // Pego os valores de opMode, masterAddr e myAddr, se a chave não existrir, retorna o valor default.
+  // Leio a configuração num só registro, se não existir uso as chaves antigas.
   // Nota: O nome da chave é limitado a 15 caracteres.
-  _opMode = pref.getUInt("opMode", LORA_OP_MODE_PAIRING);
-  _netId = pref.getUInt("netId", 0);
-  _masterAddr = pref.getUInt("masterAddr", 0);
-  _myAddr = pref.getUInt("myAddr", 0);
+  // Versões novas do registro só acrescentam campos no final
+  CfgRec cfg;
+  memset(&cfg, 0, sizeof(cfg));
+  size_t cfgLen = pref.getBytes("cfg", &cfg, sizeof(cfg));
+  if ((cfgLen >= LORA_CFG_V1_SIZE) && (cfg.version >= 1) && (cfg.version <= LORA_CFG_VERSION)) {
+    _opMode = cfg.opMode;
+    _netId = cfg.netId;
+    _masterAddr = cfg.masterAddr;
+    _myAddr = cfg.myAddr;
+    // Pulo os IDs que podem ter sido usados depois do último salvamento,
+    // assim o master não descarta mensagens novas como repetidas
+    _lastSendIdTele = 128 + ((cfg.lastSendIdTele - 128 + LORA_ID_SAVE_STEP) & 0x3F);
+    _lastSendIdConf = 192 + ((cfg.lastSendIdConf - 192 + LORA_ID_SAVE_STEP) & 0x3F);
+    // O primeiro envio já grava os IDs novos
+    _savedIdTele = cfg.lastSendIdTele;
+    _savedIdConf = cfg.lastSendIdConf;
+    _channel = (cfg.version >= 2) ? cfg.channel : LORA_CHANNEL_NONE;
+  } else {
+    _opMode = pref.getUInt("opMode", LORA_OP_MODE_PAIRING);
+    _netId = pref.getUInt("netId", 0);
+    _masterAddr = pref.getUInt("masterAddr", 0);
+    _myAddr = pref.getUInt("myAddr", 0);
+    // O firmware antigo não gravava os IDs e começava sempre dos mesmos
+    // valores: pulo adiante como no registro, o primeiro envio já o grava
+    _lastSendIdTele = 128 + ((_savedIdTele - 128 + LORA_ID_SAVE_STEP) & 0x3F);
+    _lastSendIdConf = 192 + ((_savedIdConf - 192 + LORA_ID_SAVE_STEP) & 0x3F);
+  }
+  // Endereços dos endpoints
+  uint8_t epAddrs[LORA_ENDPOINT_MAX];
+  size_t epLen = pref.getBytes("ep", epAddrs, sizeof(epAddrs));
+  for (uint8_t ep = 0; (ep < _endpointsLen) && (ep < epLen); ep++) {
+    _endpoints[ep].addr = epAddrs[ep];
+  }
+  // Grupos do principal e dos endpoints
+  if (pref.getBytes("grp", _groups, sizeof(_groups)) != sizeof(_groups)) {
+    memset(_groups, 0, sizeof(_groups));
+  }
   // Fecho Preferences
   pref.end();
 
-  setOpMode(_opMode);
-
-  // Inicialização do módulo transceptor LoRa
-  while (!LoRa.begin(_loraFrequency)) {
-    if (_debugEnabeld) {
-      Serial.println(".");
-    }
-    delay(500);
-  }
-
-  LoRa.setTxPower(20);
+  // Chaves de sessão (AEAD) e contadores do nonce
+  aeadLoad();
 
-  LoRa.setSyncWord(_syncWord);
-
-  // entro no modo "receive"
-  LoRa.receive();
+  setOpMode(_opMode);
 
-  if (_debugEnabeld) {
-    Serial.println("LoRa Iniciando, OK!");
-  }
+  // Inicialização do módulo transceptor LoRa, sem bloquear.
+  // Se falhar, loopLora tenta de novo.
+  radioBegin();
 
 } /* inic */
 
@@ -151,6 +251,18 @@ LF_LoRaClass& LF_LoRaClass::setOnLedTurnOffPairing(LF_LORA_ON_LED_TURN_OFF_PAIRI
   return *this;
 } /* setOnLedTurnOffPairing */
 
+/* -------------------------------------------------------------------------- */
+LF_LoRaClass& LF_LoRaClass::setOnAeadDeviceKey(LF_LORA_ON_AEAD_DEVICE_KEY) {
+  // No master (adaptador USB): chave do dispositivo pelo MAC da apresentação
+  // (12 dígitos HEX), true se conhecida. Habilita o AEAD no papel de master
+  // e carrega as chaves dos escravos já pareados, sem depender de inic()
+  this->onAeadDeviceKey = onAeadDeviceKey;
+  _aeadMaster = (bool)onAeadDeviceKey;
+  _aeadEnabled = _aeadDeviceOk || _aeadMaster;
+  aeadLoad();
+  return *this;
+} /* setOnAeadDeviceKey */
+
 /* -------------------------------------------------------------------------- */
 void LF_LoRaClass::setFrequency(long frequency) {
   _loraFrequency = frequency;
@@ -158,10 +270,20 @@ void LF_LoRaClass::setFrequency(long frequency) {
 
 /* -------------------------------------------------------------------------- */
 void LF_LoRaClass::setSyncWord(int synch) {
-  _syncWord = synch;
-  LoRa.setSyncWord(_syncWord);
+  if (taskCmdPush(TASK_CMD_SYNC_WORD, &synch, sizeof(synch))) return;
+  syncWordApply(synch);
 } /* setSyncWord */
 
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::syncWordApply(int synch) {
+  _syncWord = synch;
+  if (_nativeEnabled) {
+    if (_radioReady) _native.setSyncWord(_syncWord);
+  } else {
+    LoRa.setSyncWord(_syncWord);
+  }
+} /* syncWordApply */
+
 /* -------------------------------------------------------------------------- */
 uint8_t LF_LoRaClass::myAddr() {
   return _myAddr;
@@ -193,44 +315,207 @@ void LF_LoRaClass::setOpMode(uint8_t modo) {
   if (_opMode ==LORA_OP_MODE_PAIRING) {
     _stepNegotiation = LORA_STEP_NEG_INIC;
     _lastModoOp = LORA_OP_MODE_PAIRING;
+    _pairOk = false;
+    _pairPending = false;
+    _pairChannel = LORA_CHANNEL_NONE;
+    _pairRound = 0;
+    memset(_pairGroups, 0, sizeof(_pairGroups));
+    for (uint8_t ep = 0; ep < _endpointsLen; ep++) {
+      _endpoints[ep].pairOk = false;
+      _endpoints[ep].pairPending = false;
+    }
+    // Minha contribuição às chaves de sessão (AEAD), a mesma em todas as
+    // apresentações deste pareamento: o master pode ter ouvido qualquer uma
+    for (uint8_t ep = 0; ep <= _endpointsLen; ep++) {
+      _aeadPairTokens[ep] = aeadRandom();
+      _aeadPairKeyed[ep] = false;
+    }
+  }
+  // Pareamento no canal comum, loop no canal atribuído
+  if (_radioReady) {
+    radioSetFrequency(currentFrequency());
   }
 } /* setOpMode */
 
 /* -------------------------------------------------------------------------- */
-void LF_LoRaClass::loraEncode(const char *in, int len, char *out)
+int LF_LoRaClass::loraEncode(const char *in, int len, char *out)
 {
-  for (uint8_t i = 0; i < len; i++) {
+  // out precisa de LF_LORA_MAX_PACKET_SIZE + 1 bytes (terminador)
+  if ((len < 0) || (len > LF_LORA_MAX_PACKET_SIZE)) {
+    out[0] = 0;
+    return 0;
+  }
+
+  // Mensagens de pareamento ('!') vão sempre abertas
+  if ((!_aeadEnabled) || (len < LF_LORA_HEADER_SIZE) || (in[0] == '!')) {
+    for (uint8_t i = 0; i < len; i++) {
+      out[i] = in[i];
+    }
+    out[len] = 0;
+    if (_aeadMaster && (len > 0) && (in[0] == '!')) {
+      // Master: o 101 leva a minha contribuição às chaves de sessão
+      len = aeadPairReply(out, len);
+    }
+    masterRouteStamp(out, len);
+    return len;
+  }
+
+  // Cabeçalho aberto | contador | dados cifrados | tag
+  uint8_t ctrLen = aeadOverhead(hexByte(in + 4)) - LF_LORA_AEAD_TAG_LEN;
+  int outLen = len + ctrLen + LF_LORA_AEAD_TAG_LEN;
+  if (outLen > LF_LORA_MAX_PACKET_SIZE) {
+    out[0] = 0;
+    return 0;
+  }
+  if (!aeadSelect(in)) {
+    out[0] = 0;
+    return 0;
+  }
+  // Contador do nonce nunca se repete com a mesma chave: gravado a cada
+  // LORA_NONCE_SAVE_STEP quadros e pulado adiante no início, como os IDs
+  uint32_t counter = ++aeadTxCounter();
+  saveIdsCheck();
+  uint8_t nonce[LF_LORA_AES_BLOCK];
+  aeadNonce(in, counter, nonce);
+
+  int dataLen = len - LF_LORA_HEADER_SIZE;
+  uint8_t *data = (uint8_t *)out + LF_LORA_HEADER_SIZE + ctrLen;
+  for (uint8_t i = 0; i < LF_LORA_HEADER_SIZE; i++) {
     out[i] = in[i];
   }
-  out[len] = 0;
+  // O contador de saltos fica fora do nonce, posso mudar depois de calculado
+  masterRouteStamp(out, len);
+  // No quadro individual só os bits baixos do contador, o receptor completa
+  // pelo último aceito (LF_LoRaAeadWindow::expand)
+  for (uint8_t i = 0; i < ctrLen; i++) {
+    out[LF_LORA_HEADER_SIZE + i] = (uint8_t)(counter >> (8 * (ctrLen - 1 - i)));
+  }
+  for (int i = 0; i < dataLen; i++) {
+    data[i] = in[LF_LORA_HEADER_SIZE + i];
+  }
+  _aead.crypt(nonce, data, dataLen);
+  nonce[13] = 1; // Separação de domínio entre CTR e CMAC
+  _aead.mac(nonce, data, dataLen, data + dataLen);
+  out[outLen] = 0;
+  return outLen;
+
 } /* loraEncode */
 
 /* -------------------------------------------------------------------------- */
-void LF_LoRaClass::loraAddHeader(const char *in, int len, uint8_t para, char *out) {
+int LF_LoRaClass::loraAddHeader(const char *in, int len, uint8_t para, char *out) {
   _lastSendId++;
   if (_lastSendId > 127) _lastSendId = 0;
-  loraAddHeaderId(in, len, para, _lastSendId, out);
+  return loraAddHeaderId(in, len, para, _lastSendId, out);
 } /* loraAddHeader */
 
 /* -------------------------------------------------------------------------- */
-void LF_LoRaClass::loraAddHeaderId(const char *in, int len, uint8_t para, uint8_t id, char *out) {
-  char aux[len + 12]; // Buffer aux para inserir cabeçalho
-  sprintf(aux, "%02X%02X%02X%02X%04X", _netId, _myAddr, para, id, len + 12);
+int LF_LoRaClass::loraAddHeaderId(const char *in, int len, uint8_t para, uint8_t id, char *out) {
+  return loraAddHeaderDe(in, len, _myAddr, para, id, out);
+} /* loraAddHeaderId */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaClass::loraAddHeaderDe(const char *in, int len, uint8_t de, uint8_t para, uint8_t id, char *out) {
+  char aux[len + 12 + 1]; // Buffer aux para inserir cabeçalho
+  LF_LoRaFmt::fmtHex(aux + 0, 3, _netId, 2);
+  LF_LoRaFmt::fmtHex(aux + 2, 3, de, 2);
+  LF_LoRaFmt::fmtHex(aux + 4, 3, para, 2);
+  LF_LoRaFmt::fmtHex(aux + 6, 3, id, 2);
+  LF_LoRaFmt::fmtHex(aux + 8, 5, len + 12, 4);
   // Completo com msg de entrada
   for (uint8_t i = 0; i < len; i++) {
     aux[i+12] = in[i];
   }
-  loraEncode(aux, len + 12, out);
-} /* loraAddHeaderId */
+  return loraEncode(aux, len + 12, out);
+} /* loraAddHeaderDe */
 
 /* -------------------------------------------------------------------------- */
 bool LF_LoRaClass::loraDecode(const char *in, int len, char *out)
 {
-  for (uint8_t i = 0; i < len; i++) {
+  // Mensagens de pareamento ('!') vão sempre abertas
+  if ((!_aeadEnabled) || ((len > 0) && (in[0] == '!'))) {
+    for (uint8_t i = 0; i < len; i++) {
+      out[i] = in[i];
+    }
+    out[len] = 0;
+    if (_aeadMaster && (len > 0) && (in[0] == '!')) {
+      // Master: guardo a contribuição do escravo que se apresenta (100)
+      aeadPairRecord(out, len);
+    }
+    masterRouteLearn(out, len);
+    return true;
+  }
+
+  out[0] = 0;
+  _aeadReplay = false;
+  _aeadForeign = false;
+  if ((len < LF_LORA_HEADER_SIZE + LF_LORA_AEAD_OVERHEAD) || (len > LF_LORA_MAX_PACKET_SIZE)) {
+    return false;
+  }
+  for (uint8_t i = 0; i < LF_LORA_HEADER_SIZE; i++) {
+    if (!isxdigit(in[i])) return false;
+  }
+  uint8_t ctrLen = aeadOverhead(hexByte(in + 4)) - LF_LORA_AEAD_TAG_LEN;
+  int dataLen = len - LF_LORA_HEADER_SIZE - ctrLen - LF_LORA_AEAD_TAG_LEN;
+  if (dataLen < 0) {
+    return false;
+  }
+  if (!aeadSelect(in)) {
+    // Quadro de outro par, sem a chave o cabeçalho aberto ainda serve ao
+    // repetidor (loraCheckForeign)
+    _aeadForeign = true;
+    return false;
+  }
+  const uint8_t *ctr = (const uint8_t *)in + LF_LORA_HEADER_SIZE;
+  LF_LoRaAeadWindow &window = aeadRxWindow();
+  uint32_t counter;
+  if (ctrLen == LF_LORA_AEAD_CTR_LEN_GROUP) {
+    counter = ((uint32_t)ctr[0] << 24) | ((uint32_t)ctr[1] << 16) | ((uint32_t)ctr[2] << 8) | ctr[3];
+  } else {
+    counter = window.expand(((uint16_t)ctr[0] << 8) | ctr[1]);
+  }
+  uint8_t nonce[LF_LORA_AES_BLOCK];
+  aeadNonce(in, counter, nonce);
+  const uint8_t *data = ctr + ctrLen;
+
+  // Confiro a tag antes de decifrar
+  uint8_t tag[LF_LORA_AEAD_TAG_LEN];
+  nonce[13] = 1;
+  _aead.mac(nonce, data, dataLen, tag);
+  uint8_t diff = 0;
+  for (uint8_t i = 0; i < LF_LORA_AEAD_TAG_LEN; i++) {
+    diff |= tag[i] ^ data[dataLen + i];
+  }
+  if (diff != 0) {
+    if (_debugEnabeld) {
+      Serial.println("AEAD: tag inválida!");
+    }
+    return false;
+  }
+  nonce[13] = 0;
+
+  // Quadro autêntico, mas o contador do remetente tem que ser novo
+  if (!window.check(counter)) {
+    if (_debugEnabeld) {
+      Serial.println("AEAD: quadro repetido!");
+    }
+    _aeadReplay = true;
+    return false;
+  }
+  if (!_replaying) {
+    saveIdsCheck();
+  }
+
+  for (uint8_t i = 0; i < LF_LORA_HEADER_SIZE; i++) {
     out[i] = in[i];
   }
-  out[len] = 0;
+  for (int i = 0; i < dataLen; i++) {
+    out[LF_LORA_HEADER_SIZE + i] = data[i];
+  }
+  _aead.crypt(nonce, (uint8_t *)out + LF_LORA_HEADER_SIZE, dataLen);
+  out[LF_LORA_HEADER_SIZE + dataLen] = 0;
+  masterRouteLearn(out, LF_LORA_HEADER_SIZE + dataLen);
   return true;
+
 } /* loraDecode */
 
 /* -------------------------------------------------------------------------- */
@@ -242,12 +527,28 @@ uint8_t LF_LoRaClass::loraCheckMsgIni(const char *in, int len, uint8_t &de, uint
   int index;
 
   // Buffer aux para decodificação
-  char aux[LF_LORA_MAX_PACKET_SIZE];
+  char aux[LF_LORA_MAX_PACKET_SIZE + 1];
 
   if (!loraDecode(in, len, aux)) {
+    out[0] = 0; // Retorna nulo
+    if (_aeadReplay) {
+      // Autêntico e já aceito (repetidor ou repetição): cabeçalho é confiável
+      de = hexByte(in + 2);
+      para = hexByte(in + 4);
+      _lastRegRec = {de, para, hexByte(in + 6)};
+      return LORA_MSG_CHECK_ALREADY_REC; // msg já recebida
+    }
+    if (_aeadForeign) {
+      return loraCheckForeign(in, de, para);
+    }
     return LORA_MSG_CHECK_ERROR; // erro nos dados
   }
 
+  // Com AEAD a mensagem decodificada é menor
+  if (_aeadEnabled) {
+    len -= aeadOverhead(hexByte(in + 4));
+  }
+
   // Agora testo o buffer decodificado
   for (uint8_t i = 0; i < 12; i++) {
     if (!isxdigit(aux[i])) {
@@ -258,27 +559,17 @@ uint8_t LF_LoRaClass::loraCheckMsgIni(const char *in, int len, uint8_t &de, uint
   }
 
   // Analiso o buffer aux...
-  char sub[4 + 1]; // +1 para o caractere nulo '\0'
-  // Pego Net
-  strncpy(sub, aux + 0, 2);
-  sub[2] = '\0';
-  net = strtol(sub, NULL, 16); // Base 16
-  // Pego DE
-  strncpy(sub, aux + 2, 2);
-  sub[2] = '\0';
-  de = strtol(sub, NULL, 16); // Base 16
-  // Pego PARA
-  strncpy(sub, aux + 4, 2);
-  sub[2] = '\0';
-  para = strtol(sub, NULL, 16); // Base 16
-  // Pego ID
-  strncpy(sub, aux + 6, 2);
-  sub[2] = '\0';
-  id = strtol(sub, NULL, 16); // Base 16
+  net = hexByte(aux + 0); // Pego Net
+  de = hexByte(aux + 2); // Pego DE
+  para = hexByte(aux + 4); // Pego PARA
+  id = hexByte(aux + 6); // Pego ID
   // Pego LEN
-  strncpy(sub, aux + 8, 4);
-  sub[4] = '\0';
-  int len_in_msg = strtol(sub, NULL, 16); // Base 16
+  uint32_t len_hex = 0;
+  LF_LoRaFmt::parseHex(aux + 8, 4, len_hex);
+  int len_in_msg = len_hex;
+  // O nibble mais alto de LEN é o contador de saltos (repetidor)
+  _lastHops = len_in_msg >> 12;
+  len_in_msg &= 0x0FFF;
   // Testo NetId
   if (net != _netId) {
     out[0] = 0; // Retorna nulo
@@ -298,6 +589,17 @@ uint8_t LF_LoRaClass::loraCheckMsgIni(const char *in, int len, uint8_t &de, uint
   // Salvo último cabeçalho recebido
   _lastRegRec = {de, para, id};
 
+  if (isMulticast(para)) {
+    // Grupo e difusão têm registro próprio, com validade: o ID do master é
+    // um só para todos os destinos e volta a cada 128 mensagens
+    if (groupDupFind(de, para, id)) {
+      return LORA_MSG_CHECK_ALREADY_REC; // msg já recebida
+    }
+    _groupDup[_groupDupNext] = {de, para, id, millis()};
+    _groupDupNext = (_groupDupNext + 1) % LORA_GROUP_DUP_RECS;
+    return LORA_MSG_CHECK_OK; // OK
+  }
+
   // Procuro registro de cabeçalho
   index = findRegRec(de, para);
   if (index==-1) {
@@ -315,6 +617,48 @@ uint8_t LF_LoRaClass::loraCheckMsgIni(const char *in, int len, uint8_t &de, uint
 
 } /* loraCheckMsgIni */
 
+/* -------------------------------------------------------------------------- */
+uint8_t LF_LoRaClass::loraCheckForeign(const char *in, uint8_t &de, uint8_t &para)
+{
+
+  // Quadro cifrado de um par de que não tenho a chave de sessão: só o
+  // cabeçalho aberto, sem autenticar, como no descarte antecipado. Serve
+  // ao repetidor e ao registro de repetidas, nunca é entregue
+  uint8_t net = hexByte(in + 0);
+  de = hexByte(in + 2);
+  para = hexByte(in + 4);
+  uint8_t id = hexByte(in + 6);
+  uint32_t len_hex = 0;
+  LF_LoRaFmt::parseHex(in + 8, 4, len_hex);
+  _lastHops = len_hex >> 12;
+  if (net != _netId) {
+    return LORA_MSG_CHECK_ERROR; // erro nos dados
+  }
+  _lastRegRec = {de, para, id};
+
+  if (!isMulticast(para)) {
+    int index = findRegRec(de, para);
+    if (index == -1) {
+      addRegRec(de, para, id);
+    } else {
+      if (_regRecs[index].id == id) {
+        return LORA_MSG_CHECK_ALREADY_REC; // msg já recebida
+      }
+      _regRecs[index].id = id;
+    }
+  }
+
+  if ((endpointFind(para) == -1) && !isMulticast(para)) {
+    return LORA_MSG_CHECK_NOT_ME; // msg não é para mim
+  }
+  if (de != _masterAddr) {
+    return LORA_MSG_CHECK_NOT_MASTER; // msg não é do master
+  }
+  // Do master para mim sem chave: não pareado com AEAD
+  return LORA_MSG_CHECK_ERROR; // erro nos dados
+
+} /* loraCheckForeign */
+
 /* -------------------------------------------------------------------------- */
 uint8_t LF_LoRaClass::loraCheckMsg(const char *in, int len, char *out)
 {
@@ -326,9 +670,20 @@ uint8_t LF_LoRaClass::loraCheckMsg(const char *in, int len, char *out)
 
   if (ret != LORA_MSG_CHECK_OK) return ret;
 
-  if (para!=_myAddr) {
+  // Endpoint que recebe a mensagem, difusão começa no principal
+  int ep = endpointFind(para);
+  if ((ep == -1) && !isMulticast(para)) {
     return LORA_MSG_CHECK_NOT_ME; // msg não é para mim
   }
+  if (ep == -1) {
+    // Grupo de que nenhum endpoint faz parte
+    bool member = (para == LORA_ADDR_BROADCAST);
+    for (uint8_t e = 0; (e <= _endpointsLen) && !member; e++) {
+      member = groupHas(e, para);
+    }
+    if (!member) return LORA_MSG_CHECK_NOT_ME; // msg não é para mim
+  }
+  _rxEp = (ep == -1) ? 0 : ep;
   if (de!=_masterAddr) {
     return LORA_MSG_CHECK_NOT_MASTER; // msg não é do master
   }
@@ -350,6 +705,10 @@ uint8_t LF_LoRaClass::loraCheckMsgMaster(const char *in, int len, char *out)
   if (para!=_myAddr) {
     return LORA_MSG_CHECK_NOT_ME; // msg não é para mim
   }
+  if (out[0] == LORA_CTRL_CHAR) {
+    // Resposta de escravo ao envio em grupo
+    otaReport(de, out);
+  }
   return LORA_MSG_CHECK_OK; // OK
 
 } /* loraCheckMsgMaster */
@@ -420,46 +779,67 @@ uint8_t LF_LoRaClass::lastSendId() {
 } /* lastSendId */
 
 /* -------------------------------------------------------------------------- */
-void LF_LoRaClass::execMsgModePairing(String sMsg) {
+void LF_LoRaClass::execMsgModePairing(const char *msg, int len) {
 
+  // msg sem o '!' inicial: PARA!DE!CMD[!ARG...]
   if (_debugEnabeld) {
-    Serial.println("Cfg Cmd: " + sMsg + " Len: " + String(sMsg.length()));
-  }
-  if (!sMsg.substring(6,7).equals(String("!"))) return;
-  if (!sMsg.substring(13,14).equals(String("!"))) return;
-  String sPara = sMsg.substring(0,6);
-  String sDe = sMsg.substring(7,13);
-  String sCmd = sMsg.substring(14,17);
-  sDe.toUpperCase();
-  if (_debugEnabeld) {
-    Serial.println("De: " + sDe + " Para: "  + sPara + " Cmd: "  + sCmd);
+    Serial.println("Cfg Cmd: " + String(msg) + " Len: " + String(len));
   }
+  LF_LoRaCmd cmd;
+  if (!cmd.parse(msg, len)) return;
+  LF_LoRaToken tPara = cmd.token(0);
+  LF_LoRaToken tDe = cmd.token(1);
+  LF_LoRaToken tCmd = cmd.token(2);
+  if ((tPara.len != 6) || (tDe.len != 6)) return;
+  if (cmd.match(pairingCmds, sizeof(pairingCmds) / sizeof(pairingCmds[0]), 2) == nullptr) return;
+  if (!tDe.equalsIgnoreCase("FFFFFF")) return;
 
   if ((_stepNegotiation == LORA_STEP_NEG_INIC) || (_stepNegotiation == LORA_STEP_NEG_CFG)) {
     if (_debugEnabeld) {
       Serial.println("LORA_STEP_NEG_INIC ou LORA_STEP_NEG_CFG");
     }
-    if (sMsg.length() == 17) { // Comando inicial...
-      if (!sDe.equals(String("FFFFFF"))) return;
-      if ((sPara.equals(String("000000"))) && (sCmd.equals(String("100")))) {
-        String sRet = "!FFFFFF!" + _sLast6Mac + "!100!" + _sMac + "!" + _sModel;
-        // Retardo aleatóriamente para enviar
-        uint8_t t = random(0, 200);
-        delay(t);
-        if (_debugEnabeld) {
-          Serial.println(sRet);
-        }
-        sendNegotiation(sRet);
-        // Retardo aleatóriamente para enviar
-        t = random(400, 600);
-        delay(t);
-        if (_debugEnabeld) {
-          Serial.println(sRet);
-        }
-        sendNegotiation(sRet);
-        _stepNegotiation = LORA_STEP_NEG_CFG;
-        return;
+    if ((cmd.argCount() == 0) && tPara.equals("000000") && tCmd.equals("100")) { // Comando inicial...
+      String sRet = "!FFFFFF!" + _sLast6Mac + "!100!" + _sMac + "!" + _sModel + aeadPairTokenStr(0);
+      // Envio duas vezes com retardos aleatórios, sem bloquear o loop
+      unsigned long t = random(0, 200);
+      unsigned long repeat = random(400, 600);
+      pairingPush(0, sRet, t, repeat);
+      // Cada endpoint se apresenta como um dispositivo, depois do principal
+      t += repeat;
+      for (uint8_t ep = 1; ep <= _endpointsLen; ep++) {
+        EndpointRec &e = _endpoints[ep - 1];
+        sRet = "!FFFFFF!" + e.sLast6Mac + "!100!" + _sMac.substring(0,6) + e.sLast6Mac + "!" + e.model + aeadPairTokenStr(ep);
+        t += random(100, 300);
+        pairingPush(ep, sRet, t, 0);
+      }
+      _stepNegotiation = LORA_STEP_NEG_CFG;
+      return;
+    }
+    if ((cmd.argCount() == 2) && tPara.equals("000000") && tCmd.equals("100")) { // Comando inicial com slots...
+      int slots = cmd.arg(0).toInt();
+      int slotLen = cmd.arg(1).toInt();
+      if ((slots <= 0) || (slotLen <= 0)) return;
+      _pairSlotLen = slotLen;
+      _pairRound++;
+      for (uint8_t ep = 0; ep <= _endpointsLen; ep++) {
+        String sEpMac = endpointMac(ep);
+        String sModel = (ep == 0) ? _sModel : _endpoints[ep - 1].model;
+        // Escolho o slot pelo MAC misturado com a rodada: MACs diferentes se
+        // espalham pelos slots e quem colidiu cai em slots novos na rodada seguinte
+        uint32_t hash = 0;
+        LF_LoRaFmt::parseHex(sEpMac.c_str(), sEpMac.length(), hash);
+        // Rodada espalhada por todos os bits: só no byte alto ela não chega
+        // aos bits do produto de onde sai o slot
+        hash = (hash ^ ((uint32_t)_pairRound * 0x9E3779B9UL)) * 2654435761UL;
+        uint16_t slot = (hash >> 16) % slots;
+        String sRet = "!FFFFFF!" + sEpMac + "!100!" + _sMac.substring(0,6) + sEpMac + "!" + sModel + aeadPairTokenStr(ep);
+        // Envio uma vez, dentro do slot, com pequeno retardo aleatório. Sem
+        // repetição: uma cópia a mais ocuparia outro slot e dobraria as
+        // colisões, e quem o master não ouviu é chamado de novo na próxima rodada
+        pairingPush(ep, sRet, (unsigned long)slot * slotLen + random(0, slotLen / 4 + 1), 0);
       }
+      _stepNegotiation = LORA_STEP_NEG_CFG;
+      return;
     }
   }
 
@@ -467,93 +847,337 @@ void LF_LoRaClass::execMsgModePairing(String sMsg) {
     if (_debugEnabeld) {
       Serial.println("LORA_STEP_NEG_CFG");
     }
-    if (sMsg.length() != 29) return;
-    if (!sMsg.substring(17,18).equals(String("!"))) return;
-    if (!sMsg.substring(21,22).equals(String("!"))) return;
-    if (!sMsg.substring(25,26).equals(String("!"))) return;
-    if (!sDe.equals(String("FFFFFF"))) return;
-    if ((sPara.equals(_sLast6Mac)) && (sCmd.equals(String("101")))) {
-      String sNetId = sMsg.substring(18,21);
-      String sAddrM = sMsg.substring(22,25);
-      String sAddrE = sMsg.substring(26,29);
-      String sRet = "!FFFFFF!" + _sLast6Mac + "!101!" + sNetId + "!" + sAddrM + "!" + sAddrE;
-      if (_debugEnabeld) {
-        Serial.println(sRet);
+    if (!tCmd.equals("101")) return;
+    LF_LoRaToken tNetId = cmd.arg(0);
+    LF_LoRaToken tAddrM = cmd.arg(1);
+    // Contribuição do master à chave de sessão (AEAD), "!Nxxxxxxxx" no fim
+    uint8_t argc = cmd.argCount();
+    LF_LoRaToken tToken = cmd.arg(argc - 1);
+    bool keyed = (argc > 3) && (tToken.len == 9) && (tToken.ptr[0] == 'N') && tToken.sub(1, 8).isHex();
+    uint32_t masterToken = 0;
+    if (keyed) {
+      LF_LoRaFmt::parseHex(tToken.ptr + 1, 8, masterToken);
+      argc--;
+    }
+    LF_LoRaToken tChannel = {"", 0};
+    LF_LoRaToken tGroups[LORA_ENDPOINT_MAX + 1];
+    // Endpoints (0 é o principal) configurados por esta mensagem
+    uint8_t eps[LORA_ENDPOINT_MAX + 1];
+    LF_LoRaToken tAddrs[LORA_ENDPOINT_MAX + 1];
+    unsigned long times[LORA_ENDPOINT_MAX + 1];
+    uint8_t n = 0;
+    bool single = false;
+    int ep = endpointMacFind(tPara);
+    if ((argc <= 5) && (ep != -1)) {
+      // !NNN!MMM!EEE[!CCC][!Gggg...], com canal e grupos atribuídos pelo master
+      if (cmd.arg(2).len != 3) return;
+      tGroups[0] = {"", 0};
+      for (uint8_t i = 3; i < argc; i++) {
+        LF_LoRaToken t = cmd.arg(i);
+        if ((t.len > 0) && (t.ptr[0] == LORA_GROUP_CHAR)) {
+          tGroups[0] = t.sub(1, t.len - 1);
+        } else {
+          if ((t.len != 3) || !t.isDigits()) return;
+          tChannel = t;
+        }
       }
-      sendNegotiation(sRet);
-      // Retardo aleatóriamente para enviar
-      uint8_t t = random(400, 600);
-      delay(t);
-      if (_debugEnabeld) {
-        Serial.println(sRet);
-      }
-      sendNegotiation(sRet);
-      _stepNegotiation = LORA_STEP_NEG_FIM;
-      _netId = sNetId.toInt();
-      _masterAddr = sAddrM.toInt();
-      _myAddr = sAddrE.toInt();
-      setOpMode(LORA_OP_MODE_LOOP);
-      if (_btnEnabled == true) {
-        // Terminou a configuração... desligando o LED
-        if (onLedTurnOffPairing)
-          onLedTurnOffPairing();
-      }
-      // Abro Preferences com o nomespace "LoRa"
-      pref.begin("LoRa", false);
-      // Salvo _opMode, _masterAddr e _myAddr na memória não volátil com os nomes das chaves "opMode", "masterAdd" e "myAddr"
-      pref.putUInt("opMode", _opMode);
-      pref.putUInt("netId", _netId);
-      pref.putUInt("masterAddr", _masterAddr);
-      pref.putUInt("myAddr", _myAddr);
-      // Fecho Preferences
-      pref.end();
-
+      eps[0] = ep;
+      tAddrs[0] = cmd.arg(2);
+      times[0] = 0;
+      n = 1;
+      single = true;
+    } else if (tPara.equals("FFFFFF")) {
+      // Configuração em lote: !FFFFFF!FFFFFF!101!NNN!MMM!XXXXXXEEE[CCC][Gggg...][!XXXXXXEEE...]
+      for (uint8_t i = 2; i < argc; i++) {
+        LF_LoRaToken t = cmd.arg(i);
+        LF_LoRaToken g = {"", 0};
+        for (uint16_t k = 9; k < t.len; k++) {
+          if (t.ptr[k] == LORA_GROUP_CHAR) {
+            g = t.sub(k + 1, t.len - k - 1);
+            t = t.sub(0, k);
+            break;
+          }
+        }
+        if ((t.len != 9) && (t.len != 12)) return;
+        ep = endpointMacFind(t.sub(0,6));
+        if ((ep != -1) && (n <= LORA_ENDPOINT_MAX)) {
+          eps[n] = ep;
+          tAddrs[n] = t.sub(6,3);
+          tGroups[n] = g;
+          // Respondo na ordem da lista, um slot para cada
+          times[n] = (unsigned long)(i - 2) * _pairSlotLen;
+          n++;
+          if (t.len == 12) {
+            tChannel = t.sub(9,3);
+          }
+        }
+      }
+      if (n == 0) return;
+    } else {
       return;
     }
+    // Endereço de grupo ou de difusão não serve para um nó
+    for (uint8_t k = 0; k < n; k++) {
+      if (!tAddrs[k].isDigits() || (tAddrs[k].toInt() >= LORA_ADDR_GROUP_FIRST)) return;
+    }
+    _pairNetId = tNetId.toInt();
+    _pairMasterAddr = tAddrM.toInt();
+    if (tChannel.len == 3) {
+      _pairChannel = tChannel.toInt();
+    }
+    for (uint8_t k = 0; k < n; k++) {
+      char ret[48];
+      LF_LoRaLine line(ret, sizeof(ret), '!');
+      line.addStr("FFFFFF").addStr(endpointMacStr(eps[k])).addStr("101");
+      line.addStr(tNetId.ptr, tNetId.len).addStr(tAddrM.ptr, tAddrM.len).addStr(tAddrs[k].ptr, tAddrs[k].len);
+      if (tChannel.len == 3) {
+        line.addStr(tChannel.ptr, tChannel.len);
+      }
+      if (!pairGroupsSet(eps[k], tGroups[k])) return;
+      String sRet = String(ret);
+      if (eps[k] == 0) {
+        _pairMyAddr = tAddrs[k].toInt();
+        _pairOk = true;
+      } else {
+        _endpoints[eps[k] - 1].pairAddr = tAddrs[k].toInt();
+        _endpoints[eps[k] - 1].pairOk = true;
+      }
+      _aeadPairKeyed[eps[k]] = keyed;
+      _aeadPairMaster[eps[k]] = masterToken;
+      if (single) {
+        // Envio já e repito com retardo aleatório, sem bloquear o loop
+        pairingPush(eps[k], sRet, 0, random(400, 600));
+      } else {
+        // Configuração em lote, finalizo após enviar a confirmação duas
+        // vezes como no caso individual: a segunda depois de todo o lote,
+        // no mesmo slot, para não colidir com os outros da lista
+        pairingPush(eps[k], sRet, times[k], (unsigned long)(argc - 2) * _pairSlotLen);
+      }
+    }
+    if (_pairOk) {
+      // Endpoints que o master não configurar não seguram o pareamento
+      if (!_wheel.pending(_tmrPairEp)) {
+        _wheel.add(_tmrPairEp, LORA_ENDPOINT_PAIR_TIMEOUT);
+      }
+    }
+    pairingCheckFinish();
+    return;
   }
 
 } /* execMsgModePairing */
 
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::execMsgModePairing(String sMsg) {
+  // Assinatura antiga, para quem já chamava com String
+  execMsgModePairing(sMsg.c_str(), sMsg.length());
+} /* execMsgModePairing */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::pairingPush(uint8_t ep, String sRet, unsigned long delay, unsigned long repeat) {
+  // repeat: retardo da segunda cópia depois da primeira, 0 envia uma vez
+  if (ep > 0) {
+    EndpointRec &e = _endpoints[ep - 1];
+    e.pairMsg = sRet;
+    e.pairRepeat = repeat;
+    _wheel.add(e.pairTimer, delay);
+    e.pairPending = true;
+    return;
+  }
+  _pairMsg = sRet;
+  _pairRepeat = repeat;
+  _wheel.add(_tmrPair, delay);
+  _pairPending = true;
+} /* pairingPush */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::pairingSendLoop() {
+
+  if (_pairPending && !_wheel.pending(_tmrPair)) {
+    if (_debugEnabeld) {
+      Serial.println(_pairMsg);
+    }
+    sendNegotiation(_pairMsg);
+    if (_pairRepeat > 0) {
+      _wheel.add(_tmrPair, _pairRepeat);
+      _pairRepeat = 0;
+      return;
+    }
+    _pairPending = false;
+    pairingCheckFinish();
+    return;
+  }
+
+  for (uint8_t ep = 0; ep < _endpointsLen; ep++) {
+    EndpointRec &e = _endpoints[ep];
+    if (e.pairPending && !_wheel.pending(e.pairTimer)) {
+      sendNegotiation(e.pairMsg);
+      if (e.pairRepeat > 0) {
+        _wheel.add(e.pairTimer, e.pairRepeat);
+        e.pairRepeat = 0;
+        return;
+      }
+      e.pairPending = false;
+      pairingCheckFinish();
+      // Um envio por loop
+      return;
+    }
+  }
+
+  // Desisto dos endpoints que faltam
+  if (_pairOk && !_wheel.pending(_tmrPairEp) && (_opMode == LORA_OP_MODE_PAIRING)) {
+    for (uint8_t ep = 0; ep < _endpointsLen; ep++) {
+      _endpoints[ep].pairPending = false;
+    }
+    if (!_pairPending) {
+      pairingFinish();
+    }
+  }
+
+} /* pairingSendLoop */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::pairingCheckFinish() {
+  // Termino com o principal e todos os endpoints configurados e respondidos
+  if (_pairOk && !_pairPending && endpointPairDone()) {
+    pairingFinish();
+  }
+} /* pairingCheckFinish */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::pairingFinish() {
+
+  _netId = _pairNetId;
+  _masterAddr = _pairMasterAddr;
+  _myAddr = _pairMyAddr;
+  _channel = _pairChannel;
+  for (uint8_t ep = 0; ep < _endpointsLen; ep++) {
+    EndpointRec &e = _endpoints[ep];
+    // Endpoint não configurado fica sem endereço
+    e.addr = e.pairOk ? e.pairAddr : 0;
+    if (!e.pairOk) memset(_pairGroups[ep + 1], 0, LORA_GROUP_MAX);
+  }
+  memcpy(_groups, _pairGroups, sizeof(_groups));
+  _wheel.cancel(_tmrPairEp);
+  _stepNegotiation = LORA_STEP_NEG_FIM;
+  _deltaBaseOk = false;
+  setOpMode(LORA_OP_MODE_LOOP);
+  if ((_btnEnabled == true) && (!_taskMode)) {
+    // Terminou a configuração... desligando o LED
+    if (onLedTurnOffPairing)
+      onLedTurnOffPairing();
+  }
+  // Endereços novos, chaves de sessão (AEAD) novas
+  aeadPairKeys();
+  // Salvo a configuração na memória não volátil
+  saveCfg();
+
+} /* pairingFinish */
+
 /* -------------------------------------------------------------------------- */
 void LF_LoRaClass::sendNegotiation(String sRet) {
 
   if (_opMode != LORA_OP_MODE_PAIRING) return;
 
-  // Enviando estado via LoRa
-  LoRa.beginPacket();
-
   // Crio buffer para colocar dados LoRa
-  char lora_data[LF_LORA_MAX_PACKET_SIZE];
+  char lora_data[LF_LORA_MAX_PACKET_SIZE + 1];
 
   // Formato pacote LoRa
-  loraEncode(sRet.c_str(), sRet.length(), lora_data);
+  int len = loraEncode(sRet.c_str(), sRet.length(), lora_data);
 
   // Enviando LoRa
-  LoRa.print(lora_data);
-
-  LoRa.endPacket();
-
-  // entro no modo "receive"
-  LoRa.receive();
+  loraSendRaw(lora_data, len);
 
 } /* sendNegotiation */
 
 /* -------------------------------------------------------------------------- */
 bool LF_LoRaClass::loopLora() {
 
+  reportLoop();
+
+  // No modo tarefa o rádio roda em outra tarefa, aqui só entrego as mensagens
+  if (_taskMode) {
+    return taskRxDrain();
+  }
+
+  return serviceLora();
+
+} /* loopLora */
+
+/* -------------------------------------------------------------------------- */
+uint32_t LF_LoRaClass::timeToNextDeadline() {
+
+  // Tempo (ms) que o chamador pode dormir sem perder um prazo.
+  // LF_LORA_WHEEL_NONE se não há nada agendado.
+  if (_taskMode) return LF_LORA_WHEEL_NONE;
+
+  _wheel.advance(lfLoRaMillis64());
+
+  // Mensagem esperando para sair, do principal ou de um endpoint
+  if (nextSendLen() >= 0) return 0;
+  if (_pairPending && !_wheel.pending(_tmrPair)) return 0;
+  for (uint8_t ep = 0; ep < _endpointsLen; ep++) {
+    if (_endpoints[ep].pairPending && !_wheel.pending(_endpoints[ep].pairTimer)) return 0;
+  }
+  if (_analyzerEnabled && !_wheel.pending(_tmrAnalyzer)) return 0;
+  if (_otaRepPending && !_wheel.pending(_tmrOtaRep)) return 0;
+  if ((_otaTx.status() == LF_LORA_OTA_SENDING) && !_wheel.pending(_tmrOtaTx)) return 0;
+
+  uint32_t next = _wheel.nextDeadline();
+
+  // Retransmissões do repetidor
+  for (int i = 0; i < _fwdRecsLen; i++) {
+    int64_t elapsed = getDeltaMillis(_fwdRecs[i].time);
+    uint32_t wait = (elapsed >= (int64_t)_fwdRecs[i].delay) ? 0 : _fwdRecs[i].delay - elapsed;
+    if (wait < next) next = wait;
+  }
+
+  // Botão e LED, borda da interrupção esperando vence agora
+  if (_btnEnabled) {
+    if (!_btnEdgeQueue.empty()) return 0;
+    uint32_t ui = _uiWheel.nextDeadline();
+    if (ui < next) next = ui;
+  }
+
+  return next;
+
+} /* timeToNextDeadline */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::serviceLora() {
+
+  // Todos os prazos do protocolo vencem aqui
+  _wheel.advance(lfLoRaMillis64());
+
+  if (!_radioReady) {
+    if (!_wheel.pending(_tmrRadio)) {
+      radioBegin();
+    }
+    return false;
+  }
+
   bool ret = loraMsgReceiveLoop();
 
+  channelHopLoop(ret);
+
   loraMsgSendLoop();
 
+  repeaterSendLoop();
+
+  pairingSendLoop();
+
+  otaLoop();
+
+  analyzerLoop();
+
   return ret;
 
-} /* loopLora */
+} /* serviceLora */
 
 /* -------------------------------------------------------------------------- */
 bool LF_LoRaClass::loraMsgReceiveLoop() {
 
   // Tentando analisar pacote recebido
-  int packetSize = LoRa.parsePacket();
+  int packetSize = radioParsePacket();
 
   if (packetSize) {
 
@@ -564,96 +1188,249 @@ bool LF_LoRaClass::loraMsgReceiveLoop() {
       return false;
     }
 
-    // Lendo o pacote
-    String LoraData = "";
+    // Momento da recepção (radioParsePacket), usado pelo TDMA e pelo relógio da rede
+    _lastRxLen = packetSize;
 
-    while (LoRa.available()) {
-      LoraData += (char)LoRa.read();
+    // Lendo o pacote
+    char loraData[LF_LORA_MAX_PACKET_SIZE + 1];
+    int loraLen = 0;
+
+    if ((_opMode == LORA_OP_MODE_LOOP) && (packetSize >= LF_LORA_HEADER_SIZE) && !_analyzerEnabled) {
+      // Leio só o cabeçalho e descarto cedo o que não é para mim
+      loraLen = radioRead(loraData, LF_LORA_HEADER_SIZE);
+      if (loraEarlyDrop(loraData, loraLen)) {
+        _earlyDropCount++;
+        captureRec(loraData, loraLen, packetSize, LORA_MSG_CHECK_EARLY_DROP);
+        return false;
+      }
     }
 
-    // Lendo o lastRSSI
-    _rssi = LoRa.packetRssi();
+    loraLen += radioRead(loraData + loraLen, packetSize - loraLen);
+    loraData[loraLen] = 0;
+
+    // Lendo o lastRSSI e o SNR
+    if (_nativeEnabled) {
+      _rssi = _native.packetRssi();
+      _snr = _native.packetSnr();
+    } else {
+      _rssi = LoRa.packetRssi();
+      _snr = LoRa.packetSnr();
+    }
 
-    // Crio buffer para receber a mensagem processada
-    char msg_data[packetSize];
+    if (_analyzerEnabled) {
+      // Todo quadro ouvido entra nas estatísticas, de qualquer rede ou endereço
+      _analyzer.frame(loraData, loraLen, _rssi, loraAirtime(packetSize), millis());
+    }
 
-    if (_opMode == LORA_OP_MODE_LOOP) {
+    return loraMsgProcess(loraData, loraLen);
 
-      int res = loraCheckMsg(LoraData.c_str(), LoraData.length(), msg_data);
+  }
 
-      if (res==LORA_MSG_CHECK_OK) {
-        // está OK, trato a mensagem
-        _lastIdRec = _lastRegRec.id;
-        String sMsg = String(msg_data);
+  return false;
 
-        // Presevo msg par o usuário
-        _lastMsg = sMsg;
+} /* loraMsgReceiveLoop */
 
-        if (_debugEnabeld) {
-          Serial.println("Msg ID: " + String(_lastIdRec) + " Msg: " + sMsg);
-          Serial.println("Recebendo Msg: " + sMsg);
-          Serial.print("RSSI: "); Serial.println(String(_rssi, DEC));
-        }
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::loraMsgProcess(const char *loraData, int len) {
 
-        if (_lastIdRec > 191) {
-          if (_lastIdRec == _internalMsgId) {
-            // É confirmação de recebimento de mensagem MSG_TYPE_CONFIRM
-            _internalMsgStatus = INT_STATUS_EMPTY;
-            _internalLastMsgStatus = INT_STATUS_EMPTY;
-            return true;
-          }
-        }
+  // Crio buffer para receber a mensagem processada
+  char msg_data[len + 1];
 
-        // Trato o comando (calback)
-        if (onExecMsgModeLoop)
-          onExecMsgModeLoop(sMsg, MSG_TYPE_RESPONSE);
+  if (_opMode == LORA_OP_MODE_LOOP) {
 
-        return true;
+    int res = loraCheckMsg(loraData, len, msg_data);
 
-      } else {
+    captureRec(loraData, len, len, res);
 
-        if (_debugEnabeld) {
-          Serial.println("Msg não OK, retorno: " + String(res));
-        }
+    if (res==LORA_MSG_CHECK_OK) {
+      // está OK, trato a mensagem
+      _lastIdRec = _lastRegRec.id;
+      String sMsg = String(msg_data);
 
+      // Presevo msg par o usuário
+      if (!_taskMode) {
+        _lastMsg = sMsg;
       }
 
-    }
-    if (_opMode == LORA_OP_MODE_PAIRING) {
+      if (_debugEnabeld) {
+        Serial.println("Msg ID: " + String(_lastIdRec) + " Msg: " + sMsg);
+        Serial.println("Recebendo Msg: " + sMsg);
+        Serial.print("RSSI: "); Serial.println(String(_rssi, DEC));
+      }
 
-      if (loraDecode(LoraData.c_str(), LoraData.length(), msg_data)) {
+      if ((sMsg.charAt(0) == LORA_CTRL_CHAR) && execMsgCtrl(sMsg)) {
+        // Mensagem de controle da biblioteca
+        return false;
+      }
 
-        String sMsg = String(msg_data);
-        if (_debugEnabeld) {
-          Serial.println("Msg Cfg: " + sMsg);
+      if ((_lastIdRec > 191) && (_rxEp == 0)) {
+        if (_storeWaitAck && (_lastIdRec == _storeId)) {
+          // Confirmação de um quadro em lote
+          storeAck();
+          return true;
+        }
+        if (_lastIdRec == _internalMsgId) {
+          // É confirmação de recebimento de mensagem MSG_TYPE_CONFIRM
+          _storeMiss = 0;
+          deltaAck();
+          _internalMsgStatus = INT_STATUS_EMPTY;
+          _internalLastMsgStatus = INT_STATUS_EMPTY;
+          if (_taskMode) {
+            taskRxPush(msg_data, false);
+          }
+          return true;
+        }
+      }
+      if ((_lastIdRec > 191) && (_rxEp > 0)) {
+        EndpointRec &e = _endpoints[_rxEp - 1];
+        if (_lastIdRec == e.msgId) {
+          // Confirmação para um endpoint
+          e.msgStatus = INT_STATUS_EMPTY;
+          e.lastMsgStatus = INT_STATUS_EMPTY;
+          if (_taskMode) {
+            taskRxPush(msg_data, false);
+          }
+          return true;
         }
-        if (sMsg.substring(0,1).equals(String("!")))
-          execMsgModePairing(sMsg.substring(1));
+      }
 
+      // Resposta a grupo ou difusão sai no slot do meu endereço
+      _groupRxOn = isMulticast(_lastRegRec.para);
+      if (_groupRxOn) {
+        _groupRxId = _lastIdRec;
+        _wheel.add(_tmrGroupResp, (uint32_t)(_myAddr % LORA_GROUP_RESP_SLOTS) * _groupRespSlot);
       }
 
-    }
+      // Difusão vai para todos os endpoints, grupo só para os membros
+      uint8_t epFirst = _rxEp;
+      uint8_t epLast = _groupRxOn ? _endpointsLen : _rxEp;
+      for (uint8_t ep = epFirst; ep <= epLast; ep++) {
+        if ((_lastRegRec.para != LORA_ADDR_BROADCAST) && _groupRxOn && !groupHas(ep, _lastRegRec.para)) continue;
+        _rxEp = ep;
+        // Trato o comando (calback), no modo tarefa na tarefa da aplicação
+        if (_taskMode) {
+          taskRxPush(msg_data, true);
+        } else if (ep > 0) {
+          if (_endpoints[ep - 1].onExecMsg)
+            _endpoints[ep - 1].onExecMsg(sMsg, MSG_TYPE_RESPONSE);
+        } else if (onExecMsgModeLoop) {
+          onExecMsgModeLoop(sMsg, MSG_TYPE_RESPONSE);
+        }
+      }
 
-  }
+      return true;
 
-  return false;
+    } else {
 
-} /* loraMsgReceiveLoop */
+      if (_debugEnabeld) {
+        Serial.println("Msg não OK, retorno: " + String(res));
+      }
+
+      if ((res==LORA_MSG_CHECK_NOT_MASTER) && (msg_data[0] == LORA_CTRL_CHAR)) {
+        // Resposta de escravo ao envio em grupo
+        otaReport(_lastRegRec.de, msg_data);
+      }
+
+      if (_repeaterEnabled) {
+        if (res==LORA_MSG_CHECK_NOT_ME) {
+          // Msg para outro nó, avalio se retransmito
+          repeaterCheck(loraData, len);
+        } else if (res==LORA_MSG_CHECK_ALREADY_REC) {
+          // Outro repetidor já retransmitiu, cancelo a minha
+          repeaterCancel(_lastRegRec);
+        }
+      }
+
+    }
+
+  }
+  if (_opMode == LORA_OP_MODE_PAIRING) {
+
+    bool ok = loraDecode(loraData, len, msg_data);
+
+    captureRec(loraData, len, len, ok ? LORA_MSG_CHECK_OK : LORA_MSG_CHECK_ERROR);
+
+    if (ok) {
+
+      if (_debugEnabeld) {
+        Serial.println("Msg Cfg: " + String(msg_data));
+      }
+      if (msg_data[0] == '!')
+        execMsgModePairing(msg_data + 1, strlen(msg_data) - 1);
+
+    }
+
+  }
+
+  return false;
+
+} /* loraMsgProcess */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::loraEarlyDrop(const char *header, int len) {
+
+  // Cabeçalho incompleto ou inválido, deixo loraCheckMsg decidir
+  if (len < LF_LORA_HEADER_SIZE) return false;
+  for (uint8_t i = 0; i < LF_LORA_HEADER_SIZE; i++) {
+    if (!isxdigit(header[i])) return false;
+  }
+
+  uint8_t net = hexByte(header + 0);
+  uint8_t de = hexByte(header + 2);
+  uint8_t para = hexByte(header + 4);
+  uint8_t id = hexByte(header + 6);
+
+  // Outra rede
+  if (net != _netId) return true;
+
+  // Outro destino, o repetidor ainda precisa ver a mensagem
+  if ((endpointFind(para) == -1) && !isMulticast(para) && (!_repeaterEnabled)) return true;
+
+  // Já recebida
+  int index = findRegRec(de, para);
+  bool dup = isMulticast(para) ? groupDupFind(de, para, id) : ((index != -1) && (_regRecs[index].id == id));
+  if (dup) {
+    if (_repeaterEnabled && !_replaying) {
+      // Outro repetidor já retransmitiu, cancelo a minha
+      repeaterCancel({de, para, id});
+    }
+    return true;
+  }
+
+  return false;
+
+} /* loraEarlyDrop */
+
+/* -------------------------------------------------------------------------- */
+uint32_t LF_LoRaClass::earlyDropCount() {
+  return _earlyDropCount;
+} /* earlyDropCount */
 
 /* -------------------------------------------------------------------------- */
 void LF_LoRaClass::loraMsgSendLoop() {
 
-  if (fiFoSendMsg()) {
-    return;
+  bool tdma = _tdmaBeaconOk;
+  if (tdma) {
+    // No modo TDMA só envio dentro do meu slot
+    int len = nextSendLen();
+    if (len < 0) return;
+    if (_aeadEnabled) len += LF_LORA_AEAD_OVERHEAD;
+    if (!tdmaCanSend(len + LF_LORA_HEADER_SIZE)) return;
   }
 
-  internalSendMsg();
+  // Um envio por vez, todos os endpoints pelo mesmo escalonador
+  bool sent = fiFoSendMsg() || internalSendMsg() || storeSendMsg() || endpointSendMsg();
+
+  if (sent && tdma && _tdmaBeaconOk) {
+    // Slot deste superframe usado, só depois de enviar de fato
+    _tdmaLastCycle = _tdmaCycle;
+  }
 
 } /* loraMsgSendLoop */
 
 /* -------------------------------------------------------------------------- */
 int LF_LoRaClass::lastRssi() {
-  return _rssi;
+  return _taskMode ? _appRssi : _rssi;
 } /* lastRssi */
 
 /* -------------------------------------------------------------------------- */
@@ -663,18 +1440,44 @@ String LF_LoRaClass::lastMsg() {
 
 /* -------------------------------------------------------------------------- */
 uint8_t LF_LoRaClass::lastIdRec() {
-  return _lastIdRec;
+  return _taskMode ? _appIdRec : _lastIdRec;
 } /* lastIdRec */
 
 /* -------------------------------------------------------------------------- */
 void LF_LoRaClass::sendState(String sState, MsgType mt) {
+  sendState(0, sState, mt);
+} /* sendState */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::sendState(uint8_t ep, String sState, MsgType mt) {
+
+  if (ep > _endpointsLen) return;
+
+  if (_taskMode) {
+    // Entrego para a tarefa do rádio, que confere o modo de operação
+    TaskMsg item;
+    item.type = mt;
+    item.ep = ep;
+    item.id = _appIdRec;
+    item.group = (mt == MSG_TYPE_RESPONSE) && _appGroup;
+    strncpy(item.msg, sState.c_str(), LF_LORA_MAX_PACKET_SIZE);
+    item.msg[LF_LORA_MAX_PACKET_SIZE] = 0;
+    if (!_taskTxQueue.push(item)) {
+      if (_debugEnabeld) {
+        Serial.println("Fila TX cheia!");
+      }
+    }
+    return;
+  }
 
   if (_opMode != LORA_OP_MODE_LOOP) return;
 
   if (mt == MSG_TYPE_RESPONSE) {
-    fiFoPushMsg(sState, _lastIdRec);
-  } else {
+    fiFoPushMsg(sState, _lastIdRec, endpointAddr(ep), _groupRxOn && (_lastIdRec == _groupRxId));
+  } else if (ep == 0) {
     internalPushMsg(sState, mt);
+  } else {
+    endpointPushMsg(ep, sState, mt);
   }
 
 } /* sendState */
@@ -685,6 +1488,8 @@ void LF_LoRaClass::loopBtnLed() {
   // Só executa se estiver habilitado
   if (_btnEnabled == false) return;
 
+  // Prazos do botão e do LED
+  _uiWheel.advance(lfLoRaMillis64());
   // Avaliando o Btn
   btnCheck();
 
@@ -692,12 +1497,20 @@ void LF_LoRaClass::loopBtnLed() {
   if (_btnCfgActive) {
     _btnCfgActive = false;
     // Comutando o modo de operação para CFG
-    if (_opMode == LORA_OP_MODE_LOOP) {
+    if (_taskMode) {
+      _taskReqPairing = true;
+    } else if (_opMode == LORA_OP_MODE_LOOP) {
       setOpMode(LORA_OP_MODE_PAIRING);
     }
   }
 
   // Loop LED
+  ledLoop();
+
+} /* loopBtnLed */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::ledLoop() {
 
   // Vejo se os calbacks estão configurados
   if (!onLedCheck) return;
@@ -705,8 +1518,8 @@ void LF_LoRaClass::loopBtnLed() {
   if (!onLedTurnOffPairing) return;
 
   if (_opMode == LORA_OP_MODE_PAIRING) {
-    if (getDeltaMillis(_lastLedTime) > LED_CICLE_TIME) {
-      _lastLedTime = millis();
+    if (!_uiWheel.pending(_tmrLed)) {
+      _uiWheel.add(_tmrLed, LED_CICLE_TIME);
       if (onLedCheck()) {
         onLedTurnOffPairing();
       } else {
@@ -715,73 +1528,110 @@ void LF_LoRaClass::loopBtnLed() {
     }
   } else {
     // Apago o LED quando termina a configuração
-    if (_lastModoOp = LORA_OP_MODE_PAIRING) {
+    if (_lastModoOp == LORA_OP_MODE_PAIRING) {
       _lastModoOp = LORA_OP_MODE_LOOP;
       onLedTurnOffPairing();
     }
   }
 
-} /* loopBtnLed */
+} /* ledLoop */
 
 /* -------------------------------------------------------------------------- */
 void LF_LoRaClass::btnCheck() {
 
-  _btnState = digitalRead(_btnPin) xor _btnInverted;
+  bool edges = false;
 
-  if (_btnState && !_lastBtnState) {
-    int64_t debouceDelay = getDeltaMillis(_lastBtnDebounceTime);
-    if (debouceDelay < BTN_DEBOUNCE_TIME)
-      return;
-    _lastBtnState = true;
-    _btnCounter ++;
-    _btnClick= true;
-    _btnLong = false;
-    _lastBtnOnTime = millis();
-    _lastBtnLongTime = millis();
-  }
-  if (_btnState && _lastBtnState) {
-    _lastBtnDebounceTime = millis();
-    int64_t onDelay = getDeltaMillis(_lastBtnOnTime);
-    if (onDelay < BTN_ON_TIME)
-      return;
-    _btnClick= false;
-    _btnLong = true;
-    int64_t delay = getDeltaMillis(_lastBtnLongTime);
-    if (delay < BTN_LONG_TIME)
-      return;
-    _btnLong = false;
+  // Bordas registradas pela interrupção, com o momento em que ocorreram
+  BtnEdge edge;
+  while (_btnEdgeQueue.pop(edge)) {
+    _lastBtnState = edge.pressed;
+    _btn.edge(edge.pressed, edge.time);
+    edges = true;
   }
-  if (!_btnState && _lastBtnState) {
-    int64_t debouceDelay = getDeltaMillis(_lastBtnDebounceTime);
-    if (debouceDelay < BTN_DEBOUNCE_TIME)
-      return;
-    _lastBtnState = false;
-    _lastBtnOffTime = millis();
+
+  // Sem interrupção, ou borda perdida com a fila cheia, confiro o nível atual
+  bool state = digitalRead(_btnPin) xor _btnInverted;
+  unsigned long now = millis();
+  if (state != _lastBtnState) {
+    _lastBtnState = state;
+    _btn.edge(state, now);
+    edges = true;
   }
-  if (!_btnState && !_lastBtnState) {
-    _lastBtnDebounceTime = millis();
-    int64_t offDelay = getDeltaMillis(_lastBtnOffTime);
-    if (offDelay < BTN_OFF_TIME)
-      return;
-    if (_btnClick) {
-      if (_btnCounter == 1) {
-        _btnClickActive = true;
-      } else if (_btnCounter == 2) {
-        _btnDblClickActive = true;
-      } else if (_btnCounter >= 5) {
-        _btnCfgActive = true;
-      }
-    }
-    if (_btnLong) {
-      _btnLongActive = true;
-    }
-    _btnClick = 0,
-    _btnLong = 0;
-    _btnCounter = 0;
+
+  // Sem borda e sem prazo vencido, nada muda nos gestos
+  if (!edges && _uiWheel.pending(_tmrBtn)) return;
+
+  btnEvent(_btn.update(now));
+  _btnIsOn = _btn.isOn();
+
+  uint32_t next = _btn.nextDeadline(now);
+  if (next != BTN_NO_DEADLINE) {
+    _uiWheel.add(_tmrBtn, next);
+  } else {
+    _uiWheel.cancel(_tmrBtn);
   }
 
 } /* btnCheck */
 
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::btnEvent(uint8_t evt) {
+  if (evt == BTN_EVT_CLICK) {
+    _btnClickActive = true;
+  } else if (evt == BTN_EVT_DBL_CLICK) {
+    _btnDblClickActive = true;
+  } else if (evt == BTN_EVT_LONG) {
+    _btnLongActive = true;
+  } else if (evt == BTN_EVT_CFG) {
+    _btnCfgActive = true;
+  }
+} /* btnEvent */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::setBtnIrqEnable(bool enable) {
+
+  // A interrupção só registra as bordas, gestos e LED continuam no loopBtnLed
+#if defined(ESP32)
+  if (!_btnEnabled) return false;
+  if (enable == _btnIrqEnabled) return true;
+
+  if (enable) {
+    _btnIrqEnabled = true;
+    attachInterruptArg(digitalPinToInterrupt(_btnPin), &LF_LoRaClass::btnIsr, this, CHANGE);
+  } else {
+    detachInterrupt(digitalPinToInterrupt(_btnPin));
+    _btnIrqEnabled = false;
+    _btnEdgeQueue.clear();
+  }
+  return true;
+#else
+  return !enable;
+#endif
+
+} /* setBtnIrqEnable */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::btnIrqEnabled() {
+  return _btnIrqEnabled;
+} /* btnIrqEnabled */
+
+/* -------------------------------------------------------------------------- */
+void IRAM_ATTR LF_LoRaClass::btnIsr(void *arg) {
+
+  // Só registro a borda. Nível lido direto no registro do GPIO e millis()
+  // estão na IRAM, a fila é inline. Cheia, a borda é perdida e o loop
+  // corrige pelo nível atual.
+  LF_LoRaClass *self = (LF_LoRaClass *)arg;
+  BtnEdge edge;
+#if defined(ESP32)
+  edge.pressed = gpio_ll_get_level(&GPIO, (gpio_num_t)self->_btnPin) xor self->_btnInverted;
+#else
+  edge.pressed = digitalRead(self->_btnPin) xor self->_btnInverted;
+#endif
+  edge.time = millis();
+  self->_btnEdgeQueue.push(edge);
+
+} /* btnIsr */
+
 /* -------------------------------------------------------------------------- */
 bool LF_LoRaClass::isBtnClickActive() {
   bool ret = _btnClickActive;
@@ -805,27 +1655,18 @@ bool LF_LoRaClass::isBtnLongActive() {
 
 /* -------------------------------------------------------------------------- */
 bool LF_LoRaClass::isBtnOn() {
-  return _btnState && !_btnClick;
+  return _btnIsOn;
 } /* isBtnOn */
 
 /* -------------------------------------------------------------------------- */
 int64_t LF_LoRaClass::getDeltaMillis(unsigned long lastTime) {
 
-  // Avalia o tempo, considerando o overflow do millis()...
-  // Usando int64_t para lidar com o overflow...
-  unsigned long auxMillis = millis();
-  int64_t deltaTime = auxMillis;
-  // Tratando o overload de millis, que faria auxMillis < lastTime
-  if (auxMillis < lastTime) {
-    deltaTime = auxMillis + 0xFFFFFFFF;
-  }
-  deltaTime = deltaTime - lastTime;
-
-  return deltaTime;
+  // Subtração sem sinal de 32 bits já trata a volta do millis() (mod 2^32)
+  return (uint32_t)(millis() - lastTime);
 
 } /* getDeltaMillis */
 
-bool LF_LoRaClass::fiFoPushMsg(String msg, uint8_t id) {
+bool LF_LoRaClass::fiFoPushMsg(String msg, uint8_t id, uint8_t de, bool group) {
   // Verificando se FiFo está cheia
   // Atualizando cópia do ponteiro da última mensagem
   uint8_t aux = _fiFoLast + 1;
@@ -836,18 +1677,35 @@ bool LF_LoRaClass::fiFoPushMsg(String msg, uint8_t id) {
     return false;
   }
 
+  // Resposta a comando de grupo: descartada ou no slot do endereço
+  if (group && (_groupResp == LORA_GROUP_RESP_NONE)) {
+    return true;
+  }
+
   // Inclui na FiFo a última mensagem
   _fiFoMsgMsg[_fiFoLast] = msg;
   _fiFoId[_fiFoLast] = id;
+  _fiFoDe[_fiFoLast] = de;
+  _fiFoGroup[_fiFoLast] = group;
   // Atualiza ponteiro da última mensagem
   _fiFoLast = aux;
   return true;
 } /* fiFoPush */
 
 bool LF_LoRaClass::fiFoSendMsg() {
-  // Se FiFo não vazio...
-  if (_fiFoFirst != _fiFoLast) {
-    sendMsg(_fiFoMsgMsg[_fiFoFirst], _fiFoId[_fiFoFirst]);
+  // Se FiFo tem mensagem liberada...
+  uint8_t i = fiFoNext();
+  if (i != _fiFoLast) {
+    sendMsg(_fiFoMsgMsg[i], _fiFoId[i], _fiFoDe[i]);
+    // Fecho o buraco trazendo as retidas antes dela uma posição adiante
+    while (i != _fiFoFirst) {
+      uint8_t prev = (i > 0) ? i - 1 : FIFO_LEN - 1;
+      _fiFoMsgMsg[i] = _fiFoMsgMsg[prev];
+      _fiFoId[i] = _fiFoId[prev];
+      _fiFoDe[i] = _fiFoDe[prev];
+      _fiFoGroup[i] = _fiFoGroup[prev];
+      i = prev;
+    }
     // Atualizo ponteiro da primeira mensagem
     _fiFoFirst += 1;
     if (_fiFoFirst >= FIFO_LEN)
@@ -858,27 +1716,53 @@ bool LF_LoRaClass::fiFoSendMsg() {
 } /* fiFoSendMsg */
 
 void LF_LoRaClass::internalPushMsg(String msg, MsgType mt) {
+  if (_storeEnabled && (_masterLost || !_store.empty())) {
+    // Master perdido ou fila ainda subindo: guardo na ordem, sem delta
+    _store.push(millis(), msg.c_str(), msg.length());
+    return;
+  }
+  _internalMsgTime = millis();
+  uint16_t fullLen = msg.length();
+  if ((mt == MSG_TYPE_TELEMETRY) && _deltaEnabled) {
+    String sDelta;
+    if (deltaBuild(msg, sDelta)) {
+      msg = sDelta;
+    } else {
+      // Estado completo vai com confirmação, vira a nova base
+      mt = MSG_TYPE_CONFIRM;
+    }
+  }
   if (mt == MSG_TYPE_TELEMETRY) {
     if ((_internalMsgStatus == INT_STATUS_EMPTY) || (_internalMsgStatus == INT_STATUS_TELEMETRY)) {
       _internalMsgStatus = INT_STATUS_TELEMETRY;
-      _internalMsg = msg;
     } else {
       _internalMsgStatus = INT_STATUS_CONFIRM;
-      _internalMsg = msg;
     }
   }
   if (mt == MSG_TYPE_CONFIRM) {
     _internalMsgStatus = INT_STATUS_CONFIRM;
-    _internalMsg = msg;
   }
+  _internalMsg = msg;
+  _internalFullLen = fullLen;
 } /* internalSetMsg */
 
 bool LF_LoRaClass::internalSendMsg() {
   if (_internalMsgStatus == INT_STATUS_EMPTY) {
     return false;
   }
+  if (endpointTxHeld()) {
+    return false;
+  }
   if (_internalLastMsgStatus != INT_STATUS_EMPTY) {
-    if (getDeltaMillis(_lastMsgTime) < _msgSendInterval) {
+    if (_wheel.pending(_tmrSend)) {
+      return false;
+    }
+  }
+  if (_storeEnabled && (_internalLastMsgStatus == INT_STATUS_CONFIRM) && (_internalMsgStatus == INT_STATUS_CONFIRM)) {
+    // Reenvio, o master não confirmou o anterior
+    if (++_storeMiss >= LORA_STORE_MISS) {
+      storeLost();
+      _wheel.add(_tmrStore, _storeBackoff);
       return false;
     }
   }
@@ -887,17 +1771,180 @@ bool LF_LoRaClass::internalSendMsg() {
   if (_internalMsgStatus == INT_STATUS_CONFIRM) {
     _internalMsgId = getNextIdConfToSend();
   }
-  sendMsg(_internalMsg, _internalMsgId);
+  sendMsg(_internalMsg, _internalMsgId, _myAddr);
+  endpointTxNext();
+  _internalSentMsg = _internalMsg;
+  if (_internalMsg.charAt(0) == LORA_DELTA_CHAR) {
+    // Conto só o delta que foi para o ar, não o substituído antes do envio
+    _deltaCount++;
+    _deltaBytesSaved += _internalFullLen - _internalMsg.length();
+  }
   if (_internalMsgStatus == INT_STATUS_TELEMETRY) {
     _internalMsgStatus = INT_STATUS_EMPTY;
   }
   return true;
 } /* internalSendMsg */
 
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::storeLost() {
+
+  // Master sem confirmar: a mensagem pendente vai para a fila, que sobe
+  // em lote quando uma sondagem for confirmada
+  if (!_masterLost && _debugEnabeld) {
+    Serial.println("Master perdido, guardando registros");
+  }
+  _masterLost = true;
+  if (_storeLostTime == 0) _storeLostTime = millis();
+  _storeBackoff = _msgSendIntervalBase;
+  if (_internalMsgStatus != INT_STATUS_EMPTY) {
+    _store.push(_internalMsgTime, _internalMsg.c_str(), _internalMsg.length());
+  }
+  _internalMsgStatus = INT_STATUS_EMPTY;
+  _internalLastMsgStatus = INT_STATUS_EMPTY;
+  // Base do delta pode não ter chegado, a próxima telemetria vai completa
+  _deltaResync = true;
+
+} /* storeLost */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::storeSendMsg() {
+
+  if (!_storeEnabled || _store.empty() || _wheel.pending(_tmrStore)) return false;
+
+  if (_storeWaitAck && !_masterLost && (++_storeMiss >= LORA_STORE_MISS)) {
+    // Master sumiu no meio da subida
+    storeLost();
+  }
+
+  // Os registros mais antigos que couberem, a sondagem já leva dados
+  char frame[LORA_STORE_FRAME + 1];
+  if (_store.pack(frame, sizeof(frame), millis(), _storeEndSeq) == 0) {
+    // Registro maior que o quadro não sobe nunca
+    _store.ack(_storeEndSeq + 1);
+    return false;
+  }
+  _storeId = getNextIdConfToSend();
+  _storeWaitAck = true;
+  sendMsg(String(frame), _storeId, _myAddr);
+
+  if (_masterLost) {
+    // Sondagem com intervalo dobrando a cada falha
+    _wheel.add(_tmrStore, random(_storeBackoff, _storeBackoff + _storeBackoff / 2));
+    _storeBackoff = (_storeBackoff * 2 > LORA_STORE_PROBE_MAX) ? LORA_STORE_PROBE_MAX : _storeBackoff * 2;
+  } else {
+    _wheel.add(_tmrStore, _msgSendIntervalBase);
+  }
+  return true;
+
+} /* storeSendMsg */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::storeAck() {
+
+  _store.ack(_storeEndSeq);
+  _storeWaitAck = false;
+  _storeMiss = 0;
+  if (_masterLost && _debugEnabeld) {
+    Serial.println("Master de volta, pendentes: " + String(_store.count()));
+  }
+  _masterLost = false;
+
+  if (_store.empty()) {
+    // Tempo desde a perda do master até a fila esvaziar
+    _storeRecoveryTime = getDeltaMillis(_storeLostTime);
+    _storeLostTime = 0;
+    _wheel.cancel(_tmrStore);
+  } else {
+    _wheel.add(_tmrStore, LORA_STORE_GAP);
+  }
+
+} /* storeAck */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::setStoreEnable(bool enable) {
+  // Desligada por padrão: só habilitar se o master entende o quadro em
+  // lote e confirma o ID dele (ver LF_LoRa_Store.h)
+  if (taskCmdPush(TASK_CMD_STORE, &enable, sizeof(enable))) return;
+  storeApply(enable);
+} /* setStoreEnable */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::storeApply(bool enable) {
+  _storeEnabled = enable;
+  if (!_storeEnabled) {
+    _store.clear();
+    _masterLost = false;
+    _storeWaitAck = false;
+    _storeMiss = 0;
+    _storeLostTime = 0;
+    _wheel.cancel(_tmrStore);
+  }
+} /* storeApply */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::masterLost() {
+  return _masterLost;
+} /* masterLost */
+
+/* -------------------------------------------------------------------------- */
+unsigned long LF_LoRaClass::storeRecoveryTime() {
+  return _storeRecoveryTime;
+} /* storeRecoveryTime */
+
+/* -------------------------------------------------------------------------- */
+LF_LoRaStore& LF_LoRaClass::store() {
+  return _store;
+} /* store */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::setAnalyzerEnable(bool enable, uint32_t period, Print *out) {
+
+  // Escuta sem filtro e a cada período escreve o resumo em out (nullptr não
+  // escreve, as estatísticas ficam em analyzer() até o próximo período)
+  TaskCmdAnalyzer arg = {enable, period, out};
+  if (taskCmdPush(TASK_CMD_ANALYZER, &arg, sizeof(arg))) return;
+  analyzerApply(enable, period, out);
+
+} /* setAnalyzerEnable */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::analyzerApply(bool enable, uint32_t period, Print *out) {
+
+  _analyzerEnabled = enable;
+  _analyzerPeriod = period;
+  _analyzerOut = out;
+  _analyzer.reset(millis());
+  if (_analyzerEnabled) {
+    _wheel.add(_tmrAnalyzer, _analyzerPeriod);
+  } else {
+    _wheel.cancel(_tmrAnalyzer);
+  }
+
+} /* analyzerApply */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::analyzerLoop() {
+
+  if (!_analyzerEnabled || _wheel.pending(_tmrAnalyzer)) return;
+
+  if (_analyzerOut != nullptr) {
+    _analyzer.summary(*_analyzerOut, millis());
+  }
+  _analyzer.reset(millis());
+  _wheel.add(_tmrAnalyzer, _analyzerPeriod);
+
+} /* analyzerLoop */
+
+/* -------------------------------------------------------------------------- */
+LF_LoRaAnalyzer& LF_LoRaClass::analyzer() {
+  return _analyzer;
+} /* analyzer */
+
 /* -------------------------------------------------------------------------- */
 uint8_t LF_LoRaClass::getNextIdTeleToSend() {
   _lastSendIdTele++;
   if (_lastSendIdTele > 191) _lastSendIdTele = 128;
+  saveIdsCheck();
   return _lastSendIdTele;
 } /* getNextIdTeleToSend */
 
@@ -905,16 +1952,146 @@ uint8_t LF_LoRaClass::getNextIdTeleToSend() {
 uint8_t LF_LoRaClass::getNextIdConfToSend() {
   _lastSendIdConf++;
   if (_lastSendIdConf < 192) _lastSendIdConf = 192;
+  saveIdsCheck();
   return _lastSendIdConf;
 } /* getNextIdConfToSend */
 
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::saveIdsCheck() {
+  // Só gravo a cada LORA_ID_SAVE_STEP envios, para poupar a flash
+  if ((((_lastSendIdTele - _savedIdTele) & 0x3F) >= LORA_ID_SAVE_STEP) ||
+      (((_lastSendIdConf - _savedIdConf) & 0x3F) >= LORA_ID_SAVE_STEP)) {
+    saveCfg();
+  } else if (_aeadEnabled) {
+    aeadSaveCheck();
+  }
+} /* saveIdsCheck */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::saveCfg() {
+
+  CfgRec cfg;
+  memset(&cfg, 0, sizeof(cfg));
+  cfg.version = LORA_CFG_VERSION;
+  cfg.opMode = _opMode;
+  cfg.netId = _netId;
+  cfg.masterAddr = _masterAddr;
+  cfg.myAddr = _myAddr;
+  cfg.lastSendIdTele = _lastSendIdTele;
+  cfg.lastSendIdConf = _lastSendIdConf;
+  cfg.channel = _channel;
+  // Chave de sessão do principal, as demais vão em "aead" (aeadSave)
+  int main = _aeadMaster ? -1 : aeadNodeFind(_myAddr);
+  if (main != -1) {
+    AeadNodeRec &r = _aeadNodes[main];
+    cfg.aeadCounter = r.txCounter;
+    cfg.aeadRxMaster = r.rx.last();
+    memcpy(cfg.aeadKey, r.key, LF_LORA_AES_BLOCK);
+    cfg.aeadKeyOk = true;
+  }
+  cfg.aeadGroupRx = _aeadGroupRx.last();
+
+  // Abro Preferences com o nomespace "LoRa"
+  pref.begin("LoRa", false);
+  // Salvo tudo num só registro, uma única escrita na flash
+  pref.putBytes("cfg", &cfg, sizeof(cfg));
+  if (_endpointsLen > 0) {
+    uint8_t epAddrs[LORA_ENDPOINT_MAX];
+    for (uint8_t ep = 0; ep < _endpointsLen; ep++) {
+      epAddrs[ep] = _endpoints[ep].addr;
+    }
+    pref.putBytes("ep", epAddrs, _endpointsLen);
+  }
+  // Grupos do principal e dos endpoints
+  pref.putBytes("grp", _groups, sizeof(_groups));
+  // Fecho Preferences
+  pref.end();
+
+  _savedIdTele = _lastSendIdTele;
+  _savedIdConf = _lastSendIdConf;
+  if (main != -1) {
+    _aeadNodes[main].txSaved = cfg.aeadCounter;
+    _aeadNodes[main].rxSaved = cfg.aeadRxMaster;
+  }
+  _aeadGroupRxSaved = cfg.aeadGroupRx;
+  if (_aeadEnabled) {
+    aeadSave();
+  }
+
+} /* saveCfg */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::radioBegin() {
+
+  // Próxima tentativa se falhar
+  _wheel.add(_tmrRadio, LORA_RADIO_RETRY_TIME);
+
+  if (_nativeEnabled) {
+
+    if (!_native.begin(currentFrequency())) {
+      if (_debugEnabeld) {
+        Serial.println(".");
+      }
+      return false;
+    }
+
+    _native.setTxPower(20);
+    _native.setSpreadingFactor(_loraSf);
+    _native.setSignalBandwidth(_loraBw);
+    _native.setCodingRate4(_loraCr);
+    _native.setSyncWord(_syncWord);
+
+    // entro no modo "receive"
+    _native.receive();
+
+  } else {
+
+    if (!LoRa.begin(currentFrequency())) {
+      if (_debugEnabeld) {
+        Serial.println(".");
+      }
+      return false;
+    }
+
+    LoRa.setTxPower(20);
+    LoRa.setSpreadingFactor(_loraSf);
+    LoRa.setSignalBandwidth(_loraBw);
+    LoRa.setCodingRate4(_loraCr);
+    LoRa.setSyncWord(_syncWord);
+
+    // entro no modo "receive"
+    LoRa.receive();
+
+  }
+
+  _radioReady = true;
+  _wheel.cancel(_tmrRadio);
+
+  if (_debugEnabeld) {
+    Serial.println("LoRa Iniciando, OK!");
+  }
+
+  return true;
+
+} /* radioBegin */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::radioReady() {
+  return _radioReady;
+} /* radioReady */
+
+/* -------------------------------------------------------------------------- */
+unsigned long LF_LoRaClass::timeToFirstTx() {
+  return _firstTxTime;
+} /* timeToFirstTx */
+
 /* -------------------------------------------------------------------------- */
 void LF_LoRaClass::setSendInterval(unsigned long interval) {
   _msgSendIntervalBase = interval;
 } /* setSendInterval */
 
 /* -------------------------------------------------------------------------- */
-void LF_LoRaClass::sendMsg(String msg, uint8_t id) {
+void LF_LoRaClass::sendMsg(String msg, uint8_t id, uint8_t de) {
 
   if (_opMode != LORA_OP_MODE_LOOP) return;
 
@@ -922,28 +2099,17 @@ void LF_LoRaClass::sendMsg(String msg, uint8_t id) {
     Serial.print("sendMsg: ");Serial.print(msg);Serial.println(id);
   }
 
-  // Restando o tempo de msg
-  _lastMsgTime = millis();
-
   // Definindo o próximo intervalo
-  _msgSendInterval = random(_msgSendIntervalBase - 500, _msgSendIntervalBase + 500);
-
-  // Enviando estado via LoRa
-  LoRa.beginPacket();
+  _wheel.add(_tmrSend, random(_msgSendIntervalBase - 500, _msgSendIntervalBase + 500));
 
   // Crio buffer para colocar dados LoRa
-  char lora_data[LF_LORA_MAX_PACKET_SIZE];
+  char lora_data[LF_LORA_MAX_PACKET_SIZE + 1];
 
   // Formato pacote LoRa como resposta informando o ID
-  loraAddHeaderId(msg.c_str(), msg.length(), _masterAddr, id, lora_data);
+  int len = loraAddHeaderDe(msg.c_str(), msg.length(), de, _masterAddr, id, lora_data);
 
   // Enviando LoRa
-  LoRa.print(lora_data);
-
-  LoRa.endPacket();
-
-  // entro no modo "receive"
-  LoRa.receive();
+  loraSendRaw(lora_data, len);
 
   if (_debugEnabeld) {
     Serial.print("Dado LoRa: "); Serial.println(lora_data);
@@ -954,5 +2120,2075 @@ void LF_LoRaClass::sendMsg(String msg, uint8_t id) {
 
 } /* sendMsg */
 
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::loraSendRaw(const char *data, int len) {
+
+  if ((!_radioReady) || (len <= 0) || _replaying) return;
+
+  // Enviando via LoRa
+  if (_nativeEnabled) {
+
+    // FIFO escrita numa só rajada SPI
+    _native.send((const uint8_t *)data, len);
+
+    // entro no modo "receive"
+    _native.receive();
+
+  } else {
+
+    LoRa.beginPacket();
+
+    LoRa.write((const uint8_t *)data, len);
+
+    LoRa.endPacket();
+
+    // entro no modo "receive"
+    LoRa.receive();
+
+  }
+
+  // No envio o DIO0 sobe com o TxDone, não é recepção
+  _rxDoneStamped = false;
+
+  if (_firstTxTime == 0) {
+    // Tempo desde inic() até o primeiro envio
+    _firstTxTime = micros() - _inicTime;
+    if (_debugEnabeld) {
+      Serial.print("Primeiro envio (us): "); Serial.println(_firstTxTime);
+    }
+  }
+
+} /* loraSendRaw */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::setRepeaterEnable(bool enable) {
+  if (taskCmdPush(TASK_CMD_REPEATER, &enable, sizeof(enable))) return;
+  repeaterApply(enable);
+} /* setRepeaterEnable */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::repeaterApply(bool enable) {
+  _repeaterEnabled = enable;
+  _fwdRecsLen = 0;
+  _routeRecsLen = 0;
+} /* repeaterApply */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::repeaterEnabled() {
+  return _repeaterEnabled;
+} /* repeaterEnabled */
+
+/* -------------------------------------------------------------------------- */
+uint8_t LF_LoRaClass::lastHops() {
+  return _lastHops;
+} /* lastHops */
+
+/* -------------------------------------------------------------------------- */
+uint32_t LF_LoRaClass::repeaterFwdCount() {
+  return _fwdCount;
+} /* repeaterFwdCount */
+
+/* -------------------------------------------------------------------------- */
+uint32_t LF_LoRaClass::repeaterFwdAirtime() {
+  return _fwdAirtime;
+} /* repeaterFwdAirtime */
+
+/* -------------------------------------------------------------------------- */
+uint32_t LF_LoRaClass::loraAirtime(int len) {
+
+  // Tempo no ar (ms) de um pacote com len bytes, conforme a nota AN1200.13 da Semtech
+  // Considera cabeçalho explícito, preâmbulo de 8 símbolos e sem CRC (padrão da LoRa)
+  uint32_t tSym = ((uint32_t)1 << _loraSf) * 1000000UL / _loraBw; // us
+  int de = (tSym > 16000) ? 1 : 0; // Low Data Rate Optimize
+  int num = 8 * len - 4 * _loraSf + 28;
+  int den = 4 * (_loraSf - 2 * de);
+  int nPayload = 8;
+  if (num > 0) {
+    nPayload += ((num + den - 1) / den) * _loraCr;
+  }
+  uint32_t tPreamble = (8 * 4 + 17) * tSym / 4; // (8 + 4.25) símbolos
+  return (tPreamble + nPayload * tSym + 999) / 1000;
+
+} /* loraAirtime */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::repeaterCheck(const char *in, int len) {
+
+  RegRec header = _lastRegRec;
+
+  // Não retransmito minhas próprias mensagens
+  if (endpointFind(header.de) != -1) return;
+
+  // Limite de saltos
+  if (_lastHops >= LORA_HOP_MAX) return;
+
+  if (header.para == _masterAddr) {
+    // Subida para o master, aprendo que o nó de origem é alcançável por mim
+    routeLearn(header.de, _lastHops);
+  } else if (header.de == _masterAddr) {
+    // Descida do master, só retransmito se o destino está atrás de mim
+    if (!routeKnown(header.para)) return;
+  } else {
+    // Não é mensagem de/para o master
+    return;
+  }
+
+  if (_fwdRecsLen >= LORA_FWD_FIFO_LEN) {
+    if (_debugEnabeld) {
+      Serial.println("Repetidor: FIFO cheia!");
+    }
+    return;
+  }
+
+  // Copio a mensagem bruta e incremento o contador de saltos (primeiro dígito de LEN)
+  FwdRec &rec = _fwdRecs[_fwdRecsLen];
+  for (int i = 0; i < len; i++) {
+    rec.data[i] = in[i];
+  }
+  rec.data[len] = 0;
+  uint8_t hops = _lastHops + 1;
+  rec.data[LORA_HOPS_POS] = (hops < 10) ? ('0' + hops) : ('A' + hops - 10);
+  rec.len = len;
+  rec.header = header;
+  // Retardo aleatório para não colidir com outros repetidores
+  rec.time = millis();
+  rec.delay = random(LORA_FWD_DELAY_MIN, LORA_FWD_DELAY_MAX);
+  _fwdRecsLen++;
+
+} /* repeaterCheck */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::repeaterCancel(RegRec header) {
+  for (int i = 0; i < _fwdRecsLen; i++) {
+    if ((_fwdRecs[i].header.de == header.de) && (_fwdRecs[i].header.para == header.para) &&
+        (_fwdRecs[i].header.id == header.id)) {
+      // Removo da FIFO
+      for (int j = i + 1; j < _fwdRecsLen; j++) {
+        _fwdRecs[j-1] = _fwdRecs[j];
+      }
+      _fwdRecsLen--;
+      return;
+    }
+  }
+} /* repeaterCancel */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::repeaterSendLoop() {
+
+  if (_fwdRecsLen == 0) return;
+
+  for (int i = 0; i < _fwdRecsLen; i++) {
+    if (getDeltaMillis(_fwdRecs[i].time) >= (int64_t)_fwdRecs[i].delay) {
+      if (_debugEnabeld) {
+        Serial.print("Repetindo: "); Serial.println(_fwdRecs[i].data);
+      }
+      loraSendRaw(_fwdRecs[i].data, _fwdRecs[i].len);
+      _fwdCount++;
+      _fwdAirtime += loraAirtime(_fwdRecs[i].len);
+      repeaterCancel(_fwdRecs[i].header);
+      // Uma retransmissão por loop
+      return;
+    }
+  }
+
+} /* repeaterSendLoop */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::routeLearn(uint8_t addr, uint8_t hops) {
+  int index = -1;
+  for (int i = 0; i < _routeRecsLen; i++) {
+    if (_routeRecs[i].addr == addr) {
+      index = i;
+      break;
+    }
+  }
+  if (index == -1) {
+    if (_routeRecsLen < LORA_ROUTE_LEN) {
+      index = _routeRecsLen++;
+    } else {
+      // Tabela cheia, substituo a rota mais antiga
+      index = 0;
+      for (int i = 1; i < _routeRecsLen; i++) {
+        if (getDeltaMillis(_routeRecs[i].time) > getDeltaMillis(_routeRecs[index].time)) {
+          index = i;
+        }
+      }
+    }
+  }
+  _routeRecs[index] = {addr, hops, millis()};
+} /* routeLearn */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::routeKnown(uint8_t addr) {
+  for (int i = 0; i < _routeRecsLen; i++) {
+    if (_routeRecs[i].addr == addr) {
+      return getDeltaMillis(_routeRecs[i].time) < LORA_ROUTE_TIMEOUT;
+    }
+  }
+  return false;
+} /* routeKnown */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::setMasterRoutes(bool enable) {
+  // Para o master (adaptador USB): aprende pelas subidas a quantos saltos
+  // está cada escravo e limita a descida a essa distância. Escravo ouvido
+  // direto recebe o quadro sem marca, como antes (firmware antigo aceita).
+  if (taskCmdPush(TASK_CMD_ROUTES, &enable, sizeof(enable))) return;
+  masterRoutesApply(enable);
+} /* setMasterRoutes */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::masterRoutesApply(bool enable) {
+  _masterRoutes = enable;
+  _routeRecsLen = 0;
+} /* masterRoutesApply */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::masterRouteLearn(const char *msg, int len) {
+
+  // Mensagem decodificada: o contador de saltos é a distância do remetente
+  if (!_masterRoutes || _replaying || (len < LF_LORA_HEADER_SIZE) || (msg[0] == '!')) return;
+  for (uint8_t i = 0; i < LF_LORA_HEADER_SIZE; i++) {
+    if (!isxdigit(msg[i])) return;
+  }
+  uint8_t de = hexByte(msg + 2);
+  if (isMulticast(de)) return;
+  uint32_t hops = 0;
+  LF_LoRaFmt::parseHex(msg + LORA_HOPS_POS, 1, hops);
+  // Chegam a cópia direta e a retransmitida: fico com o caminho mais curto
+  // enquanto a rota vale
+  for (int i = 0; i < _routeRecsLen; i++) {
+    if ((_routeRecs[i].addr == de) && (_routeRecs[i].hops < hops) &&
+        (getDeltaMillis(_routeRecs[i].time) < LORA_ROUTE_TIMEOUT)) return;
+  }
+  routeLearn(de, hops);
+
+} /* masterRouteLearn */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::masterRouteStamp(char *msg, int len) {
+
+  // Mensagem a enviar: começo o contador de saltos de forma que os
+  // repetidores só retransmitam até a distância aprendida do destino.
+  // Destino desconhecido ou ouvido direto vai com o contador zerado, como
+  // antes: escravo sem repetidor pode ter firmware que exige LEN[0] == '0'.
+  if (!_masterRoutes || (len < LF_LORA_HEADER_SIZE) || (msg[0] == '!')) return;
+  for (uint8_t i = 0; i < LF_LORA_HEADER_SIZE; i++) {
+    if (!isxdigit(msg[i])) return;
+  }
+  uint8_t para = hexByte(msg + 4);
+  if (isMulticast(para)) return;
+  for (int i = 0; i < _routeRecsLen; i++) {
+    if ((_routeRecs[i].addr == para) && (getDeltaMillis(_routeRecs[i].time) < LORA_ROUTE_TIMEOUT)) {
+      if ((_routeRecs[i].hops > 0) && (_routeRecs[i].hops < LORA_HOP_MAX)) {
+        msg[LORA_HOPS_POS] = '0' + (LORA_HOP_MAX - _routeRecs[i].hops);
+      }
+      return;
+    }
+  }
+
+} /* masterRouteStamp */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::execMsgCtrl(String sMsg) {
+
+  // Só consumo as mensagens de controle que conheço e bem formadas,
+  // as demais que começam com '$' são da aplicação
+  char code = sMsg.charAt(1);
+
+  if (code == LORA_CTRL_TDMA_BEACON) {
+    return tdmaBeacon(sMsg);
+  }
+
+  if (code == LORA_CTRL_TIME) {
+    return timeBeacon(sMsg);
+  }
+
+  if (code == LORA_CTRL_DELTA_RESYNC) {
+    if (sMsg.length() != 2) return false;
+    // Próxima telemetria vai completa
+    _deltaResync = true;
+    return true;
+  }
+
+  if ((code != LF_LORA_OTA_QUERY) && (code != LF_LORA_OTA_START) && (code != LF_LORA_OTA_BLOCK) &&
+      (code != LF_LORA_OTA_END)) {
+    return false;
+  }
+  // Quadros OTA sempre começam com a sessão
+  if ((sMsg.length() < 4) || !isxdigit(sMsg.charAt(2)) || !isxdigit(sMsg.charAt(3))) return false;
+
+  if (_debugEnabeld) {
+    Serial.println("Msg Ctrl: " + sMsg);
+  }
+
+  if (code == LF_LORA_OTA_QUERY) {
+    // Respondo com os blocos que faltam no meu slot
+    uint16_t slotLen;
+    int slot = _otaRx.slot(sMsg.c_str(), sMsg.length(), _myAddr, slotLen);
+    if (slot >= 0) {
+      _otaRepPending = true;
+      _wheel.add(_tmrOtaRep, (uint32_t)slot * slotLen + random(0, LORA_OTA_SLOT_MARGIN / 2));
+    }
+  } else {
+    _otaRx.frame(sMsg.c_str(), sMsg.length());
+  }
+  return true;
+
+} /* execMsgCtrl */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::setTdmaEnable(bool enable) {
+  // Desligado por padrão: só sigo os beacons do master se habilitado
+  if (taskCmdPush(TASK_CMD_TDMA, &enable, sizeof(enable))) return;
+  tdmaApply(enable);
+} /* setTdmaEnable */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::tdmaApply(bool enable) {
+  _tdmaEnabled = enable;
+  if (!_tdmaEnabled) {
+    _tdmaBeaconOk = false;
+  }
+} /* tdmaApply */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::tdmaActive() {
+  return _tdmaBeaconOk;
+} /* tdmaActive */
+
+/* -------------------------------------------------------------------------- */
+uint8_t LF_LoRaClass::tdmaSlot() {
+  return _tdmaSlot;
+} /* tdmaSlot */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::tdmaBeacon(String sMsg) {
+
+  // Formato: $B SSSS LLLL CC [AA AA ...] (HEX, sem espaços)
+  // SSSS: duração do superframe (ms), LLLL: duração do slot (ms),
+  // CC: slots de contenção após os atribuídos, AA: endereço dono de cada slot
+  int len = sMsg.length();
+  if ((len < 12) || ((len - 12) % 2 != 0)) return false;
+  for (int i = 2; i < len; i++) {
+    if (!isxdigit(sMsg.charAt(i))) return false;
+  }
+
+  // Beacon válido, mesmo com o TDMA desligado não vai para a aplicação
+  if (!_tdmaEnabled) return true;
+
+  const char *p = sMsg.c_str();
+  uint32_t superframe = 0;
+  uint32_t slotLen = 0;
+  LF_LoRaFmt::parseHex(p + 2, 4, superframe);
+  LF_LoRaFmt::parseHex(p + 6, 4, slotLen);
+  uint8_t contention = hexByte(p + 10);
+  uint8_t slots = (len - 12) / 2;
+
+  if ((superframe == 0) || (slotLen == 0) || ((uint32_t)(slots + contention) * slotLen > superframe)) return true;
+
+  _tdmaSlot = 0xFF;
+  for (uint8_t i = 0; i < slots; i++) {
+    uint8_t addr = hexByte(p + 12 + 2 * i);
+    if (addr == _myAddr) {
+      _tdmaSlot = i;
+      break;
+    }
+  }
+
+  // O superframe começa na recepção do beacon
+  _tdmaBeaconTime = _lastRxTime;
+  _tdmaSuperframe = superframe;
+  _tdmaSlotLen = slotLen;
+  _tdmaSlots = slots;
+  _tdmaContention = contention;
+  _tdmaLastCycle = 0xFFFFFFFF;
+  _tdmaOffsetCycle = 0xFFFFFFFF;
+  _tdmaBeaconOk = true;
+
+  if (_debugEnabeld) {
+    Serial.println("TDMA Beacon, slot: " + String(_tdmaSlot));
+  }
+  return true;
+
+} /* tdmaBeacon */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::tdmaCanSend(int len) {
+
+  int64_t elapsed = getDeltaMillis(_tdmaBeaconTime);
+
+  // Perdi o beacon, volto ao ALOHA
+  if (elapsed > (int64_t)_tdmaSuperframe * LORA_TDMA_BEACON_LOST) {
+    _tdmaBeaconOk = false;
+    if (_debugEnabeld) {
+      Serial.println("TDMA Beacon perdido!");
+    }
+    return true;
+  }
+
+  uint32_t cycle = elapsed / _tdmaSuperframe;
+  uint32_t pos = elapsed % _tdmaSuperframe;
+
+  // Um envio por superframe, marcado por loraMsgSendLoop depois de enviar
+  if (cycle == _tdmaLastCycle) return false;
+  _tdmaCycle = cycle;
+
+  // Guarda cresce com o tempo desde o beacon, cobrindo a deriva dos cristais
+  uint32_t guard = LORA_TDMA_GUARD_MIN + (uint32_t)(elapsed * LORA_TDMA_DRIFT_PPM / 1000000);
+  uint32_t airtime = loraAirtime(len);
+
+  uint32_t start;
+  uint32_t end;
+  if (_tdmaSlot != 0xFF) {
+    // Slot atribuído
+    start = (uint32_t)_tdmaSlot * _tdmaSlotLen + guard;
+    end = (uint32_t)(_tdmaSlot + 1) * _tdmaSlotLen - guard;
+  } else {
+    // Sem slot, uso a região de contenção
+    if (_tdmaContention == 0) return false;
+    start = (uint32_t)_tdmaSlots * _tdmaSlotLen + guard;
+    end = (uint32_t)(_tdmaSlots + _tdmaContention) * _tdmaSlotLen - guard;
+    if (end <= start + airtime) return false;
+    if (cycle != _tdmaOffsetCycle) {
+      // Sorteio o ponto de envio dentro da contenção uma vez por superframe
+      _tdmaOffsetCycle = cycle;
+      _tdmaContentionOffset = random(0, end - start - airtime);
+    }
+    start += _tdmaContentionOffset;
+  }
+
+  if (end <= start + airtime) return false;
+  if ((pos < start) || (pos + airtime > end)) return false;
+
+  return true;
+
+} /* tdmaCanSend */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::sendTdmaBeacon(uint16_t superframe, uint16_t slotLen, uint8_t contention, const uint8_t *addrs, uint8_t addrsLen) {
+
+  // Para uso quando esta biblioteca faz o papel de master
+  if (addrsLen > LORA_TDMA_MAX_SLOTS) addrsLen = LORA_TDMA_MAX_SLOTS;
+
+  char msg[12 + 2 * LORA_TDMA_MAX_SLOTS + 1];
+  msg[0] = LORA_CTRL_CHAR;
+  msg[1] = LORA_CTRL_TDMA_BEACON;
+  LF_LoRaFmt::fmtHex(msg + 2, 5, superframe, 4);
+  LF_LoRaFmt::fmtHex(msg + 6, 5, slotLen, 4);
+  LF_LoRaFmt::fmtHex(msg + 10, 3, contention, 2);
+  for (uint8_t i = 0; i < addrsLen; i++) {
+    LF_LoRaFmt::fmtHex(msg + 12 + 2 * i, 3, addrs[i], 2);
+  }
+
+  char lora_data[LF_LORA_MAX_PACKET_SIZE + 1];
+  int len = loraAddHeader(msg, strlen(msg), LORA_ADDR_BROADCAST, lora_data);
+  loraSendRaw(lora_data, len);
+
+} /* sendTdmaBeacon */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::sendTimeBeacon() {
+
+  // Para uso quando esta biblioteca faz o papel de master. O tempo vai
+  // no último momento antes do envio, o escravo soma o tempo no ar.
+  char msg[11];
+  char lora_data[LF_LORA_MAX_PACKET_SIZE + 1];
+  msg[0] = LORA_CTRL_CHAR;
+  msg[1] = LORA_CTRL_TIME;
+  LF_LoRaFmt::fmtHex(msg + 2, 9, syncMillis(), 8);
+  int len = loraAddHeader(msg, 10, LORA_ADDR_BROADCAST, lora_data);
+  loraSendRaw(lora_data, len);
+
+} /* sendTimeBeacon */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::timeBeacon(String sMsg) {
+
+  // Formato: $T tttttttt (HEX, sem espaços), tempo da rede (ms) no início do envio
+  if (sMsg.length() != 10) return false;
+
+  uint32_t master;
+  if (LF_LoRaFmt::parseHex(sMsg.c_str() + 2, 8, master) != 8) return false;
+
+  // Beacon retransmitido chega com atraso desconhecido
+  if (_lastHops > 0) return true;
+
+  // No fim da recepção o master já andou o tempo no ar do pacote
+  _timeSync.sample(_lastRxTime, master + loraAirtime(_lastRxLen));
+  _timeSnap.store(_timeSync);
+
+  if (_debugEnabeld) {
+    Serial.println("Tempo da rede, erro (ms): " + String(_timeSync.lastError()) +
+                   " deriva (ppm): " + String(_timeSync.driftPpm()));
+  }
+  return true;
+
+} /* timeBeacon */
+
+/* -------------------------------------------------------------------------- */
+uint32_t LF_LoRaClass::syncMillis() {
+  // Tempo da rede (ms): o do master se já recebi beacon, senão o local.
+  // Pode ser chamado da tarefa da aplicação, leio a cópia do ajuste.
+  return _timeSnap.now(millis());
+} /* syncMillis */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::timeSynced() {
+  return _timeSnap.synced();
+} /* timeSynced */
+
+/* -------------------------------------------------------------------------- */
+LF_LoRaTimeSync& LF_LoRaClass::timeSync() {
+  return _timeSync;
+} /* timeSync */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::setOtaImage(LF_LoRaOtaImage *image) {
+  // Destino das imagens recebidas em grupo, nullptr desabilita
+  if (taskCmdPush(TASK_CMD_OTA_IMAGE, &image, sizeof(image))) return;
+  otaImageApply(image);
+} /* setOtaImage */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::otaImageApply(LF_LoRaOtaImage *image) {
+  _otaRx.setImage(image);
+  _otaRepPending = false;
+  _wheel.cancel(_tmrOtaRep);
+} /* otaImageApply */
+
+/* -------------------------------------------------------------------------- */
+LF_LoRaOtaRx& LF_LoRaClass::otaRx() {
+  return _otaRx;
+} /* otaRx */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::otaSend(uint8_t para, char kind, uint32_t size, LF_LoRaOtaImage *image, const uint8_t *nodes, uint8_t nodesLen) {
+
+  // Master: envia a imagem uma vez para o grupo para, depois só os blocos
+  // que os escravos da lista nodes pedirem.
+  // No modo tarefa a imagem é lida pela tarefa do rádio, aqui só confiro os
+  // argumentos, o resultado fica em otaTx().status()
+  if (_taskMode) {
+    if ((image == nullptr) || (size == 0)) return false;
+    TaskCmdOtaSend arg = {};
+    arg.para = para;
+    arg.kind = kind;
+    arg.size = size;
+    arg.image = image;
+    arg.nodesLen = (nodesLen > LF_LORA_OTA_MAX_NODES) ? LF_LORA_OTA_MAX_NODES : nodesLen;
+    if (arg.nodesLen > 0) {
+      memcpy(arg.nodes, nodes, arg.nodesLen);
+    }
+    return taskCmdPush(TASK_CMD_OTA_SEND, &arg, sizeof(arg));
+  }
+  return otaSendApply(para, kind, size, image, nodes, nodesLen);
+
+} /* otaSend */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::otaSendApply(uint8_t para, char kind, uint32_t size, LF_LoRaOtaImage *image, const uint8_t *nodes, uint8_t nodesLen) {
+
+  uint16_t slotLen = loraAirtime(12 + LF_LORA_OTA_REPORT_LEN + (_aeadEnabled ? LF_LORA_AEAD_OVERHEAD : 0)) + LORA_OTA_SLOT_MARGIN;
+  _otaSession++;
+  if (!_otaTx.begin(_otaSession, kind, size, image, nodes, nodesLen, slotLen)) return false;
+  _otaPara = para;
+  _otaWindow = false;
+  _wheel.cancel(_tmrOtaTx);
+  return true;
+
+} /* otaSendApply */
+
+/* -------------------------------------------------------------------------- */
+LF_LoRaOtaTx& LF_LoRaClass::otaTx() {
+  return _otaTx;
+} /* otaTx */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::otaReport(uint8_t de, const char *msg) {
+  if (msg[1] != LF_LORA_OTA_MISSING) return;
+  _otaTx.report(de, msg, strlen(msg));
+} /* otaReport */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::otaLoop() {
+
+  char msg[LF_LORA_MAX_PACKET_SIZE + 1];
+  char lora_data[LF_LORA_MAX_PACKET_SIZE + 1];
+  int maxLen = LF_LORA_MAX_PACKET_SIZE - 12 - aeadOverhead(_otaPara);
+
+  // Escravo: resposta à consulta, no seu slot
+  if (_otaRepPending && !_wheel.pending(_tmrOtaRep)) {
+    _otaRepPending = false;
+    int len = _otaRx.report(msg, LF_LORA_OTA_REPORT_LEN + 1);
+    if (len > 0) {
+      len = loraAddHeader(msg, len, _masterAddr, lora_data);
+      loraSendRaw(lora_data, len);
+    }
+  }
+
+  // Master: próximo quadro depois que o anterior saiu do ar
+  if ((_otaTx.status() != LF_LORA_OTA_SENDING) || _wheel.pending(_tmrOtaTx)) return;
+  if (_otaTx.waiting()) {
+    if (!_otaWindow) {
+      // Janela para as respostas dos escravos
+      _otaWindow = true;
+      _wheel.add(_tmrOtaTx, _otaTx.window());
+      return;
+    }
+    _otaWindow = false;
+    _otaTx.endWindow();
+  }
+  int len = _otaTx.next(msg, maxLen);
+  if (len == 0) return;
+  len = loraAddHeader(msg, len, _otaPara, lora_data);
+  loraSendRaw(lora_data, len);
+  _wheel.add(_tmrOtaTx, loraAirtime(len) + LORA_OTA_GAP);
+
+  if (_debugEnabeld) {
+    Serial.println("OTA: " + String(msg));
+  }
+
+} /* otaLoop */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::setGroups(uint8_t ep, const uint8_t *groups, uint8_t len) {
+
+  // Grupos do endpoint ep (0 é o principal), gravados na memória não volátil
+  if ((ep > _endpointsLen) || (len > LORA_GROUP_MAX)) return false;
+  for (uint8_t i = 0; i < len; i++) {
+    if ((groups[i] < LORA_ADDR_GROUP_FIRST) || (groups[i] > LORA_ADDR_GROUP_LAST)) return false;
+  }
+  memset(_groups[ep], 0, LORA_GROUP_MAX);
+  memcpy(_groups[ep], groups, len);
+  saveCfg();
+  return true;
+
+} /* setGroups */
+
+/* -------------------------------------------------------------------------- */
+uint8_t LF_LoRaClass::groupCount(uint8_t ep) {
+  if (ep > _endpointsLen) return 0;
+  uint8_t n = 0;
+  while ((n < LORA_GROUP_MAX) && (_groups[ep][n] != 0)) n++;
+  return n;
+} /* groupCount */
+
+/* -------------------------------------------------------------------------- */
+uint8_t LF_LoRaClass::group(uint8_t ep, uint8_t i) {
+  if ((ep > _endpointsLen) || (i >= LORA_GROUP_MAX)) return 0;
+  return _groups[ep][i];
+} /* group */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::setGroupResponse(uint8_t mode, uint16_t slot) {
+  // Respostas a comandos de grupo e difusão: nenhuma ou no slot do endereço
+  TaskCmdGroupResp arg = {mode, slot};
+  if (taskCmdPush(TASK_CMD_GROUP_RESP, &arg, sizeof(arg))) return;
+  groupResponseApply(mode, slot);
+} /* setGroupResponse */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::groupResponseApply(uint8_t mode, uint16_t slot) {
+  _groupResp = mode;
+  _groupRespSlot = slot;
+} /* groupResponseApply */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::isMulticast(uint8_t addr) {
+  return (addr == LORA_ADDR_BROADCAST) || ((addr >= LORA_ADDR_GROUP_FIRST) && (addr <= LORA_ADDR_GROUP_LAST));
+} /* isMulticast */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::groupHas(uint8_t ep, uint8_t addr) {
+  for (uint8_t i = 0; i < LORA_GROUP_MAX; i++) {
+    if (_groups[ep][i] == addr) return true;
+  }
+  return false;
+} /* groupHas */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::groupDupFind(uint8_t de, uint8_t para, uint8_t id) {
+  for (uint8_t i = 0; i < LORA_GROUP_DUP_RECS; i++) {
+    GroupDupRec &r = _groupDup[i];
+    if ((r.time != 0) && (r.de == de) && (r.para == para) && (r.id == id) &&
+        (getDeltaMillis(r.time) < LORA_GROUP_DUP_TIME)) return true;
+  }
+  return false;
+} /* groupDupFind */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::pairGroupsSet(uint8_t ep, const LF_LoRaToken &t) {
+
+  // Lista "ggg[ggg...]" recebida no pareamento
+  memset(_pairGroups[ep], 0, LORA_GROUP_MAX);
+  if ((t.len % 3 != 0) || (t.len / 3 > LORA_GROUP_MAX)) return false;
+  for (uint8_t i = 0; i < t.len / 3; i++) {
+    LF_LoRaToken g = t.sub(3 * i, 3);
+    int32_t addr = g.toInt();
+    if (!g.isDigits() || (addr < LORA_ADDR_GROUP_FIRST) || (addr > LORA_ADDR_GROUP_LAST)) return false;
+    _pairGroups[ep][i] = addr;
+  }
+  return true;
+
+} /* pairGroupsSet */
+
+/* -------------------------------------------------------------------------- */
+uint8_t LF_LoRaClass::fiFoNext() {
+  // Primeira mensagem que pode sair, _fiFoLast se nenhuma. Resposta a
+  // comando de grupo esperando o slot do endereço não segura as de trás.
+  for (uint8_t i = _fiFoFirst; i != _fiFoLast; i = (i + 1 < FIFO_LEN) ? i + 1 : 0) {
+    if (!_fiFoGroup[i] || !_wheel.pending(_tmrGroupResp)) return i;
+  }
+  return _fiFoLast;
+} /* fiFoNext */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::setAeadKey(const uint8_t *key) {
+
+  // Chave do dispositivo (16 bytes), nullptr desabilita. Não cifra nada:
+  // no pareamento, com as contribuições aleatórias do escravo (100) e do
+  // master (101), dela sai a chave de sessão do principal e de cada
+  // endpoint, gravada na memória não volátil. O master conhece a chave de
+  // cada dispositivo pelo MAC (setOnAeadDeviceKey) e um nó não tem a chave
+  // de sessão de outro. Chamar depois de inic(), antes de parear.
+  if (taskCmdPush(TASK_CMD_AEAD_KEY, key, (key == nullptr) ? 0 : LF_LORA_AES_BLOCK)) return;
+  aeadKeyApply(key);
+
+} /* setAeadKey */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::aeadKeyApply(const uint8_t *key) {
+
+  _aeadDeviceOk = (key != nullptr);
+  if (_aeadDeviceOk) {
+    _aeadDevice.setKey(key);
+  }
+  _aeadEnabled = _aeadDeviceOk || _aeadMaster;
+
+} /* aeadKeyApply */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::setAeadGroupKey(const uint8_t *key) {
+
+  // Chave de grupo e difusão (16 bytes), nullptr desabilita. Uma só para a
+  // rede, distribuída pela aplicação: quem a tem lê e forja comandos de
+  // grupo do master, mas não os quadros individuais de nenhum nó
+  if (taskCmdPush(TASK_CMD_AEAD_GROUP, key, (key == nullptr) ? 0 : LF_LORA_AES_BLOCK)) return;
+  aeadGroupKeyApply(key);
+
+} /* setAeadGroupKey */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::aeadGroupKeyApply(const uint8_t *key) {
+
+  _aeadGroupOk = (key != nullptr);
+  if (_aeadGroupOk) {
+    memcpy(_aeadGroupKey, key, LF_LORA_AES_BLOCK);
+  }
+  if (_aeadKeyNode == LORA_AEAD_KEY_GROUP) {
+    _aeadKeyNode = -1;
+  }
+
+} /* aeadGroupKeyApply */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::aeadEnabled() {
+  return _aeadEnabled;
+} /* aeadEnabled */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::aeadSelect(const char *header) {
+
+  // A chave é a de sessão do escravo envolvido, nos dois sentidos: a mesma
+  // no escravo e no master. Grupo e difusão só do master, com a de grupo
+  uint8_t de = hexByte(header + 2);
+  uint8_t para = hexByte(header + 4);
+  int index;
+  if (isMulticast(para)) {
+    if (!_aeadGroupOk || (de != _masterAddr)) return false;
+    index = LORA_AEAD_KEY_GROUP;
+  } else {
+    index = aeadNodeFind((de == _masterAddr) ? para : de);
+    if (index == -1) return false;
+  }
+  if (index != _aeadKeyNode) {
+    _aead.setKey((index == LORA_AEAD_KEY_GROUP) ? _aeadGroupKey : _aeadNodes[index].key);
+    _aeadKeyNode = index;
+  }
+  return true;
+
+} /* aeadSelect */
+
+/* -------------------------------------------------------------------------- */
+uint32_t &LF_LoRaClass::aeadTxCounter() {
+  // Da chave escolhida por aeadSelect
+  if (_aeadKeyNode == LORA_AEAD_KEY_GROUP) return _aeadGroupTx;
+  return _aeadNodes[_aeadKeyNode].txCounter;
+} /* aeadTxCounter */
+
+/* -------------------------------------------------------------------------- */
+LF_LoRaAeadWindow &LF_LoRaClass::aeadRxWindow() {
+  // Da chave escolhida por aeadSelect
+  if (_aeadKeyNode == LORA_AEAD_KEY_GROUP) return _aeadGroupRx;
+  return _aeadNodes[_aeadKeyNode].rx;
+} /* aeadRxWindow */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaClass::aeadOverhead(uint8_t para) {
+  // Grupo e difusão levam o contador inteiro: quem entrou no grupo depois,
+  // ou perdeu muitos quadros, não tem de onde tirar os bits altos
+  return isMulticast(para) ? LF_LORA_AEAD_OVERHEAD_GROUP : LF_LORA_AEAD_OVERHEAD;
+} /* aeadOverhead */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::aeadNonce(const char *header, uint32_t counter, uint8_t *nonce) {
+
+  // NET, DE, PARA, ID e LEN do cabeçalho, sem o contador de saltos que
+  // o repetidor altera, mais o contador inteiro do remetente
+  memset(nonce, 0, LF_LORA_AES_BLOCK);
+  for (uint8_t i = 0; i < 6; i++) {
+    nonce[i] = hexByte(header + 2 * i);
+  }
+  nonce[4] &= 0x0F;
+  nonce[6] = counter >> 24;
+  nonce[7] = counter >> 16;
+  nonce[8] = counter >> 8;
+  nonce[9] = counter;
+
+} /* aeadNonce */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaClass::aeadNodeFind(uint8_t addr) {
+  for (uint8_t i = 0; i < _aeadNodesLen; i++) {
+    if (_aeadNodes[i].addr == addr) return i;
+  }
+  return -1;
+} /* aeadNodeFind */
+
+/* -------------------------------------------------------------------------- */
+AeadNodeRec &LF_LoRaClass::aeadNodeSet(uint8_t addr, const uint8_t *key) {
+
+  // Chave nova, contadores do zero. Tabela cheia troco em rodízio
+  int index = aeadNodeFind(addr);
+  if (index == -1) {
+    if (_aeadNodesLen < LORA_AEAD_NODES) {
+      index = _aeadNodesLen++;
+    } else {
+      index = _aeadNodesNext;
+      _aeadNodesNext = (_aeadNodesNext + 1) % LORA_AEAD_NODES;
+    }
+  }
+  AeadNodeRec &r = _aeadNodes[index];
+  r.addr = addr;
+  memcpy(r.key, key, LF_LORA_AES_BLOCK);
+  r.txCounter = 0;
+  r.txSaved = 0;
+  r.rx.reset(0);
+  r.rxSaved = 0;
+  if (_aeadKeyNode == index) {
+    _aeadKeyNode = -1;
+  }
+  return r;
+
+} /* aeadNodeSet */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::aeadNodeMain(const AeadNodeRec &r) {
+  // A chave do principal do escravo vai no registro "cfg"
+  return !_aeadMaster && (r.addr == _myAddr);
+} /* aeadNodeMain */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::aeadSessionKey(LF_LoRaAead &device, uint8_t net, uint8_t addr, uint32_t slaveToken,
+                                  uint32_t masterToken, uint8_t *key) {
+
+  // Um bloco AES com a chave do dispositivo sobre a rede, o endereço e as
+  // duas contribuições: cada pareamento dá uma chave nova, e os contadores
+  // podem voltar a zero
+  uint8_t blk[LF_LORA_AES_BLOCK];
+  memset(blk, 0, sizeof(blk));
+  blk[0] = 'L';
+  blk[1] = 'F';
+  blk[2] = 'K';
+  blk[3] = net;
+  blk[4] = addr;
+  for (uint8_t i = 0; i < 4; i++) {
+    blk[5 + i] = slaveToken >> (24 - 8 * i);
+    blk[9 + i] = masterToken >> (24 - 8 * i);
+  }
+  device.encryptBlock(blk, key);
+
+} /* aeadSessionKey */
+
+/* -------------------------------------------------------------------------- */
+uint32_t LF_LoRaClass::aeadRandom() {
+#if defined(ESP32)
+  // Gerador do hardware
+  return esp_random();
+#else
+  return ((uint32_t)random(0x10000) << 16) | (uint32_t)random(0x10000);
+#endif
+} /* aeadRandom */
+
+/* -------------------------------------------------------------------------- */
+String LF_LoRaClass::aeadPairTokenStr(uint8_t ep) {
+  // "!Nxxxxxxxx" no fim da apresentação (100), só com a chave do dispositivo
+  if (!_aeadDeviceOk) return String();
+  char s[11] = "!N";
+  LF_LoRaFmt::fmtHex(s + 2, 9, _aeadPairTokens[ep], 8);
+  return String(s);
+} /* aeadPairTokenStr */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::aeadPairKeys() {
+
+  // Escravo, no fim do pareamento: chave de sessão do principal e de cada
+  // endpoint configurado. Se o 101 veio sem a contribuição do master
+  // (master sem AEAD), fica sem chave e não envia nem aceita quadros
+  // cifrados até um novo pareamento
+  _aeadNodesLen = 0;
+  _aeadNodesNext = 0;
+  _aeadKeyNode = -1;
+  if (!_aeadDeviceOk) return;
+  for (uint8_t ep = 0; ep <= _endpointsLen; ep++) {
+    bool ok = (ep == 0) ? _pairOk : _endpoints[ep - 1].pairOk;
+    if (!ok) continue;
+    if (!_aeadPairKeyed[ep]) {
+      if (_debugEnabeld) {
+        Serial.println("AEAD: 101 sem a contribuição do master!");
+      }
+      continue;
+    }
+    uint8_t addr = (ep == 0) ? _myAddr : _endpoints[ep - 1].addr;
+    uint8_t key[LF_LORA_AES_BLOCK];
+    aeadSessionKey(_aeadDevice, _netId, addr, _aeadPairTokens[ep], _aeadPairMaster[ep], key);
+    aeadNodeSet(addr, key);
+  }
+
+} /* aeadPairKeys */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::aeadPairRecord(const char *msg, int len) {
+
+  // Master: apresentação "!FFFFFF!XXXXXX!100!MAC!MODELO!Nxxxxxxxx", guardo
+  // a contribuição do escravo até o 101
+  LF_LoRaCmd cmd;
+  if (!cmd.parse(msg + 1, len - 1) || (cmd.count() != 6)) return;
+  if (!cmd.token(0).equals("FFFFFF") || !cmd.token(2).equals("100")) return;
+  LF_LoRaToken tMac6 = cmd.token(1);
+  LF_LoRaToken tMac = cmd.token(3);
+  LF_LoRaToken tToken = cmd.token(5);
+  if ((tMac6.len != 6) || (tMac.len != 12) || (tToken.len != 9) || (tToken.ptr[0] != 'N') ||
+      !tToken.sub(1, 8).isHex()) return;
+
+  // A mesma placa de novo substitui, senão troco em rodízio
+  int index = -1;
+  for (uint8_t i = 0; i < LORA_AEAD_PAIR_RECS; i++) {
+    if (tMac6.equalsIgnoreCase(_aeadPairRecs[i].mac6)) {
+      index = i;
+      break;
+    }
+  }
+  if (index == -1) {
+    index = _aeadPairRecsNext;
+    _aeadPairRecsNext = (_aeadPairRecsNext + 1) % LORA_AEAD_PAIR_RECS;
+  }
+  AeadPairRec &r = _aeadPairRecs[index];
+  memcpy(r.mac6, tMac6.ptr, 6);
+  r.mac6[6] = 0;
+  memcpy(r.mac, tMac.ptr, 12);
+  r.mac[12] = 0;
+  LF_LoRaFmt::parseHex(tToken.ptr + 1, 8, r.token);
+
+} /* aeadPairRecord */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaClass::aeadPairReply(char *out, int len) {
+
+  // Master. Na chamada do pareamento (100), contribuição nova para a
+  // rodada. No 101, a chave de sessão de cada escravo configurado de quem
+  // ouvi a apresentação, e a contribuição vai no fim: "!Nxxxxxxxx". É a
+  // mesma em toda a rodada, um 101 repetido dá a mesma chave
+  LF_LoRaCmd cmd;
+  if (!cmd.parse(out + 1, len - 1) || (cmd.count() < 3)) return len;
+  if (cmd.token(2).equals("100") && cmd.token(0).equals("000000")) {
+    _aeadPairToken = aeadRandom();
+    _aeadPairTokenOk = true;
+    return len;
+  }
+  if (!cmd.token(2).equals("101") || (cmd.count() < 6) || (len + 10 > LF_LORA_MAX_PACKET_SIZE)) return len;
+  if (!_aeadPairTokenOk) {
+    _aeadPairToken = aeadRandom();
+    _aeadPairTokenOk = true;
+  }
+
+  // !XXXXXX!FFFFFF!101!NNN!MMM!EEE... ou o lote !FFFFFF!FFFFFF!101!NNN!MMM!XXXXXXEEE...
+  uint8_t net = cmd.token(3).toInt();
+  bool batch = cmd.token(0).equals("FFFFFF");
+  bool keyed = false;
+  for (uint8_t i = batch ? 5 : 0; i < (batch ? cmd.count() : 1); i++) {
+    LF_LoRaToken t = cmd.token(i);
+    LF_LoRaToken tAddr = batch ? t.sub(6, 3) : cmd.token(5);
+    if ((t.len < 6) || (tAddr.len != 3) || !tAddr.isDigits()) continue;
+    if (aeadPairNode(t.sub(0, 6), net, tAddr.toInt())) {
+      keyed = true;
+    }
+  }
+  if (!keyed) return len;
+  out[len++] = '!';
+  out[len++] = 'N';
+  len += LF_LoRaFmt::fmtHex(out + len, 9, _aeadPairToken, 8);
+  return len;
+
+} /* aeadPairReply */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::aeadPairNode(const LF_LoRaToken &mac6, uint8_t net, uint8_t addr) {
+
+  // Master: chave de sessão do escravo, da chave do dispositivo que a
+  // aplicação conhece pelo MAC
+  for (uint8_t i = 0; i < LORA_AEAD_PAIR_RECS; i++) {
+    AeadPairRec &r = _aeadPairRecs[i];
+    if (!mac6.equalsIgnoreCase(r.mac6)) continue;
+    uint8_t devKey[LF_LORA_AES_BLOCK];
+    if (!onAeadDeviceKey || !onAeadDeviceKey(r.mac, devKey)) return false;
+    LF_LoRaAead device;
+    device.setKey(devKey);
+    uint8_t key[LF_LORA_AES_BLOCK];
+    aeadSessionKey(device, net, addr, r.token, _aeadPairToken, key);
+    aeadNodeSet(addr, key);
+    aeadSave();
+    return true;
+  }
+  return false;
+
+} /* aeadPairNode */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::aeadLoad() {
+
+  // Chaves de sessão gravadas, com os contadores pulados adiante como os
+  // IDs: o de envio nunca se repete com a mesma chave, e quadros aceitos
+  // até a última gravação não passam de novo. Os aceitos depois dela (até
+  // LORA_NONCE_SAVE_STEP) ainda passariam uma vez.
+  _aeadNodesLen = 0;
+  _aeadNodesNext = 0;
+  _aeadKeyNode = -1;
+  pref.begin("LoRa", true);
+  CfgRec cfg;
+  memset(&cfg, 0, sizeof(cfg));
+  size_t cfgLen = pref.getBytes("cfg", &cfg, sizeof(cfg));
+  if (!_aeadMaster && (cfgLen >= LORA_CFG_V1_SIZE) && (cfg.version >= 4) && (cfg.version <= LORA_CFG_VERSION)) {
+    if (cfg.aeadKeyOk) {
+      AeadNodeRec &r = aeadNodeSet(cfg.myAddr, cfg.aeadKey);
+      r.txCounter = cfg.aeadCounter + LORA_NONCE_SAVE_STEP;
+      r.txSaved = cfg.aeadCounter;
+      r.rx.reset(cfg.aeadRxMaster);
+      r.rxSaved = cfg.aeadRxMaster;
+    }
+    _aeadGroupRx.reset(cfg.aeadGroupRx);
+    _aeadGroupRxSaved = cfg.aeadGroupRx;
+  }
+  // Endpoints do escravo, ou os escravos do master
+  AeadNodeRec recs[LORA_AEAD_NODES];
+  size_t n = pref.getBytes("aead", recs, sizeof(recs)) / sizeof(AeadNodeRec);
+  for (size_t i = 0; i < n; i++) {
+    AeadNodeRec &r = aeadNodeSet(recs[i].addr, recs[i].key);
+    r.txCounter = recs[i].txCounter + LORA_NONCE_SAVE_STEP;
+    r.txSaved = recs[i].txCounter;
+    r.rx.reset(recs[i].rx.last());
+    r.rxSaved = recs[i].rx.last();
+  }
+  _aeadGroupTxSaved = pref.getUInt("aeadGrp", 0);
+  _aeadGroupTx = _aeadGroupTxSaved + LORA_NONCE_SAVE_STEP;
+  pref.end();
+
+} /* aeadLoad */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::aeadSave() {
+
+  // Chaves de sessão além da do principal e o contador de grupo do master,
+  // numa só escrita
+  AeadNodeRec recs[LORA_AEAD_NODES];
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < _aeadNodesLen; i++) {
+    if (!aeadNodeMain(_aeadNodes[i])) {
+      recs[n++] = _aeadNodes[i];
+    }
+  }
+  pref.begin("LoRa", false);
+  if (n > 0) {
+    pref.putBytes("aead", recs, n * sizeof(AeadNodeRec));
+  } else {
+    pref.remove("aead");
+  }
+  if (_aeadMaster) {
+    pref.putUInt("aeadGrp", _aeadGroupTx);
+  }
+  pref.end();
+
+  for (uint8_t i = 0; i < _aeadNodesLen; i++) {
+    AeadNodeRec &r = _aeadNodes[i];
+    if (aeadNodeMain(r)) continue;
+    r.txSaved = r.txCounter;
+    r.rxSaved = r.rx.last();
+  }
+  if (_aeadMaster) {
+    _aeadGroupTxSaved = _aeadGroupTx;
+  }
+
+} /* aeadSave */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::aeadSaveCheck() {
+
+  // Só gravo a cada LORA_NONCE_SAVE_STEP quadros de uma mesma chave
+  bool cfg = !_aeadMaster && (_aeadGroupRx.last() - _aeadGroupRxSaved >= LORA_NONCE_SAVE_STEP);
+  bool nodes = _aeadMaster && (_aeadGroupTx - _aeadGroupTxSaved >= LORA_NONCE_SAVE_STEP);
+  for (uint8_t i = 0; i < _aeadNodesLen; i++) {
+    AeadNodeRec &r = _aeadNodes[i];
+    if ((r.txCounter - r.txSaved < LORA_NONCE_SAVE_STEP) && (r.rx.last() - r.rxSaved < LORA_NONCE_SAVE_STEP)) continue;
+    if (aeadNodeMain(r)) {
+      cfg = true;
+    } else {
+      nodes = true;
+    }
+  }
+  if (cfg) {
+    // Grava também as demais
+    saveCfg();
+  } else if (nodes) {
+    aeadSave();
+  }
+
+} /* aeadSaveCheck */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::setNativeDriver(bool enable) {
+  // Deve ser chamado antes de inic()
+  _nativeEnabled = enable;
+} /* setNativeDriver */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::nativeDriver() {
+  return _nativeEnabled;
+} /* nativeDriver */
+
+/* -------------------------------------------------------------------------- */
+LF_SX127x& LF_LoRaClass::sx127x() {
+  return _native;
+} /* sx127x */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::setSpreadingFactor(uint8_t sf) {
+  _loraSf = sf;
+  if (!_radioReady) return;
+  if (_nativeEnabled) {
+    _native.setSpreadingFactor(_loraSf);
+  } else {
+    LoRa.setSpreadingFactor(_loraSf);
+  }
+} /* setSpreadingFactor */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::setSignalBandwidth(long bw) {
+  _loraBw = bw;
+  if (!_radioReady) return;
+  if (_nativeEnabled) {
+    _native.setSignalBandwidth(_loraBw);
+  } else {
+    LoRa.setSignalBandwidth(_loraBw);
+  }
+} /* setSignalBandwidth */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::setCodingRate4(uint8_t denominator) {
+  _loraCr = denominator;
+  if (!_radioReady) return;
+  if (_nativeEnabled) {
+    _native.setCodingRate4(_loraCr);
+  } else {
+    LoRa.setCodingRate4(_loraCr);
+  }
+} /* setCodingRate4 */
+
+/* -------------------------------------------------------------------------- */
+float LF_LoRaClass::lastSnr() {
+  return _snr;
+} /* lastSnr */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaClass::radioParsePacket() {
+
+  // Marca do RxDone tirada antes de olhar o rádio: se não há pacote ela
+  // era de um pacote com erro de CRC e é descartada. Sem a interrupção
+  // (fora do ESP32) fica o momento em que o loop achou o pacote.
+  bool stamped = _rxDoneStamped.exchange(false);
+  uint32_t stamp = _rxDoneTime;
+  int len = _nativeEnabled ? _native.parsePacket() : LoRa.parsePacket();
+  if (len > 0) {
+    _lastRxTime = stamped ? stamp : millis();
+  }
+  return len;
+
+} /* radioParsePacket */
+
+/* -------------------------------------------------------------------------- */
+void IRAM_ATTR LF_LoRaClass::rxDoneIsr(void *arg) {
+  // Só registro o momento, o pacote é lido no loop
+  LF_LoRaClass *self = (LF_LoRaClass *)arg;
+  self->_rxDoneTime = millis();
+  self->_rxDoneStamped = true;
+} /* rxDoneIsr */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaClass::radioRead(char *buf, int len) {
+  if (len <= 0) return 0;
+  if (_nativeEnabled) {
+    // Leitura em rajada da FIFO
+    return _native.readFifo((uint8_t *)buf, len);
+  }
+  int n = 0;
+  while ((n < len) && LoRa.available()) {
+    buf[n++] = (char)LoRa.read();
+  }
+  return n;
+} /* radioRead */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::setCaptureEnable(bool enable, size_t size) {
+
+  delete[] _capBuf;
+  _capBuf = nullptr;
+  _capSize = 0;
+  captureClear();
+
+  if (!enable) return;
+  if (size < LF_LORA_CAPTURE_REC_HEADER + LF_LORA_MAX_PACKET_SIZE) {
+    size = LF_LORA_CAPTURE_REC_HEADER + LF_LORA_MAX_PACKET_SIZE;
+  }
+  _capBuf = new uint8_t[size];
+  _capSize = size;
+
+} /* setCaptureEnable */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::captureClear() {
+  _capHead = 0;
+  _capTail = 0;
+  _capUsed = 0;
+  _capCount = 0;
+  _capDropped = 0;
+} /* captureClear */
+
+/* -------------------------------------------------------------------------- */
+uint16_t LF_LoRaClass::captureCount() {
+  return _capCount;
+} /* captureCount */
+
+/* -------------------------------------------------------------------------- */
+uint32_t LF_LoRaClass::captureDropped() {
+  return _capDropped;
+} /* captureDropped */
+
+/* -------------------------------------------------------------------------- */
+uint8_t LF_LoRaClass::capturePeek(size_t offset) {
+  return _capBuf[(_capTail + offset) % _capSize];
+} /* capturePeek */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::captureRec(const char *data, int dataLen, int len, uint8_t verdict) {
+
+  if ((_capBuf == nullptr) || _replaying) return;
+
+  // Registro: tempo(4) RSSI(2) SNR*4(1) veredito(1) LEN(1) bytes guardados(1) + dados
+  size_t recLen = LF_LORA_CAPTURE_REC_HEADER + dataLen;
+
+  // Sem espaço, descarto os registros mais antigos
+  while (_capSize - _capUsed < recLen) {
+    size_t oldLen = LF_LORA_CAPTURE_REC_HEADER + capturePeek(9);
+    _capTail = (_capTail + oldLen) % _capSize;
+    _capUsed -= oldLen;
+    _capCount--;
+    _capDropped++;
+  }
+
+  uint32_t t = millis();
+  int16_t rssi = _rssi;
+  uint8_t hdr[LF_LORA_CAPTURE_REC_HEADER] = {
+    (uint8_t)(t), (uint8_t)(t >> 8), (uint8_t)(t >> 16), (uint8_t)(t >> 24),
+    (uint8_t)(rssi), (uint8_t)(rssi >> 8),
+    (uint8_t)(int8_t)(_snr * 4),
+    verdict,
+    (uint8_t)len,
+    (uint8_t)dataLen
+  };
+  for (size_t i = 0; i < recLen; i++) {
+    _capBuf[_capHead] = (i < LF_LORA_CAPTURE_REC_HEADER) ? hdr[i] : (uint8_t)data[i - LF_LORA_CAPTURE_REC_HEADER];
+    _capHead = (_capHead + 1) % _capSize;
+  }
+  _capUsed += recLen;
+  _capCount++;
+
+} /* captureRec */
+
+/* -------------------------------------------------------------------------- */
+size_t LF_LoRaClass::captureDump(Print &out) {
+
+  // Cabeçalho do arquivo: "LFCP" + versão, seguido dos registros em ordem
+  uint8_t magic[5] = {'L', 'F', 'C', 'P', LF_LORA_CAPTURE_VERSION};
+  size_t n = out.write(magic, sizeof(magic));
+  if (_capBuf == nullptr) return n;
+
+  // A parte contínua do anel e depois a que deu a volta
+  size_t first = _capSize - _capTail;
+  if (first > _capUsed) first = _capUsed;
+  n += out.write(_capBuf + _capTail, first);
+  if (_capUsed > first) {
+    n += out.write(_capBuf, _capUsed - first);
+  }
+  return n;
+
+} /* captureDump */
+
+/* -------------------------------------------------------------------------- */
+uint32_t LF_LoRaClass::captureReplay(const uint8_t *trace, size_t len, CaptureStats *stats) {
+
+  // Reclassifica um trace gerado por captureDump, sem usar o rádio.
+  // Só decodifica e confere cada quadro: nada é executado, respondido,
+  // retransmitido ou gravado. A conferência parte de registros vazios
+  // (cabeçalhos, duplicadas de grupo, janelas AEAD), como um nó recém-pareado,
+  // e os do nó são restaurados no fim. No modo tarefa a tarefa do rádio
+  // usa esses registros, não reprocesso.
+  if (stats != nullptr) {
+    memset(stats, 0, sizeof(*stats));
+  }
+  if (_taskMode || (len < 5) || (trace[0] != 'L') || (trace[1] != 'F') || (trace[2] != 'C') || (trace[3] != 'P') ||
+      (trace[4] != LF_LORA_CAPTURE_VERSION)) {
+    return 0;
+  }
+
+  RegRec *regRecs = _regRecs;
+  int regRecsLen = _regRecsLen;
+  _regRecs = nullptr;
+  _regRecsLen = 0;
+  GroupDupRec groupDup[LORA_GROUP_DUP_RECS];
+  memcpy(groupDup, _groupDup, sizeof(groupDup));
+  memset(_groupDup, 0, sizeof(_groupDup));
+  uint8_t groupDupNext = _groupDupNext;
+  AeadNodeRec aeadNodes[LORA_AEAD_NODES];
+  memcpy(aeadNodes, _aeadNodes, sizeof(aeadNodes));
+  for (uint8_t i = 0; i < _aeadNodesLen; i++) {
+    _aeadNodes[i].rx.reset(0);
+  }
+  LF_LoRaAeadWindow aeadGroupRx = _aeadGroupRx;
+  _aeadGroupRx.reset(0);
+  RegRec lastRegRec = _lastRegRec;
+  uint8_t lastHops = _lastHops;
+  uint8_t rxEp = _rxEp;
+  int rssi = _rssi;
+  float snr = _snr;
+
+  uint32_t count = 0;
+  size_t pos = 5;
+  _replaying = true;
+  while (pos + LF_LORA_CAPTURE_REC_HEADER <= len) {
+    const uint8_t *rec = trace + pos;
+    uint8_t dataLen = rec[9];
+    if (pos + LF_LORA_CAPTURE_REC_HEADER + dataLen > len) break;
+    const char *data = (const char *)rec + LF_LORA_CAPTURE_REC_HEADER;
+
+    _rssi = (int16_t)(rec[4] | (rec[5] << 8));
+    _snr = ((int8_t)rec[6]) / 4.0;
+
+    uint8_t verdict;
+    if (dataLen < rec[8]) {
+      // Só o cabeçalho foi guardado (descarte antecipado)
+      bool drop = (_opMode == LORA_OP_MODE_LOOP) && loraEarlyDrop(data, dataLen);
+      verdict = drop ? LORA_MSG_CHECK_EARLY_DROP : LORA_MSG_CHECK_ERROR;
+    } else {
+      char buf[LF_LORA_MAX_PACKET_SIZE + 1];
+      char out[LF_LORA_MAX_PACKET_SIZE + 1];
+      memcpy(buf, data, dataLen);
+      buf[dataLen] = 0;
+      if (_opMode == LORA_OP_MODE_LOOP) {
+        verdict = loraCheckMsg(buf, dataLen, out);
+      } else {
+        verdict = loraDecode(buf, dataLen, out) ? LORA_MSG_CHECK_OK : LORA_MSG_CHECK_ERROR;
+      }
+    }
+    if (stats != nullptr) {
+      stats->verdicts[verdict]++;
+      if (verdict != rec[7]) stats->mismatches++;
+    }
+    count++;
+    pos += LF_LORA_CAPTURE_REC_HEADER + dataLen;
+  }
+  _replaying = false;
+  if (stats != nullptr) {
+    stats->frames = count;
+  }
+
+  clearRegRecs();
+  _regRecs = regRecs;
+  _regRecsLen = regRecsLen;
+  memcpy(_groupDup, groupDup, sizeof(groupDup));
+  _groupDupNext = groupDupNext;
+  memcpy(_aeadNodes, aeadNodes, sizeof(aeadNodes));
+  _aeadGroupRx = aeadGroupRx;
+  _lastRegRec = lastRegRec;
+  _lastHops = lastHops;
+  _rxEp = rxEp;
+  _rssi = rssi;
+  _snr = snr;
+
+  return count;
+
+} /* captureReplay */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::taskEntry(void *arg) {
+  ((LF_LoRaClass *)arg)->taskLoop();
+#if defined(ESP32)
+  vTaskDelete(NULL);
+#endif
+} /* taskEntry */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::beginTask(uint8_t core, uint32_t stackSize) {
+
+  // Deve ser chamado depois de inic()
+  if (_taskMode) return true;
+
+  _taskRxQueue.clear();
+  _taskTxQueue.clear();
+  _taskReqPairing = false;
+  _appIdRec = _lastIdRec;
+  _appRssi = _rssi;
+  _appGroup = false;
+  _taskRun = true;
+  _taskDone = false;
+  _taskMode = true;
+
+#if defined(ESP32)
+  if (xTaskCreatePinnedToCore(taskEntry, "LF_LoRa", stackSize, this, 2, NULL, core) != pdPASS) {
+    _taskMode = false;
+    _taskRun = false;
+    return false;
+  }
+#else
+  // Fora do ESP32 a thread não tem núcleo nem pilha configuráveis
+  (void)core;
+  (void)stackSize;
+  _taskThread = std::thread(taskEntry, this);
+#endif
+
+  return true;
+
+} /* beginTask */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::endTask() {
+
+  if (!_taskMode) return;
+
+  _taskRun = false;
+#if defined(ESP32)
+  while (!_taskDone) {
+    delay(1);
+  }
+#else
+  if (_taskThread.joinable()) {
+    _taskThread.join();
+  }
+#endif
+  _taskMode = false;
+
+  // Aplico o que a tarefa não pegou e entrego o que ficou na fila
+  taskTxDrain();
+  taskRxDrain();
+
+} /* endTask */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::taskMode() {
+  return _taskMode;
+} /* taskMode */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::taskLoop() {
+
+  while (_taskRun) {
+
+    // Pedido de pareamento feito pelo botão
+    if (_taskReqPairing.exchange(false)) {
+      if (_opMode == LORA_OP_MODE_LOOP) {
+        setOpMode(LORA_OP_MODE_PAIRING);
+      }
+    }
+
+    taskTxDrain();
+
+    serviceLora();
+
+#if defined(ESP32)
+    vTaskDelay(1);
+#else
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+
+  }
+
+  _taskDone = true;
+
+} /* taskLoop */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::taskTxDrain() {
+
+  // Mensagens e configuração enviadas pela aplicação, na ordem
+  TaskMsg item;
+  while (_taskTxQueue.pop(item)) {
+    switch (item.type) {
+      case TASK_CMD_REPEATER:
+        repeaterApply(item.msg[0]);
+        continue;
+      case TASK_CMD_ROUTES:
+        masterRoutesApply(item.msg[0]);
+        continue;
+      case TASK_CMD_AEAD_KEY:
+        aeadKeyApply(item.exec ? (const uint8_t *)item.msg : nullptr);
+        continue;
+      case TASK_CMD_AEAD_GROUP:
+        aeadGroupKeyApply(item.exec ? (const uint8_t *)item.msg : nullptr);
+        continue;
+      case TASK_CMD_SYNC_WORD: {
+        int synch;
+        memcpy(&synch, item.msg, sizeof(synch));
+        syncWordApply(synch);
+        continue;
+      }
+      case TASK_CMD_HOPPING: {
+        unsigned long dwell;
+        memcpy(&dwell, item.msg, sizeof(dwell));
+        channelHoppingApply(dwell);
+        continue;
+      }
+      case TASK_CMD_TDMA:
+        tdmaApply(item.msg[0]);
+        continue;
+      case TASK_CMD_STORE:
+        storeApply(item.msg[0]);
+        continue;
+      case TASK_CMD_DELTA:
+        deltaEnableApply(item.msg[0], item.msg[1]);
+        continue;
+      case TASK_CMD_CHANNEL:
+        channelApply(item.msg[0]);
+        continue;
+      case TASK_CMD_GROUP_RESP: {
+        TaskCmdGroupResp arg;
+        memcpy(&arg, item.msg, sizeof(arg));
+        groupResponseApply(arg.mode, arg.slot);
+        continue;
+      }
+      case TASK_CMD_ANALYZER: {
+        TaskCmdAnalyzer arg;
+        memcpy(&arg, item.msg, sizeof(arg));
+        analyzerApply(arg.enable, arg.period, arg.out);
+        continue;
+      }
+      case TASK_CMD_OTA_IMAGE: {
+        LF_LoRaOtaImage *image;
+        memcpy(&image, item.msg, sizeof(image));
+        otaImageApply(image);
+        continue;
+      }
+      case TASK_CMD_OTA_SEND: {
+        TaskCmdOtaSend arg;
+        memcpy(&arg, item.msg, sizeof(arg));
+        otaSendApply(arg.para, arg.kind, arg.size, arg.image, arg.nodes, arg.nodesLen);
+        continue;
+      }
+    }
+    if (_opMode != LORA_OP_MODE_LOOP) continue;
+    if (item.type == MSG_TYPE_RESPONSE) {
+      fiFoPushMsg(String(item.msg), item.id, endpointAddr(item.ep), item.group);
+    } else if (item.ep == 0) {
+      internalPushMsg(String(item.msg), (MsgType)item.type);
+    } else {
+      endpointPushMsg(item.ep, String(item.msg), (MsgType)item.type);
+    }
+  }
+
+} /* taskTxDrain */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::taskCmdPush(uint8_t cmd, const void *arg, uint8_t len) {
+
+  // No modo tarefa a configuração vai pela fila, a tarefa do rádio aplica.
+  // Não pode se perder: com a fila cheia espero a tarefa esvaziar
+  if (!_taskMode) return false;
+  TaskMsg item;
+  item.type = cmd;
+  item.exec = (len > 0);
+  if (len > 0) {
+    memcpy(item.msg, arg, len);
+  }
+  while (!_taskTxQueue.push(item)) {
+    delay(1);
+  }
+  return true;
+
+} /* taskCmdPush */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::taskRxPush(const char *msg, bool exec) {
+  TaskMsg item;
+  item.type = MSG_TYPE_RESPONSE;
+  item.ep = _rxEp;
+  item.id = _lastIdRec;
+  item.rssi = _rssi;
+  item.exec = exec;
+  // A tarefa da aplicação responde depois, quando _groupRxOn já pode ser de outra
+  item.group = exec && _groupRxOn;
+  strncpy(item.msg, msg, LF_LORA_MAX_PACKET_SIZE);
+  item.msg[LF_LORA_MAX_PACKET_SIZE] = 0;
+  if (!_taskRxQueue.push(item)) {
+    if (_debugEnabeld) {
+      Serial.println("Fila RX cheia!");
+    }
+  }
+} /* taskRxPush */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::taskRxDrain() {
+
+  bool ret = false;
+  TaskMsg item;
+  while (_taskRxQueue.pop(item)) {
+    ret = true;
+    String sMsg = String(item.msg);
+    _lastMsg = sMsg;
+    _appIdRec = item.id;
+    _appRssi = item.rssi;
+    _appEp = item.ep;
+    _appGroup = item.group;
+    // Trato o comando (calback) na tarefa da aplicação
+    if (item.exec) {
+      if (item.ep > 0) {
+        if (_endpoints[item.ep - 1].onExecMsg)
+          _endpoints[item.ep - 1].onExecMsg(sMsg, MSG_TYPE_RESPONSE);
+      } else if (onExecMsgModeLoop) {
+        onExecMsgModeLoop(sMsg, MSG_TYPE_RESPONSE);
+      }
+    }
+  }
+  return ret;
+
+} /* taskRxDrain */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::setChannelPlan(const long *frequencies, uint8_t count) {
+  if (count > LORA_CHANNEL_MAX) count = LORA_CHANNEL_MAX;
+  for (uint8_t i = 0; i < count; i++) {
+    _channelPlan[i] = frequencies[i];
+  }
+  _channelPlanLen = count;
+} /* setChannelPlan */
+
+/* -------------------------------------------------------------------------- */
+uint8_t LF_LoRaClass::channel() {
+  return _channel;
+} /* channel */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::setChannel(uint8_t channel) {
+  // Usado pelo master para falar com um escravo no canal dele
+  if (taskCmdPush(TASK_CMD_CHANNEL, &channel, sizeof(channel))) return;
+  channelApply(channel);
+} /* setChannel */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::channelApply(uint8_t channel) {
+  _channel = channel;
+  if (_radioReady) {
+    radioSetFrequency(currentFrequency());
+  }
+} /* channelApply */
+
+/* -------------------------------------------------------------------------- */
+long LF_LoRaClass::currentFrequency() {
+  if ((_opMode == LORA_OP_MODE_LOOP) && (_channel < _channelPlanLen)) {
+    return _channelPlan[_channel];
+  }
+  return _loraFrequency;
+} /* currentFrequency */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::setChannelHopping(unsigned long dwell) {
+  // Gateway: percorre o plano de canais, dwell ms em cada um (0 desliga)
+  if (taskCmdPush(TASK_CMD_HOPPING, &dwell, sizeof(dwell))) return;
+  channelHoppingApply(dwell);
+} /* setChannelHopping */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::channelHoppingApply(unsigned long dwell) {
+  // A varredura tem índice próprio, o canal atribuído (_channel) não muda
+  _hopDwell = dwell;
+  if (dwell > 0) {
+    _hopIndex = (_channel < _channelPlanLen) ? _channel : 0;
+    _wheel.add(_tmrHop, dwell);
+  } else {
+    _wheel.cancel(_tmrHop);
+    // Volto para o canal atribuído
+    if (_radioReady) {
+      radioSetFrequency(currentFrequency());
+    }
+  }
+} /* channelHoppingApply */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::channelHopLoop(bool received) {
+
+  if ((_hopDwell == 0) || (_channelPlanLen == 0)) return;
+
+  // Recebi algo, fico no canal para a resposta
+  if (received) {
+    _wheel.add(_tmrHop, _hopDwell);
+    return;
+  }
+
+  // Não troco de canal com envio pendente
+  if ((_fiFoFirst != _fiFoLast) || (_fwdRecsLen > 0)) return;
+
+  if (_wheel.pending(_tmrHop)) return;
+
+  _wheel.add(_tmrHop, _hopDwell);
+  _hopIndex = (_hopIndex + 1) % _channelPlanLen;
+  radioSetFrequency(_channelPlan[_hopIndex]);
+
+} /* channelHopLoop */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::radioSetFrequency(long frequency) {
+  if (_nativeEnabled) {
+    _native.setFrequency(frequency);
+    _native.receive();
+  } else {
+    LoRa.setFrequency(frequency);
+    LoRa.receive();
+  }
+} /* radioSetFrequency */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::setDeltaEnable(bool enable, uint8_t fullEvery) {
+  uint8_t arg[2] = {enable, fullEvery};
+  if (taskCmdPush(TASK_CMD_DELTA, arg, sizeof(arg))) return;
+  deltaEnableApply(enable, fullEvery);
+} /* setDeltaEnable */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::deltaEnableApply(bool enable, uint8_t fullEvery) {
+  _deltaEnabled = enable;
+  _deltaFullEvery = fullEvery;
+  _deltaBaseOk = false;
+} /* deltaEnableApply */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::deltaEnabled() {
+  return _deltaEnabled;
+} /* deltaEnabled */
+
+/* -------------------------------------------------------------------------- */
+uint32_t LF_LoRaClass::deltaBytesSaved() {
+  return _deltaBytesSaved;
+} /* deltaBytesSaved */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::deltaBuild(const String &sState, String &sDelta) {
+
+  // Sem base confirmada, ou hora de renovar a base, envio completo
+  if (!_deltaBaseOk || _deltaResync) return false;
+  if (_deltaCount >= _deltaFullEvery) return false;
+  // Estado completo aguardando confirmação, substituo por outro completo
+  if (_internalMsgStatus == INT_STATUS_CONFIRM) return false;
+  if (sState.charAt(0) != '#') return false;
+
+  char aux[4];
+  LF_LoRaFmt::fmtInt(aux, sizeof(aux), _deltaBaseId, 3);
+  sDelta = String(LORA_DELTA_CHAR) + String(aux);
+
+  int pa = 1;
+  int pb = 1;
+  for (int i = 0; i < LORA_DELTA_MAX_FIELDS; i++) {
+    int ea = sState.indexOf('#', pa);
+    int eb = _deltaBase.indexOf('#', pb);
+    // Quantidade de campos mudou
+    if ((ea == -1) != (eb == -1)) return false;
+    String a = sState.substring(pa, (ea == -1) ? sState.length() : ea);
+    if (!a.equals(_deltaBase.substring(pb, (eb == -1) ? _deltaBase.length() : eb))) {
+      LF_LoRaFmt::fmtInt(aux, sizeof(aux), i, 2);
+      sDelta += "#" + String(aux) + a;
+    }
+    if (ea == -1) {
+      // Só compensa se o delta for menor
+      if (sDelta.length() >= sState.length()) return false;
+      return true;
+    }
+    pa = ea + 1;
+    pb = eb + 1;
+  }
+
+  return false;
+
+} /* deltaBuild */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::deltaAck() {
+
+  if (!_deltaEnabled) return;
+
+  // Estado completo confirmado pelo master passa a ser a base
+  if (_internalSentMsg.charAt(0) == '#') {
+    _deltaBase = _internalSentMsg;
+    _deltaBaseId = _internalMsgId;
+    _deltaBaseOk = true;
+    _deltaResync = false;
+    _deltaCount = 0;
+  }
+
+} /* deltaAck */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::deltaApply(const String &sDelta, const String &sBase, uint8_t baseId, String &sOut) {
+
+  // Para o master: reconstrói o estado completo a partir da base (último
+  // estado completo confirmado, com o seu ID). Retornando false o master
+  // deve enviar "$D" para o escravo.
+  if ((sDelta.charAt(0) != LORA_DELTA_CHAR) || (sDelta.length() < 4)) return false;
+  if (sDelta.substring(1,4).toInt() != baseId) return false;
+  if (sBase.charAt(0) != '#') return false;
+
+  int pd = 4;
+  int index = -1;
+  String value;
+  if (!deltaNext(sDelta, pd, index, value) && (index == -2)) return false;
+
+  sOut = "";
+  int pb = 1;
+  for (int i = 0; i < LORA_DELTA_MAX_FIELDS; i++) {
+    int eb = sBase.indexOf('#', pb);
+    if (i == index) {
+      sOut += "#" + value;
+      if (!deltaNext(sDelta, pd, index, value)) {
+        if (index == -2) return false;
+        index = -1;
+      }
+    } else {
+      sOut += "#" + sBase.substring(pb, (eb == -1) ? sBase.length() : eb);
+    }
+    if (eb == -1) break;
+    pb = eb + 1;
+  }
+
+  // Campo além da base
+  return (index == -1);
+
+} /* deltaApply */
+
+/* -------------------------------------------------------------------------- */
+LF_LoRaReport& LF_LoRaClass::report() {
+  return _report;
+} /* report */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::setReportEnable(bool enable) {
+  // A biblioteca envia a telemetria quando report() decidir
+  _reportEnabled = enable;
+} /* setReportEnable */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::reportEnabled() {
+  return _reportEnabled;
+} /* reportEnabled */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::reportValue(const char *name, float value) {
+  return _report.setValue(name, value, millis());
+} /* reportValue */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::reportLoop() {
+
+  if (!_reportEnabled) return;
+  if (_opMode != LORA_OP_MODE_LOOP) return;
+
+  unsigned long now = millis();
+  if (_report.due(now)) {
+    sendState(_report.state(), MSG_TYPE_TELEMETRY);
+    _report.sent(now);
+  }
+
+} /* reportLoop */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaClass::addEndpoint(String model, std::function<void(String, MsgType)> onExecMsg) {
+
+  // Chamar antes de inic(), retorna o número do endpoint (o principal é 0)
+  if (_endpointsLen >= LORA_ENDPOINT_MAX) return -1;
+
+  EndpointRec &e = _endpoints[_endpointsLen];
+  e.addr = 0;
+  e.model = model;
+  e.onExecMsg = onExecMsg;
+  e.pairOk = false;
+  e.pairAddr = 0;
+  e.pairPending = false;
+  e.pairRepeat = 0;
+  e.msgStatus = INT_STATUS_EMPTY;
+  e.lastMsgStatus = INT_STATUS_EMPTY;
+  e.msgId = 0;
+  _endpointsLen++;
+
+  return _endpointsLen;
+
+} /* addEndpoint */
+
+/* -------------------------------------------------------------------------- */
+uint8_t LF_LoRaClass::endpointCount() {
+  return _endpointsLen;
+} /* endpointCount */
+
+/* -------------------------------------------------------------------------- */
+uint8_t LF_LoRaClass::endpointAddr(uint8_t ep) {
+  if (ep == 0) return _myAddr;
+  if (ep > _endpointsLen) return 0;
+  return _endpoints[ep - 1].addr;
+} /* endpointAddr */
+
+/* -------------------------------------------------------------------------- */
+uint8_t LF_LoRaClass::lastEndpoint() {
+  // Endpoint da última mensagem recebida, para responder com sendState(ep, ...)
+  return _taskMode ? _appEp : _rxEp;
+} /* lastEndpoint */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaClass::endpointFind(uint8_t addr) {
+  if (addr == _myAddr) return 0;
+  for (uint8_t ep = 0; ep < _endpointsLen; ep++) {
+    if ((_endpoints[ep].addr != 0) && (_endpoints[ep].addr == addr)) return ep + 1;
+  }
+  return -1;
+} /* endpointFind */
+
+/* -------------------------------------------------------------------------- */
+String LF_LoRaClass::endpointMac(uint8_t ep) {
+  if (ep == 0) return _sLast6Mac;
+  return _endpoints[ep - 1].sLast6Mac;
+} /* endpointMac */
+
+/* -------------------------------------------------------------------------- */
+const char *LF_LoRaClass::endpointMacStr(uint8_t ep) {
+  if (ep == 0) return _sLast6Mac.c_str();
+  return _endpoints[ep - 1].sLast6Mac.c_str();
+} /* endpointMacStr */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaClass::endpointMacFind(const LF_LoRaToken &mac) {
+  for (uint8_t ep = 0; ep <= _endpointsLen; ep++) {
+    if (mac.equalsIgnoreCase(endpointMacStr(ep))) return ep;
+  }
+  return -1;
+} /* endpointMacFind */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::endpointPairDone() {
+  for (uint8_t ep = 0; ep < _endpointsLen; ep++) {
+    if (!_endpoints[ep].pairOk || _endpoints[ep].pairPending) return false;
+  }
+  return true;
+} /* endpointPairDone */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::endpointPushMsg(uint8_t ep, String msg, MsgType mt) {
+  // Mesma regra de internalPushMsg, uma mensagem pendente por endpoint
+  EndpointRec &e = _endpoints[ep - 1];
+  if (mt == MSG_TYPE_TELEMETRY) {
+    if ((e.msgStatus == INT_STATUS_EMPTY) || (e.msgStatus == INT_STATUS_TELEMETRY)) {
+      e.msgStatus = INT_STATUS_TELEMETRY;
+    } else {
+      e.msgStatus = INT_STATUS_CONFIRM;
+    }
+    e.msg = msg;
+  }
+  if (mt == MSG_TYPE_CONFIRM) {
+    e.msgStatus = INT_STATUS_CONFIRM;
+    e.msg = msg;
+  }
+} /* endpointPushMsg */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::endpointSendMsg() {
+
+  // Rodízio entre os endpoints, um envio por vez
+  if (endpointTxHeld()) return false;
+  for (uint8_t k = 0; k < _endpointsLen; k++) {
+    uint8_t ep = (_endpointNext + k) % _endpointsLen;
+    EndpointRec &e = _endpoints[ep];
+    if ((e.msgStatus == INT_STATUS_EMPTY) || (e.addr == 0)) continue;
+    if ((e.lastMsgStatus != INT_STATUS_EMPTY) && _wheel.pending(e.sendTimer)) continue;
+    e.lastMsgStatus = e.msgStatus;
+    e.msgId = (e.msgStatus == INT_STATUS_CONFIRM) ? getNextIdConfToSend() : getNextIdTeleToSend();
+    sendMsg(e.msg, e.msgId, e.addr);
+    _wheel.add(e.sendTimer, random(_msgSendIntervalBase - 500, _msgSendIntervalBase + 500));
+    endpointTxNext();
+    if (e.msgStatus == INT_STATUS_TELEMETRY) {
+      e.msgStatus = INT_STATUS_EMPTY;
+    }
+    _endpointNext = (ep + 1) % _endpointsLen;
+    return true;
+  }
+  return false;
+
+} /* endpointSendMsg */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaClass::endpointTxHeld() {
+  // Com endpoints, os envios próprios (principal e endpoints) passam por um
+  // escalonador só: o rádio não emenda um envio de cada endpoint
+  return (_endpointsLen > 0) && _wheel.pending(_tmrEpTx);
+} /* endpointTxHeld */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaClass::endpointTxNext() {
+  // Próximo envio próprio depois de uma fração do intervalo de envio, com
+  // todos enviando, cada um usa uma vez por intervalo
+  if (_endpointsLen == 0) return;
+  unsigned long gap = _msgSendIntervalBase / (_endpointsLen + 1);
+  _wheel.add(_tmrEpTx, random(gap / 2, gap + gap / 2));
+} /* endpointTxNext */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaClass::nextSendLen() {
+  // Tamanho da próxima mensagem que o escalonador vai enviar, -1 se nenhuma
+  // (mesmas condições de fiFoSendMsg, internalSendMsg, storeSendMsg e endpointSendMsg)
+  uint8_t i = fiFoNext();
+  if (i != _fiFoLast) return _fiFoMsgMsg[i].length();
+  if ((_internalMsgStatus != INT_STATUS_EMPTY) && !endpointTxHeld() &&
+      ((_internalLastMsgStatus == INT_STATUS_EMPTY) || !_wheel.pending(_tmrSend))) return _internalMsg.length();
+  if (_storeEnabled && !_store.empty() && !_wheel.pending(_tmrStore)) return LORA_STORE_FRAME;
+  if (endpointTxHeld()) return -1;
+  for (uint8_t ep = 0; ep < _endpointsLen; ep++) {
+    EndpointRec &e = _endpoints[ep];
+    if ((e.msgStatus == INT_STATUS_EMPTY) || (e.addr == 0)) continue;
+    if ((e.lastMsgStatus != INT_STATUS_EMPTY) && _wheel.pending(e.sendTimer)) continue;
+    return e.msg.length();
+  }
+  return -1;
+} /* nextSendLen */
+
 /* Defino a variável Globla LF_LoRa aqui, para não ter que declarar no .ino */
 LF_LoRaClass LF_LoRa;
@@ -24,6 +24,48 @@
 // Preferences para salvar na memória não volátil
 #include "Preferences.h"
 
+// Criptografia autenticada opcional
+#include "LF_LoRa_Aead.h"
+
+// Driver nativo opcional do SX127x
+#include "LF_LoRa_SX127x.h"
+
+// Filas sem trava para o modo tarefa
+#include "LF_LoRa_Queue.h"
+#if !defined(ESP32)
+#include <thread>
+#endif
+
+// Envio de telemetria por mudança
+#include "LF_LoRa_Report.h"
+
+// Gestos do botão
+#include "LF_LoRa_Button.h"
+
+// Roda de timers e tempo de 64 bits
+#include "LF_LoRa_Timer.h"
+#if defined(ESP32)
+#include "hal/gpio_ll.h"
+#endif
+
+// Formatação e leitura de números sem alocação
+#include "LF_LoRa_Fmt.h"
+
+// Separação dos comandos "!PARA!DE!CMD!..." sem alocação
+#include "LF_LoRa_Cmd.h"
+
+// Distribuição de firmware/configuração em grupo
+#include "LF_LoRa_Ota.h"
+
+// Relógio da rede (beacons de tempo do master)
+#include "LF_LoRa_Time.h"
+
+// Registros guardados enquanto o master não responde
+#include "LF_LoRa_Store.h"
+
+// Estatísticas do canal (modo analisador)
+#include "LF_LoRa_Analyzer.h"
+
 //########## Para LoRa
 #define LORA_OP_MODE_PAIRING 0   // Modo de pareamento
 #define LORA_OP_MODE_LOOP    1   // Modo loop de mensagens
@@ -32,6 +74,15 @@
 #define LORA_STEP_NEG_CFG    1   // Fase da negociação do LoRa2MQTT - Recebe Configuração
 #define LORA_STEP_NEG_FIM    2   // Fase da negociação do LoRa2MQTT - Final - Salva e Muda Modo
 
+#define LORA_PAIR_SLOT_DEF 150   // Duração padrão de um slot de pareamento (ms)
+
+// Registro de configuração na memória não volátil
+#define LORA_CFG_VERSION        4   // Versão do registro "cfg"
+#define LORA_CFG_V1_SIZE        7   // Tamanho do registro na versão 1
+#define LORA_ID_SAVE_STEP      16   // Envios entre gravações dos IDs de sequência
+#define LORA_NONCE_SAVE_STEP   64   // Quadros cifrados entre gravações dos contadores do nonce
+#define LORA_RADIO_RETRY_TIME 500   // Intervalo para tentar iniciar o rádio (ms)
+
 // Frequência de comunicação
 #define LORA_FREQ_AS  433E6  // Asia
 #define LORA_FREQ_EU  868E6  // Europe
@@ -40,23 +91,116 @@
 // "sync word" range de 0x00 - 0xFF
 #define LORA_SYNC_WORD_DEF   0xE6
 
-#define LF_LORA_MAX_PACKET_SIZE  255
+#define LF_LORA_MAX_PACKET_SIZE  255   // Buffers de pacote têm um byte a mais para o terminador
+#define LF_LORA_HEADER_SIZE       12
+
+// Para o modo repetidor (mesh)
+#define LORA_HOP_MAX              3     // Máximo de saltos de uma mensagem
+#define LORA_FWD_FIFO_LEN         4     // Mensagens aguardando retransmissão
+#define LORA_FWD_DELAY_MIN       50     // Retardo mínimo para retransmitir (ms)
+#define LORA_FWD_DELAY_MAX      400     // Retardo máximo para retransmitir (ms)
+#define LORA_ROUTE_LEN           32     // Endereços aprendidos pelo repetidor
+#define LORA_ROUTE_TIMEOUT   600000     // Validade de uma rota aprendida (ms)
+#define LORA_HOPS_POS  (LF_LORA_HEADER_SIZE - 4)  // Primeiro dígito de LEN, o contador de saltos
+
+// Chaves de sessão (AEAD), derivadas no pareamento: no escravo uma para o
+// principal e cada endpoint, no master uma para cada escravo
+#define LORA_AEAD_NODES        16
+#define LORA_AEAD_PAIR_RECS     8   // Apresentações (100) guardadas pelo master até o 101
+#define LORA_AEAD_KEY_GROUP    -2   // Chave de grupo em uso (_aeadKeyNode)
+
+// Plano de canais
+#define LORA_CHANNEL_MAX       16     // Máximo de canais no plano
+#define LORA_CHANNEL_NONE    0xFF     // Sem canal atribuído, usa a frequência base
+
+// Endpoints lógicos além do principal, no mesmo rádio
+#define LORA_ENDPOINT_MAX       4
+#define LORA_ENDPOINT_PAIR_TIMEOUT  30000   // Espera pelos endpoints depois do principal (ms)
+
+// Endereço de difusão (broadcast)
+#define LORA_ADDR_BROADCAST    0xFF
+
+// Endereços de grupo, atribuídos pelo master no pareamento com "!G240241"
+// depois do endereço (ou "G240241" no fim do token do lote)
+#define LORA_ADDR_GROUP_FIRST  0xF0
+#define LORA_ADDR_GROUP_LAST   0xFE
+#define LORA_GROUP_CHAR         'G'
+#define LORA_GROUP_MAX           4      // Grupos por endpoint
+#define LORA_GROUP_DUP_RECS     16      // IDs recentes de grupo e difusão
+#define LORA_GROUP_DUP_TIME  30000      // Validade de um ID de grupo e difusão (ms)
+#define LORA_GROUP_RESP_NONE     0      // Não responde a comandos de grupo
+#define LORA_GROUP_RESP_STAGGER  1      // Responde no slot do seu endereço
+#define LORA_GROUP_RESP_SLOT   250      // Duração do slot de resposta (ms)
+#define LORA_GROUP_RESP_SLOTS   16
+
+// Mensagens de controle da biblioteca (não vão para o usuário, '$' com outro código vai)
+#define LORA_CTRL_CHAR          '$'
+#define LORA_CTRL_TDMA_BEACON   'B'
+#define LORA_CTRL_DELTA_RESYNC  'D'   // Master perdeu o estado base, envie completo
+#define LORA_CTRL_TIME          'T'   // $Ttttttttt: tempo da rede (ms, HEX) no início do envio
+
+// Envio em grupo de imagens (OTA), quadros LF_LORA_OTA_* após o '$'
+#define LORA_OTA_GAP             20     // Intervalo entre quadros além do tempo no ar (ms)
+#define LORA_OTA_SLOT_MARGIN    100     // Folga no slot de resposta de cada escravo (ms)
+
+// Guarda local (LF_LoRaStore) quando o master não confirma
+#define LORA_STORE_MISS           4     // Confirmações perdidas seguidas para considerar o master perdido
+#define LORA_STORE_FRAME        200     // Tamanho máximo do quadro em lote
+#define LORA_STORE_GAP          500     // Intervalo entre quadros em lote confirmados (ms)
+#define LORA_STORE_PROBE_MAX 600000     // Maior intervalo entre sondagens do master perdido (ms)
+
+// Modo analisador: resumo das estatísticas do canal a cada período
+#define LORA_ANALYZER_PERIOD  60000     // ms
+
+// Telemetria delta: "%BBB#NNvalor[#NNvalor...]"
+// BBB é o ID do estado completo confirmado pelo master (base), NN o índice do campo alterado
+#define LORA_DELTA_CHAR         '%'
+#define LORA_DELTA_FULL_EVERY    10     // Deltas enviados antes de um estado completo
+#define LORA_DELTA_MAX_FIELDS   100     // Índice do campo tem 2 dígitos
+
+// Para o modo TDMA (slots definidos pelo beacon do master)
+#define LORA_TDMA_MAX_SLOTS      48     // Máximo de slots atribuídos no beacon
+#define LORA_TDMA_GUARD_MIN      10     // Tempo de guarda mínimo (ms)
+#define LORA_TDMA_DRIFT_PPM     100     // Deriva relativa dos relógios (ppm, soma master + escravo)
+#define LORA_TDMA_BEACON_LOST     3     // Superframes sem beacon para voltar ao ALOHA
 
 #define LORA_MSG_CHECK_OK            0
 #define LORA_MSG_CHECK_NOT_MASTER    1
 #define LORA_MSG_CHECK_NOT_ME        2
 #define LORA_MSG_CHECK_ALREADY_REC   3
 #define LORA_MSG_CHECK_ERROR         4
+#define LORA_MSG_CHECK_EARLY_DROP    5
+
+// Captura de pacotes recebidos (trace binário)
+#define LF_LORA_CAPTURE_SIZE       4096   // Tamanho padrão do anel de captura (bytes)
+#define LF_LORA_CAPTURE_REC_HEADER   10   // Bytes de cabeçalho de cada registro
+#define LF_LORA_CAPTURE_VERSION       1   // Versão do formato do trace
 
 #define LED_CICLE_TIME        500
 #define LED_MIN_BRIGHTNESS     26
 
-#define BTN_DEBOUNCE_TIME      20
-#define BTN_ON_TIME          1000
-#define BTN_OFF_TIME          400
-#define BTN_LONG_TIME        3000
+#define BTN_EDGE_QUEUE_LEN     16
 
 #define FIFO_LEN                   10
+#define TASK_QUEUE_LEN              8
+#define TASK_STACK_SIZE          4096
+
+// Configuração pedida pela aplicação no modo tarefa (TaskMsg.type, depois
+// dos MsgType), aplicada pela tarefa do rádio na ordem das mensagens
+#define TASK_CMD_REPEATER        0x40
+#define TASK_CMD_AEAD_KEY        0x41
+#define TASK_CMD_SYNC_WORD       0x42
+#define TASK_CMD_HOPPING         0x43
+#define TASK_CMD_ROUTES          0x44
+#define TASK_CMD_TDMA            0x45
+#define TASK_CMD_STORE           0x46
+#define TASK_CMD_DELTA           0x47
+#define TASK_CMD_CHANNEL         0x48
+#define TASK_CMD_GROUP_RESP      0x49
+#define TASK_CMD_ANALYZER        0x4A
+#define TASK_CMD_OTA_IMAGE       0x4B
+#define TASK_CMD_OTA_SEND        0x4C
+#define TASK_CMD_AEAD_GROUP      0x4D
 #define LORA_MSG_SEND_INTERVAL   4000
 
 enum MsgType {
@@ -77,11 +221,104 @@ struct RegRec {
   uint8_t id;
 };
 
+struct CfgRec {
+  uint8_t version;
+  uint8_t opMode;
+  uint8_t netId;
+  uint8_t masterAddr;
+  uint8_t myAddr;
+  uint8_t lastSendIdTele;
+  uint8_t lastSendIdConf;
+  uint8_t channel;          // Versão 2
+  uint32_t aeadCounter;     // Versão 3, contador do nonce (AEAD)
+  uint32_t aeadRxMaster;    // Versão 3, último contador aceito do master
+  uint32_t aeadGroupRx;     // Versão 4, último contador de grupo aceito do master
+  uint8_t aeadKey[LF_LORA_AES_BLOCK]; // Versão 4, chave de sessão do principal
+  bool aeadKeyOk;           // Versão 4, aeadKey derivada no pareamento
+};
+
+// Resultado de captureReplay
+struct CaptureStats {
+  uint32_t frames;
+  uint32_t verdicts[LORA_MSG_CHECK_EARLY_DROP + 1];   // Por LORA_MSG_CHECK_*
+  uint32_t mismatches;                                // Veredito diferente do gravado
+};
+
+// Chave de sessão (AEAD) entre o master e um escravo, nos dois sentidos
+struct AeadNodeRec {
+  uint8_t addr;             // Escravo (no escravo, o principal ou um endpoint)
+  uint8_t key[LF_LORA_AES_BLOCK];
+  uint32_t txCounter;       // Último contador enviado
+  uint32_t txSaved;
+  LF_LoRaAeadWindow rx;     // Contadores aceitos do outro lado
+  uint32_t rxSaved;
+};
+
+// Apresentação (100) de um escravo ouvida pelo master, com a contribuição
+// dele à chave de sessão
+struct AeadPairRec {
+  char mac6[7];
+  char mac[13];
+  uint32_t token;
+};
+
+struct TaskMsg {
+  uint8_t type;
+  uint8_t ep;
+  uint8_t id;
+  int16_t rssi;
+  bool exec;
+  bool group;               // Comando de grupo ou difusão (resposta no slot do endereço)
+  char msg[LF_LORA_MAX_PACKET_SIZE + 1];
+};
+
+struct FwdRec {
+  RegRec header;
+  unsigned long time;
+  unsigned long delay;
+  int len;
+  char data[LF_LORA_MAX_PACKET_SIZE + 1];
+};
+
+struct GroupDupRec {
+  uint8_t de;
+  uint8_t para;
+  uint8_t id;
+  unsigned long time;
+};
+
+struct RouteRec {
+  uint8_t addr;
+  uint8_t hops;
+  unsigned long time;
+};
+
+// Endpoint lógico: tem endereço, modelo e MAC virtual próprios para o
+// pareamento, e sua própria telemetria. Usa o rádio e a rede do principal.
+struct EndpointRec {
+  uint8_t addr;
+  String model;
+  String sLast6Mac;
+  std::function<void(String, MsgType)> onExecMsg;
+  bool pairOk;
+  uint8_t pairAddr;
+  bool pairPending;
+  String pairMsg;
+  unsigned long pairRepeat;
+  LF_LoRaTimer pairTimer;
+  uint8_t msgStatus;
+  uint8_t lastMsgStatus;
+  uint8_t msgId;
+  String msg;
+  LF_LoRaTimer sendTimer;
+};
+
 // Callbacks da Biblioteca
 #define LF_LORA_ON_EXEC_MSG_MODE_LOOP std::function<void(String, MsgType)> onExecMsgModeLoop
 #define LF_LORA_ON_LED_CHECK std::function<bool()> onLedCheck
 #define LF_LORA_ON_LED_TURN_ON_PAIRING std::function<void()> onLedTurnOnPairing
 #define LF_LORA_ON_LED_TURN_OFF_PAIRING std::function<void()> onLedTurnOffPairing
+#define LF_LORA_ON_AEAD_DEVICE_KEY std::function<bool(const char *, uint8_t *)> onAeadDeviceKey
 
 class LF_LoRaClass {
 
@@ -95,12 +332,15 @@ public:
   void hardwareCfg(uint8_t rstPin, uint8_t ssPin, uint8_t sckPin, uint8_t mosiPin, uint8_t misoPin, uint8_t di00Pin);
   void slaveCfg(String model);
   void btnCfg(uint8_t btn_pin, bool btn_inverted);
+  bool setBtnIrqEnable(bool enable);
+  bool btnIrqEnabled();
   void inic();
   void setDebugEnable(bool debugEnable);
   LF_LoRaClass& setOnExecMsgModeLoop(LF_LORA_ON_EXEC_MSG_MODE_LOOP);
   LF_LoRaClass& setOnLedCheck(LF_LORA_ON_LED_CHECK);
   LF_LoRaClass& setOnLedTurnOnPairing(LF_LORA_ON_LED_TURN_ON_PAIRING);
   LF_LoRaClass& setOnLedTurnOffPairing(LF_LORA_ON_LED_TURN_OFF_PAIRING);
+  LF_LoRaClass& setOnAeadDeviceKey(LF_LORA_ON_AEAD_DEVICE_KEY);
   void setFrequency(long frequency);
   void setSyncWord(int synch);
   uint8_t myAddr();
@@ -109,26 +349,97 @@ public:
   void setMasterAddr(uint8_t addr);
   uint8_t opMode();
   void setOpMode(uint8_t modo);
-  void loraEncode(const char *in, int len, char *out);
-  void loraAddHeader(const char *in, int len, uint8_t para, char *out);
-  void loraAddHeaderId(const char *in, int len, uint8_t para, uint8_t id, char *out);
+  int loraEncode(const char *in, int len, char *out);
+  int loraAddHeader(const char *in, int len, uint8_t para, char *out);
+  int loraAddHeaderId(const char *in, int len, uint8_t para, uint8_t id, char *out);
   bool loraDecode(const char *in, int len, char *out);
   uint8_t loraCheckMsg(const char *in, int len, char *out);
   uint8_t loraCheckMsgMaster(const char *in, int len, char *out);
   RegRec lastMsgHeader();
   uint8_t lastSendId();
+  void execMsgModePairing(const char *msg, int len);
   void execMsgModePairing(String sMsg);
   bool loopLora();
+  uint32_t timeToNextDeadline();
   int lastRssi();
   String lastMsg();
   uint8_t lastIdRec();
   void sendState(String sState, MsgType mt);
+  void sendState(uint8_t ep, String sState, MsgType mt);
+  int addEndpoint(String model, std::function<void(String, MsgType)> onExecMsg);
+  uint8_t endpointCount();
+  uint8_t endpointAddr(uint8_t ep);
+  uint8_t lastEndpoint();
   void loopBtnLed();
   bool isBtnClickActive();
   bool isBtnDblClickActive();
   bool isBtnLongActive();
   bool isBtnOn();
   int64_t getDeltaMillis(unsigned long lastTime);
+  void setRepeaterEnable(bool enable);
+  bool repeaterEnabled();
+  uint8_t lastHops();
+  uint32_t repeaterFwdCount();
+  uint32_t repeaterFwdAirtime();
+  void setMasterRoutes(bool enable);
+  uint32_t loraAirtime(int len);
+  bool radioReady();
+  unsigned long timeToFirstTx();
+  void setAeadKey(const uint8_t *key);
+  void setAeadGroupKey(const uint8_t *key);
+  bool aeadEnabled();
+  uint32_t earlyDropCount();
+  void setNativeDriver(bool enable);
+  bool nativeDriver();
+  LF_SX127x& sx127x();
+  void setSpreadingFactor(uint8_t sf);
+  void setSignalBandwidth(long bw);
+  void setCodingRate4(uint8_t denominator);
+  float lastSnr();
+  void setCaptureEnable(bool enable, size_t size = LF_LORA_CAPTURE_SIZE);
+  void captureClear();
+  uint16_t captureCount();
+  uint32_t captureDropped();
+  size_t captureDump(Print &out);
+  uint32_t captureReplay(const uint8_t *trace, size_t len, CaptureStats *stats = nullptr);
+  bool beginTask(uint8_t core = 0, uint32_t stackSize = TASK_STACK_SIZE);
+  void endTask();
+  bool taskMode();
+  void setChannelPlan(const long *frequencies, uint8_t count);
+  uint8_t channel();
+  void setChannel(uint8_t channel);
+  long currentFrequency();
+  void setChannelHopping(unsigned long dwell);
+  void setDeltaEnable(bool enable, uint8_t fullEvery = LORA_DELTA_FULL_EVERY);
+  bool deltaEnabled();
+  uint32_t deltaBytesSaved();
+  bool deltaApply(const String &sDelta, const String &sBase, uint8_t baseId, String &sOut);
+  LF_LoRaReport& report();
+  void setReportEnable(bool enable);
+  bool reportEnabled();
+  bool reportValue(const char *name, float value);
+  void setTdmaEnable(bool enable);
+  bool tdmaActive();
+  uint8_t tdmaSlot();
+  void sendTdmaBeacon(uint16_t superframe, uint16_t slotLen, uint8_t contention, const uint8_t *addrs, uint8_t addrsLen);
+  void sendTimeBeacon();
+  uint32_t syncMillis();
+  bool timeSynced();
+  LF_LoRaTimeSync& timeSync();
+  void setOtaImage(LF_LoRaOtaImage *image);
+  LF_LoRaOtaRx& otaRx();
+  bool otaSend(uint8_t para, char kind, uint32_t size, LF_LoRaOtaImage *image, const uint8_t *nodes, uint8_t nodesLen);
+  LF_LoRaOtaTx& otaTx();
+  void setStoreEnable(bool enable);
+  bool masterLost();
+  unsigned long storeRecoveryTime();
+  LF_LoRaStore& store();
+  void setAnalyzerEnable(bool enable, uint32_t period = LORA_ANALYZER_PERIOD, Print *out = &Serial);
+  LF_LoRaAnalyzer& analyzer();
+  bool setGroups(uint8_t ep, const uint8_t *groups, uint8_t len);
+  uint8_t groupCount(uint8_t ep);
+  uint8_t group(uint8_t ep, uint8_t i);
+  void setGroupResponse(uint8_t mode, uint16_t slot = LORA_GROUP_RESP_SLOT);
 
   // LF_LoRaClass Private
   // --------------
@@ -139,24 +450,121 @@ private:
   LF_LORA_ON_LED_CHECK;
   LF_LORA_ON_LED_TURN_ON_PAIRING;
   LF_LORA_ON_LED_TURN_OFF_PAIRING;
+  LF_LORA_ON_AEAD_DEVICE_KEY;
 
   uint8_t loraCheckMsgIni(const char *in, int len, uint8_t &de, uint8_t &para, char *out);
+  uint8_t loraCheckForeign(const char *in, uint8_t &de, uint8_t &para);
   void addRegRec(uint8_t de, uint8_t para, uint8_t id);
   void removeRegRec(int index);
   void clearRegRecs();
   int findRegRec(uint8_t de, uint8_t para);
+  int endpointFind(uint8_t addr);
+  String endpointMac(uint8_t ep);
+  const char *endpointMacStr(uint8_t ep);
+  int endpointMacFind(const LF_LoRaToken &mac);
+  bool endpointPairDone();
+  void endpointPushMsg(uint8_t ep, String msg, MsgType mt);
+  bool endpointSendMsg();
+  bool endpointTxHeld();
+  void endpointTxNext();
+  int nextSendLen();
+  int loraAddHeaderDe(const char *in, int len, uint8_t de, uint8_t para, uint8_t id, char *out);
   void sendNegotiation(String sRet);
+  void pairingPush(uint8_t ep, String sRet, unsigned long delay, unsigned long repeat);
+  void pairingCheckFinish();
+  void pairingSendLoop();
+  void pairingFinish();
+  bool serviceLora();
+  static void taskEntry(void *arg);
+  void taskLoop();
+  void taskRxPush(const char *msg, bool exec);
+  bool taskRxDrain();
+  void taskTxDrain();
+  bool taskCmdPush(uint8_t cmd, const void *arg, uint8_t len);
+  void repeaterApply(bool enable);
+  void aeadKeyApply(const uint8_t *key);
+  void aeadGroupKeyApply(const uint8_t *key);
+  void syncWordApply(int synch);
+  void channelHoppingApply(unsigned long dwell);
+  void masterRoutesApply(bool enable);
+  void tdmaApply(bool enable);
+  void storeApply(bool enable);
+  void deltaEnableApply(bool enable, uint8_t fullEvery);
+  void channelApply(uint8_t channel);
+  void groupResponseApply(uint8_t mode, uint16_t slot);
+  void analyzerApply(bool enable, uint32_t period, Print *out);
+  void otaImageApply(LF_LoRaOtaImage *image);
+  bool otaSendApply(uint8_t para, char kind, uint32_t size, LF_LoRaOtaImage *image, const uint8_t *nodes, uint8_t nodesLen);
   bool loraMsgReceiveLoop();
+  bool loraMsgProcess(const char *loraData, int len);
+  void captureRec(const char *data, int dataLen, int len, uint8_t verdict);
+  uint8_t capturePeek(size_t offset);
+  bool loraEarlyDrop(const char *header, int len);
+  int radioParsePacket();
+  int radioRead(char *buf, int len);
+  void radioSetFrequency(long frequency);
+  void channelHopLoop(bool received);
+  bool deltaBuild(const String &sState, String &sDelta);
+  void deltaAck();
+  void reportLoop();
+  void otaLoop();
+  void otaReport(uint8_t de, const char *msg);
+  bool isMulticast(uint8_t addr);
+  bool groupHas(uint8_t ep, uint8_t addr);
+  bool groupDupFind(uint8_t de, uint8_t para, uint8_t id);
+  bool pairGroupsSet(uint8_t ep, const LF_LoRaToken &t);
+  uint8_t fiFoNext();
   void loraMsgSendLoop();
   void btnCheck();
-  bool fiFoPushMsg(String msg, uint8_t id);
+  void btnEvent(uint8_t evt);
+  void ledLoop();
+  static void IRAM_ATTR btnIsr(void *arg);
+  static void IRAM_ATTR rxDoneIsr(void *arg);
+  bool fiFoPushMsg(String msg, uint8_t id, uint8_t de, bool group);
   bool fiFoSendMsg();
   void internalPushMsg(String msg, MsgType mt);
   bool internalSendMsg();
+  bool storeSendMsg();
+  void storeLost();
+  void storeAck();
+  void analyzerLoop();
   uint8_t getNextIdTeleToSend();
   uint8_t getNextIdConfToSend();
   void setSendInterval(unsigned long interval);
-  void sendMsg(String msg, uint8_t id);
+  void saveIdsCheck();
+  void saveCfg();
+  bool radioBegin();
+  bool aeadSelect(const char *header);
+  uint32_t &aeadTxCounter();
+  LF_LoRaAeadWindow &aeadRxWindow();
+  int aeadOverhead(uint8_t para);
+  void aeadNonce(const char *header, uint32_t counter, uint8_t *nonce);
+  int aeadNodeFind(uint8_t addr);
+  AeadNodeRec &aeadNodeSet(uint8_t addr, const uint8_t *key);
+  bool aeadNodeMain(const AeadNodeRec &r);
+  void aeadSessionKey(LF_LoRaAead &device, uint8_t net, uint8_t addr, uint32_t slaveToken, uint32_t masterToken, uint8_t *key);
+  uint32_t aeadRandom();
+  String aeadPairTokenStr(uint8_t ep);
+  void aeadPairKeys();
+  void aeadPairRecord(const char *msg, int len);
+  int aeadPairReply(char *out, int len);
+  bool aeadPairNode(const LF_LoRaToken &mac6, uint8_t net, uint8_t addr);
+  void aeadLoad();
+  void aeadSave();
+  void aeadSaveCheck();
+  void sendMsg(String msg, uint8_t id, uint8_t de);
+  void loraSendRaw(const char *data, int len);
+  void repeaterCheck(const char *in, int len);
+  void repeaterCancel(RegRec header);
+  void repeaterSendLoop();
+  void routeLearn(uint8_t addr, uint8_t hops);
+  bool routeKnown(uint8_t addr);
+  void masterRouteLearn(const char *msg, int len);
+  void masterRouteStamp(char *msg, int len);
+  bool execMsgCtrl(String sMsg);
+  bool tdmaBeacon(String sMsg);
+  bool timeBeacon(String sMsg);
+  bool tdmaCanSend(int len);
 
   // ## Variáveis
   Preferences pref;
@@ -173,16 +581,32 @@ private:
   uint8_t _lastSendId = 0;
   uint8_t _lastSendIdTele = 128;
   uint8_t _lastSendIdConf = 192;
+  uint8_t _savedIdTele = 128;
+  uint8_t _savedIdConf = 192;
   RegRec *_regRecs = nullptr;
   int _regRecsLen = 0;
   RegRec _lastRegRec = {0, 0, 0};
+  uint8_t _lastHops = 0;
 
-  uint8_t _opMode = LORA_OP_MODE_LOOP;
+  std::atomic<uint8_t> _opMode{LORA_OP_MODE_LOOP};
   uint8_t _stepNegotiation = LORA_STEP_NEG_INIC;
 
+  bool _pairPending = false;
+  bool _pairOk = false;
+  LF_LoRaTimer _tmrPairEp;
+  String _pairMsg;
+  unsigned long _pairRepeat = 0;
+  unsigned long _pairSlotLen = LORA_PAIR_SLOT_DEF;
+  uint8_t _pairRound = 0;
+  uint8_t _pairNetId = 0;
+  uint8_t _pairMasterAddr = 0;
+  uint8_t _pairMyAddr = 0;
+  uint8_t _pairChannel = LORA_CHANNEL_NONE;
+
   uint8_t _lastIdRec;
   String _lastMsg;
   int _rssi;
+  float _snr = 0;
 
   uint8_t _loraRstPin;
   uint8_t _loraSsPin;
@@ -191,41 +615,198 @@ private:
   uint8_t _loraMisoPin;
   uint8_t _loraDi00Pin;
 
+  bool _aeadEnabled = false;
+  bool _aeadDeviceOk = false;
+  LF_LoRaAead _aeadDevice;                 // Chave do dispositivo, só para derivar as de sessão
+  LF_LoRaAead _aead;                       // Chave em uso, de _aeadKeyNode
+  int _aeadKeyNode = -1;
+  AeadNodeRec _aeadNodes[LORA_AEAD_NODES] = {};
+  uint8_t _aeadNodesLen = 0;
+  uint8_t _aeadNodesNext = 0;
+  bool _aeadGroupOk = false;
+  uint8_t _aeadGroupKey[LF_LORA_AES_BLOCK] = {};
+  uint32_t _aeadGroupTx = 0;
+  uint32_t _aeadGroupTxSaved = 0;
+  LF_LoRaAeadWindow _aeadGroupRx;
+  uint32_t _aeadGroupRxSaved = 0;
+  uint32_t _aeadPairTokens[LORA_ENDPOINT_MAX + 1] = {};  // Minha contribuição, por endpoint
+  uint32_t _aeadPairMaster[LORA_ENDPOINT_MAX + 1] = {};  // Contribuição do master no 101
+  bool _aeadPairKeyed[LORA_ENDPOINT_MAX + 1] = {};
+  bool _aeadMaster = false;
+  AeadPairRec _aeadPairRecs[LORA_AEAD_PAIR_RECS] = {};
+  uint8_t _aeadPairRecsNext = 0;
+  uint32_t _aeadPairToken = 0;             // Contribuição do master na rodada
+  bool _aeadPairTokenOk = false;
+  bool _aeadReplay = false;
+  bool _aeadForeign = false;
+
+  bool _nativeEnabled = false;
+  LF_SX127xArduinoSpi _nativeSpi;
+  LF_SX127x _native;
+
+  bool _radioReady = false;
+  unsigned long _inicTime = 0;
+  unsigned long _firstTxTime = 0;
+
   long _loraFrequency = LORA_FREQ_NA;
+  long _channelPlan[LORA_CHANNEL_MAX];
+  uint8_t _channelPlanLen = 0;
+  uint8_t _channel = LORA_CHANNEL_NONE;     // Canal atribuído, gravado no "cfg"
+  uint8_t _hopIndex = 0;                    // Canal atual do gateway que varre o plano
+  unsigned long _hopDwell = 0;
   int _syncWord = LORA_SYNC_WORD_DEF;
+  uint8_t _loraSf = 7;
+  long _loraBw = 125E3;
+  uint8_t _loraCr = 5;
+
+  bool _repeaterEnabled = false;
+  FwdRec _fwdRecs[LORA_FWD_FIFO_LEN];
+  uint8_t _fwdRecsLen = 0;
+  RouteRec _routeRecs[LORA_ROUTE_LEN];
+  uint8_t _routeRecsLen = 0;
+  uint32_t _fwdCount = 0;
+  uint32_t _fwdAirtime = 0;
+  bool _masterRoutes = false;
+
+  bool _tdmaEnabled = false;
+  bool _tdmaBeaconOk = false;
+  unsigned long _tdmaBeaconTime = 0;
+  uint16_t _tdmaSuperframe = 0;
+  uint16_t _tdmaSlotLen = 0;
+  uint8_t _tdmaSlot = 0xFF;
+  uint8_t _tdmaSlots = 0;
+  uint8_t _tdmaContention = 0;
+  uint32_t _tdmaLastCycle = 0xFFFFFFFF;
+  uint32_t _tdmaCycle = 0;
+  uint32_t _tdmaOffsetCycle = 0xFFFFFFFF;
+  uint16_t _tdmaContentionOffset = 0;
+
+  unsigned long _lastRxTime = 0;
+  int _lastRxLen = 0;
+  std::atomic<uint32_t> _rxDoneTime{0};        // Marcado na interrupção do DIO0 (RxDone)
+  std::atomic<bool> _rxDoneStamped{false};
+  LF_LoRaTimeSync _timeSync;
+  LF_LoRaTimeSnap _timeSnap;
+  uint32_t _earlyDropCount = 0;
+
+  uint8_t *_capBuf = nullptr;
+  size_t _capSize = 0;
+  size_t _capHead = 0;
+  size_t _capTail = 0;
+  size_t _capUsed = 0;
+  uint16_t _capCount = 0;
+  uint32_t _capDropped = 0;
+  bool _replaying = false;
+
+  std::atomic<bool> _taskMode{false};
+  std::atomic<bool> _taskRun{false};
+  std::atomic<bool> _taskDone{false};
+  std::atomic<bool> _taskReqPairing{false};
+  LF_LoRaQueue<TaskMsg, TASK_QUEUE_LEN> _taskRxQueue;
+  LF_LoRaQueue<TaskMsg, TASK_QUEUE_LEN> _taskTxQueue;
+  uint8_t _appIdRec = 0;
+  int _appRssi = 0;
+  bool _appGroup = false;
+#if !defined(ESP32)
+  std::thread _taskThread;
+#endif
 
   uint8_t _btnPin;
   bool _btnInverted;
   bool _btnEnabled = false;
-  unsigned long _lastLedTime = 0;
-  unsigned long _lastBtnDebounceTime = 0;
-  unsigned long _lastBtnOnTime = 0;
-  unsigned long _lastBtnOffTime = 0;
-  unsigned long _lastBtnLongTime = 0;
-  bool _btnState = false;
+  LF_LoRaTimerWheel _uiWheel;
+  LF_LoRaTimer _tmrLed;
+  LF_LoRaTimer _tmrBtn;
+  LF_LoRaButton _btn;
   bool _lastBtnState = false;
-  bool _btnClick = false;
-  bool _btnLong = false;
   bool _btnClickActive = false;
   bool _btnDblClickActive = false;
   bool _btnLongActive = false;
   bool _btnCfgActive = false;
-  uint8_t _btnCounter = 0;
-  bool _lastModoOp = LORA_OP_MODE_LOOP;
+  uint8_t _lastModoOp = LORA_OP_MODE_LOOP;
+
+  bool _btnIrqEnabled = false;
+  bool _btnIsOn = false;
+  LF_LoRaQueue<BtnEdge, BTN_EDGE_QUEUE_LEN> _btnEdgeQueue;
 
   uint8_t _fiFoFirst = 0;
   uint8_t _fiFoLast = 0;
   String _fiFoMsgMsg[FIFO_LEN];
   uint8_t _fiFoId[FIFO_LEN];
+  uint8_t _fiFoDe[FIFO_LEN];
+
+  EndpointRec _endpoints[LORA_ENDPOINT_MAX];
+  uint8_t _endpointsLen = 0;
+  uint8_t _endpointNext = 0;
+  LF_LoRaTimer _tmrEpTx;
+  uint8_t _rxEp = 0;
+  uint8_t _appEp = 0;
 
   uint8_t _internalMsgStatus = INT_STATUS_EMPTY;
   uint8_t _internalLastMsgStatus = INT_STATUS_EMPTY;
   uint8_t _internalMsgId;
   String _internalMsg;
+  uint16_t _internalFullLen = 0;          // Estado completo que _internalMsg (delta) substitui
+  unsigned long _internalMsgTime = 0;
+  String _internalSentMsg;
+
+  bool _deltaEnabled = false;
+  bool _deltaBaseOk = false;
+  bool _deltaResync = false;
+  String _deltaBase;
+  uint8_t _deltaBaseId = 0;
+  uint8_t _deltaCount = 0;
+  uint8_t _deltaFullEvery = LORA_DELTA_FULL_EVERY;
+  uint32_t _deltaBytesSaved = 0;
+
+  bool _reportEnabled = false;
+  LF_LoRaReport _report;
+
+  LF_LoRaOtaRx _otaRx;
+  LF_LoRaOtaTx _otaTx;
+  uint8_t _otaPara = LORA_ADDR_BROADCAST;
+  uint8_t _otaSession = 0;
+  bool _otaRepPending = false;
+  bool _otaWindow = false;
+
+  uint8_t _groups[LORA_ENDPOINT_MAX + 1][LORA_GROUP_MAX] = {};     // 0 é livre
+  uint8_t _pairGroups[LORA_ENDPOINT_MAX + 1][LORA_GROUP_MAX] = {};
+  GroupDupRec _groupDup[LORA_GROUP_DUP_RECS] = {};
+  uint8_t _groupDupNext = 0;
+  uint8_t _groupResp = LORA_GROUP_RESP_STAGGER;
+  uint16_t _groupRespSlot = LORA_GROUP_RESP_SLOT;
+  bool _groupRxOn = false;
+  uint8_t _groupRxId = 0;
+  bool _fiFoGroup[FIFO_LEN] = {};
+
+  LF_LoRaStore _store;
+  bool _storeEnabled = false;
+  bool _masterLost = false;
+  bool _storeWaitAck = false;
+  uint8_t _storeMiss = 0;
+  uint8_t _storeId = 0;
+  uint32_t _storeEndSeq = 0;
+  unsigned long _storeBackoff = 0;
+  unsigned long _storeLostTime = 0;
+  unsigned long _storeRecoveryTime = 0;
+
+  LF_LoRaAnalyzer _analyzer;
+  bool _analyzerEnabled = false;
+  uint32_t _analyzerPeriod = LORA_ANALYZER_PERIOD;
+  Print *_analyzerOut = nullptr;
 
-  unsigned long _lastMsgTime = 0;
   unsigned long _msgSendIntervalBase = LORA_MSG_SEND_INTERVAL;
-  unsigned long _msgSendInterval = LORA_MSG_SEND_INTERVAL;
+
+  LF_LoRaTimerWheel _wheel;
+  LF_LoRaTimer _tmrSend;
+  LF_LoRaTimer _tmrPair;
+  LF_LoRaTimer _tmrRadio;
+  LF_LoRaTimer _tmrHop;
+  LF_LoRaTimer _tmrOtaTx;
+  LF_LoRaTimer _tmrOtaRep;
+  LF_LoRaTimer _tmrGroupResp;
+  LF_LoRaTimer _tmrStore;
+  LF_LoRaTimer _tmrAnalyzer;
 
 };
 
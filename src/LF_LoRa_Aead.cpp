@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#include "LF_LoRa_Aead.h"
+
+#include <string.h>
+
+#if !defined(LF_LORA_AEAD_HW)
+// Tabela S-box do AES (FIPS-197)
+static const uint8_t sbox[256] = {
+  0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+  0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+  0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+  0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+  0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+  0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+  0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+  0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+  0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+  0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+  0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+  0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+  0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+  0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+  0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+  0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
+};
+
+static inline uint8_t xtime(uint8_t x) {
+  return (uint8_t)((x << 1) ^ ((x & 0x80) ? 0x1b : 0x00));
+}
+#endif
+
+/* -------------------------------------------------------------------------- */
+LF_LoRaAead::LF_LoRaAead()
+{
+#if defined(LF_LORA_AEAD_HW)
+  mbedtls_aes_init(&_ctx);
+#endif
+}
+
+/* -------------------------------------------------------------------------- */
+LF_LoRaAead::~LF_LoRaAead()
+{
+#if defined(LF_LORA_AEAD_HW)
+  mbedtls_aes_free(&_ctx);
+#endif
+}
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaAead::setKey(const uint8_t *key) {
+
+#if defined(LF_LORA_AEAD_HW)
+  mbedtls_aes_setkey_enc(&_ctx, key, 128);
+#else
+  // Expansão da chave AES-128 (11 chaves de rodada)
+  static const uint8_t rcon[10] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36};
+  memcpy(_roundKey, key, 16);
+  for (int i = 4; i < 44; i++) {
+    uint8_t t[4];
+    memcpy(t, &_roundKey[(i - 1) * 4], 4);
+    if (i % 4 == 0) {
+      uint8_t u = t[0];
+      t[0] = sbox[t[1]] ^ rcon[i / 4 - 1];
+      t[1] = sbox[t[2]];
+      t[2] = sbox[t[3]];
+      t[3] = sbox[u];
+    }
+    for (int j = 0; j < 4; j++) {
+      _roundKey[i * 4 + j] = _roundKey[(i - 4) * 4 + j] ^ t[j];
+    }
+  }
+#endif
+
+  cmacSubkeys();
+
+} /* setKey */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaAead::encryptBlock(const uint8_t *in, uint8_t *out) {
+
+#if defined(LF_LORA_AEAD_HW)
+  mbedtls_aes_crypt_ecb(&_ctx, MBEDTLS_AES_ENCRYPT, in, out);
+#else
+  uint8_t s[16];
+  for (int i = 0; i < 16; i++) {
+    s[i] = in[i] ^ _roundKey[i];
+  }
+  for (int round = 1; round <= 10; round++) {
+    // SubBytes + ShiftRows
+    uint8_t t[16];
+    for (int c = 0; c < 4; c++) {
+      for (int r = 0; r < 4; r++) {
+        t[c * 4 + r] = sbox[s[((c + r) % 4) * 4 + r]];
+      }
+    }
+    // MixColumns (exceto na última rodada)
+    if (round < 10) {
+      for (int c = 0; c < 4; c++) {
+        uint8_t *col = &t[c * 4];
+        uint8_t a = col[0] ^ col[1] ^ col[2] ^ col[3];
+        uint8_t c0 = col[0];
+        col[0] ^= a ^ xtime(col[0] ^ col[1]);
+        col[1] ^= a ^ xtime(col[1] ^ col[2]);
+        col[2] ^= a ^ xtime(col[2] ^ col[3]);
+        col[3] ^= a ^ xtime(col[3] ^ c0);
+      }
+    }
+    // AddRoundKey
+    for (int i = 0; i < 16; i++) {
+      s[i] = t[i] ^ _roundKey[round * 16 + i];
+    }
+  }
+  memcpy(out, s, 16);
+#endif
+
+} /* encryptBlock */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaAead::cmacSubkeys() {
+
+  // Subchaves K1 e K2 do CMAC (RFC 4493)
+  uint8_t l[LF_LORA_AES_BLOCK];
+  memset(l, 0, sizeof(l));
+  encryptBlock(l, l);
+  for (int i = 0; i < 16; i++) {
+    _k1[i] = (l[i] << 1) | ((i < 15) ? (l[i + 1] >> 7) : 0);
+  }
+  if (l[0] & 0x80) _k1[15] ^= 0x87;
+  for (int i = 0; i < 16; i++) {
+    _k2[i] = (_k1[i] << 1) | ((i < 15) ? (_k1[i + 1] >> 7) : 0);
+  }
+  if (_k1[0] & 0x80) _k2[15] ^= 0x87;
+
+} /* cmacSubkeys */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaAead::crypt(const uint8_t *nonce, uint8_t *data, int len) {
+
+  // CTR: o contador ocupa os 2 últimos bytes do bloco do nonce
+  uint8_t ctr[LF_LORA_AES_BLOCK];
+  uint8_t ks[LF_LORA_AES_BLOCK];
+  memcpy(ctr, nonce, LF_LORA_AES_BLOCK);
+  uint16_t n = 0;
+  for (int i = 0; i < len; i += LF_LORA_AES_BLOCK) {
+    ctr[14] = n >> 8;
+    ctr[15] = n & 0xFF;
+    n++;
+    encryptBlock(ctr, ks);
+    int m = len - i;
+    if (m > LF_LORA_AES_BLOCK) m = LF_LORA_AES_BLOCK;
+    for (int j = 0; j < m; j++) {
+      data[i + j] ^= ks[j];
+    }
+  }
+
+} /* crypt */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaAead::mac(const uint8_t *nonce, const uint8_t *data, int len, uint8_t *tag) {
+
+  // CMAC sobre nonce || data, o nonce ocupa o primeiro bloco inteiro
+  uint8_t x[LF_LORA_AES_BLOCK];
+  memcpy(x, nonce, LF_LORA_AES_BLOCK);
+  if (len == 0) {
+    // O bloco do nonce é o último, completo
+    for (int i = 0; i < LF_LORA_AES_BLOCK; i++) x[i] ^= _k1[i];
+    encryptBlock(x, x);
+    memcpy(tag, x, LF_LORA_AEAD_TAG_LEN);
+    return;
+  }
+  encryptBlock(x, x);
+  int i = 0;
+  while (len - i > LF_LORA_AES_BLOCK) {
+    for (int j = 0; j < LF_LORA_AES_BLOCK; j++) x[j] ^= data[i + j];
+    encryptBlock(x, x);
+    i += LF_LORA_AES_BLOCK;
+  }
+  // Último bloco, completo (K1) ou com preenchimento 10..0 (K2)
+  int m = len - i;
+  for (int j = 0; j < m; j++) x[j] ^= data[i + j];
+  if (m == LF_LORA_AES_BLOCK) {
+    for (int j = 0; j < LF_LORA_AES_BLOCK; j++) x[j] ^= _k1[j];
+  } else {
+    x[m] ^= 0x80;
+    for (int j = 0; j < LF_LORA_AES_BLOCK; j++) x[j] ^= _k2[j];
+  }
+  encryptBlock(x, x);
+  memcpy(tag, x, LF_LORA_AEAD_TAG_LEN);
+
+} /* mac */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaAeadWindow::reset(uint32_t counter) {
+  // Tudo até counter conta como já aceito
+  _last = counter;
+  _seen = 0xFFFFFFFF;
+} /* reset */
+
+/* -------------------------------------------------------------------------- */
+uint32_t LF_LoRaAeadWindow::expand(uint16_t low) const {
+  // O contador mais próximo do último aceito com esses 16 bits baixos. Vale
+  // enquanto o remetente não se adiantar 32768 quadros ou mais; fora disso a
+  // tag não confere e só um novo pareamento resolve
+  return _last + (int16_t)(low - (uint16_t)_last);
+} /* expand */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaAeadWindow::check(uint32_t counter) {
+
+  // Aceito contador maior que o último aceito, ou um dos anteriores dentro
+  // da janela ainda não visto (o repetidor pode inverter a ordem)
+  if (counter > _last) {
+    uint32_t shift = counter - _last;
+    _seen = ((shift >= LF_LORA_AEAD_WINDOW) ? 0 : (_seen << shift)) | 1;
+    _last = counter;
+    return true;
+  }
+  uint32_t age = _last - counter;
+  if ((age >= LF_LORA_AEAD_WINDOW) || (_seen & ((uint32_t)1 << age))) return false;
+  _seen |= (uint32_t)1 << age;
+  return true;
+
+} /* check */
+
+/* -------------------------------------------------------------------------- */
+uint32_t LF_LoRaAeadWindow::last() const {
+  return _last;
+} /* last */
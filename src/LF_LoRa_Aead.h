@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef	LF_LORA_AEAD_H
+#define	LF_LORA_AEAD_H
+
+#include <stdint.h>
+
+// No ESP32 uso o AES do mbedtls, que usa o hardware.
+// Definindo LF_LORA_AEAD_SOFT, usa a implementação em software.
+#if defined(ESP32) && !defined(LF_LORA_AEAD_SOFT)
+#define LF_LORA_AEAD_HW
+#include "mbedtls/aes.h"
+#endif
+
+#define LF_LORA_AES_BLOCK           16
+#define LF_LORA_AEAD_CTR_LEN         2   // Bytes do contador no quadro individual (16 bits baixos)
+#define LF_LORA_AEAD_CTR_LEN_GROUP   4   // Contador inteiro no quadro de grupo e difusão
+#define LF_LORA_AEAD_TAG_LEN         4   // Bytes da tag (CMAC truncado)
+#define LF_LORA_AEAD_OVERHEAD       (LF_LORA_AEAD_CTR_LEN + LF_LORA_AEAD_TAG_LEN)
+#define LF_LORA_AEAD_OVERHEAD_GROUP (LF_LORA_AEAD_CTR_LEN_GROUP + LF_LORA_AEAD_TAG_LEN)
+#define LF_LORA_AEAD_WINDOW         32   // Contadores anteriores ao último aceitos fora de ordem
+
+// AES-128 em modo CTR para cifrar e AES-CMAC truncado para autenticar
+class LF_LoRaAead {
+
+public:
+
+  LF_LoRaAead();
+  ~LF_LoRaAead();
+
+  void setKey(const uint8_t *key);
+  void encryptBlock(const uint8_t *in, uint8_t *out);
+  void crypt(const uint8_t *nonce, uint8_t *data, int len);
+  void mac(const uint8_t *nonce, const uint8_t *data, int len, uint8_t *tag);
+
+private:
+
+  void cmacSubkeys();
+
+#if defined(LF_LORA_AEAD_HW)
+  mbedtls_aes_context _ctx;
+#else
+  uint8_t _roundKey[176];
+#endif
+  uint8_t _k1[LF_LORA_AES_BLOCK];
+  uint8_t _k2[LF_LORA_AES_BLOCK];
+
+};
+
+// Contadores aceitos de um remetente, contra repetição. Reconstrói o
+// contador de 32 bits a partir dos 16 bits baixos enviados no quadro
+class LF_LoRaAeadWindow {
+
+public:
+
+  void reset(uint32_t counter);
+  uint32_t expand(uint16_t low) const;
+  bool check(uint32_t counter);
+  uint32_t last() const;
+
+private:
+
+  uint32_t _last = 0;
+  uint32_t _seen = 0xFFFFFFFF;   // Bit n: _last - n já aceito
+
+};
+
+#endif
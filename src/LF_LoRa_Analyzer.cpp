@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#include "LF_LoRa_Analyzer.h"
+#include "LF_LoRa_Fmt.h"
+
+#include <string.h>
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaAnalyzer::frame(const char *data, int len, int rssi, uint32_t airtime, uint32_t now) {
+
+  // Todo quadro ocupa o canal, mesmo o que não entendo
+  _frames++;
+  _airtime += airtime;
+
+  uint32_t net, de, para, id;
+  if ((len < 12) ||
+      (LF_LoRaFmt::parseHex(data + 0, 2, net) != 2) || (LF_LoRaFmt::parseHex(data + 2, 2, de) != 2) ||
+      (LF_LoRaFmt::parseHex(data + 4, 2, para) != 2) || (LF_LoRaFmt::parseHex(data + 6, 2, id) != 2)) {
+    _invalid++;
+    return false;
+  }
+
+  LF_LoRaSenderStats *s = senderFind(net, de, now);
+
+  // Mesmo (para, id) ouvido há pouco: retransmissão do repetidor ou eco
+  bool dup = false;
+  for (uint8_t i = 0; i < LF_LORA_ANALYZER_IDS; i++) {
+    if ((s->frames > 0) && (s->ids[i][0] == para) && (s->ids[i][1] == id)) dup = true;
+  }
+  if (dup) {
+    s->dups++;
+  } else {
+    s->ids[s->idsNext][0] = para;
+    s->ids[s->idsNext][1] = id;
+    s->idsNext = (s->idsNext + 1) % LF_LORA_ANALYZER_IDS;
+    // Confirmação nova (não é ack de outra) com a anterior ainda sem ack: o escravo reenviou
+    if (!ackSeen(net, de, para, id) && (id > 191)) {
+      if (s->confPending) s->retx++;
+      s->confPending = true;
+      s->confPara = para;
+      s->confId = id;
+    }
+  }
+
+  if (s->frames > 0) {
+    uint32_t gap = now - s->lastTime;
+    if ((s->gaps == 0) || (gap < s->gapMin)) s->gapMin = gap;
+    if (gap > s->gapMax) s->gapMax = gap;
+    s->gapSum += gap;
+    s->gaps++;
+  }
+  s->lastTime = now;
+
+  if ((s->frames == 0) || (rssi < s->rssiMin)) s->rssiMin = rssi;
+  if ((s->frames == 0) || (rssi > s->rssiMax)) s->rssiMax = rssi;
+  s->rssiSum += rssi;
+  int bin = (rssi < LF_LORA_ANALYZER_RSSI_MIN) ? 0 : (rssi - LF_LORA_ANALYZER_RSSI_MIN) / LF_LORA_ANALYZER_RSSI_STEP;
+  if (bin >= LF_LORA_ANALYZER_RSSI_BINS) bin = LF_LORA_ANALYZER_RSSI_BINS - 1;
+  s->rssiHist[bin]++;
+
+  s->frames++;
+  s->bytes += len;
+  s->airtime += airtime;
+  return true;
+
+} /* frame */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaAnalyzer::ackSeen(uint8_t net, uint8_t de, uint8_t para, uint8_t id) {
+
+  // Resposta com o ID da confirmação pendente do destino
+  bool ack = false;
+  for (uint8_t i = 0; i < LF_LORA_ANALYZER_SENDERS; i++) {
+    LF_LoRaSenderStats &s = _senders[i];
+    if (s.used && (s.net == net) && (s.de == para) && s.confPending && (s.confPara == de) && (s.confId == id)) {
+      s.confPending = false;
+      ack = true;
+    }
+  }
+  return ack;
+
+} /* ackSeen */
+
+/* -------------------------------------------------------------------------- */
+LF_LoRaSenderStats *LF_LoRaAnalyzer::senderFind(uint8_t net, uint8_t de, uint32_t now) {
+
+  int slot = -1;
+  int quiet = 0;
+  for (uint8_t i = 0; i < LF_LORA_ANALYZER_SENDERS; i++) {
+    LF_LoRaSenderStats &s = _senders[i];
+    if (!s.used) {
+      if (slot == -1) slot = i;
+      continue;
+    }
+    if ((s.net == net) && (s.de == de)) return &s;
+    LF_LoRaSenderStats &q = _senders[quiet];
+    if ((s.airtime < q.airtime) || ((s.airtime == q.airtime) && ((now - s.lastTime) > (now - q.lastTime)))) quiet = i;
+  }
+
+  // Tabela cheia, troco o mais silencioso (menos tempo no ar), que pesa
+  // menos na ocupação do canal
+  if (slot == -1) {
+    slot = quiet;
+    _evicted++;
+  }
+  LF_LoRaSenderStats &s = _senders[slot];
+  memset(&s, 0, sizeof(s));
+  s.used = true;
+  s.net = net;
+  s.de = de;
+  return &s;
+
+} /* senderFind */
+
+/* -------------------------------------------------------------------------- */
+size_t LF_LoRaAnalyzer::summary(Print &out, uint32_t now) {
+
+  // #AN#segundos#quadros#tempo no ar (ms)#ocupação (por mil)#inválidos#remetentes#trocados
+  // #AS#rede#remetente#quadros#bytes#tempo no ar#ocupação#RSSI médio#mín#máx#
+  //    duplicadas (por mil)#reenvios (por mil)#intervalo médio#mín#máx (ms)#histograma RSSI...
+  // Remetentes do mais ruidoso (mais tempo no ar) para o menos
+  char buf[LF_LORA_ANALYZER_LINE_LEN];
+  size_t n = 0;
+
+  LF_LoRaLine line(buf, sizeof(buf));
+  line.addStr("AN").addInt((now - _start) / 1000).addInt(_frames).addInt(_airtime)
+      .addInt(utilization(now)).addInt(_invalid).addInt(senderCount()).addInt(_evicted);
+  n += out.write((const uint8_t *)line.c_str(), line.length());
+  n += out.write('\n');
+
+  bool done[LF_LORA_ANALYZER_SENDERS] = {};
+  uint32_t elapsed = now - _start;
+  while (true) {
+    int best = -1;
+    for (uint8_t i = 0; i < LF_LORA_ANALYZER_SENDERS; i++) {
+      if (!_senders[i].used || done[i]) continue;
+      if ((best == -1) || (_senders[i].airtime > _senders[best].airtime)) best = i;
+    }
+    if (best == -1) break;
+    done[best] = true;
+
+    LF_LoRaSenderStats &s = _senders[best];
+    line.clear();
+    line.addStr("AS").addHex(s.net, 2).addHex(s.de, 2).addInt(s.frames).addInt(s.bytes).addInt(s.airtime)
+        .addInt((elapsed > 0) ? (uint64_t)s.airtime * 1000 / elapsed : 0)
+        .addInt(s.rssiSum / (int32_t)s.frames).addInt(s.rssiMin).addInt(s.rssiMax)
+        .addInt((uint64_t)s.dups * 1000 / s.frames).addInt((uint64_t)s.retx * 1000 / s.frames)
+        .addInt((s.gaps > 0) ? s.gapSum / s.gaps : 0).addInt(s.gapMin).addInt(s.gapMax);
+    for (uint8_t b = 0; b < LF_LORA_ANALYZER_RSSI_BINS; b++) {
+      line.addInt(s.rssiHist[b]);
+    }
+    n += out.write((const uint8_t *)line.c_str(), line.length());
+    n += out.write('\n');
+  }
+
+  return n;
+
+} /* summary */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaAnalyzer::reset(uint32_t now) {
+  memset(_senders, 0, sizeof(_senders));
+  _start = now;
+  _frames = 0;
+  _invalid = 0;
+  _airtime = 0;
+  _evicted = 0;
+} /* reset */
+
+/* -------------------------------------------------------------------------- */
+uint8_t LF_LoRaAnalyzer::senderCount() {
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < LF_LORA_ANALYZER_SENDERS; i++) {
+    if (_senders[i].used) n++;
+  }
+  return n;
+} /* senderCount */
+
+/* -------------------------------------------------------------------------- */
+LF_LoRaSenderStats *LF_LoRaAnalyzer::sender(uint8_t i) {
+  // i-ésimo remetente em uso, nullptr depois do último
+  for (uint8_t k = 0; k < LF_LORA_ANALYZER_SENDERS; k++) {
+    if (!_senders[k].used) continue;
+    if (i == 0) return &_senders[k];
+    i--;
+  }
+  return nullptr;
+} /* sender */
+
+/* -------------------------------------------------------------------------- */
+uint32_t LF_LoRaAnalyzer::frames() {
+  return _frames;
+} /* frames */
+
+/* -------------------------------------------------------------------------- */
+uint32_t LF_LoRaAnalyzer::invalid() {
+  return _invalid;
+} /* invalid */
+
+/* -------------------------------------------------------------------------- */
+uint32_t LF_LoRaAnalyzer::airtime() {
+  return _airtime;
+} /* airtime */
+
+/* -------------------------------------------------------------------------- */
+uint32_t LF_LoRaAnalyzer::utilization(uint32_t now) {
+  // Ocupação do canal (por mil) desde o último reset
+  uint32_t elapsed = now - _start;
+  if (elapsed == 0) return 0;
+  return (uint64_t)_airtime * 1000 / elapsed;
+} /* utilization */
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef	LF_LORA_ANALYZER_H
+#define	LF_LORA_ANALYZER_H
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#define LF_LORA_ANALYZER_SENDERS    16     // Remetentes na tabela, cheia troca o mais silencioso
+#define LF_LORA_ANALYZER_IDS         4     // IDs recentes por remetente (duplicadas)
+#define LF_LORA_ANALYZER_RSSI_BINS   8     // Faixas do histograma de RSSI
+#define LF_LORA_ANALYZER_RSSI_MIN -130     // Início da primeira faixa (dBm)
+#define LF_LORA_ANALYZER_RSSI_STEP  10     // Largura de cada faixa (dB)
+#define LF_LORA_ANALYZER_LINE_LEN  160
+
+struct LF_LoRaSenderStats {
+  bool used;
+  uint8_t net;
+  uint8_t de;
+  uint32_t frames;
+  uint32_t bytes;
+  uint32_t airtime;                       // ms
+  uint32_t dups;                          // Mesmo (de, para, id) de novo
+  uint32_t retx;                          // Nova confirmação sem ack da anterior
+  int16_t rssiMin;
+  int16_t rssiMax;
+  int32_t rssiSum;
+  uint16_t rssiHist[LF_LORA_ANALYZER_RSSI_BINS];
+  uint32_t lastTime;
+  uint32_t gapMin;                        // Intervalo entre quadros (ms)
+  uint32_t gapMax;
+  uint32_t gapSum;
+  uint32_t gaps;
+  uint8_t ids[LF_LORA_ANALYZER_IDS][2];   // (para, id) recentes
+  uint8_t idsNext;
+  bool confPending;                       // Confirmação sem ack visto
+  uint8_t confPara;
+  uint8_t confId;
+};
+
+// Estatísticas do canal a partir dos cabeçalhos "NNDDPPIILLLL" de todos os
+// quadros ouvidos, sem filtro de rede ou endereço.
+// Não usa millis(), recebe o tempo para poder ser testado fora da placa.
+class LF_LoRaAnalyzer {
+
+public:
+
+  bool frame(const char *data, int len, int rssi, uint32_t airtime, uint32_t now);
+  size_t summary(Print &out, uint32_t now);
+  void reset(uint32_t now);
+  uint8_t senderCount();
+  LF_LoRaSenderStats *sender(uint8_t i);
+  uint32_t frames();
+  uint32_t invalid();
+  uint32_t airtime();
+  uint32_t utilization(uint32_t now);
+
+private:
+
+  LF_LoRaSenderStats *senderFind(uint8_t net, uint8_t de, uint32_t now);
+  bool ackSeen(uint8_t net, uint8_t de, uint8_t para, uint8_t id);
+
+  LF_LoRaSenderStats _senders[LF_LORA_ANALYZER_SENDERS] = {};
+  uint32_t _start = 0;
+  uint32_t _frames = 0;
+  uint32_t _invalid = 0;
+  uint32_t _airtime = 0;
+  uint32_t _evicted = 0;
+
+};
+
+#endif
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#include "LF_LoRa_Button.h"
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaButton::edge(bool pressed, unsigned long now) {
+
+  // Confirmo a borda anterior se ficou estável até agora
+  debounce(now);
+
+  _raw = pressed;
+  _rawTime = now;
+
+} /* edge */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaButton::debounce(unsigned long now) {
+  // Nível precisa ficar estável BTN_DEBOUNCE_TIME para valer
+  if ((_raw != _state) && (now - _rawTime >= BTN_DEBOUNCE_TIME)) {
+    stable(_raw, _rawTime);
+  }
+} /* debounce */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaButton::stable(bool pressed, unsigned long time) {
+
+  _state = pressed;
+
+  if (pressed) {
+    _counter++;
+    _click = true;
+    _long = false;
+    _onTime = time;
+  } else {
+    // Apertado mais que BTN_ON_TIME não é clique, até BTN_LONG_TIME é longo
+    unsigned long held = time - _onTime;
+    if (held >= BTN_ON_TIME) {
+      _click = false;
+      _long = (held < BTN_LONG_TIME);
+    }
+    _on = false;
+    _offTime = time;
+  }
+
+} /* stable */
+
+/* -------------------------------------------------------------------------- */
+uint8_t LF_LoRaButton::update(unsigned long now) {
+
+  debounce(now);
+
+  if (_state) {
+    _on = (now - _onTime >= BTN_ON_TIME);
+    return BTN_EVT_NONE;
+  }
+
+  if (_counter == 0) return BTN_EVT_NONE;
+  if (now - _offTime < BTN_OFF_TIME) return BTN_EVT_NONE;
+
+  // Terminou a sequência de cliques
+  uint8_t evt = BTN_EVT_NONE;
+  if (_click) {
+    if (_counter == 1) {
+      evt = BTN_EVT_CLICK;
+    } else if (_counter == 2) {
+      evt = BTN_EVT_DBL_CLICK;
+    } else if (_counter >= BTN_CFG_CLICKS) {
+      evt = BTN_EVT_CFG;
+    }
+  } else if (_long) {
+    evt = BTN_EVT_LONG;
+  }
+  _click = false;
+  _long = false;
+  _counter = 0;
+
+  return evt;
+
+} /* update */
+
+/* -------------------------------------------------------------------------- */
+uint32_t LF_LoRaButton::nextDeadline(unsigned long now) {
+
+  // Tempo até update() poder mudar alguma coisa sem nova borda
+  unsigned long wait;
+  if (_raw != _state) {
+    wait = BTN_DEBOUNCE_TIME - (now - _rawTime);
+    if (now - _rawTime >= BTN_DEBOUNCE_TIME) wait = 0;
+  } else if (_state && !_on) {
+    wait = BTN_ON_TIME - (now - _onTime);
+    if (now - _onTime >= BTN_ON_TIME) wait = 0;
+  } else if (!_state && (_counter > 0)) {
+    wait = BTN_OFF_TIME - (now - _offTime);
+    if (now - _offTime >= BTN_OFF_TIME) wait = 0;
+  } else {
+    return BTN_NO_DEADLINE;
+  }
+  return wait;
+
+} /* nextDeadline */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaButton::isOn() {
+  return _on;
+} /* isOn */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaButton::idle() {
+  return !_state && (_raw == _state) && (_counter == 0);
+} /* idle */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaButton::reset() {
+  _raw = false;
+  _state = false;
+  _on = false;
+  _click = false;
+  _long = false;
+  _counter = 0;
+} /* reset */
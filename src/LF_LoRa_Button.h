@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef	LF_LORA_BUTTON_H
+#define	LF_LORA_BUTTON_H
+
+#include <stdint.h>
+
+#define BTN_DEBOUNCE_TIME      20
+#define BTN_ON_TIME          1000
+#define BTN_OFF_TIME          400
+#define BTN_LONG_TIME        3000
+#define BTN_CFG_CLICKS          5   // Cliques para entrar no pareamento
+#define BTN_NO_DEADLINE  0xFFFFFFFF   // Parado, nada a avaliar
+
+// Eventos do botão
+#define BTN_EVT_NONE            0
+#define BTN_EVT_CLICK           1
+#define BTN_EVT_DBL_CLICK       2
+#define BTN_EVT_LONG            3
+#define BTN_EVT_CFG             4
+
+// Borda bruta do botão, como lida na interrupção
+struct BtnEdge {
+  bool pressed;
+  unsigned long time;
+};
+
+// Reconhece clique, duplo clique, clique longo e os cliques de pareamento
+// a partir das bordas do botão. Não acessa o hardware nem millis(), recebe
+// as bordas e o tempo, para poder ser testado fora da placa.
+class LF_LoRaButton {
+
+public:
+
+  void edge(bool pressed, unsigned long now);
+  uint8_t update(unsigned long now);
+  uint32_t nextDeadline(unsigned long now);
+  bool isOn();
+  bool idle();
+  void reset();
+
+private:
+
+  void debounce(unsigned long now);
+  void stable(bool pressed, unsigned long time);
+
+  bool _raw = false;
+  unsigned long _rawTime = 0;
+  bool _state = false;
+  bool _on = false;
+  unsigned long _onTime = 0;
+  unsigned long _offTime = 0;
+  bool _click = false;
+  bool _long = false;
+  uint8_t _counter = 0;
+
+};
+
+#endif
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#include "LF_LoRa_Cmd.h"
+#include "LF_LoRa_Fmt.h"
+
+static inline char upper(char c) {
+  return ((c >= 'a') && (c <= 'z')) ? c - 'a' + 'A' : c;
+} /* upper */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaToken::equals(const char *s) const {
+  uint16_t i = 0;
+  for (; i < len; i++) {
+    // Paro no '\0' de s mesmo que o token tenha um '\0' no meio
+    if ((s[i] == 0) || (s[i] != ptr[i])) return false;
+  }
+  return s[i] == 0;
+} /* equals */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaToken::equalsIgnoreCase(const char *s) const {
+  uint16_t i = 0;
+  for (; i < len; i++) {
+    if ((s[i] == 0) || (upper(s[i]) != upper(ptr[i]))) return false;
+  }
+  return s[i] == 0;
+} /* equalsIgnoreCase */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaToken::isDigits() const {
+  if (len == 0) return false;
+  for (uint16_t i = 0; i < len; i++) {
+    if ((ptr[i] < '0') || (ptr[i] > '9')) return false;
+  }
+  return true;
+} /* isDigits */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaToken::isHex() const {
+  if (len == 0) return false;
+  uint32_t v;
+  for (uint16_t i = 0; i < len; i++) {
+    if (LF_LoRaFmt::parseHex(ptr + i, 1, v) == 0) return false;
+  }
+  return true;
+} /* isHex */
+
+/* -------------------------------------------------------------------------- */
+LF_LoRaToken LF_LoRaToken::sub(uint16_t pos, uint16_t n) const {
+  if (pos > len) pos = len;
+  if (n > len - pos) n = len - pos;
+  return {ptr + pos, n};
+} /* sub */
+
+/* -------------------------------------------------------------------------- */
+int32_t LF_LoRaToken::toInt() const {
+  int32_t v = 0;
+  if (LF_LoRaFmt::parseInt(ptr, len, v) == 0) return 0;
+  return v;
+} /* toInt */
+
+/* -------------------------------------------------------------------------- */
+float LF_LoRaToken::toFloat() const {
+  float v = 0;
+  if (LF_LoRaFmt::parseFloat(ptr, len, v) == 0) return 0;
+  return v;
+} /* toFloat */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaCmd::parse(const char *buf, int len, char delimiter) {
+
+  _count = 0;
+  _spec = nullptr;
+  _argCount = 0;
+  if ((len < 0) || (len > 0xFFFF)) return false;
+
+  int start = 0;
+  for (int i = 0; i <= len; i++) {
+    if ((i == len) || (buf[i] == delimiter)) {
+      if (_count >= LF_LORA_CMD_MAX_TOKENS) {
+        _count = 0;
+        return false; // Tokens demais
+      }
+      _tok[_count].ptr = buf + start;
+      _tok[_count].len = i - start;
+      _count++;
+      start = i + 1;
+    }
+  }
+  return true;
+
+} /* parse */
+
+/* -------------------------------------------------------------------------- */
+uint8_t LF_LoRaCmd::count() {
+  return _count;
+} /* count */
+
+/* -------------------------------------------------------------------------- */
+LF_LoRaToken LF_LoRaCmd::token(uint8_t i) {
+  if (i >= _count) return {"", 0};
+  return _tok[i];
+} /* token */
+
+/* -------------------------------------------------------------------------- */
+uint8_t LF_LoRaCmd::width(const LF_LoRaCmdSpec &spec, uint8_t i) {
+  return spec.width[(i < LF_LORA_CMD_WIDTHS) ? i : LF_LORA_CMD_WIDTHS - 1];
+} /* width */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaCmd::matchSpec(const LF_LoRaCmdSpec &spec, uint8_t cmdIdx) {
+
+  LF_LoRaToken t = _tok[cmdIdx];
+  uint16_t codeLen = 0;
+  while (spec.code[codeLen]) codeLen++;
+
+  if (spec.packed) {
+    // Código seguido dos args com largura fixa, a última pode ser livre
+    if ((t.len < codeLen) || !t.sub(0, codeLen).equals(spec.code)) return false;
+    if (_count != cmdIdx + 1) return false;
+    uint16_t pos = codeLen;
+    for (uint8_t i = 0; i < spec.maxArgs; i++) {
+      uint8_t w = width(spec, i);
+      if (w == 0) {
+        if (i != spec.maxArgs - 1) return false;
+        w = t.len - pos;
+      }
+      if (pos + w > t.len) return false;
+      if ((i < 8) && (spec.digits & (1 << i)) && !t.sub(pos, w).isDigits()) return false;
+      pos += w;
+    }
+    if (pos != t.len) return false;
+    _argCount = spec.maxArgs;
+    return true;
+  }
+
+  if (!t.equals(spec.code)) return false;
+  uint8_t n = _count - cmdIdx - 1;
+  if (n < spec.minArgs) return false;
+  if ((spec.maxArgs != LF_LORA_CMD_ANY) && (n > spec.maxArgs)) return false;
+  for (uint8_t i = 0; i < n; i++) {
+    LF_LoRaToken a = _tok[cmdIdx + 1 + i];
+    uint8_t w = width(spec, i);
+    if ((w != 0) && (a.len != w)) return false;
+    if ((i < 8) && (spec.digits & (1 << i)) && !a.isDigits()) return false;
+  }
+  _argCount = n;
+  return true;
+
+} /* matchSpec */
+
+/* -------------------------------------------------------------------------- */
+const LF_LoRaCmdSpec *LF_LoRaCmd::match(const LF_LoRaCmdSpec *table, uint8_t tableLen, uint8_t cmdIdx) {
+
+  // Procura o comando do token cmdIdx na tabela e valida os args
+  _spec = nullptr;
+  _argCount = 0;
+  if (cmdIdx >= _count) return nullptr;
+  for (uint8_t i = 0; i < tableLen; i++) {
+    if (matchSpec(table[i], cmdIdx)) {
+      _spec = &table[i];
+      _cmdIdx = cmdIdx;
+      return _spec;
+    }
+  }
+  _argCount = 0;
+  return nullptr;
+
+} /* match */
+
+/* -------------------------------------------------------------------------- */
+uint8_t LF_LoRaCmd::argCount() {
+  return _argCount;
+} /* argCount */
+
+/* -------------------------------------------------------------------------- */
+LF_LoRaToken LF_LoRaCmd::arg(uint8_t i) {
+
+  if ((_spec == nullptr) || (i >= _argCount)) return {"", 0};
+  if (!_spec->packed) return _tok[_cmdIdx + 1 + i];
+
+  LF_LoRaToken t = _tok[_cmdIdx];
+  uint16_t pos = 0;
+  while (_spec->code[pos]) pos++;
+  for (uint8_t k = 0; k < i; k++) {
+    pos += width(*_spec, k);
+  }
+  uint8_t w = width(*_spec, i);
+  return t.sub(pos, (w == 0) ? t.len - pos : w);
+
+} /* arg */
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef	LF_LORA_CMD_H
+#define	LF_LORA_CMD_H
+
+#include <stdint.h>
+
+#define LF_LORA_CMD_MAX_TOKENS   32
+#define LF_LORA_CMD_ANY          0xFF  // maxArgs sem limite
+#define LF_LORA_CMD_WIDTHS       4
+
+// Trecho do buffer original, sem cópia e sem '\0'
+struct LF_LoRaToken {
+  const char *ptr;
+  uint16_t len;
+
+  bool equals(const char *s) const;
+  bool equalsIgnoreCase(const char *s) const;
+  bool isDigits() const;
+  bool isHex() const;
+  LF_LoRaToken sub(uint16_t pos, uint16_t n) const;
+  int32_t toInt() const;  // 0 se inválido, como String::toInt
+  float toFloat() const;  // 0 se inválido, como String::toFloat
+};
+
+// Entrada da tabela de comandos, montada em tempo de compilação.
+// Os args vêm separados pelo delimitador, ou colados ao código (packed)
+// com as larguras fixas de width[]. Largura 0 é livre; args além de
+// LF_LORA_CMD_WIDTHS usam a última largura.
+struct LF_LoRaCmdSpec {
+  const char *code;
+  uint8_t minArgs;
+  uint8_t maxArgs;
+  uint8_t digits;   // bit i: arg i só com dígitos decimais
+  bool packed;
+  uint8_t width[LF_LORA_CMD_WIDTHS];
+};
+
+// Separa e valida mensagens "!PARA!DE!CMD!..." no próprio buffer
+class LF_LoRaCmd {
+
+public:
+
+  bool parse(const char *buf, int len, char delimiter = '!');
+  uint8_t count();
+  LF_LoRaToken token(uint8_t i);
+  const LF_LoRaCmdSpec *match(const LF_LoRaCmdSpec *table, uint8_t tableLen, uint8_t cmdIdx);
+  uint8_t argCount();
+  LF_LoRaToken arg(uint8_t i);
+
+private:
+
+  bool matchSpec(const LF_LoRaCmdSpec &spec, uint8_t cmdIdx);
+  uint8_t width(const LF_LoRaCmdSpec &spec, uint8_t i);
+
+  LF_LoRaToken _tok[LF_LORA_CMD_MAX_TOKENS];
+  uint8_t _count = 0;
+  const LF_LoRaCmdSpec *_spec = nullptr;
+  uint8_t _cmdIdx = 0;
+  uint8_t _argCount = 0;
+
+};
+
+#endif
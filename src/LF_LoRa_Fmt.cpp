@@ -0,0 +1,371 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#include "LF_LoRa_Fmt.h"
+
+static const uint32_t fmtPow10[LF_LORA_FMT_MAX_DECIMALS + 1] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+
+static const char hexDigits[] = "0123456789ABCDEF";
+
+// Valor de um dígito hex, 0xFF se não for
+static inline uint8_t hexValue(char c) {
+  if ((c >= '0') && (c <= '9')) return c - '0';
+  if ((c >= 'A') && (c <= 'F')) return c - 'A' + 10;
+  if ((c >= 'a') && (c <= 'f')) return c - 'a' + 10;
+  return 0xFF;
+} /* hexValue */
+
+// Escreve os dígitos de v (sem sinal), com no mínimo width dígitos
+static int fmtDigits(char *out, int size, uint32_t v, uint8_t width) {
+  char tmp[16];
+  int n = 0;
+  do {
+    tmp[n++] = '0' + (v % 10);
+    v /= 10;
+  } while (v > 0);
+  while (n < width && n < (int)sizeof(tmp)) tmp[n++] = '0';
+  if (n >= size) return 0;
+  for (int i = 0; i < n; i++) {
+    out[i] = tmp[n - 1 - i];
+  }
+  out[n] = 0;
+  return n;
+} /* fmtDigits */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaFmt::fmtInt(char *out, int size, int32_t value, uint8_t width) {
+
+  if (size <= 0) return 0;
+  out[0] = 0;
+
+  int n = 0;
+  uint32_t v = (uint32_t)value;
+  if (value < 0) {
+    if (size < 2) return 0;
+    out[n++] = '-';
+    v = 0u - v;
+    if (width > 0) width--;
+  }
+  int d = fmtDigits(out + n, size - n, v, width);
+  if (d == 0) {
+    out[0] = 0;
+    return 0;
+  }
+  return n + d;
+
+} /* fmtInt */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaFmt::fmtHex(char *out, int size, uint32_t value, uint8_t width) {
+
+  if (size <= 0) return 0;
+  out[0] = 0;
+
+  char tmp[16];
+  int n = 0;
+  do {
+    tmp[n++] = hexDigits[value & 0x0F];
+    value >>= 4;
+  } while (value > 0);
+  while (n < width && n < (int)sizeof(tmp)) tmp[n++] = '0';
+  if (n >= size) return 0;
+  for (int i = 0; i < n; i++) {
+    out[i] = tmp[n - 1 - i];
+  }
+  out[n] = 0;
+  return n;
+
+} /* fmtHex */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaFmt::fmtFixed(char *out, int size, int32_t scaled, uint8_t decimals) {
+
+  // scaled é o valor multiplicado por 10^decimals
+  if (size <= 0) return 0;
+  out[0] = 0;
+  if (decimals > LF_LORA_FMT_MAX_DECIMALS) return 0;
+
+  int n = 0;
+  uint32_t v = (uint32_t)scaled;
+  if (scaled < 0) {
+    if (size < 2) return 0;
+    out[n++] = '-';
+    v = 0u - v;
+  }
+  int d = fmtDigits(out + n, size - n, v / fmtPow10[decimals], 1);
+  if (d == 0) {
+    out[0] = 0;
+    return 0;
+  }
+  n += d;
+  if (decimals == 0) return n;
+
+  if (n + 1 + decimals >= size) {
+    out[0] = 0;
+    return 0;
+  }
+  out[n++] = '.';
+  fmtDigits(out + n, size - n, v % fmtPow10[decimals], decimals);
+  return n + decimals;
+
+} /* fmtFixed */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaFmt::fmtFloat(char *out, int size, float value, uint8_t decimals) {
+
+  if (size <= 0) return 0;
+  out[0] = 0;
+  if (decimals > LF_LORA_FMT_MAX_DECIMALS) return 0;
+
+  // Arredondo para o número de casas, fora da faixa de int32 não formata
+  float scaled = value * fmtPow10[decimals];
+  scaled += (scaled < 0) ? -0.5f : 0.5f;
+  if ((scaled >= 2147483647.0f) || (scaled <= -2147483647.0f) || (scaled != scaled)) return 0;
+  return fmtFixed(out, size, (int32_t)scaled, decimals);
+
+} /* fmtFloat */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaFmt::parseInt(const char *in, int len, int32_t &value) {
+
+  int i = 0;
+  bool neg = false;
+  if ((i < len) && ((in[i] == '-') || (in[i] == '+'))) {
+    neg = (in[i] == '-');
+    i++;
+  }
+  int start = i;
+  uint32_t v = 0;
+  while ((i < len) && (in[i] >= '0') && (in[i] <= '9')) {
+    uint32_t next = v * 10 + (in[i] - '0');
+    if ((v > 214748364) || (next > (neg ? 2147483648u : 2147483647u))) return 0; // Estouro
+    v = next;
+    i++;
+  }
+  if (i == start) return 0;
+  value = neg ? (int32_t)(0u - v) : (int32_t)v;
+  return i;
+
+} /* parseInt */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaFmt::parseHex(const char *in, int len, uint32_t &value) {
+
+  if (len > 8) len = 8;
+  uint32_t v = 0;
+  int i = 0;
+  while (i < len) {
+    uint8_t d = hexValue(in[i]);
+    if (d == 0xFF) break;
+    v = (v << 4) | d;
+    i++;
+  }
+  if (i == 0) return 0;
+  value = v;
+  return i;
+
+} /* parseHex */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaFmt::parseFixed(const char *in, int len, uint8_t decimals, int32_t &scaled) {
+
+  // Lê "[-]inteiro[.fração]" como inteiro multiplicado por 10^decimals,
+  // casas a mais são truncadas
+  if (decimals > LF_LORA_FMT_MAX_DECIMALS) return 0;
+
+  int32_t ip;
+  int i = parseInt(in, len, ip);
+  if (i == 0) return 0;
+  bool neg = (in[0] == '-');
+  uint32_t mag = neg ? 0u - (uint32_t)ip : (uint32_t)ip;
+
+  uint32_t frac = 0;
+  uint8_t digits = 0;
+  if ((i < len) && (in[i] == '.')) {
+    i++;
+    while ((i < len) && (in[i] >= '0') && (in[i] <= '9')) {
+      if (digits < decimals) {
+        frac = frac * 10 + (in[i] - '0');
+        digits++;
+      }
+      i++;
+    }
+  }
+  while (digits < decimals) {
+    frac *= 10;
+    digits++;
+  }
+
+  uint64_t v = (uint64_t)mag * fmtPow10[decimals] + frac;
+  if (v > (neg ? 2147483648ull : 2147483647ull)) return 0; // Estouro
+  scaled = neg ? (int32_t)(0u - (uint32_t)v) : (int32_t)v;
+  return i;
+
+} /* parseFixed */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaFmt::parseFloat(const char *in, int len, float &value) {
+
+  // Lê "[-]inteiro[.fração][E[-]expoente]", como "915E6"
+  int i = 0;
+  bool neg = false;
+  if ((i < len) && ((in[i] == '-') || (in[i] == '+'))) {
+    neg = (in[i] == '-');
+    i++;
+  }
+  // Dígitos num inteiro e a escala num expoente de 10, divido uma vez só no
+  // fim: somar fração a fração acumula o erro de cada passo
+  uint64_t mant = 0;
+  int32_t exp10 = 0;
+  bool digits = false;
+  while ((i < len) && (in[i] >= '0') && (in[i] <= '9')) {
+    // Além de 18 dígitos só conto a escala
+    if (mant < 100000000000000000ULL) {
+      mant = mant * 10 + (in[i] - '0');
+    } else {
+      exp10++;
+    }
+    digits = true;
+    i++;
+  }
+  if ((i < len) && (in[i] == '.')) {
+    i++;
+    while ((i < len) && (in[i] >= '0') && (in[i] <= '9')) {
+      if (mant < 100000000000000000ULL) {
+        mant = mant * 10 + (in[i] - '0');
+        exp10--;
+      }
+      digits = true;
+      i++;
+    }
+  }
+  if (!digits) return 0;
+
+  if ((i < len) && ((in[i] == 'E') || (in[i] == 'e'))) {
+    int32_t e;
+    int n = parseInt(in + i + 1, len - i - 1, e);
+    if (n > 0) {
+      i += 1 + n;
+      if (e > 60) e = 60;
+      if (e < -60) e = -60;
+      exp10 += e;
+    }
+  }
+
+  // Fora da faixa do float de qualquer jeito
+  if (exp10 > 80) exp10 = 80;
+  if (exp10 < -80) exp10 = -80;
+  double scale = 1;
+  for (int32_t e = (exp10 < 0) ? -exp10 : exp10; e > 0; e--) scale *= 10;
+  double d = (exp10 < 0) ? mant / scale : mant * scale;
+  float v = (d > 3.4e38) ? 3.4e38f : (float)d;
+  value = neg ? -v : v;
+  return i;
+
+} /* parseFloat */
+
+/* -------------------------------------------------------------------------- */
+LF_LoRaLine::LF_LoRaLine(char *buf, int size, char delimiter)
+{
+  _buf = buf;
+  _size = size;
+  _delimiter = delimiter;
+  clear();
+}
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaLine::clear() {
+  _len = 0;
+  _overflow = (_size <= 0);
+  if (_size > 0) _buf[0] = 0;
+} /* clear */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaLine::delimiter() {
+  if (_overflow || (_len + 1 >= _size)) {
+    _overflow = true;
+    return false;
+  }
+  _buf[_len++] = _delimiter;
+  _buf[_len] = 0;
+  return true;
+} /* delimiter */
+
+/* -------------------------------------------------------------------------- */
+LF_LoRaLine& LF_LoRaLine::addInt(int32_t value, uint8_t width) {
+  if (!delimiter()) return *this;
+  int n = LF_LoRaFmt::fmtInt(_buf + _len, _size - _len, value, width);
+  if (n == 0) _overflow = true;
+  _len += n;
+  return *this;
+} /* addInt */
+
+/* -------------------------------------------------------------------------- */
+LF_LoRaLine& LF_LoRaLine::addHex(uint32_t value, uint8_t width) {
+  if (!delimiter()) return *this;
+  int n = LF_LoRaFmt::fmtHex(_buf + _len, _size - _len, value, width);
+  if (n == 0) _overflow = true;
+  _len += n;
+  return *this;
+} /* addHex */
+
+/* -------------------------------------------------------------------------- */
+LF_LoRaLine& LF_LoRaLine::addFixed(int32_t scaled, uint8_t decimals) {
+  if (!delimiter()) return *this;
+  int n = LF_LoRaFmt::fmtFixed(_buf + _len, _size - _len, scaled, decimals);
+  if (n == 0) _overflow = true;
+  _len += n;
+  return *this;
+} /* addFixed */
+
+/* -------------------------------------------------------------------------- */
+LF_LoRaLine& LF_LoRaLine::addFloat(float value, uint8_t decimals) {
+  if (!delimiter()) return *this;
+  int n = LF_LoRaFmt::fmtFloat(_buf + _len, _size - _len, value, decimals);
+  if (n == 0) _overflow = true;
+  _len += n;
+  return *this;
+} /* addFloat */
+
+/* -------------------------------------------------------------------------- */
+LF_LoRaLine& LF_LoRaLine::addStr(const char *value) {
+  int len = 0;
+  while (value[len]) len++;
+  return addStr(value, len);
+} /* addStr */
+
+/* -------------------------------------------------------------------------- */
+LF_LoRaLine& LF_LoRaLine::addStr(const char *value, int len) {
+  if (!delimiter()) return *this;
+  for (int i = 0; i < len; i++) {
+    if (_len + 1 >= _size) {
+      _overflow = true;
+      break;
+    }
+    _buf[_len++] = value[i];
+  }
+  _buf[_len] = 0;
+  return *this;
+} /* addStr */
+
+/* -------------------------------------------------------------------------- */
+const char *LF_LoRaLine::c_str() {
+  return _buf;
+} /* c_str */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaLine::length() {
+  return _len;
+} /* length */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaLine::overflow() {
+  return _overflow;
+} /* overflow */
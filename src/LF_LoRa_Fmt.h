@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef	LF_LORA_FMT_H
+#define	LF_LORA_FMT_H
+
+#include <stdint.h>
+
+#define LF_LORA_FMT_MAX_DECIMALS   6
+
+// Formatação e leitura de números no buffer do chamador, sem alocação,
+// sem sprintf/strtol. As funções fmt* retornam os caracteres escritos
+// (0 se não coube, o buffer sempre termina com '\0'). As parse* retornam
+// os caracteres lidos (0 se inválido).
+class LF_LoRaFmt {
+
+public:
+
+  static int fmtInt(char *out, int size, int32_t value, uint8_t width = 0);
+  static int fmtHex(char *out, int size, uint32_t value, uint8_t width = 0);
+  static int fmtFixed(char *out, int size, int32_t scaled, uint8_t decimals);
+  static int fmtFloat(char *out, int size, float value, uint8_t decimals);
+
+  static int parseInt(const char *in, int len, int32_t &value);
+  static int parseHex(const char *in, int len, uint32_t &value);
+  static int parseFixed(const char *in, int len, uint8_t decimals, int32_t &scaled);
+  static int parseFloat(const char *in, int len, float &value);
+
+};
+
+// Monta uma linha de estado "#v1#v2..." de uma vez no buffer do chamador
+class LF_LoRaLine {
+
+public:
+
+  LF_LoRaLine(char *buf, int size, char delimiter = '#');
+
+  LF_LoRaLine& addInt(int32_t value, uint8_t width = 0);
+  LF_LoRaLine& addHex(uint32_t value, uint8_t width = 0);
+  LF_LoRaLine& addFixed(int32_t scaled, uint8_t decimals);
+  LF_LoRaLine& addFloat(float value, uint8_t decimals);
+  LF_LoRaLine& addStr(const char *value);
+  LF_LoRaLine& addStr(const char *value, int len);
+  void clear();
+  const char *c_str();
+  int length();
+  bool overflow();
+
+private:
+
+  bool delimiter();
+
+  char *_buf;
+  int _size;
+  int _len = 0;
+  char _delimiter;
+  bool _overflow = false;
+
+};
+
+#endif
@@ -0,0 +1,762 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#include "LF_LoRa_Ota.h"
+#include "LF_LoRa_Fmt.h"
+
+#include <string.h>
+
+#define OTA_PH_START    0
+#define OTA_PH_BLOCKS   1
+#define OTA_PH_QUERY    2
+#define OTA_PH_WAIT     3
+#define OTA_PH_END      4
+#define OTA_PH_DONE     5
+
+#if !defined(LF_LORA_SHA_HW)
+// Constantes do SHA-256 (FIPS 180-4)
+static const uint32_t shaK[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static inline uint32_t ror(uint32_t x, uint8_t n) {
+  return (x >> n) | (x << (32 - n));
+}
+#endif
+
+// Escreve os bytes em hex, sem '\0'
+static void hexWrite(char *out, const uint8_t *data, int len) {
+  static const char digits[] = "0123456789ABCDEF";
+  for (int i = 0; i < len; i++) {
+    out[2 * i] = digits[data[i] >> 4];
+    out[2 * i + 1] = digits[data[i] & 0x0F];
+  }
+} /* hexWrite */
+
+// Lê len bytes em hex, false se algum caractere não for hex
+static bool hexRead(const char *in, uint8_t *data, int len) {
+  uint32_t v;
+  for (int i = 0; i < len; i++) {
+    if (LF_LoRaFmt::parseHex(in + 2 * i, 2, v) != 2) return false;
+    data[i] = v;
+  }
+  return true;
+} /* hexRead */
+
+// Lê um campo hex de tamanho fixo
+static bool hexField(const char *in, int digits, uint32_t &v) {
+  return LF_LoRaFmt::parseHex(in, digits, v) == digits;
+} /* hexField */
+
+// Número em hex de tamanho variável: os dígitos antes do último vão
+// como 'G'..'V', o último como '0'..'F'. Buracos próximos custam 1 caractere.
+static int varintWrite(char *out, uint16_t v) {
+  static const char digits[] = "0123456789ABCDEF";
+  char aux[4];
+  int n = 0;
+  do {
+    aux[n++] = v & 0x0F;
+    v >>= 4;
+  } while (v > 0);
+  for (int i = 0; i < n; i++) {
+    uint8_t d = aux[n - 1 - i];
+    out[i] = (i == n - 1) ? digits[d] : 'G' + d;
+  }
+  return n;
+} /* varintWrite */
+
+// Lê um número escrito por varintWrite, retorna os caracteres lidos (0 se inválido)
+static int varintRead(const char *in, int len, uint32_t &v) {
+  v = 0;
+  for (int i = 0; (i < len) && (i < 5); i++) {
+    char c = in[i];
+    if ((c >= 'G') && (c <= 'V')) {
+      v = (v << 4) | (c - 'G');
+      continue;
+    }
+    uint32_t d;
+    if (LF_LoRaFmt::parseHex(in + i, 1, d) != 1) return 0;
+    v = (v << 4) | d;
+    return i + 1;
+  }
+  return 0;
+} /* varintRead */
+
+static inline bool bitGet(const uint8_t *map, uint16_t n) {
+  return map[n >> 3] & (1 << (n & 7));
+}
+
+static inline void bitSet(uint8_t *map, uint16_t n) {
+  map[n >> 3] |= (1 << (n & 7));
+}
+
+/* -------------------------------------------------------------------------- */
+LF_LoRaSha256::LF_LoRaSha256()
+{
+#if defined(LF_LORA_SHA_HW)
+  mbedtls_sha256_init(&_ctx);
+#endif
+}
+
+/* -------------------------------------------------------------------------- */
+LF_LoRaSha256::~LF_LoRaSha256()
+{
+#if defined(LF_LORA_SHA_HW)
+  mbedtls_sha256_free(&_ctx);
+#endif
+}
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaSha256::begin() {
+
+#if defined(LF_LORA_SHA_HW)
+  mbedtls_sha256_starts(&_ctx, 0);
+#else
+  static const uint32_t h0[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+  };
+  memcpy(_state, h0, sizeof(_state));
+  _bits = 0;
+  _bufLen = 0;
+#endif
+
+} /* begin */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaSha256::update(const uint8_t *data, int len) {
+
+#if defined(LF_LORA_SHA_HW)
+  mbedtls_sha256_update(&_ctx, data, len);
+#else
+  _bits += (uint64_t)len * 8;
+  while (len > 0) {
+    int n = 64 - _bufLen;
+    if (n > len) n = len;
+    memcpy(_buf + _bufLen, data, n);
+    _bufLen += n;
+    data += n;
+    len -= n;
+    if (_bufLen == 64) {
+      transform(_buf);
+      _bufLen = 0;
+    }
+  }
+#endif
+
+} /* update */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaSha256::finish(uint8_t *hash) {
+
+#if defined(LF_LORA_SHA_HW)
+  mbedtls_sha256_finish(&_ctx, hash);
+#else
+  uint64_t bits = _bits;
+  uint8_t pad = 0x80;
+  update(&pad, 1);
+  pad = 0;
+  while (_bufLen != 56) {
+    update(&pad, 1);
+  }
+  uint8_t len[8];
+  for (uint8_t i = 0; i < 8; i++) {
+    len[i] = bits >> (56 - 8 * i);
+  }
+  update(len, 8);
+  for (uint8_t i = 0; i < 8; i++) {
+    hash[4 * i] = _state[i] >> 24;
+    hash[4 * i + 1] = _state[i] >> 16;
+    hash[4 * i + 2] = _state[i] >> 8;
+    hash[4 * i + 3] = _state[i];
+  }
+#endif
+
+} /* finish */
+
+#if !defined(LF_LORA_SHA_HW)
+/* -------------------------------------------------------------------------- */
+void LF_LoRaSha256::transform(const uint8_t *block) {
+
+  uint32_t w[64];
+  for (uint8_t i = 0; i < 16; i++) {
+    w[i] = ((uint32_t)block[4 * i] << 24) | ((uint32_t)block[4 * i + 1] << 16) |
+           ((uint32_t)block[4 * i + 2] << 8) | block[4 * i + 3];
+  }
+  for (uint8_t i = 16; i < 64; i++) {
+    uint32_t s0 = ror(w[i - 15], 7) ^ ror(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    uint32_t s1 = ror(w[i - 2], 17) ^ ror(w[i - 2], 19) ^ (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+
+  uint32_t a = _state[0], b = _state[1], c = _state[2], d = _state[3];
+  uint32_t e = _state[4], f = _state[5], g = _state[6], h = _state[7];
+  for (uint8_t i = 0; i < 64; i++) {
+    uint32_t t1 = h + (ror(e, 6) ^ ror(e, 11) ^ ror(e, 25)) + ((e & f) ^ (~e & g)) + shaK[i] + w[i];
+    uint32_t t2 = (ror(a, 2) ^ ror(a, 13) ^ ror(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+  _state[0] += a; _state[1] += b; _state[2] += c; _state[3] += d;
+  _state[4] += e; _state[5] += f; _state[6] += g; _state[7] += h;
+
+} /* transform */
+#endif
+
+#if defined(ESP32)
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaOtaFlash::begin(char kind, uint32_t size) {
+
+  if (kind != LF_LORA_OTA_KIND_FW) return false;
+  if (_handle != 0) {
+    esp_ota_abort(_handle);
+    _handle = 0;
+  }
+  _part = esp_ota_get_next_update_partition(NULL);
+  if ((_part == nullptr) || (size > _part->size)) return false;
+  // Apaga só o tamanho da imagem
+  if (esp_ota_begin(_part, size, &_handle) != ESP_OK) {
+    _handle = 0;
+    return false;
+  }
+  return true;
+
+} /* begin */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaOtaFlash::write(uint32_t offset, const uint8_t *data, int len) {
+  if (_handle == 0) return false;
+  return esp_ota_write_with_offset(_handle, data, len, offset) == ESP_OK;
+} /* write */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaOtaFlash::read(uint32_t offset, uint8_t *data, int len) {
+  if (_part == nullptr) return false;
+  return esp_partition_read(_part, offset, data, len) == ESP_OK;
+} /* read */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaOtaFlash::end(bool ok) {
+
+  if (_handle == 0) return false;
+  esp_ota_handle_t handle = _handle;
+  _handle = 0;
+  if (!ok) {
+    esp_ota_abort(handle);
+    return false;
+  }
+  // esp_ota_end valida a imagem, a troca vale no próximo boot
+  if (esp_ota_end(handle) != ESP_OK) return false;
+  return esp_ota_set_boot_partition(_part) == ESP_OK;
+
+} /* end */
+#endif
+
+/* -------------------------------------------------------------------------- */
+LF_LoRaOtaRx::~LF_LoRaOtaRx()
+{
+  delete[] _bitmap;
+}
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaOtaRx::setImage(LF_LoRaOtaImage *image) {
+  reset();
+  _image = image;
+} /* setImage */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaOtaRx::reset() {
+  if ((_status == LF_LORA_OTA_RECEIVING) || (_status == LF_LORA_OTA_VERIFIED)) {
+    _image->end(false);
+  }
+  delete[] _bitmap;
+  _bitmap = nullptr;
+  _status = LF_LORA_OTA_IDLE;
+  _started = false;
+  _blocks = 0;
+  _received = 0;
+} /* reset */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaOtaRx::frame(const char *msg, int len) {
+
+  // msg começa no '$'
+  if ((_image == nullptr) || (len < 4)) return false;
+  uint32_t session;
+  if (!hexField(msg + 2, 2, session)) return false;
+
+  if (msg[1] == LF_LORA_OTA_START) {
+    return start(msg, len);
+  }
+  if (!_started || (session != _session)) return false;
+
+  if (msg[1] == LF_LORA_OTA_BLOCK) {
+    return block(msg, len);
+  }
+  if (msg[1] == LF_LORA_OTA_END) {
+    // Só troca a imagem se foi verificada
+    if (_status == LF_LORA_OTA_VERIFIED) {
+      _status = _image->end(true) ? LF_LORA_OTA_DONE : LF_LORA_OTA_FAIL;
+    } else if (_status == LF_LORA_OTA_RECEIVING) {
+      _image->end(false);
+      _status = LF_LORA_OTA_FAIL;
+    }
+    delete[] _bitmap;
+    _bitmap = nullptr;
+    return true;
+  }
+  return false;
+
+} /* frame */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaOtaRx::start(const char *msg, int len) {
+
+  if (len != 15 + 2 * LF_LORA_OTA_HASH_LEN) return false;
+  uint32_t session, size, blockSize;
+  if (!hexField(msg + 2, 2, session)) return false;
+  if (!hexField(msg + 5, 8, size)) return false;
+  if (!hexField(msg + 13, 2, blockSize)) return false;
+  uint8_t hash[LF_LORA_OTA_HASH_LEN];
+  if (!hexRead(msg + 15, hash, LF_LORA_OTA_HASH_LEN)) return false;
+  // Início repetido da mesma sessão. A sessão sozinha não basta: o master
+  // reiniciado volta a numerar do começo, então comparo também a imagem.
+  if (_started && (session == _session) && (msg[4] == _kind) && (size == _size) &&
+      (blockSize == _blockSize) && (memcmp(hash, _hash, LF_LORA_OTA_HASH_LEN) == 0) &&
+      (_status != LF_LORA_OTA_FAIL)) return true;
+
+  if ((blockSize == 0) || (blockSize > LF_LORA_OTA_BLOCK_MAX) || (size == 0)) return false;
+  uint32_t blocks = (size + blockSize - 1) / blockSize;
+  if (blocks > LF_LORA_OTA_MAX_BLOCKS) return false;
+
+  reset();
+  if (!_image->begin(msg[4], size)) return false;
+  _bitmap = new uint8_t[(blocks + 7) / 8]();
+  memcpy(_hash, hash, LF_LORA_OTA_HASH_LEN);
+  _session = session;
+  _kind = msg[4];
+  _size = size;
+  _blockSize = blockSize;
+  _blocks = blocks;
+  _received = 0;
+  _reportFrom = 0;
+  _started = true;
+  _status = LF_LORA_OTA_RECEIVING;
+  return true;
+
+} /* start */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaOtaRx::block(const char *msg, int len) {
+
+  if (_status != LF_LORA_OTA_RECEIVING) return true;
+  uint32_t n;
+  if ((len < 8) || !hexField(msg + 4, 4, n) || (n >= _blocks)) return false;
+  uint32_t offset = n * _blockSize;
+  int blockLen = (_size - offset < _blockSize) ? _size - offset : _blockSize;
+  if (len != 8 + 2 * blockLen) return false;
+  if (has(n)) return true; // Repetido
+
+  uint8_t data[LF_LORA_OTA_BLOCK_MAX];
+  if (!hexRead(msg + 8, data, blockLen)) return false;
+  if (!_image->write(offset, data, blockLen)) return false;
+  bitSet(_bitmap, n);
+  _received++;
+
+  if (_received == _blocks) {
+    if (verify()) {
+      _status = LF_LORA_OTA_VERIFIED;
+    } else {
+      // Imagem corrompida, descarto a gravação e peço tudo de novo
+      _image->end(false);
+      memset(_bitmap, 0, (_blocks + 7) / 8);
+      _received = 0;
+      if (!_image->begin(_kind, _size)) _status = LF_LORA_OTA_FAIL;
+    }
+  }
+  return true;
+
+} /* block */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaOtaRx::verify() {
+
+  LF_LoRaSha256 sha;
+  uint8_t buf[64];
+  sha.begin();
+  for (uint32_t pos = 0; pos < _size; pos += sizeof(buf)) {
+    int n = (_size - pos < sizeof(buf)) ? _size - pos : sizeof(buf);
+    if (!_image->read(pos, buf, n)) return false;
+    sha.update(buf, n);
+  }
+  uint8_t hash[LF_LORA_OTA_HASH_LEN];
+  sha.finish(hash);
+  return memcmp(hash, _hash, LF_LORA_OTA_HASH_LEN) == 0;
+
+} /* verify */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaOtaRx::has(uint16_t n) {
+  return bitGet(_bitmap, n);
+} /* has */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaOtaRx::slot(const char *msg, int len, uint8_t addr, uint16_t &slotLen) {
+
+  // Consulta do master: minha posição na lista define quando respondo
+  if ((_image == nullptr) || (len < 8) || ((len - 8) % 2 != 0)) return -1;
+  uint32_t session, t;
+  if (!hexField(msg + 2, 2, session) || !hexField(msg + 4, 4, t)) return -1;
+  for (int i = 0; 8 + 2 * i < len; i++) {
+    uint32_t a;
+    if (!hexField(msg + 8 + 2 * i, 2, a)) return -1;
+    if (a == addr) {
+      _querySession = session;
+      slotLen = t;
+      return i;
+    }
+  }
+  return -1;
+
+} /* slot */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaOtaRx::report(char *out, int size) {
+
+  // $MSS[faltantes]: vazio se completo, '*' se perdi o início
+  if (size < 6) return 0;
+  out[0] = '$';
+  out[1] = LF_LORA_OTA_MISSING;
+  LF_LoRaFmt::fmtHex(out + 2, 3, _querySession, 2);
+  int n = 4;
+
+  if (!_started || (_session != _querySession)) {
+    out[n++] = '*';
+    out[n] = 0;
+    return n;
+  }
+  if (_status == LF_LORA_OTA_RECEIVING) {
+    // Continuo de onde a resposta anterior parou, assim todos os
+    // buracos são pedidos mesmo quando não cabem numa resposta só
+    if (_reportFrom >= _blocks) _reportFrom = 0;
+    uint16_t first = _reportFrom;
+    while ((first < _blocks) && has(first)) first++;
+    if (first == _blocks) {
+      first = 0;
+      while (has(first)) first++;
+    }
+    uint16_t prev = 0;
+    bool any = false;
+    uint16_t i = first;
+    for (; i < _blocks; i++) {
+      if (has(i)) continue;
+      char aux[5];
+      int len = varintWrite(aux, any ? i - prev - 1 : i);
+      if (n + len >= size) break;
+      memcpy(out + n, aux, len);
+      n += len;
+      prev = i;
+      any = true;
+    }
+    _reportFrom = i;
+  }
+  out[n] = 0;
+  return n;
+
+} /* report */
+
+/* -------------------------------------------------------------------------- */
+uint8_t LF_LoRaOtaRx::status() {
+  return _status;
+} /* status */
+
+/* -------------------------------------------------------------------------- */
+uint8_t LF_LoRaOtaRx::session() {
+  return _session;
+} /* session */
+
+/* -------------------------------------------------------------------------- */
+uint16_t LF_LoRaOtaRx::blocks() {
+  return _blocks;
+} /* blocks */
+
+/* -------------------------------------------------------------------------- */
+uint16_t LF_LoRaOtaRx::received() {
+  return _received;
+} /* received */
+
+/* -------------------------------------------------------------------------- */
+LF_LoRaOtaTx::~LF_LoRaOtaTx()
+{
+  delete[] _send;
+  delete[] _need;
+}
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaOtaTx::begin(uint8_t session, char kind, uint32_t size, LF_LoRaOtaImage *image,
+                         const uint8_t *nodes, uint8_t nodesLen, uint16_t slotLen, uint8_t blockSize) {
+
+  stop();
+  if ((image == nullptr) || (size == 0)) return false;
+  if ((blockSize == 0) || (blockSize > LF_LORA_OTA_BLOCK_MAX)) return false;
+  uint32_t blocks = (size + blockSize - 1) / blockSize;
+  if (blocks > LF_LORA_OTA_MAX_BLOCKS) return false;
+  if (nodesLen > LF_LORA_OTA_MAX_NODES) nodesLen = LF_LORA_OTA_MAX_NODES;
+
+  // Hash da imagem inteira, os escravos conferem antes de trocar
+  LF_LoRaSha256 sha;
+  uint8_t buf[64];
+  sha.begin();
+  for (uint32_t pos = 0; pos < size; pos += sizeof(buf)) {
+    int n = (size - pos < sizeof(buf)) ? size - pos : sizeof(buf);
+    if (!image->read(pos, buf, n)) return false;
+    sha.update(buf, n);
+  }
+  sha.finish(_hash);
+
+  _image = image;
+  _session = session;
+  _kind = kind;
+  _size = size;
+  _blockSize = blockSize;
+  _blocks = blocks;
+  _slotLen = slotLen;
+  _send = new uint8_t[(blocks + 7) / 8];
+  _need = new uint8_t[(blocks + 7) / 8]();
+  memset(_send, 0xFF, (blocks + 7) / 8);
+  for (uint8_t i = 0; i < nodesLen; i++) {
+    _nodes[i] = nodes[i];
+    _nodeOk[i] = false;
+  }
+  _nodesLen = nodesLen;
+  _needStart = false;
+  _cursor = 0;
+  _round = 1;
+  _endCount = 0;
+  _blocksSent = 0;
+  _phase = OTA_PH_START;
+  _status = LF_LORA_OTA_SENDING;
+  return true;
+
+} /* begin */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaOtaTx::stop() {
+  delete[] _send;
+  delete[] _need;
+  _send = nullptr;
+  _need = nullptr;
+  _phase = OTA_PH_DONE;
+  if (_status == LF_LORA_OTA_SENDING) _status = LF_LORA_OTA_FAIL;
+} /* stop */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaOtaTx::next(char *out, int size) {
+
+  // Próximo quadro da rodada, 0 enquanto aguarda as respostas ou no fim
+  if (_phase == OTA_PH_START) {
+    _phase = OTA_PH_BLOCKS;
+    _cursor = 0;
+    return frameStart(out, size);
+  }
+
+  if (_phase == OTA_PH_BLOCKS) {
+    while ((_cursor < _blocks) && !bitGet(_send, _cursor)) _cursor++;
+    if (_cursor < _blocks) {
+      _blocksSent++;
+      return frameBlock(_cursor++, out, size);
+    }
+    // Sem escravos conhecidos não há consulta, só uma passada
+    _phase = (_nodesLen == 0) ? OTA_PH_END : OTA_PH_QUERY;
+  }
+
+  if (_phase == OTA_PH_QUERY) {
+    _phase = OTA_PH_WAIT;
+    int n = frameQuery(out, size);
+    if (n > 0) return n;
+    _phase = OTA_PH_END; // Todos completos
+  }
+
+  if (_phase == OTA_PH_END) {
+    _endCount++;
+    if (_endCount >= LF_LORA_OTA_END_REPEAT) {
+      _phase = OTA_PH_DONE;
+      _status = (nodesOk() == _nodesLen) ? LF_LORA_OTA_DONE : LF_LORA_OTA_FAIL;
+    }
+    if (size < 5) return 0;
+    out[0] = '$';
+    out[1] = LF_LORA_OTA_END;
+    LF_LoRaFmt::fmtHex(out + 2, 3, _session, 2);
+    return 4;
+  }
+
+  return 0;
+
+} /* next */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaOtaTx::frameStart(char *out, int size) {
+
+  if (size < 16 + 2 * LF_LORA_OTA_HASH_LEN) return 0;
+  out[0] = '$';
+  out[1] = LF_LORA_OTA_START;
+  LF_LoRaFmt::fmtHex(out + 2, 3, _session, 2);
+  out[4] = _kind;
+  LF_LoRaFmt::fmtHex(out + 5, 9, _size, 8);
+  LF_LoRaFmt::fmtHex(out + 13, 3, _blockSize, 2);
+  hexWrite(out + 15, _hash, LF_LORA_OTA_HASH_LEN);
+  out[15 + 2 * LF_LORA_OTA_HASH_LEN] = 0;
+  return 15 + 2 * LF_LORA_OTA_HASH_LEN;
+
+} /* frameStart */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaOtaTx::frameBlock(uint16_t n, char *out, int size) {
+
+  uint32_t offset = (uint32_t)n * _blockSize;
+  int blockLen = (_size - offset < _blockSize) ? _size - offset : _blockSize;
+  if (size < 9 + 2 * blockLen) return 0;
+  uint8_t data[LF_LORA_OTA_BLOCK_MAX];
+  if (!_image->read(offset, data, blockLen)) return 0;
+  out[0] = '$';
+  out[1] = LF_LORA_OTA_BLOCK;
+  LF_LoRaFmt::fmtHex(out + 2, 3, _session, 2);
+  LF_LoRaFmt::fmtHex(out + 4, 5, n, 4);
+  hexWrite(out + 8, data, blockLen);
+  out[8 + 2 * blockLen] = 0;
+  return 8 + 2 * blockLen;
+
+} /* frameBlock */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaOtaTx::frameQuery(char *out, int size) {
+
+  // Só consulto quem ainda não completou
+  if (size < 9) return 0;
+  out[0] = '$';
+  out[1] = LF_LORA_OTA_QUERY;
+  LF_LoRaFmt::fmtHex(out + 2, 3, _session, 2);
+  LF_LoRaFmt::fmtHex(out + 4, 5, _slotLen, 4);
+  int n = 8;
+  for (uint8_t i = 0; i < _nodesLen; i++) {
+    if (_nodeOk[i]) continue;
+    if (n + 3 > size) break;
+    LF_LoRaFmt::fmtHex(out + n, 3, _nodes[i], 2);
+    n += 2;
+  }
+  return (n > 8) ? n : 0;
+
+} /* frameQuery */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaOtaTx::report(uint8_t de, const char *msg, int len) {
+
+  if ((_status != LF_LORA_OTA_SENDING) || (len < 4) || (msg[1] != LF_LORA_OTA_MISSING)) return;
+  uint32_t session;
+  if (!hexField(msg + 2, 2, session) || (session != _session)) return;
+  int node = -1;
+  for (uint8_t i = 0; i < _nodesLen; i++) {
+    if (_nodes[i] == de) node = i;
+  }
+  if (node == -1) return;
+
+  if ((len == 5) && (msg[4] == '*')) {
+    // Perdeu o início, precisa de tudo
+    _needStart = true;
+    memset(_need, 0xFF, (_blocks + 7) / 8);
+    return;
+  }
+  if (len == 4) {
+    _nodeOk[node] = true;
+    return;
+  }
+  // Primeiro buraco absoluto, os seguintes pela distância ao anterior
+  uint32_t block = 0;
+  bool first = true;
+  for (int p = 4; p < len;) {
+    uint32_t v;
+    int n = varintRead(msg + p, len - p, v);
+    if (n == 0) return;
+    block = first ? v : block + v + 1;
+    first = false;
+    if (block >= _blocks) return;
+    bitSet(_need, block);
+    p += n;
+  }
+
+} /* report */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaOtaTx::waiting() {
+  return _phase == OTA_PH_WAIT;
+} /* waiting */
+
+/* -------------------------------------------------------------------------- */
+uint32_t LF_LoRaOtaTx::window() {
+  // Um slot por escravo consultado, mais um de folga
+  uint8_t pending = _nodesLen - nodesOk();
+  return (uint32_t)(pending + 1) * _slotLen;
+} /* window */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaOtaTx::endWindow() {
+
+  if (_phase != OTA_PH_WAIT) return;
+  if ((nodesOk() == _nodesLen) || (_round >= LF_LORA_OTA_MAX_ROUNDS)) {
+    _phase = OTA_PH_END;
+    return;
+  }
+  // Próxima rodada só com a união dos blocos pedidos
+  uint8_t *aux = _send;
+  _send = _need;
+  _need = aux;
+  memset(_need, 0, (_blocks + 7) / 8);
+  _round++;
+  _cursor = 0;
+  _phase = _needStart ? OTA_PH_START : OTA_PH_BLOCKS;
+  _needStart = false;
+
+} /* endWindow */
+
+/* -------------------------------------------------------------------------- */
+uint8_t LF_LoRaOtaTx::status() {
+  return _status;
+} /* status */
+
+/* -------------------------------------------------------------------------- */
+uint8_t LF_LoRaOtaTx::rounds() {
+  return _round;
+} /* rounds */
+
+/* -------------------------------------------------------------------------- */
+uint32_t LF_LoRaOtaTx::blocksSent() {
+  return _blocksSent;
+} /* blocksSent */
+
+/* -------------------------------------------------------------------------- */
+uint8_t LF_LoRaOtaTx::nodesOk() {
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < _nodesLen; i++) {
+    if (_nodeOk[i]) n++;
+  }
+  return n;
+} /* nodesOk */
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef	LF_LORA_OTA_H
+#define	LF_LORA_OTA_H
+
+#include <stdint.h>
+
+// No ESP32 uso o SHA-256 do mbedtls, que usa o hardware.
+// Definindo LF_LORA_OTA_SOFT, usa a implementação em software.
+#if defined(ESP32) && !defined(LF_LORA_OTA_SOFT)
+#define LF_LORA_SHA_HW
+#include "mbedtls/sha256.h"
+#endif
+
+#if defined(ESP32)
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#endif
+
+#define LF_LORA_OTA_HASH_LEN      32
+#define LF_LORA_OTA_BLOCK_SIZE    96    // Bytes por bloco, 192 caracteres hex no quadro
+#define LF_LORA_OTA_BLOCK_MAX    112    // Maior bloco que cabe num pacote
+#define LF_LORA_OTA_MAX_BLOCKS   0xFFFF
+#define LF_LORA_OTA_MAX_NODES     32    // Escravos consultados pelo master
+#define LF_LORA_OTA_REPORT_LEN   200    // Tamanho máximo da resposta com os faltantes
+#define LF_LORA_OTA_MAX_ROUNDS    16    // Rodadas de reparo
+#define LF_LORA_OTA_END_REPEAT     2
+
+// Quadros de controle (após o '$'), campos em hex
+#define LF_LORA_OTA_START    'O'   // $OSSKLLLLLLLLBBHASH (K: tipo, L: tamanho, B: bloco)
+#define LF_LORA_OTA_BLOCK    'K'   // $KSSNNNNDADOS
+#define LF_LORA_OTA_QUERY    'Q'   // $QSSTTTTAA[AA...] (T: slot em ms, A: endereços)
+#define LF_LORA_OTA_MISSING  'M'   // $MSS[faltantes], vazio se completo, * sem início
+#define LF_LORA_OTA_END      'E'   // $ESS
+
+#define LF_LORA_OTA_KIND_FW      'F'   // Firmware
+#define LF_LORA_OTA_KIND_CFG     'C'   // Configuração em lote
+
+// Estados
+#define LF_LORA_OTA_IDLE         0
+#define LF_LORA_OTA_RECEIVING    1
+#define LF_LORA_OTA_VERIFIED     2
+#define LF_LORA_OTA_DONE         3
+#define LF_LORA_OTA_FAIL         4
+#define LF_LORA_OTA_SENDING      5
+
+class LF_LoRaSha256 {
+
+public:
+
+  LF_LoRaSha256();
+  ~LF_LoRaSha256();
+
+  void begin();
+  void update(const uint8_t *data, int len);
+  void finish(uint8_t *hash);
+
+private:
+
+#if defined(LF_LORA_SHA_HW)
+  mbedtls_sha256_context _ctx;
+#else
+  void transform(const uint8_t *block);
+
+  uint32_t _state[8];
+  uint64_t _bits = 0;
+  uint8_t _buf[64];
+  uint8_t _bufLen = 0;
+#endif
+
+};
+
+// Destino (escravo) ou origem (master) da imagem, pode ser substituída por um mock para testes
+class LF_LoRaOtaImage {
+
+public:
+
+  virtual ~LF_LoRaOtaImage() {}
+  virtual bool begin(char, uint32_t) { return true; }
+  virtual bool write(uint32_t offset, const uint8_t *data, int len) = 0;
+  virtual bool read(uint32_t offset, uint8_t *data, int len) = 0;
+  virtual bool end(bool ok) { return ok; }
+
+};
+
+#if defined(ESP32)
+// Partição OTA livre do ESP32, os blocos podem chegar fora de ordem
+class LF_LoRaOtaFlash : public LF_LoRaOtaImage {
+
+public:
+
+  bool begin(char kind, uint32_t size);
+  bool write(uint32_t offset, const uint8_t *data, int len);
+  bool read(uint32_t offset, uint8_t *data, int len);
+  bool end(bool ok);
+
+private:
+
+  const esp_partition_t *_part = nullptr;
+  esp_ota_handle_t _handle = 0;
+
+};
+#endif
+
+// Recepção no escravo: blocos, mapa de faltantes e verificação
+class LF_LoRaOtaRx {
+
+public:
+
+  ~LF_LoRaOtaRx();
+
+  void setImage(LF_LoRaOtaImage *image);
+  bool frame(const char *msg, int len);
+  int slot(const char *msg, int len, uint8_t addr, uint16_t &slotLen);
+  int report(char *out, int size);
+  void reset();
+
+  uint8_t status();
+  uint8_t session();
+  uint16_t blocks();
+  uint16_t received();
+
+private:
+
+  bool start(const char *msg, int len);
+  bool block(const char *msg, int len);
+  bool verify();
+  bool has(uint16_t n);
+
+  LF_LoRaOtaImage *_image = nullptr;
+  uint8_t *_bitmap = nullptr;
+  uint8_t _status = LF_LORA_OTA_IDLE;
+  bool _started = false;
+  uint8_t _session = 0;
+  uint8_t _querySession = 0;
+  char _kind = 0;
+  uint32_t _size = 0;
+  uint8_t _blockSize = 0;
+  uint16_t _blocks = 0;
+  uint16_t _received = 0;
+  uint16_t _reportFrom = 0;
+  uint8_t _hash[LF_LORA_OTA_HASH_LEN];
+
+};
+
+// Envio no master: início, blocos, consulta e rodadas de reparo.
+// Cada bloco vai ao ar uma vez por rodada para todo o grupo, a rodada
+// seguinte só leva a união dos blocos que os escravos pediram.
+class LF_LoRaOtaTx {
+
+public:
+
+  ~LF_LoRaOtaTx();
+
+  bool begin(uint8_t session, char kind, uint32_t size, LF_LoRaOtaImage *image,
+             const uint8_t *nodes, uint8_t nodesLen, uint16_t slotLen,
+             uint8_t blockSize = LF_LORA_OTA_BLOCK_SIZE);
+  int next(char *out, int size);
+  void report(uint8_t de, const char *msg, int len);
+  bool waiting();
+  uint32_t window();
+  void endWindow();
+  void stop();
+
+  uint8_t status();
+  uint8_t rounds();
+  uint32_t blocksSent();
+  uint8_t nodesOk();
+
+private:
+
+  int frameStart(char *out, int size);
+  int frameBlock(uint16_t n, char *out, int size);
+  int frameQuery(char *out, int size);
+
+  LF_LoRaOtaImage *_image = nullptr;
+  uint8_t *_send = nullptr;   // Blocos da rodada
+  uint8_t *_need = nullptr;   // Pedidos para a próxima rodada
+  uint8_t _status = LF_LORA_OTA_IDLE;
+  uint8_t _phase = 0;
+  uint8_t _session = 0;
+  char _kind = 0;
+  uint32_t _size = 0;
+  uint8_t _blockSize = 0;
+  uint16_t _blocks = 0;
+  uint16_t _cursor = 0;
+  uint8_t _hash[LF_LORA_OTA_HASH_LEN];
+  bool _needStart = false;
+  uint8_t _round = 0;
+  uint8_t _endCount = 0;
+  uint32_t _blocksSent = 0;
+  uint16_t _slotLen = 0;
+  uint8_t _nodes[LF_LORA_OTA_MAX_NODES];
+  bool _nodeOk[LF_LORA_OTA_MAX_NODES];
+  uint8_t _nodesLen = 0;
+
+};
+
+#endif
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef	LF_LORA_QUEUE_H
+#define	LF_LORA_QUEUE_H
+
+#include <stdint.h>
+#include <atomic>
+
+// Fila sem trava (lock-free) para um produtor e um consumidor.
+// Cabem N - 1 itens. push e pop são sempre inline, para poderem ser
+// usados numa interrupção em IRAM.
+#define LF_LORA_QUEUE_INLINE inline __attribute__((always_inline))
+
+template <typename T, uint16_t N>
+class LF_LoRaQueue {
+
+public:
+
+  LF_LORA_QUEUE_INLINE bool push(const T &item) {
+    uint16_t head = _head.load(std::memory_order_relaxed);
+    uint16_t next = (head + 1) % N;
+    if (next == _tail.load(std::memory_order_acquire)) {
+      return false; // Cheia
+    }
+    _items[head] = item;
+    _head.store(next, std::memory_order_release);
+    return true;
+  }
+
+  LF_LORA_QUEUE_INLINE bool pop(T &item) {
+    uint16_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail == _head.load(std::memory_order_acquire)) {
+      return false; // Vazia
+    }
+    item = _items[tail];
+    _tail.store((tail + 1) % N, std::memory_order_release);
+    return true;
+  }
+
+  bool empty() {
+    return _tail.load(std::memory_order_acquire) == _head.load(std::memory_order_acquire);
+  }
+
+  void clear() {
+    _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release);
+  }
+
+private:
+
+  T _items[N];
+  std::atomic<uint16_t> _head{0};
+  std::atomic<uint16_t> _tail{0};
+
+};
+
+#endif
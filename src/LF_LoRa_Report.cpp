@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#include "LF_LoRa_Report.h"
+#include "LF_LoRa_Fmt.h"
+
+#include <string.h>
+#include <math.h>
+
+/* -------------------------------------------------------------------------- */
+LF_LoRaReport::LF_LoRaReport()
+{
+
+}
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaReport::addField(const char *name, uint8_t decimals, float deadband, uint8_t deadbandType,
+                            unsigned long minInterval, unsigned long maxInterval, float rate) {
+
+  if (_fieldsLen >= LF_LORA_REPORT_MAX_FIELDS) return -1;
+
+  ReportField &f = _fields[_fieldsLen];
+  f.name = name;
+  f.decimals = decimals;
+  f.deadbandType = deadbandType;
+  f.deadband = deadband;
+  f.rate = rate;
+  f.minInterval = minInterval;
+  f.maxInterval = maxInterval;
+  f.value = 0;
+  f.sentValue = 0;
+  f.lastSample = 0;
+  f.lastSampleTime = 0;
+  f.lastSentTime = 0;
+  f.hasValue = false;
+  f.trigger = false;
+
+  return _fieldsLen++;
+
+} /* addField */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaReport::fieldIndex(const char *name) {
+  for (int i = 0; i < _fieldsLen; i++) {
+    if (strcmp(_fields[i].name, name) == 0) return i;
+  }
+  return -1;
+} /* fieldIndex */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaReport::setValue(const char *name, float value, unsigned long now) {
+  return setValue(fieldIndex(name), value, now);
+} /* setValue */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaReport::setValue(int index, float value, unsigned long now) {
+
+  if ((index < 0) || (index >= _fieldsLen)) return false;
+
+  ReportField &f = _fields[index];
+  if (fieldTrigger(f, value, now)) {
+    f.trigger = true;
+  }
+  f.value = value;
+  f.lastSample = value;
+  f.lastSampleTime = now;
+  f.hasValue = true;
+  _pending = true;
+
+  return f.trigger;
+
+} /* setValue */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaReport::fieldTrigger(ReportField &f, float value, unsigned long now) {
+
+  // Primeiro valor sempre vai
+  if (!f.hasValue || !_sentOnce) return true;
+
+  // Banda morta em relação ao último valor enviado
+  float delta = fabsf(value - f.sentValue);
+  float band = f.deadband;
+  if (f.deadbandType == LF_LORA_REPORT_DB_REL) {
+    band = f.deadband * fabsf(f.sentValue);
+  }
+  if (delta > band) return true;
+
+  // Taxa de variação entre amostras, pega mudanças rápidas ainda dentro da banda
+  if ((f.rate > 0) && (now != f.lastSampleTime)) {
+    float dt = (now - f.lastSampleTime) / 1000.0f;
+    if (fabsf(value - f.lastSample) / dt > f.rate) return true;
+  }
+
+  return false;
+
+} /* fieldTrigger */
+
+/* -------------------------------------------------------------------------- */
+float LF_LoRaReport::value(int index) {
+  if ((index < 0) || (index >= _fieldsLen)) return 0;
+  return _fields[index].value;
+} /* value */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaReport::setHeartbeat(unsigned long minInterval, unsigned long maxInterval) {
+  // Com os valores estáveis o intervalo dobra a cada envio, até maxInterval
+  _hbMin = minInterval;
+  _hbMax = (maxInterval < minInterval) ? minInterval : maxInterval;
+  _hbInterval = _hbMin;
+} /* setHeartbeat */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaReport::due(unsigned long now) {
+
+  if (_fieldsLen == 0) return false;
+
+  unsigned long elapsed = now - _lastSentTime;
+  bool send = false;
+  _hbFired = false;
+
+  for (int i = 0; i < _fieldsLen; i++) {
+    ReportField &f = _fields[i];
+    if (!f.hasValue) continue;
+    // minInterval conta do último envio que este valor disparou
+    if (f.trigger && (!_sentOnce || (now - f.lastSentTime >= f.minInterval))) send = true;
+    if ((f.maxInterval > 0) && (elapsed >= f.maxInterval)) send = true;
+  }
+
+  if (!send && (_hbInterval > 0) && _sentOnce && (elapsed >= _hbInterval)) {
+    send = true;
+    _hbFired = true;
+  }
+
+  if (!send && _pending) {
+    // Amostra nova que não justificou envio
+    _suppressedCount++;
+  }
+  _pending = false;
+
+  return send;
+
+} /* due */
+
+/* -------------------------------------------------------------------------- */
+String LF_LoRaReport::state() {
+  char buf[LF_LORA_REPORT_LINE_LEN];
+  state(buf, sizeof(buf));
+  return String(buf);
+} /* state */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaReport::state(char *buf, int size) {
+
+  // "#v1#v2..." no buffer do chamador, sem alocação.
+  // Retorna o tamanho, 0 (linha vazia) se não coube
+  LF_LoRaLine line(buf, size);
+  for (int i = 0; i < _fieldsLen; i++) {
+    line.addFloat(_fields[i].value, _fields[i].decimals);
+  }
+  if (line.overflow()) {
+    line.clear();
+    return 0;
+  }
+  return line.length();
+
+} /* state */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaReport::sent(unsigned long now) {
+
+  bool changed = false;
+  for (int i = 0; i < _fieldsLen; i++) {
+    ReportField &f = _fields[i];
+    if (f.trigger) changed = true;
+    if (f.trigger || !_sentOnce) f.lastSentTime = now;
+    f.sentValue = f.value;
+    f.trigger = false;
+  }
+
+  // Heartbeat adaptativo: volta ao mínimo quando algo mudou
+  if (changed || !_hbFired) {
+    _hbInterval = _hbMin;
+  } else {
+    _hbInterval = (_hbInterval * 2 > _hbMax) ? _hbMax : _hbInterval * 2;
+  }
+
+  _sentOnce = true;
+  _lastSentTime = now;
+  _reportCount++;
+
+} /* sent */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaReport::clear() {
+  _fieldsLen = 0;
+  _sentOnce = false;
+  _pending = false;
+  _hbInterval = _hbMin;
+  _reportCount = 0;
+  _suppressedCount = 0;
+} /* clear */
+
+/* -------------------------------------------------------------------------- */
+uint8_t LF_LoRaReport::fieldCount() {
+  return _fieldsLen;
+} /* fieldCount */
+
+/* -------------------------------------------------------------------------- */
+uint32_t LF_LoRaReport::reportCount() {
+  return _reportCount;
+} /* reportCount */
+
+/* -------------------------------------------------------------------------- */
+uint32_t LF_LoRaReport::suppressedCount() {
+  return _suppressedCount;
+} /* suppressedCount */
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef	LF_LORA_REPORT_H
+#define	LF_LORA_REPORT_H
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#define LF_LORA_REPORT_MAX_FIELDS   12     // Máximo de valores registrados
+#define LF_LORA_REPORT_LINE_LEN    200     // Buffer da linha de estado
+
+// Tipo da banda morta
+#define LF_LORA_REPORT_DB_ABS        0     // Variação absoluta
+#define LF_LORA_REPORT_DB_REL        1     // Variação relativa (fração do último valor enviado)
+
+struct ReportField {
+  const char *name;
+  uint8_t decimals;
+  uint8_t deadbandType;
+  float deadband;
+  float rate;                 // Taxa de variação (unidades/s) que dispara envio, 0 desliga
+  unsigned long minInterval;  // Intervalo mínimo entre envios disparados por este valor (ms)
+  unsigned long maxInterval;  // Envio forçado se o valor não for enviado neste tempo (ms), 0 desliga
+  unsigned long lastSentTime; // Último envio disparado por este valor (ou o primeiro envio)
+  float value;
+  float sentValue;
+  float lastSample;
+  unsigned long lastSampleTime;
+  bool hasValue;
+  bool trigger;
+};
+
+// Decide quando o estado ("#v1#v2...") vale o tempo de ar.
+// Não usa millis(), recebe o tempo para poder ser testado fora da placa.
+class LF_LoRaReport {
+
+public:
+
+  LF_LoRaReport();
+
+  int addField(const char *name, uint8_t decimals, float deadband, uint8_t deadbandType = LF_LORA_REPORT_DB_ABS,
+               unsigned long minInterval = 0, unsigned long maxInterval = 0, float rate = 0);
+  int fieldIndex(const char *name);
+  bool setValue(int index, float value, unsigned long now);
+  bool setValue(const char *name, float value, unsigned long now);
+  float value(int index);
+  void setHeartbeat(unsigned long minInterval, unsigned long maxInterval);
+  bool due(unsigned long now);
+  String state();
+  int state(char *buf, int size);
+  void sent(unsigned long now);
+  void clear();
+  uint8_t fieldCount();
+  uint32_t reportCount();
+  uint32_t suppressedCount();
+
+private:
+
+  bool fieldTrigger(ReportField &f, float value, unsigned long now);
+
+  ReportField _fields[LF_LORA_REPORT_MAX_FIELDS];
+  uint8_t _fieldsLen = 0;
+  bool _sentOnce = false;
+  bool _pending = false;
+  unsigned long _lastSentTime = 0;
+  unsigned long _hbMin = 0;
+  unsigned long _hbMax = 0;
+  unsigned long _hbInterval = 0;
+  bool _hbFired = false;
+  uint32_t _reportCount = 0;
+  uint32_t _suppressedCount = 0;
+
+};
+
+#endif
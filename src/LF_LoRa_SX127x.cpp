@@ -0,0 +1,346 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#include "LF_LoRa_SX127x.h"
+
+// LF_SX127xSpi Class Methods
+/* -------------------------------------------------------------------------- */
+void LF_SX127xSpi::transferBytes(const uint8_t *tx, uint8_t *rx, int len) {
+  // Implementação padrão, byte a byte
+  for (int i = 0; i < len; i++) {
+    uint8_t b = transfer(tx ? tx[i] : 0x00);
+    if (rx) rx[i] = b;
+  }
+} /* transferBytes */
+
+// LF_SX127xArduinoSpi Class Methods
+/* -------------------------------------------------------------------------- */
+void LF_SX127xArduinoSpi::cfg(SPIClass *spi, uint8_t ssPin, uint32_t freq) {
+  _spi = spi;
+  _ssPin = ssPin;
+  _settings = SPISettings(freq, MSBFIRST, SPI_MODE0);
+} /* cfg */
+
+/* -------------------------------------------------------------------------- */
+void LF_SX127xArduinoSpi::begin() {
+  pinMode(_ssPin, OUTPUT);
+  digitalWrite(_ssPin, HIGH);
+} /* begin */
+
+/* -------------------------------------------------------------------------- */
+void LF_SX127xArduinoSpi::select(bool active) {
+  if (active) {
+    _spi->beginTransaction(_settings);
+    digitalWrite(_ssPin, LOW);
+  } else {
+    digitalWrite(_ssPin, HIGH);
+    _spi->endTransaction();
+  }
+} /* select */
+
+/* -------------------------------------------------------------------------- */
+uint8_t LF_SX127xArduinoSpi::transfer(uint8_t data) {
+  return _spi->transfer(data);
+} /* transfer */
+
+/* -------------------------------------------------------------------------- */
+void LF_SX127xArduinoSpi::transferBytes(const uint8_t *tx, uint8_t *rx, int len) {
+  // Uma única transação para todos os bytes
+  if (rx) {
+    _spi->transferBytes(tx, rx, len);
+  } else {
+    _spi->writeBytes(tx, len);
+  }
+} /* transferBytes */
+
+// LF_SX127x Class Methods
+/* -------------------------------------------------------------------------- */
+void LF_SX127x::cfg(LF_SX127xSpi *spi, int8_t rstPin) {
+  _spi = spi;
+  _rstPin = rstPin;
+} /* cfg */
+
+/* -------------------------------------------------------------------------- */
+bool LF_SX127x::begin(long frequency) {
+
+  if (_spi == nullptr) return false;
+
+  _spi->begin();
+
+  // Reset do rádio
+  if (_rstPin >= 0) {
+    pinMode(_rstPin, OUTPUT);
+    digitalWrite(_rstPin, LOW);
+    delay(10);
+    digitalWrite(_rstPin, HIGH);
+    delay(10);
+  }
+
+  if (readRegister(SX127X_REG_VERSION) != SX127X_VERSION) {
+    return false;
+  }
+
+  // Modo LoRa só pode ser ligado em sleep
+  sleep();
+
+  setFrequency(frequency);
+
+  // FIFO inteira para TX e RX, um pacote de cada vez
+  writeRegister(SX127X_REG_FIFO_TX_BASE_ADDR, 0);
+  writeRegister(SX127X_REG_FIFO_RX_BASE_ADDR, 0);
+
+  // LNA boost e AGC automático
+  writeRegister(SX127X_REG_LNA, readRegister(SX127X_REG_LNA) | 0x03);
+  writeRegister(SX127X_REG_MODEM_CONFIG_3, 0x04);
+
+  setTxPower(17);
+
+  idle();
+
+  return true;
+
+} /* begin */
+
+/* -------------------------------------------------------------------------- */
+void LF_SX127x::end() {
+  sleep();
+} /* end */
+
+/* -------------------------------------------------------------------------- */
+void LF_SX127x::setFrequency(long frequency) {
+  _frequency = frequency;
+  uint64_t frf = ((uint64_t)frequency << 19) / 32000000;
+  uint8_t buf[3] = {(uint8_t)(frf >> 16), (uint8_t)(frf >> 8), (uint8_t)(frf >> 0)};
+  writeBurst(SX127X_REG_FRF_MSB, buf, 3);
+} /* setFrequency */
+
+/* -------------------------------------------------------------------------- */
+void LF_SX127x::setSpreadingFactor(uint8_t sf) {
+  if (sf < 6) {
+    sf = 6;
+  } else if (sf > 12) {
+    sf = 12;
+  }
+  if (sf == 6) {
+    writeRegister(SX127X_REG_DETECTION_OPTIMIZE, 0xC5);
+    writeRegister(SX127X_REG_DETECTION_THRESHOLD, 0x0C);
+  } else {
+    writeRegister(SX127X_REG_DETECTION_OPTIMIZE, 0xC3);
+    writeRegister(SX127X_REG_DETECTION_THRESHOLD, 0x0A);
+  }
+  writeRegister(SX127X_REG_MODEM_CONFIG_2, (readRegister(SX127X_REG_MODEM_CONFIG_2) & 0x0F) | ((sf << 4) & 0xF0));
+  _sf = sf;
+  setLdoFlag();
+} /* setSpreadingFactor */
+
+/* -------------------------------------------------------------------------- */
+void LF_SX127x::setSignalBandwidth(long bw) {
+  static const long bws[9] = {7800, 10400, 15600, 20800, 31250, 41700, 62500, 125000, 250000};
+  uint8_t index = 9; // 500 kHz
+  for (uint8_t i = 0; i < 9; i++) {
+    if (bw <= bws[i]) {
+      index = i;
+      break;
+    }
+  }
+  writeRegister(SX127X_REG_MODEM_CONFIG_1, (readRegister(SX127X_REG_MODEM_CONFIG_1) & 0x0F) | (index << 4));
+  _bw = (index < 9) ? bws[index] : 500000;
+  setLdoFlag();
+} /* setSignalBandwidth */
+
+/* -------------------------------------------------------------------------- */
+void LF_SX127x::setCodingRate4(uint8_t denominator) {
+  if (denominator < 5) {
+    denominator = 5;
+  } else if (denominator > 8) {
+    denominator = 8;
+  }
+  uint8_t cr = denominator - 4;
+  writeRegister(SX127X_REG_MODEM_CONFIG_1, (readRegister(SX127X_REG_MODEM_CONFIG_1) & 0xF1) | (cr << 1));
+} /* setCodingRate4 */
+
+/* -------------------------------------------------------------------------- */
+void LF_SX127x::setPreambleLength(uint16_t length) {
+  uint8_t buf[2] = {(uint8_t)(length >> 8), (uint8_t)(length & 0xFF)};
+  writeBurst(SX127X_REG_PREAMBLE_MSB, buf, 2);
+} /* setPreambleLength */
+
+/* -------------------------------------------------------------------------- */
+void LF_SX127x::setSyncWord(uint8_t sw) {
+  writeRegister(SX127X_REG_SYNC_WORD, sw);
+} /* setSyncWord */
+
+/* -------------------------------------------------------------------------- */
+void LF_SX127x::setTxPower(int level) {
+  // Saída PA_BOOST, de 2 a 20 dBm
+  if (level > 17) {
+    if (level > 20) level = 20;
+    // Modo de alta potência (+20 dBm), OCP em 140 mA
+    writeRegister(SX127X_REG_PA_DAC, 0x87);
+    writeRegister(SX127X_REG_OCP, 0x20 | 0x11);
+    level -= 3;
+  } else {
+    if (level < 2) level = 2;
+    writeRegister(SX127X_REG_PA_DAC, 0x84);
+    writeRegister(SX127X_REG_OCP, 0x20 | 0x0B);
+  }
+  writeRegister(SX127X_REG_PA_CONFIG, 0x80 | (level - 2));
+} /* setTxPower */
+
+/* -------------------------------------------------------------------------- */
+void LF_SX127x::setCrc(bool enable) {
+  uint8_t mc2 = readRegister(SX127X_REG_MODEM_CONFIG_2);
+  writeRegister(SX127X_REG_MODEM_CONFIG_2, enable ? (mc2 | 0x04) : (mc2 & 0xFB));
+} /* setCrc */
+
+/* -------------------------------------------------------------------------- */
+void LF_SX127x::setLdoFlag() {
+  // Low Data Rate Optimize quando o símbolo dura mais de 16 ms
+  long symbolDuration = 1000 / (_bw / (1L << _sf));
+  uint8_t mc3 = readRegister(SX127X_REG_MODEM_CONFIG_3);
+  writeRegister(SX127X_REG_MODEM_CONFIG_3, (symbolDuration > 16) ? (mc3 | 0x08) : (mc3 & 0xF7));
+} /* setLdoFlag */
+
+/* -------------------------------------------------------------------------- */
+void LF_SX127x::sleep() {
+  writeRegister(SX127X_REG_OP_MODE, SX127X_MODE_LONG_RANGE | SX127X_MODE_SLEEP);
+} /* sleep */
+
+/* -------------------------------------------------------------------------- */
+void LF_SX127x::idle() {
+  writeRegister(SX127X_REG_OP_MODE, SX127X_MODE_LONG_RANGE | SX127X_MODE_STDBY);
+} /* idle */
+
+/* -------------------------------------------------------------------------- */
+void LF_SX127x::receive() {
+  // DIO0 => RxDone
+  writeRegister(SX127X_REG_DIO_MAPPING_1, 0x00);
+  writeRegister(SX127X_REG_OP_MODE, SX127X_MODE_LONG_RANGE | SX127X_MODE_RX_CONTINUOUS);
+} /* receive */
+
+/* -------------------------------------------------------------------------- */
+bool LF_SX127x::cad(unsigned long timeout) {
+
+  // Channel Activity Detection, retorna true se o canal está ocupado
+  idle();
+  clearIrqFlags(SX127X_IRQ_CAD_DONE | SX127X_IRQ_CAD_DETECTED);
+  writeRegister(SX127X_REG_OP_MODE, SX127X_MODE_LONG_RANGE | SX127X_MODE_CAD);
+
+  unsigned long start = millis();
+  uint8_t flags = 0;
+  while (!((flags = irqFlags()) & SX127X_IRQ_CAD_DONE)) {
+    if (millis() - start > timeout) break;
+    yield();
+  }
+  clearIrqFlags(SX127X_IRQ_CAD_DONE | SX127X_IRQ_CAD_DETECTED);
+  receive();
+
+  return (flags & SX127X_IRQ_CAD_DETECTED) != 0;
+
+} /* cad */
+
+/* -------------------------------------------------------------------------- */
+uint8_t LF_SX127x::irqFlags() {
+  return readRegister(SX127X_REG_IRQ_FLAGS);
+} /* irqFlags */
+
+/* -------------------------------------------------------------------------- */
+void LF_SX127x::clearIrqFlags(uint8_t flags) {
+  writeRegister(SX127X_REG_IRQ_FLAGS, flags);
+} /* clearIrqFlags */
+
+/* -------------------------------------------------------------------------- */
+int LF_SX127x::parsePacket() {
+
+  uint8_t flags = irqFlags();
+  if (!(flags & SX127X_IRQ_RX_DONE)) return 0;
+
+  clearIrqFlags(flags);
+
+  if (flags & SX127X_IRQ_PAYLOAD_CRC_ERROR) return 0;
+
+  // Aponto a FIFO para o início do pacote recebido
+  uint8_t len = readRegister(SX127X_REG_RX_NB_BYTES);
+  writeRegister(SX127X_REG_FIFO_ADDR_PTR, readRegister(SX127X_REG_FIFO_RX_CURRENT_ADDR));
+
+  return len;
+
+} /* parsePacket */
+
+/* -------------------------------------------------------------------------- */
+int LF_SX127x::readFifo(uint8_t *buf, int len) {
+  // Leitura em rajada, o ponteiro da FIFO avança sozinho
+  readBurst(SX127X_REG_FIFO, buf, len);
+  return len;
+} /* readFifo */
+
+/* -------------------------------------------------------------------------- */
+bool LF_SX127x::send(const uint8_t *buf, int len) {
+
+  idle();
+
+  writeRegister(SX127X_REG_FIFO_ADDR_PTR, 0);
+  writeBurst(SX127X_REG_FIFO, buf, len);
+  writeRegister(SX127X_REG_PAYLOAD_LENGTH, len);
+
+  writeRegister(SX127X_REG_OP_MODE, SX127X_MODE_LONG_RANGE | SX127X_MODE_TX);
+
+  unsigned long start = millis();
+  while (!(irqFlags() & SX127X_IRQ_TX_DONE)) {
+    if (millis() - start > SX127X_TX_TIMEOUT) {
+      idle();
+      return false;
+    }
+    yield();
+  }
+  clearIrqFlags(SX127X_IRQ_TX_DONE);
+
+  return true;
+
+} /* send */
+
+/* -------------------------------------------------------------------------- */
+int LF_SX127x::packetRssi() {
+  // Porta LF (até 525 MHz) e porta HF têm offsets diferentes no datasheet
+  return readRegister(SX127X_REG_PKT_RSSI_VALUE) - (_frequency < 525E6 ? 164 : 157);
+} /* packetRssi */
+
+/* -------------------------------------------------------------------------- */
+float LF_SX127x::packetSnr() {
+  return ((int8_t)readRegister(SX127X_REG_PKT_SNR_VALUE)) * 0.25;
+} /* packetSnr */
+
+/* -------------------------------------------------------------------------- */
+uint8_t LF_SX127x::readRegister(uint8_t reg) {
+  uint8_t value;
+  readBurst(reg, &value, 1);
+  return value;
+} /* readRegister */
+
+/* -------------------------------------------------------------------------- */
+void LF_SX127x::writeRegister(uint8_t reg, uint8_t value) {
+  writeBurst(reg, &value, 1);
+} /* writeRegister */
+
+/* -------------------------------------------------------------------------- */
+void LF_SX127x::readBurst(uint8_t reg, uint8_t *buf, int len) {
+  _spi->select(true);
+  _spi->transfer(reg & 0x7F);
+  _spi->transferBytes(nullptr, buf, len);
+  _spi->select(false);
+} /* readBurst */
+
+/* -------------------------------------------------------------------------- */
+void LF_SX127x::writeBurst(uint8_t reg, const uint8_t *buf, int len) {
+  _spi->select(true);
+  _spi->transfer(reg | 0x80);
+  _spi->transferBytes(buf, nullptr, len);
+  _spi->select(false);
+} /* writeBurst */
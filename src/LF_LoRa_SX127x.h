@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef	LF_LORA_SX127X_H
+#define	LF_LORA_SX127X_H
+
+#include <Arduino.h>
+#include <SPI.h>
+
+// Registradores do SX1276/77/78/79 no modo LoRa
+#define SX127X_REG_FIFO                 0x00
+#define SX127X_REG_OP_MODE              0x01
+#define SX127X_REG_FRF_MSB              0x06
+#define SX127X_REG_FRF_MID              0x07
+#define SX127X_REG_FRF_LSB              0x08
+#define SX127X_REG_PA_CONFIG            0x09
+#define SX127X_REG_OCP                  0x0B
+#define SX127X_REG_LNA                  0x0C
+#define SX127X_REG_FIFO_ADDR_PTR        0x0D
+#define SX127X_REG_FIFO_TX_BASE_ADDR    0x0E
+#define SX127X_REG_FIFO_RX_BASE_ADDR    0x0F
+#define SX127X_REG_FIFO_RX_CURRENT_ADDR 0x10
+#define SX127X_REG_IRQ_FLAGS            0x12
+#define SX127X_REG_RX_NB_BYTES          0x13
+#define SX127X_REG_PKT_SNR_VALUE        0x19
+#define SX127X_REG_PKT_RSSI_VALUE       0x1A
+#define SX127X_REG_MODEM_CONFIG_1       0x1D
+#define SX127X_REG_MODEM_CONFIG_2       0x1E
+#define SX127X_REG_PREAMBLE_MSB         0x20
+#define SX127X_REG_PREAMBLE_LSB         0x21
+#define SX127X_REG_PAYLOAD_LENGTH       0x22
+#define SX127X_REG_MODEM_CONFIG_3       0x26
+#define SX127X_REG_DETECTION_OPTIMIZE   0x31
+#define SX127X_REG_DETECTION_THRESHOLD  0x37
+#define SX127X_REG_SYNC_WORD            0x39
+#define SX127X_REG_DIO_MAPPING_1        0x40
+#define SX127X_REG_VERSION              0x42
+#define SX127X_REG_PA_DAC               0x4D
+
+// Modos de operação
+#define SX127X_MODE_LONG_RANGE          0x80
+#define SX127X_MODE_SLEEP               0x00
+#define SX127X_MODE_STDBY               0x01
+#define SX127X_MODE_TX                  0x03
+#define SX127X_MODE_RX_CONTINUOUS       0x05
+#define SX127X_MODE_RX_SINGLE           0x06
+#define SX127X_MODE_CAD                 0x07
+
+// Flags de interrupção (REG_IRQ_FLAGS)
+#define SX127X_IRQ_RX_TIMEOUT           0x80
+#define SX127X_IRQ_RX_DONE              0x40
+#define SX127X_IRQ_PAYLOAD_CRC_ERROR    0x20
+#define SX127X_IRQ_VALID_HEADER         0x10
+#define SX127X_IRQ_TX_DONE              0x08
+#define SX127X_IRQ_CAD_DONE             0x04
+#define SX127X_IRQ_CAD_DETECTED         0x01
+
+#define SX127X_VERSION                  0x12
+#define SX127X_SPI_FREQ              8000000
+#define SX127X_TX_TIMEOUT               5000   // ms
+
+// Interface SPI do driver, pode ser substituída por um mock para testes
+class LF_SX127xSpi {
+
+public:
+
+  virtual ~LF_SX127xSpi() {}
+  virtual void begin() {}
+  virtual void select(bool active) = 0;
+  virtual uint8_t transfer(uint8_t data) = 0;
+  virtual void transferBytes(const uint8_t *tx, uint8_t *rx, int len);
+
+};
+
+// SPI do Arduino, com os bytes em rajada
+class LF_SX127xArduinoSpi : public LF_SX127xSpi {
+
+public:
+
+  void cfg(SPIClass *spi, uint8_t ssPin, uint32_t freq = SX127X_SPI_FREQ);
+  void begin();
+  void select(bool active);
+  uint8_t transfer(uint8_t data);
+  void transferBytes(const uint8_t *tx, uint8_t *rx, int len);
+
+private:
+
+  SPIClass *_spi = nullptr;
+  uint8_t _ssPin = 0;
+  SPISettings _settings;
+
+};
+
+class LF_SX127x {
+
+public:
+
+  void cfg(LF_SX127xSpi *spi, int8_t rstPin);
+  bool begin(long frequency);
+  void end();
+
+  void setFrequency(long frequency);
+  void setSpreadingFactor(uint8_t sf);
+  void setSignalBandwidth(long bw);
+  void setCodingRate4(uint8_t denominator);
+  void setPreambleLength(uint16_t length);
+  void setSyncWord(uint8_t sw);
+  void setTxPower(int level);
+  void setCrc(bool enable);
+
+  void sleep();
+  void idle();
+  void receive();
+  bool cad(unsigned long timeout);
+
+  uint8_t irqFlags();
+  void clearIrqFlags(uint8_t flags);
+
+  int parsePacket();
+  int readFifo(uint8_t *buf, int len);
+  bool send(const uint8_t *buf, int len);
+  int packetRssi();
+  float packetSnr();
+
+  uint8_t readRegister(uint8_t reg);
+  void writeRegister(uint8_t reg, uint8_t value);
+  void readBurst(uint8_t reg, uint8_t *buf, int len);
+  void writeBurst(uint8_t reg, const uint8_t *buf, int len);
+
+private:
+
+  void setLdoFlag();
+
+  LF_SX127xSpi *_spi = nullptr;
+  int8_t _rstPin = -1;
+  long _frequency = 0;
+  uint8_t _sf = 7;
+  long _bw = 125E3;
+
+};
+
+#endif
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#include "LF_LoRa_Store.h"
+#include "LF_LoRa_Fmt.h"
+
+#include <string.h>
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaStore::push(uint32_t time, const char *msg, int len) {
+
+  // O separador não pode aparecer dentro da mensagem
+  if ((len <= 0) || (len > LF_LORA_STORE_MSG_MAX)) return false;
+  if (memchr(msg, LF_LORA_STORE_CHAR, len) != nullptr) return false;
+
+  // Sem espaço, descarto os mais antigos
+  uint16_t need = LF_LORA_STORE_REC_HEAD + len;
+  while (LF_LORA_STORE_SIZE - _used < need) {
+    dropOldest();
+    _dropped++;
+  }
+
+  uint8_t rec[LF_LORA_STORE_REC_HEAD];
+  rec[0] = len;
+  rec[1] = time >> 24;
+  rec[2] = time >> 16;
+  rec[3] = time >> 8;
+  rec[4] = time;
+
+  uint16_t tail = (_head + _used) % LF_LORA_STORE_SIZE;
+  for (uint16_t i = 0; i < need; i++) {
+    _buf[tail] = (i < LF_LORA_STORE_REC_HEAD) ? rec[i] : msg[i - LF_LORA_STORE_REC_HEAD];
+    tail = (tail + 1) % LF_LORA_STORE_SIZE;
+  }
+  _used += need;
+  _count++;
+  return true;
+
+} /* push */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaStore::pack(char *out, int size, uint32_t now, uint32_t &endSeq) {
+
+  // Junta os registros mais antigos que couberem em out, endSeq é a
+  // sequência seguinte ao último incluído (para o ack)
+  int n = 0;
+  uint16_t pos = 0;
+  uint16_t rec = 0;
+  while (rec < _count) {
+    uint8_t len = byteAt(pos);
+    if (n + 1 + LF_LORA_STORE_AGE_LEN + len > size - 1) break;
+    uint32_t time = ((uint32_t)byteAt(pos + 1) << 24) | ((uint32_t)byteAt(pos + 2) << 16) |
+                    ((uint32_t)byteAt(pos + 3) << 8) | byteAt(pos + 4);
+    out[n++] = LF_LORA_STORE_CHAR;
+    n += LF_LoRaFmt::fmtHex(out + n, LF_LORA_STORE_AGE_LEN + 1, now - time, LF_LORA_STORE_AGE_LEN);
+    for (uint8_t i = 0; i < len; i++) {
+      out[n++] = byteAt(pos + LF_LORA_STORE_REC_HEAD + i);
+    }
+    pos += LF_LORA_STORE_REC_HEAD + len;
+    rec++;
+  }
+  out[n] = 0;
+  endSeq = _firstSeq + rec;
+  return n;
+
+} /* pack */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaStore::ack(uint32_t endSeq) {
+  // Registros já descartados por falta de espaço não contam
+  while ((_count > 0) && ((int32_t)(endSeq - _firstSeq) > 0)) {
+    dropOldest();
+  }
+} /* ack */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaStore::dropOldest() {
+  uint16_t need = LF_LORA_STORE_REC_HEAD + byteAt(0);
+  _head = (_head + need) % LF_LORA_STORE_SIZE;
+  _used -= need;
+  _count--;
+  _firstSeq++;
+} /* dropOldest */
+
+/* -------------------------------------------------------------------------- */
+uint8_t LF_LoRaStore::byteAt(uint16_t pos) {
+  return _buf[(_head + pos) % LF_LORA_STORE_SIZE];
+} /* byteAt */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaStore::clear() {
+  _firstSeq += _count;
+  _head = 0;
+  _used = 0;
+  _count = 0;
+} /* clear */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaStore::empty() {
+  return _count == 0;
+} /* empty */
+
+/* -------------------------------------------------------------------------- */
+uint16_t LF_LoRaStore::count() {
+  return _count;
+} /* count */
+
+/* -------------------------------------------------------------------------- */
+uint16_t LF_LoRaStore::bytes() {
+  return _used;
+} /* bytes */
+
+/* -------------------------------------------------------------------------- */
+uint32_t LF_LoRaStore::dropped() {
+  return _dropped;
+} /* dropped */
+
+/* -------------------------------------------------------------------------- */
+int LF_LoRaStore::unpack(const char *in, int len, int pos, uint32_t &age, int &msgPos, int &msgLen) {
+
+  // Para o master: percorre o quadro em lote a partir de pos (0 no início).
+  // Retorna a posição do próximo registro, -1 no fim ou se o quadro é inválido.
+  //   int pos = 0, msgPos, msgLen;
+  //   uint32_t age;
+  //   while ((pos = LF_LoRaStore::unpack(in, len, pos, age, msgPos, msgLen)) != -1) {
+  //     // in + msgPos, msgLen: mensagem adquirida em recepção - age
+  //   }
+  // No fim confirmo o ID do quadro ao escravo.
+  if ((pos >= len) || (in[pos] != LF_LORA_STORE_CHAR)) return -1;
+  if (LF_LoRaFmt::parseHex(in + pos + 1, (len - pos - 1 < LF_LORA_STORE_AGE_LEN) ? len - pos - 1 : LF_LORA_STORE_AGE_LEN, age) != LF_LORA_STORE_AGE_LEN) return -1;
+  msgPos = pos + 1 + LF_LORA_STORE_AGE_LEN;
+  const char *end = (const char *)memchr(in + msgPos, LF_LORA_STORE_CHAR, len - msgPos);
+  msgLen = (end == nullptr) ? len - msgPos : end - (in + msgPos);
+  return msgPos + msgLen;
+
+} /* unpack */
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef	LF_LORA_STORE_H
+#define	LF_LORA_STORE_H
+
+#include <stdint.h>
+
+#define LF_LORA_STORE_SIZE       2048     // Bytes da fila circular em RAM
+#define LF_LORA_STORE_MSG_MAX     180     // Maior mensagem guardada (cabe num quadro em lote)
+#define LF_LORA_STORE_REC_HEAD      5     // Tamanho (1) + momento da aquisição (4)
+
+// Quadro de envio em lote: "&AAAAAAAA<msg>[&AAAAAAAA<msg>...]"
+// AAAAAAAA é a idade do registro (ms, HEX) no momento do envio, o master
+// obtém o momento da aquisição subtraindo a idade do momento da recepção.
+//
+// No master: o quadro chega como uma mensagem com confirmação (ID de 192 a
+// 255) cujo conteúdo começa com '&'. Percorro os registros com unpack e
+// trato cada <msg> como uma mensagem comum do escravo, com o seu momento.
+// Depois respondo ao escravo com o mesmo ID, como em qualquer confirmação:
+// só então os registros saem da fila. Sem resposta, o mesmo lote (mais os
+// registros novos que couberem) volta com outro ID, então o master deve
+// aceitar registros repetidos.
+#define LF_LORA_STORE_CHAR        '&'
+#define LF_LORA_STORE_AGE_LEN       8
+
+// Fila circular de registros com momento da aquisição, guardados enquanto
+// o master não responde. Cheia, descarta os mais antigos.
+// Cada registro tem um número de sequência: só o que o master confirmou
+// sai da fila, mesmo que registros novos tenham entrado no meio tempo.
+// Não usa millis(), recebe o tempo para poder ser testado fora da placa.
+class LF_LoRaStore {
+
+public:
+
+  bool push(uint32_t time, const char *msg, int len);
+  int pack(char *out, int size, uint32_t now, uint32_t &endSeq);
+  void ack(uint32_t endSeq);
+  void clear();
+  bool empty();
+  uint16_t count();
+  uint16_t bytes();
+  uint32_t dropped();
+
+  static int unpack(const char *in, int len, int pos, uint32_t &age, int &msgPos, int &msgLen);
+
+private:
+
+  void dropOldest();
+  uint8_t byteAt(uint16_t pos);
+
+  uint8_t _buf[LF_LORA_STORE_SIZE];
+  uint16_t _head = 0;        // Primeiro byte do registro mais antigo
+  uint16_t _used = 0;
+  uint16_t _count = 0;
+  uint32_t _firstSeq = 0;    // Sequência do registro mais antigo
+  uint32_t _dropped = 0;
+
+};
+
+#endif
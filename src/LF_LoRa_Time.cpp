@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#include "LF_LoRa_Time.h"
+
+#include <math.h>
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaTimeSync::sample(uint32_t local, uint32_t master) {
+
+  // Erro da previsão antes de usar a amostra: é a precisão real do relógio
+  if (_len > 0) {
+    _lastError = (int32_t)(master - now(local));
+    if ((_lastError > LF_LORA_TIME_RESET) || (_lastError < -LF_LORA_TIME_RESET)) {
+      // Master reiniciou ou trocou, começo de novo
+      reset();
+      _resetCount++;
+    } else {
+      float err = fabsf((float)_lastError);
+      _accuracy = (_len == 1) ? err : _accuracy + (err - _accuracy) / 8;
+    }
+  }
+
+  _local[_next] = local;
+  _offset[_next] = master - local;
+  _next = (_next + 1) % LF_LORA_TIME_SAMPLES;
+  if (_len < LF_LORA_TIME_SAMPLES) _len++;
+
+  _baseLocal = local;
+  _baseOffset = master - local;
+  fit();
+
+} /* sample */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaTimeSync::fit() {
+
+  // Mínimos quadrados de (desvio - desvio base) sobre (local - local base).
+  // Valores pequenos, cabem no float sem perder o ms.
+  float mx = 0, my = 0;
+  for (uint8_t i = 0; i < _len; i++) {
+    mx += (float)(int32_t)(_local[i] - _baseLocal);
+    my += (float)(int32_t)(_offset[i] - _baseOffset);
+  }
+  mx /= _len;
+  my /= _len;
+
+  float sxx = 0, sxy = 0;
+  for (uint8_t i = 0; i < _len; i++) {
+    float dx = (float)(int32_t)(_local[i] - _baseLocal) - mx;
+    float dy = (float)(int32_t)(_offset[i] - _baseOffset) - my;
+    sxx += dx * dx;
+    sxy += dx * dy;
+  }
+
+  _b = (sxx > 0) ? sxy / sxx : 0;
+  if (_b > LF_LORA_TIME_MAX_PPM * 1e-6f) _b = LF_LORA_TIME_MAX_PPM * 1e-6f;
+  if (_b < -LF_LORA_TIME_MAX_PPM * 1e-6f) _b = -LF_LORA_TIME_MAX_PPM * 1e-6f;
+  _a = my - _b * mx;
+
+} /* fit */
+
+/* -------------------------------------------------------------------------- */
+uint32_t LF_LoRaTimeSync::now(uint32_t local) {
+
+  // Sem beacon ainda, o relógio da rede é o local
+  if (_len == 0) return local;
+  return predict(local, _baseLocal, _baseOffset, _a, _b);
+
+} /* now */
+
+/* -------------------------------------------------------------------------- */
+uint32_t LF_LoRaTimeSync::predict(uint32_t local, uint32_t baseLocal, uint32_t baseOffset, float a, float b) {
+  float dx = (float)(int32_t)(local - baseLocal);
+  return local + baseOffset + (int32_t)lroundf(a + b * dx);
+} /* predict */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaTimeSync::synced() {
+  return _len > 0;
+} /* synced */
+
+/* -------------------------------------------------------------------------- */
+int32_t LF_LoRaTimeSync::offset() {
+  // Desvio (ms) do relógio da rede em relação ao local, no último beacon
+  return (int32_t)(_baseOffset + (int32_t)lroundf(_a));
+} /* offset */
+
+/* -------------------------------------------------------------------------- */
+float LF_LoRaTimeSync::driftPpm() {
+  return _b * 1e6f;
+} /* driftPpm */
+
+/* -------------------------------------------------------------------------- */
+int32_t LF_LoRaTimeSync::lastError() {
+  return _lastError;
+} /* lastError */
+
+/* -------------------------------------------------------------------------- */
+float LF_LoRaTimeSync::accuracy() {
+  // Média móvel do erro absoluto de previsão (ms)
+  return _accuracy;
+} /* accuracy */
+
+/* -------------------------------------------------------------------------- */
+uint8_t LF_LoRaTimeSync::sampleCount() {
+  return _len;
+} /* sampleCount */
+
+/* -------------------------------------------------------------------------- */
+uint32_t LF_LoRaTimeSync::resetCount() {
+  return _resetCount;
+} /* resetCount */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaTimeSync::reset() {
+  _len = 0;
+  _next = 0;
+  _a = 0;
+  _b = 0;
+  _accuracy = 0;
+} /* reset */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaTimeSnap::store(const LF_LoRaTimeSync &sync) {
+  uint32_t seq = _seq;
+  _seq = seq + 1;
+  _synced = sync._len > 0;
+  _baseLocal = sync._baseLocal;
+  _baseOffset = sync._baseOffset;
+  _a = sync._a;
+  _b = sync._b;
+  _seq = seq + 2;
+} /* store */
+
+/* -------------------------------------------------------------------------- */
+uint32_t LF_LoRaTimeSnap::now(uint32_t local) {
+
+  uint32_t seq, baseLocal, baseOffset;
+  bool synced;
+  float a, b;
+  do {
+    seq = _seq;
+    synced = _synced;
+    baseLocal = _baseLocal;
+    baseOffset = _baseOffset;
+    a = _a;
+    b = _b;
+  } while ((seq & 1) || (seq != _seq));
+
+  if (!synced) return local;
+  return LF_LoRaTimeSync::predict(local, baseLocal, baseOffset, a, b);
+
+} /* now */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaTimeSnap::synced() {
+  return _synced;
+} /* synced */
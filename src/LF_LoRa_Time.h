@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef	LF_LORA_TIME_H
+#define	LF_LORA_TIME_H
+
+#include <stdint.h>
+#include <atomic>
+
+#define LF_LORA_TIME_SAMPLES        8     // Beacons usados na regressão
+#define LF_LORA_TIME_MAX_PPM      500     // Deriva máxima aceita (ppm)
+#define LF_LORA_TIME_RESET       1000     // Erro (ms) que indica relógio do master reiniciado
+
+// Relógio da rede a partir dos beacons de tempo do master.
+// Cada beacon dá uma amostra (tempo local, tempo do master); a diferença
+// entre os dois é ajustada por mínimos quadrados sobre as últimas
+// LF_LORA_TIME_SAMPLES amostras, dando desvio e deriva do cristal.
+// Não usa millis(), recebe o tempo para poder ser testado fora da placa.
+// Tempos em ms de 32 bits, contas feitas com diferenças (sobrevive à volta).
+class LF_LoRaTimeSync {
+
+public:
+
+  void sample(uint32_t local, uint32_t master);
+  uint32_t now(uint32_t local);
+  bool synced();
+  int32_t offset();
+  float driftPpm();
+  int32_t lastError();
+  float accuracy();
+  uint8_t sampleCount();
+  uint32_t resetCount();
+  void reset();
+
+  static uint32_t predict(uint32_t local, uint32_t baseLocal, uint32_t baseOffset, float a, float b);
+
+private:
+
+  friend class LF_LoRaTimeSnap;
+
+  void fit();
+
+  uint32_t _local[LF_LORA_TIME_SAMPLES];
+  uint32_t _offset[LF_LORA_TIME_SAMPLES];   // master - local
+  uint8_t _len = 0;
+  uint8_t _next = 0;
+  uint32_t _baseLocal = 0;                  // Amostra mais recente, referência do ajuste
+  uint32_t _baseOffset = 0;
+  float _a = 0;                             // Desvio (ms) em _baseLocal
+  float _b = 0;                             // Deriva (ms/ms)
+  int32_t _lastError = 0;
+  float _accuracy = 0;
+  uint32_t _resetCount = 0;
+
+};
+
+// Cópia do ajuste para ler o relógio da rede de outra tarefa (seqlock).
+// Só a tarefa do rádio grava, quem lê repete se pegou a gravação no meio.
+class LF_LoRaTimeSnap {
+
+public:
+
+  void store(const LF_LoRaTimeSync &sync);
+  uint32_t now(uint32_t local);
+  bool synced();
+
+private:
+
+  std::atomic<uint32_t> _seq{0};            // Ímpar durante a gravação
+  std::atomic<bool> _synced{false};
+  std::atomic<uint32_t> _baseLocal{0};
+  std::atomic<uint32_t> _baseOffset{0};
+  std::atomic<float> _a{0};
+  std::atomic<float> _b{0};
+
+};
+
+#endif
@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#include "LF_LoRa_Timer.h"
+
+#include <Arduino.h>
+
+#if defined(ESP32)
+#include "esp_timer.h"
+#endif
+
+/* -------------------------------------------------------------------------- */
+uint64_t lfLoRaMillis64() {
+#if defined(ESP32)
+  // Contador de 64 bits em us do esp_timer
+  return esp_timer_get_time() / 1000;
+#else
+  // Estendo o millis() contando as voltas, precisa ser chamado ao menos
+  // uma vez a cada volta (~49 dias)
+  static uint32_t last = 0;
+  static uint32_t high = 0;
+  uint32_t now = millis();
+  if (now < last) high++;
+  last = now;
+  return ((uint64_t)high << 32) | now;
+#endif
+} /* lfLoRaMillis64 */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaTimerWheel::begin(uint64_t now) {
+  for (int l = 0; l < LF_LORA_WHEEL_LEVELS; l++) {
+    for (int i = 0; i < LF_LORA_WHEEL_SLOTS; i++) {
+      while (_slots[l][i] != nullptr) {
+        cancel(*_slots[l][i]);
+      }
+    }
+  }
+  _now = now;
+} /* begin */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaTimerWheel::add(LF_LoRaTimer &timer, uint32_t delay) {
+
+  if (timer.active) cancel(timer);
+
+  // Prazo 0 cairia na posição já processada, vence no próximo tick
+  if (delay == 0) delay = 1;
+  timer.expire = _now + delay;
+  insert(timer);
+
+} /* add */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaTimerWheel::insert(LF_LoRaTimer &timer) {
+
+  uint64_t delta = (timer.expire > _now) ? timer.expire - _now : 0;
+  uint64_t index = timer.expire;
+  uint8_t level = 0;
+
+  // Nível pela distância até o prazo
+  while ((level < LF_LORA_WHEEL_LEVELS - 1) && (delta >= ((uint64_t)1 << (LF_LORA_WHEEL_BITS * (level + 1))))) {
+    level++;
+  }
+  // Além do último nível, fica no mais distante e é reposicionado depois.
+  // O prazo real continua em expire.
+  uint64_t max = ((uint64_t)1 << (LF_LORA_WHEEL_BITS * LF_LORA_WHEEL_LEVELS)) - 1;
+  timer.far = (delta > max);
+  if (timer.far) {
+    index = _now + max;
+    _farCount++;
+  }
+
+  uint8_t slot = (index >> (LF_LORA_WHEEL_BITS * level)) & LF_LORA_WHEEL_MASK;
+
+  timer.level = level;
+  timer.slot = slot;
+  timer.prev = nullptr;
+  timer.next = _slots[level][slot];
+  if (timer.next != nullptr) timer.next->prev = &timer;
+  _slots[level][slot] = &timer;
+  timer.active = true;
+  _levelCount[level]++;
+  _count++;
+
+} /* insert */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaTimerWheel::cancel(LF_LoRaTimer &timer) {
+
+  if (!timer.active) return;
+
+  if (timer.prev != nullptr) {
+    timer.prev->next = timer.next;
+  } else {
+    _slots[timer.level][timer.slot] = timer.next;
+  }
+  if (timer.next != nullptr) timer.next->prev = timer.prev;
+
+  timer.next = nullptr;
+  timer.prev = nullptr;
+  timer.active = false;
+  if (timer.far) _farCount--;
+  _levelCount[timer.level]--;
+  _count--;
+
+} /* cancel */
+
+/* -------------------------------------------------------------------------- */
+bool LF_LoRaTimerWheel::pending(LF_LoRaTimer &timer) {
+  return timer.active;
+} /* pending */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaTimerWheel::cascade(uint8_t level) {
+
+  // Redistribuo a posição atual do nível nos níveis de baixo
+  uint8_t slot = (_now >> (LF_LORA_WHEEL_BITS * level)) & LF_LORA_WHEEL_MASK;
+  LF_LoRaTimer *timer = _slots[level][slot];
+  _slots[level][slot] = nullptr;
+  while (timer != nullptr) {
+    LF_LoRaTimer *next = timer->next;
+    if (timer->far) _farCount--;
+    _levelCount[level]--;
+    _count--;
+    insert(*timer);
+    timer = next;
+  }
+
+} /* cascade */
+
+/* -------------------------------------------------------------------------- */
+void LF_LoRaTimerWheel::advance(uint64_t now) {
+
+  while (_now < now) {
+
+    if (_count == 0) {
+      _now = now;
+      return;
+    }
+
+    // Nível 0 vazio, pulo até a próxima volta dele
+    if (_levelCount[0] == 0) {
+      uint64_t next = ((_now >> LF_LORA_WHEEL_BITS) + 1) << LF_LORA_WHEEL_BITS;
+      if (next > now) {
+        _now = now;
+        return;
+      }
+      _now = next - 1;
+    }
+
+    _now++;
+
+    // Na volta de um nível desço a posição do nível de cima
+    for (uint8_t level = 1; level < LF_LORA_WHEEL_LEVELS; level++) {
+      if (((_now >> (LF_LORA_WHEEL_BITS * (level - 1))) & LF_LORA_WHEEL_MASK) != 0) break;
+      cascade(level);
+    }
+
+    // Vencidos neste tick
+    uint8_t slot = _now & LF_LORA_WHEEL_MASK;
+    LF_LoRaTimer *timer = _slots[0][slot];
+    _slots[0][slot] = nullptr;
+    while (timer != nullptr) {
+      LF_LoRaTimer *next = timer->next;
+      timer->next = nullptr;
+      timer->prev = nullptr;
+      timer->active = false;
+      _levelCount[0]--;
+      _count--;
+      // O callback pode inserir o timer de novo
+      if (timer->cb != nullptr) timer->cb(timer->arg, timer->id);
+      timer = next;
+    }
+
+  }
+
+} /* advance */
+
+/* -------------------------------------------------------------------------- */
+uint32_t LF_LoRaTimerWheel::nextDeadline() {
+
+  if (_count == 0) return LF_LORA_WHEEL_NONE;
+
+  // Em cada nível a primeira posição ocupada, a partir da atual, tem o
+  // menor prazo do nível. Um timer de nível alto pode vencer antes de um
+  // do nível 0 inserido depois, então comparo todos os níveis.
+  // Timers além do último nível ficam numa posição que não segue o prazo,
+  // com eles percorro o último nível inteiro.
+  uint64_t expire = UINT64_MAX;
+  for (uint8_t level = 0; level < LF_LORA_WHEEL_LEVELS; level++) {
+    if (_levelCount[level] == 0) continue;
+    uint8_t shift = LF_LORA_WHEEL_BITS * level;
+    for (int j = 1; j <= LF_LORA_WHEEL_SLOTS; j++) {
+      uint8_t slot = ((_now >> shift) + j) & LF_LORA_WHEEL_MASK;
+      LF_LoRaTimer *timer = _slots[level][slot];
+      if (timer == nullptr) continue;
+      for (; timer != nullptr; timer = timer->next) {
+        if (timer->expire < expire) expire = timer->expire;
+      }
+      if ((level < LF_LORA_WHEEL_LEVELS - 1) || (_farCount == 0)) break;
+    }
+  }
+
+  if (expire <= _now) return 0;
+  uint64_t delta = expire - _now;
+  return (delta >= LF_LORA_WHEEL_NONE) ? LF_LORA_WHEEL_NONE - 1 : (uint32_t)delta;
+
+} /* nextDeadline */
+
+/* -------------------------------------------------------------------------- */
+uint64_t LF_LoRaTimerWheel::now() {
+  return _now;
+} /* now */
+
+/* -------------------------------------------------------------------------- */
+uint16_t LF_LoRaTimerWheel::count() {
+  return _count;
+} /* count */
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2025 by Leonardo Figueiro <leoagfig@gmail.com>
+ * LF_LoRa library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef	LF_LORA_TIMER_H
+#define	LF_LORA_TIMER_H
+
+#include <stdint.h>
+
+// Roda de timers hierárquica: 4 níveis de 64 posições, tick de 1 ms.
+// Inserir, cancelar e vencer são O(1). Prazos além de 64^4 ms (~4,6 h)
+// ficam no último nível e são reposicionados quando chegam perto.
+#define LF_LORA_WHEEL_BITS        6
+#define LF_LORA_WHEEL_SLOTS      (1 << LF_LORA_WHEEL_BITS)
+#define LF_LORA_WHEEL_MASK       (LF_LORA_WHEEL_SLOTS - 1)
+#define LF_LORA_WHEEL_LEVELS      4
+#define LF_LORA_WHEEL_NONE       0xFFFFFFFF   // Sem prazo pendente
+
+// Tempo monotônico de 64 bits em ms, não dá a volta como o millis()
+uint64_t lfLoRaMillis64();
+
+typedef void (*LF_LoRaTimerCb)(void *arg, uint8_t id);
+
+struct LF_LoRaTimer {
+  LF_LoRaTimer *next = nullptr;
+  LF_LoRaTimer *prev = nullptr;
+  uint64_t expire = 0;
+  LF_LoRaTimerCb cb = nullptr;
+  void *arg = nullptr;
+  uint8_t id = 0;
+  uint8_t level = 0;
+  uint8_t slot = 0;
+  bool active = false;
+  bool far = false;        // Além do último nível, posição não segue o prazo
+};
+
+class LF_LoRaTimerWheel {
+
+public:
+
+  void begin(uint64_t now);
+  void add(LF_LoRaTimer &timer, uint32_t delay);
+  void cancel(LF_LoRaTimer &timer);
+  bool pending(LF_LoRaTimer &timer);
+  void advance(uint64_t now);
+  uint32_t nextDeadline();
+  uint64_t now();
+  uint16_t count();
+
+private:
+
+  void insert(LF_LoRaTimer &timer);
+  void cascade(uint8_t level);
+
+  LF_LoRaTimer *_slots[LF_LORA_WHEEL_LEVELS][LF_LORA_WHEEL_SLOTS] = {};
+  uint16_t _levelCount[LF_LORA_WHEEL_LEVELS] = {};
+  uint16_t _farCount = 0;
+  uint64_t _now = 0;
+  uint16_t _count = 0;
+
+};
+
+#endif